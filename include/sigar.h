@@ -125,8 +125,69 @@ typedef struct sigar_t sigar_t;
 
 SIGAR_DECLARE(int) sigar_open(sigar_t **sigar);
 
+/*
+ * a handle any number of threads may use at once.
+ * per-process rate caches are sharded by pid and the
+ * sigar_rate_get ones by entity.  the file system, disk and
+ * net caches are refreshed a whole table at a time and stay
+ * behind one lock.  error strings are per thread.
+ * the string sigar_strerror returns on such a handle is only
+ * valid until the thread that called it exits.
+ */
+SIGAR_DECLARE(int) sigar_open_threadsafe(sigar_t **sigar);
+
 SIGAR_DECLARE(int) sigar_close(sigar_t *sigar);
 
+/*
+ * keep the data of the proc, cpu, file system, disk io, route, net
+ * interface stat, connection, arp and who lists given to their
+ * _destroy for the next list of the same kind, so that a caller
+ * polling the same lists stops allocating once they have grown to
+ * size.  off by default, turning it off frees what was kept.
+ */
+SIGAR_DECLARE(int) sigar_list_recycle_set(sigar_t *sigar, int enable);
+
+/*
+ * read procfs and sysfs from under other directories, a fixture tree
+ * or the host's /proc mounted into a container.  NULL for the live
+ * ones.  sigar_open takes them from SIGAR_PROC_ROOT and SIGAR_SYS_ROOT
+ * if set.  best set right after sigar_open, values cached by pid are
+ * not dropped.
+ */
+SIGAR_DECLARE(int) sigar_proc_root_set(sigar_t *sigar,
+                                       const char *proc_root,
+                                       const char *sys_root);
+
+/*
+ * capture every /proc and /sys file, link and directory listing the
+ * process reads into archive, for replay on another host.  process
+ * wide, the reads of every handle are recorded.  linux only.
+ * while recording, socket and route tables are read from /proc
+ * rather than netlink so that the replay has them.
+ */
+SIGAR_DECLARE(int) sigar_record_start(const char *archive);
+
+/* end of a frame, e.g. one collection pass */
+SIGAR_DECLARE(int) sigar_record_mark(void);
+
+SIGAR_DECLARE(int) sigar_record_stop(void);
+
+/*
+ * serve sigar's reads from a recorded archive, unpacked under dir
+ * (which must not exist yet) and read through sigar_proc_root_set.
+ * sigar_replay_next steps to the next frame, the first one included,
+ * and gives the time it was recorded at.  SIGAR_ENOENT past the last,
+ * EINVAL for a record of a path outside the recorded /proc and /sys.
+ * sigar_replay_close (or sigar_close) removes dir.
+ */
+SIGAR_DECLARE(int) sigar_replay_open(sigar_t *sigar,
+                                     const char *archive,
+                                     const char *dir);
+
+SIGAR_DECLARE(int) sigar_replay_next(sigar_t *sigar, sigar_uint64_t *time);
+
+SIGAR_DECLARE(int) sigar_replay_close(sigar_t *sigar);
+
 SIGAR_DECLARE(sigar_pid_t) sigar_pid_get(sigar_t *sigar);
 
 SIGAR_DECLARE(int) sigar_proc_kill(sigar_pid_t pid, int signum);
@@ -302,6 +363,10 @@ typedef struct {
 SIGAR_DECLARE(int) sigar_proc_disk_io_get(sigar_t *sigar, sigar_pid_t pid,
                                           sigar_proc_disk_io_t *proc_disk_io);
 
+/*
+ * deprecated: sigar_proc_disk_io_get keeps its own rates now, this
+ * is no longer used by sigar and only kept for code built on it.
+ */
 typedef struct {
     sigar_uint64_t
         bytes_read,
@@ -314,7 +379,6 @@ typedef struct {
         bytes_total_diff;
 } sigar_cached_proc_disk_io_t;
 
-
 typedef struct {
     sigar_uint64_t
         bytes_read,
@@ -332,6 +396,93 @@ typedef struct  {
 
 SIGAR_DECLARE(int) sigar_dump_pid_cache_get(sigar_t *sigar, sigar_dump_pid_cache_t *info);
 
+/*
+ * opt-in instrumentation of a handle, off by default.  while off an
+ * instrumented call costs a test of a flag on the way in and out.
+ */
+typedef enum {
+    SIGAR_STATS_CPU,
+    SIGAR_STATS_CPU_LIST,
+    SIGAR_STATS_MEM,
+    SIGAR_STATS_SWAP,
+    SIGAR_STATS_PROC_LIST,
+    SIGAR_STATS_PROC_STAT,
+    SIGAR_STATS_PROC_ARGS,
+    SIGAR_STATS_PROC_STATE,
+    SIGAR_STATS_PROC_MEM,
+    SIGAR_STATS_PROC_TIME,
+    SIGAR_STATS_PROC_CPU,
+    SIGAR_STATS_PROC_DISK_IO,
+    SIGAR_STATS_FILE_SYSTEM_LIST,
+    SIGAR_STATS_DISK_USAGE,
+    SIGAR_STATS_NET_INTERFACE_STAT,
+    SIGAR_STATS_NET_INTERFACE_STAT_LIST,
+    SIGAR_STATS_NET_INTERFACE_CONFIG_LIST,
+    SIGAR_STATS_NET_INTERFACE_ADDRESS_LIST,
+    SIGAR_STATS_NET_CONNECTION_WALK,
+    SIGAR_STATS_NET_CONNECTION_LIST,
+    SIGAR_STATS_NET_UNIX_CONNECTION_LIST,
+    SIGAR_STATS_NET_CONNECTION_INFO_LIST,
+    SIGAR_STATS_NET_PORT_TCP_INFO_LIST,
+    SIGAR_STATS_NET_CONNECTION_PROC_LIST,
+    SIGAR_STATS_NET_LISTENER_LIST,
+    SIGAR_STATS_NET_PROTO_COUNTER_LIST,
+    SIGAR_STATS_NETNS_LIST,
+    SIGAR_STATS_NETNS_INTERFACE_STAT_LIST,
+    SIGAR_STATS_NETNS_CONNECTION_LIST,
+    SIGAR_STATS_NETNS_PROTO_COUNTER_LIST,
+    SIGAR_STATS_DISK_IO_LIST,
+    SIGAR_STATS_FILE_SYSTEM_USAGE_LIST,
+    SIGAR_STATS_NETLINK_DUMP, /* linux, each dump behind the calls above */
+    SIGAR_STATS_API_MAX
+} sigar_stats_api_e;
+
+/*
+ * latency histogram buckets, log scale in usec with 4 linear steps
+ * per power of 2 (so within 25%), sigar_stats_bucket_usec gives the
+ * lower bound of each.  the last bucket takes everything longer.
+ */
+#define SIGAR_STATS_BUCKETS 128
+
+#define SIGAR_STATS_CACHE_MAX 16
+
+typedef struct {
+    const char *name;
+    sigar_uint64_t
+        calls,
+        errors,
+        usec_total,
+        usec_max,
+        buckets[SIGAR_STATS_BUCKETS];
+} sigar_stats_call_t;
+
+typedef struct {
+    char name[32];
+    sigar_uint64_t
+        count, /* entries */
+        hits,
+        misses;
+} sigar_stats_cache_t;
+
+typedef struct {
+    int enabled;
+    /* by every handle in the process while any has stats enabled */
+    sigar_uint64_t
+        files_opened,
+        bytes_read;
+    unsigned long cache_number;
+    sigar_stats_cache_t caches[SIGAR_STATS_CACHE_MAX];
+    sigar_stats_call_t calls[SIGAR_STATS_API_MAX];
+} sigar_stats_t;
+
+SIGAR_DECLARE(int) sigar_stats_enable(sigar_t *sigar, int enable);
+
+SIGAR_DECLARE(int) sigar_stats_get(sigar_t *sigar, sigar_stats_t *stats);
+
+SIGAR_DECLARE(int) sigar_stats_reset(sigar_t *sigar);
+
+SIGAR_DECLARE(sigar_uint64_t) sigar_stats_bucket_usec(int bucket);
+
 
 typedef struct {
     sigar_uid_t uid;
@@ -549,6 +700,70 @@ SIGAR_DECLARE(int) sigar_disk_usage_get(sigar_t *sigar,
                                         const char *name,
                                         sigar_disk_usage_t *disk);
 
+typedef struct {
+    char dir_name[SIGAR_FS_NAME_LEN];
+    /* SIGAR_OK, or ETIMEDOUT if the deadline passed or
+     * the mount is quarantined after an earlier timeout */
+    int status;
+    sigar_file_system_usage_t usage;
+} sigar_file_system_usage_entry_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_file_system_usage_entry_t *data;
+} sigar_file_system_usage_list_t;
+
+/*
+ * statvfs every mount in fslist concurrently, waiting at most
+ * timeout millis. results are in the same order as fslist.
+ */
+SIGAR_DECLARE(int)
+sigar_file_system_usage_list_get(sigar_t *sigar,
+                                 sigar_file_system_list_t *fslist,
+                                 unsigned long timeout,
+                                 sigar_file_system_usage_list_t *usagelist);
+
+SIGAR_DECLARE(int)
+sigar_file_system_usage_list_destroy(sigar_t *sigar,
+                                     sigar_file_system_usage_list_t *usagelist);
+
+typedef struct {
+    char name[SIGAR_FS_INFO_LEN]; /* e.g. "sda1" */
+    unsigned long major;
+    unsigned long minor;
+    sigar_disk_usage_t disk;
+    sigar_uint64_t read_merges;
+    sigar_uint64_t write_merges;
+    sigar_uint64_t in_progress;
+    /* linux 4.18+ */
+    sigar_uint64_t discards;
+    sigar_uint64_t discard_merges;
+    sigar_uint64_t discard_bytes;
+    sigar_uint64_t dtime;
+    /* linux 5.5+ */
+    sigar_uint64_t flushes;
+    sigar_uint64_t ftime;
+    /* computed against the previous snapshot */
+    double utilization;
+    double reads_per_sec;
+    double writes_per_sec;
+    double read_bytes_per_sec;
+    double write_bytes_per_sec;
+} sigar_disk_io_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_disk_io_t *data;
+} sigar_disk_io_list_t;
+
+SIGAR_DECLARE(int) sigar_disk_io_list_get(sigar_t *sigar,
+                                          sigar_disk_io_list_t *disklist);
+
+SIGAR_DECLARE(int) sigar_disk_io_list_destroy(sigar_t *sigar,
+                                              sigar_disk_io_list_t *disklist);
+
 SIGAR_DECLARE(int)
 sigar_file_system_ping(sigar_t *sigar,
                        sigar_file_system_t *fs);
@@ -616,6 +831,21 @@ SIGAR_DECLARE(int) sigar_net_route_list_get(sigar_t *sigar,
 SIGAR_DECLARE(int) sigar_net_route_list_destroy(sigar_t *sigar,
                                                 sigar_net_route_list_t *routelist);
 
+typedef struct sigar_net_route_walker_t sigar_net_route_walker_t;
+
+/* return SIGAR_OK to keep walking, anything else stops the walk */
+struct sigar_net_route_walker_t {
+    sigar_t *sigar;
+    int family; /* SIGAR_AF_INET, SIGAR_AF_INET6 or SIGAR_AF_UNSPEC for both */
+    void *data; /* user data */
+    int (*add_route)(sigar_net_route_walker_t *walker,
+                     sigar_net_route_t *route);
+};
+
+/* sigar_net_route_list_get is the SIGAR_AF_INET walk */
+SIGAR_DECLARE(int)
+sigar_net_route_walk(sigar_net_route_walker_t *walker);
+
 /*
  * platforms define most of these "standard" flags,
  * but of course, with different values in some cases.
@@ -699,6 +929,43 @@ sigar_net_interface_stat_get(sigar_t *sigar,
                              const char *name,
                              sigar_net_interface_stat_t *ifstat);
 
+typedef struct {
+    char name[MAX_INTERFACE_NAME_LEN];
+    sigar_uint64_t index;
+    sigar_net_interface_stat_t stat;
+    /* breakdown of the errors folded into stat */
+    sigar_uint64_t
+        rx_multicast,
+        rx_compressed,
+        rx_length_errors,
+        rx_over_errors,
+        rx_crc_errors,
+        rx_frame_errors,
+        rx_fifo_errors,
+        rx_missed_errors,
+        tx_compressed,
+        tx_aborted_errors,
+        tx_carrier_errors,
+        tx_fifo_errors,
+        tx_heartbeat_errors,
+        tx_window_errors;
+} sigar_net_interface_stat_entry_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_net_interface_stat_entry_t *data;
+} sigar_net_interface_stat_list_t;
+
+/* counters for every interface in one pass */
+SIGAR_DECLARE(int)
+sigar_net_interface_stat_list_get(sigar_t *sigar,
+                                  sigar_net_interface_stat_list_t *iflist);
+
+SIGAR_DECLARE(int)
+sigar_net_interface_stat_list_destroy(sigar_t *sigar,
+                                      sigar_net_interface_stat_list_t *iflist);
+
 typedef struct {
     unsigned long number;
     unsigned long size;
@@ -780,12 +1047,147 @@ struct sigar_net_connection_walker_t {
 SIGAR_DECLARE(int)
 sigar_net_connection_walk(sigar_net_connection_walker_t *walker);
 
+#define SIGAR_UNIX_PATH_MAX 108
+
+/*
+ * SIGAR_NETCONN_UNIX sockets along with what only they have.
+ * the walk passes them as sigar_net_connection_t of type
+ * SIGAR_NETCONN_UNIX, without these.
+ */
+typedef struct {
+    unsigned long inode;
+    unsigned long peer_inode; /* 0 if unconnected or not known */
+    sigar_uid_t uid;
+    int socket_type; /* SOCK_STREAM, SOCK_DGRAM or SOCK_SEQPACKET */
+    int state;
+    unsigned long send_queue;
+    unsigned long receive_queue;
+    char path[SIGAR_UNIX_PATH_MAX]; /* abstract names start with '@' */
+} sigar_net_unix_connection_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_net_unix_connection_t *data;
+} sigar_net_unix_connection_list_t;
+
+/* flags is SIGAR_NETCONN_SERVER and/or SIGAR_NETCONN_CLIENT */
+SIGAR_DECLARE(int)
+sigar_net_unix_connection_list_get(sigar_t *sigar,
+                                   sigar_net_unix_connection_list_t *connlist,
+                                   int flags);
+
+SIGAR_DECLARE(int)
+sigar_net_unix_connection_list_destroy(sigar_t *sigar,
+                                       sigar_net_unix_connection_list_t *connlist);
+
+typedef struct {
+    sigar_net_connection_t conn;
+    /* tcp_info; times in microseconds */
+    sigar_uint64_t rtt;
+    sigar_uint64_t rttvar;
+    sigar_uint64_t rto;
+    sigar_uint64_t retransmits; /* unrecovered rto timeouts */
+    sigar_uint64_t total_retrans;
+    sigar_uint64_t lost;
+    sigar_uint64_t unacked;
+    sigar_uint64_t snd_cwnd;
+    sigar_uint64_t snd_ssthresh;
+    sigar_uint64_t snd_mss;
+    sigar_uint64_t delivery_rate; /* bytes per second */
+    sigar_uint64_t bytes_acked;
+    sigar_uint64_t bytes_received;
+    /* listeners: connections waiting in accept() vs. the limit */
+    sigar_uint64_t accept_queue;
+    sigar_uint64_t accept_queue_max;
+    /* socket memory (skmeminfo) */
+    sigar_uint64_t rmem_alloc;
+    sigar_uint64_t rcvbuf;
+    sigar_uint64_t wmem_alloc;
+    sigar_uint64_t sndbuf;
+    sigar_uint64_t fwd_alloc;
+    sigar_uint64_t wmem_queued;
+} sigar_net_connection_info_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_net_connection_info_t *data;
+} sigar_net_connection_info_list_t;
+
+SIGAR_DECLARE(int)
+sigar_net_connection_info_list_get(sigar_t *sigar,
+                                   sigar_net_connection_info_list_t *connlist,
+                                   int flags);
+
+SIGAR_DECLARE(int)
+sigar_net_connection_info_list_destroy(sigar_t *sigar,
+                                       sigar_net_connection_info_list_t *connlist);
+
+/*
+ * bucket 0 of rtt_histogram counts rtt < 128us, each next bucket
+ * doubles the limit, the last one counts everything above.
+ * bucket 0 of retrans_histogram counts connections without
+ * retransmits, bucket n those with 2^(n-1) to 2^n-1.
+ */
+#define SIGAR_NET_HISTOGRAM_BUCKETS 16
+
+typedef struct {
+    unsigned long local_port;
+    sigar_uint64_t connections;
+    sigar_uint64_t rtt_min;
+    sigar_uint64_t rtt_max;
+    sigar_uint64_t rtt_avg;
+    sigar_uint64_t total_retrans;
+    sigar_uint64_t rtt_histogram[SIGAR_NET_HISTOGRAM_BUCKETS];
+    sigar_uint64_t retrans_histogram[SIGAR_NET_HISTOGRAM_BUCKETS];
+} sigar_net_port_tcp_info_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_net_port_tcp_info_t *data;
+} sigar_net_port_tcp_info_list_t;
+
+/* established tcp connections aggregated by local port */
+SIGAR_DECLARE(int)
+sigar_net_port_tcp_info_list_get(sigar_t *sigar,
+                                 sigar_net_port_tcp_info_list_t *portlist);
+
+SIGAR_DECLARE(int)
+sigar_net_port_tcp_info_list_destroy(sigar_t *sigar,
+                                     sigar_net_port_tcp_info_list_t *portlist);
+
+typedef struct {
+    sigar_net_connection_t conn;
+    sigar_pid_t pid; /* 0 if the owner is unknown */
+    int fd;          /* -1 if the owner is unknown */
+} sigar_net_connection_proc_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_net_connection_proc_t *data;
+} sigar_net_connection_proc_list_t;
+
+/* netstat -p: connections along with the process holding the socket */
+SIGAR_DECLARE(int)
+sigar_net_connection_proc_list_get(sigar_t *sigar,
+                                   sigar_net_connection_proc_list_t *connlist,
+                                   int flags);
+
+SIGAR_DECLARE(int)
+sigar_net_connection_proc_list_destroy(sigar_t *sigar,
+                                       sigar_net_connection_proc_list_t *connlist);
+
 typedef struct {
     int tcp_states[SIGAR_TCP_UNKNOWN];
     sigar_uint32_t tcp_inbound_total;
     sigar_uint32_t tcp_outbound_total;
     sigar_uint32_t all_inbound_total;
     sigar_uint32_t all_outbound_total;
+    /* with SIGAR_NETCONN_UNIX, listening/connected/unconnected */
+    int unix_states[SIGAR_TCP_UNKNOWN];
 } sigar_net_stat_t;
 
 SIGAR_DECLARE(int)
@@ -800,6 +1202,41 @@ sigar_net_stat_port_get(sigar_t *sigar,
                         sigar_net_address_t *address,
                         unsigned long port);
 
+typedef struct {
+    unsigned long port;
+    /* connections using port on this end: inbound if port has a
+     * listener, outbound otherwise */
+    sigar_net_stat_t local;
+    /* outbound connections to port on the other end, from a local
+     * port without a listener */
+    sigar_net_stat_t remote;
+} sigar_net_port_stat_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_net_port_stat_t *data;
+    /* same counts as sigar_net_stat_get */
+    sigar_net_stat_t total;
+    /* private: open addressing port -> data index + 1 */
+    unsigned int *index;
+    unsigned long index_size;
+} sigar_net_port_stat_map_t;
+
+/* state counts for every tcp port from one connection walk */
+SIGAR_DECLARE(int)
+sigar_net_port_stat_map_get(sigar_t *sigar,
+                            sigar_net_port_stat_map_t *portmap,
+                            int flags);
+
+SIGAR_DECLARE(sigar_net_port_stat_t *)
+sigar_net_port_stat_map_find(sigar_net_port_stat_map_t *portmap,
+                             unsigned long port);
+
+SIGAR_DECLARE(int)
+sigar_net_port_stat_map_destroy(sigar_t *sigar,
+                                sigar_net_port_stat_map_t *portmap);
+
 /* TCP-MIB */
 typedef struct {
     sigar_uint64_t active_opens;
@@ -818,6 +1255,99 @@ SIGAR_DECLARE(int)
 sigar_tcp_get(sigar_t *sigar,
               sigar_tcp_t *tcp);
 
+#define SIGAR_NET_PROTO_GROUP_LEN 16
+#define SIGAR_NET_PROTO_NAME_LEN  48
+
+typedef struct {
+    char group[SIGAR_NET_PROTO_GROUP_LEN]; /* "Tcp", "TcpExt", "Ip6", ... */
+    char name[SIGAR_NET_PROTO_NAME_LEN];   /* "ListenOverflows", ... */
+    sigar_uint64_t value;
+    /* change since the previous list_get on this sigar_t, 0 the first time */
+    sigar_uint64_t delta;
+} sigar_net_proto_counter_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_net_proto_counter_t *data;
+} sigar_net_proto_counter_list_t;
+
+/* every counter of the kernel's ip, icmp, tcp and udp MIBs (v4 and v6) */
+SIGAR_DECLARE(int)
+sigar_net_proto_counter_list_get(sigar_t *sigar,
+                                 sigar_net_proto_counter_list_t *counters);
+
+SIGAR_DECLARE(sigar_net_proto_counter_t *)
+sigar_net_proto_counter_find(sigar_net_proto_counter_list_t *counters,
+                             const char *group, const char *name);
+
+SIGAR_DECLARE(int)
+sigar_net_proto_counter_list_destroy(sigar_t *sigar,
+                                     sigar_net_proto_counter_list_t *counters);
+
+#define SIGAR_NETNS_PATH_LEN 256
+
+typedef struct {
+    /* inode of the namespace, the same for every way of naming it */
+    sigar_uint64_t id;
+    /* a process inside it, 0 if it is only bind mounted */
+    sigar_pid_t pid;
+    /* how many processes share it, 0 when addressed directly */
+    unsigned long processes;
+    /* e.g. /run/netns/blue, "" if not bind mounted anywhere we look */
+    char path[SIGAR_NETNS_PATH_LEN];
+} sigar_netns_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_netns_t *data;
+} sigar_netns_list_t;
+
+/* one entry per distinct namespace, however many processes are in it */
+SIGAR_DECLARE(int)
+sigar_netns_list_get(sigar_t *sigar,
+                     sigar_netns_list_t *netnslist);
+
+SIGAR_DECLARE(int)
+sigar_netns_list_destroy(sigar_t *sigar,
+                         sigar_netns_list_t *netnslist);
+
+/* the namespace pid is in */
+SIGAR_DECLARE(int)
+sigar_netns_pid_get(sigar_t *sigar, sigar_pid_t pid,
+                    sigar_netns_t *netns);
+
+/* the namespace bound at path, e.g. by "ip netns add" */
+SIGAR_DECLARE(int)
+sigar_netns_path_get(sigar_t *sigar, const char *path,
+                     sigar_netns_t *netns);
+
+/*
+ * the same as the plain versions, as seen from inside netns.
+ * namespaces with a pid are read through /proc/PID/net,
+ * the rest need setns() and with it CAP_SYS_ADMIN.
+ */
+SIGAR_DECLARE(int)
+sigar_netns_interface_stat_list_get(sigar_t *sigar,
+                                    sigar_netns_t *netns,
+                                    sigar_net_interface_stat_list_t *iflist);
+
+SIGAR_DECLARE(int)
+sigar_netns_connection_list_get(sigar_t *sigar,
+                                sigar_netns_t *netns,
+                                sigar_net_connection_list_t *connlist,
+                                int flags);
+
+/*
+ * deltas are kept per namespace, until a sigar_netns_list_get no
+ * longer lists it.
+ */
+SIGAR_DECLARE(int)
+sigar_netns_proto_counter_list_get(sigar_t *sigar,
+                                   sigar_netns_t *netns,
+                                   sigar_net_proto_counter_list_t *counters);
+
 typedef struct {
     sigar_uint64_t null;
     sigar_uint64_t getattr;
@@ -891,6 +1421,14 @@ sigar_net_listen_address_get(sigar_t *sigar,
                              unsigned long port,
                              sigar_net_address_t *address);
 
+/*
+ * every tcp listener and bound udp socket with its owner, from one walk.
+ * also refreshes the cache sigar_net_listen_address_get answers from.
+ */
+SIGAR_DECLARE(int)
+sigar_net_listener_list_get(sigar_t *sigar,
+                            sigar_net_connection_proc_list_t *connlist);
+
 typedef struct {
     char ifname[MAX_INTERFACE_NAME_LEN];
     char type[64];
@@ -911,6 +1449,86 @@ SIGAR_DECLARE(int) sigar_arp_list_get(sigar_t *sigar,
 SIGAR_DECLARE(int) sigar_arp_list_destroy(sigar_t *sigar,
                                           sigar_arp_list_t *arplist);
 
+typedef struct sigar_arp_walker_t sigar_arp_walker_t;
+
+/* return SIGAR_OK to keep walking, anything else stops the walk */
+struct sigar_arp_walker_t {
+    sigar_t *sigar;
+    int family; /* SIGAR_AF_INET, SIGAR_AF_INET6 or SIGAR_AF_UNSPEC for both */
+    void *data; /* user data */
+    int (*add_arp)(sigar_arp_walker_t *walker,
+                   sigar_arp_t *arp);
+};
+
+/* sigar_arp_list_get is the SIGAR_AF_INET walk */
+SIGAR_DECLARE(int)
+sigar_arp_walk(sigar_arp_walker_t *walker);
+
+typedef struct {
+    char ifname[MAX_INTERFACE_NAME_LEN]; /* the label, e.g. eth0:1 */
+    unsigned long ifindex;
+    sigar_net_address_t address;
+    sigar_net_address_t destination; /* the peer on point-to-point links */
+    sigar_net_address_t broadcast;
+    unsigned long prefix_length;
+    unsigned long scope;  /* RT_SCOPE_* on linux */
+    sigar_uint64_t flags; /* IFA_F_* on linux */
+} sigar_net_interface_address_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_net_interface_address_t *data;
+} sigar_net_interface_address_list_t;
+
+typedef struct sigar_net_interface_address_walker_t
+    sigar_net_interface_address_walker_t;
+
+/* return SIGAR_OK to keep walking, anything else stops the walk */
+struct sigar_net_interface_address_walker_t {
+    sigar_t *sigar;
+    int family; /* SIGAR_AF_INET, SIGAR_AF_INET6 or SIGAR_AF_UNSPEC for both */
+    void *data; /* user data */
+    int (*add_address)(sigar_net_interface_address_walker_t *walker,
+                       sigar_net_interface_address_t *address);
+};
+
+SIGAR_DECLARE(int)
+sigar_net_interface_address_walk(sigar_net_interface_address_walker_t *walker);
+
+/* every address of every interface, both families */
+SIGAR_DECLARE(int)
+sigar_net_interface_address_list_get(sigar_t *sigar,
+                                     sigar_net_interface_address_list_t *addrlist);
+
+SIGAR_DECLARE(int)
+sigar_net_interface_address_list_destroy(sigar_t *sigar,
+                                         sigar_net_interface_address_list_t *addrlist);
+
+typedef struct {
+    sigar_net_interface_config_t config;
+    unsigned long ifindex;
+    /* every ipv4/ipv6 address, points into the list's addresses */
+    unsigned long addresses_number;
+    sigar_net_interface_address_t *addresses;
+} sigar_net_interface_config_entry_t;
+
+typedef struct {
+    unsigned long number;
+    unsigned long size;
+    sigar_net_interface_config_entry_t *data;
+    sigar_net_interface_address_list_t addresses;
+} sigar_net_interface_config_list_t;
+
+/* sigar_net_interface_config_get for every interface at once */
+SIGAR_DECLARE(int)
+sigar_net_interface_config_list_get(sigar_t *sigar,
+                                    sigar_net_interface_config_list_t *iflist);
+
+SIGAR_DECLARE(int)
+sigar_net_interface_config_list_destroy(sigar_t *sigar,
+                                        sigar_net_interface_config_list_t *iflist);
+
 typedef struct {
     char user[32];
     char device[32];
@@ -964,6 +1582,78 @@ typedef struct {
 
 SIGAR_DECLARE(int) sigar_sys_info_get(sigar_t *sigar, sigar_sys_info_t *sysinfo);
 
+/*
+ * counters to rates.  metric and entity (a pid, a device number, an
+ * interface index, ...) are the caller's to choose, each pair keeps
+ * its previous value until it has not been seen for 20 minutes.
+ */
+#define SIGAR_RATE_COUNTER32 0x01 /* wraps at 2^32 rather than 2^64 */
+
+typedef struct {
+    sigar_uint64_t delta;    /* counted since the previous value */
+    sigar_uint64_t interval; /* msec since the previous value, 0 for the first */
+    int reset;               /* went back without wrapping, delta is 0 */
+    double rate;             /* per second, over interval */
+    /* exponentially weighted over 1, 10 and 60 seconds */
+    double rate_1s;
+    double rate_10s;
+    double rate_60s;
+} sigar_rate_t;
+
+SIGAR_DECLARE(int) sigar_rate_get(sigar_t *sigar,
+                                  sigar_uint64_t metric,
+                                  sigar_uint64_t entity,
+                                  sigar_uint64_t value,
+                                  int flags,
+                                  sigar_rate_t *rate);
+
+/*
+ * interned strings: each distinct string is held once per handle and
+ * named by a 32 bit id, so that records kept by the thousand carry ids
+ * in place of char arrays and compare them as integers.  every
+ * sigar_intern of a string takes a reference and every release gives
+ * one back, the last frees it and its id may then name another.
+ */
+#define SIGAR_INTERN_NONE 0
+
+SIGAR_DECLARE(int) sigar_intern(sigar_t *sigar, const char *str,
+                                sigar_uint32_t *id);
+
+/* NULL for an id not held */
+SIGAR_DECLARE(const char *) sigar_intern_str(sigar_t *sigar,
+                                             sigar_uint32_t id);
+
+SIGAR_DECLARE(int) sigar_intern_release(sigar_t *sigar, sigar_uint32_t id);
+
+/* distinct strings held */
+SIGAR_DECLARE(sigar_uint32_t) sigar_intern_count(sigar_t *sigar);
+
+/*
+ * a process with its strings interned, a few dozen bytes for keeping
+ * as history where sigar_proc_state_t, sigar_proc_cred_name_t and
+ * sigar_proc_exe_t take some 13k.  what cannot be read, e.g. the exe
+ * of another user's process, and the args of a process that has none
+ * (a kernel thread) are SIGAR_INTERN_NONE.
+ */
+typedef struct {
+    sigar_pid_t pid;
+    sigar_pid_t ppid;
+    char state;
+    sigar_uint32_t name;
+    sigar_uint32_t user;
+    sigar_uint32_t group;
+    sigar_uint32_t exe;
+    sigar_uint32_t cwd;
+    sigar_uint32_t args; /* joined by ' ' */
+} sigar_proc_interned_t;
+
+SIGAR_DECLARE(int) sigar_proc_interned_get(sigar_t *sigar, sigar_pid_t pid,
+                                           sigar_proc_interned_t *proc);
+
+/* releases its strings */
+SIGAR_DECLARE(int) sigar_proc_interned_release(sigar_t *sigar,
+                                               sigar_proc_interned_t *proc);
+
 #define SIGAR_FQDN_LEN 512
 
 SIGAR_DECLARE(int) sigar_fqdn_get(sigar_t *sigar, char *name, int namelen);
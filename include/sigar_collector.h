@@ -0,0 +1,140 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIGAR_COLLECTOR_H
+#define SIGAR_COLLECTOR_H
+
+/*
+ * background sampling.  sets of metrics are registered with an
+ * interval, a thread of the collector's own samples them on its own
+ * sigar handle and keeps the last ring_size samples of every set.
+ * reading a sample back takes no syscall and no lock, any number of
+ * threads may do so while the collector runs.
+ */
+
+typedef struct sigar_collector_t sigar_collector_t;
+
+#define SIGAR_COLLECT_CPU       0
+#define SIGAR_COLLECT_MEM       1
+#define SIGAR_COLLECT_NETIF     2 /* name is the interface */
+#define SIGAR_COLLECT_DISK      3 /* name is the disk, as sigar_disk_usage_get */
+#define SIGAR_COLLECT_PROC_STAT 4
+#define SIGAR_COLLECT_PROC      5 /* pid is the process */
+
+typedef struct {
+    int type;
+    sigar_uint64_t interval; /* msec */
+    sigar_pid_t pid;
+    char name[SIGAR_FS_NAME_LEN];
+} sigar_collector_set_t;
+
+typedef struct {
+    sigar_proc_cpu_t cpu;
+    sigar_proc_mem_t mem;
+    sigar_proc_state_t state;
+} sigar_collector_proc_t;
+
+typedef struct {
+    sigar_uint64_t seq;       /* 1 for the first sample of the set */
+    sigar_uint64_t scheduled; /* msec on the monotonic clock, when due */
+    sigar_uint64_t time;      /* msec on the monotonic clock, when taken */
+    sigar_uint64_t timestamp; /* msec since the epoch, when taken */
+    /* time - scheduled; max and total are over the whole run */
+    sigar_uint64_t jitter;
+    sigar_uint64_t jitter_max;
+    sigar_uint64_t jitter_total;
+    /* intervals skipped so far, when a sample ran past the next one */
+    sigar_uint64_t missed;
+    int type;
+    int status; /* of the sigar call, data is zeroed unless SIGAR_OK */
+    union {
+        sigar_cpu_t cpu;
+        sigar_mem_t mem;
+        sigar_net_interface_stat_t netif;
+        sigar_disk_usage_t disk;
+        sigar_proc_stat_t proc_stat;
+        sigar_collector_proc_t proc;
+    } data;
+} sigar_collector_sample_t;
+
+/* ring_size is rounded up to a power of 2 */
+SIGAR_DECLARE(int) sigar_collector_create(sigar_collector_t **collector,
+                                          unsigned long ring_size);
+
+/* only before sigar_collector_start, EBUSY after */
+SIGAR_DECLARE(int) sigar_collector_add(sigar_collector_t *collector,
+                                       sigar_collector_set_t *set,
+                                       int *id);
+
+SIGAR_DECLARE(int) sigar_collector_start(sigar_collector_t *collector);
+
+SIGAR_DECLARE(int) sigar_collector_stop(sigar_collector_t *collector);
+
+SIGAR_DECLARE(int) sigar_collector_destroy(sigar_collector_t *collector);
+
+/* ENOENT until the set has its first sample */
+SIGAR_DECLARE(int)
+sigar_collector_latest_get(sigar_collector_t *collector, int id,
+                           sigar_collector_sample_t *sample);
+
+/* ENOENT if seq is not taken yet or already overwritten */
+SIGAR_DECLARE(int)
+sigar_collector_sample_get(sigar_collector_t *collector, int id,
+                           sigar_uint64_t seq,
+                           sigar_collector_sample_t *sample);
+
+/*
+ * publish the latest sample of every set in the POSIX shared memory
+ * segment name (e.g. "/sigar"), for other processes to read through
+ * sigar_collector_shm_*.  after the sets are added and before start,
+ * the segment is unlinked again by sigar_collector_destroy.  EEXIST
+ * while another publisher of name is live, one that closed, or died
+ * and missed a few intervals' heartbeats, is replaced.
+ */
+SIGAR_DECLARE(int) sigar_collector_publish(sigar_collector_t *collector,
+                                           const char *name);
+
+typedef struct sigar_collector_shm_t sigar_collector_shm_t;
+
+typedef struct {
+    sigar_uint64_t number; /* of sets */
+    sigar_pid_t pid;       /* of the publisher */
+    sigar_uint64_t started;
+    sigar_uint64_t heartbeat; /* last sample written, or started */
+    int closed;
+} sigar_collector_shm_info_t;
+
+/*
+ * maps the segment read-only.  EINVAL if it was published by another
+ * layout version or by a build with another sample size.
+ */
+SIGAR_DECLARE(int) sigar_collector_shm_open(sigar_collector_shm_t **reader,
+                                            const char *name);
+
+SIGAR_DECLARE(int) sigar_collector_shm_close(sigar_collector_shm_t *reader);
+
+SIGAR_DECLARE(int)
+sigar_collector_shm_info_get(sigar_collector_shm_t *reader,
+                             sigar_collector_shm_info_t *info);
+
+SIGAR_DECLARE(int)
+sigar_collector_shm_set_get(sigar_collector_shm_t *reader, int id,
+                            sigar_collector_set_t *set);
+
+/* ESRCH once the publisher has been destroyed */
+SIGAR_DECLARE(int)
+sigar_collector_shm_latest_get(sigar_collector_shm_t *reader, int id,
+                               sigar_collector_sample_t *sample);
+
+#endif /*SIGAR_COLLECTOR_H*/
@@ -127,10 +127,26 @@ typedef struct {
     sigar_uint64_t blkdevs;
     sigar_uint64_t sockets;
     sigar_uint64_t disk_usage;
+    /** Bytes actually allocated on disk (st_blocks) */
+    sigar_uint64_t disk_allocated;
+    /** Links to files already counted, not added to disk_usage */
+    sigar_uint64_t hardlinks;
 } sigar_dir_stat_t;
 
 typedef sigar_dir_stat_t sigar_dir_usage_t;
 
+/** Do not descend into other file systems (du -x) */
+#define SIGAR_DIR_USAGE_ONE_FS 0x1
+
+typedef struct {
+    /** Levels to descend below dir, < 0 for no limit */
+    int max_depth;
+    /** SIGAR_DIR_USAGE_* flags */
+    int flags;
+    /** Scanner threads, 0 for the default */
+    int threads;
+} sigar_dir_usage_opts_t;
+
 SIGAR_DECLARE(const char *)
 sigar_file_attrs_type_string_get(sigar_file_type_e type);
 
@@ -155,3 +171,8 @@ SIGAR_DECLARE(int) sigar_dir_stat_get(sigar_t *sigar,
 SIGAR_DECLARE(int) sigar_dir_usage_get(sigar_t *sigar,
                                        const char *dir,
                                        sigar_dir_usage_t *dirusage);
+
+SIGAR_DECLARE(int) sigar_dir_usage_scan(sigar_t *sigar,
+                                        const char *dir,
+                                        sigar_dir_usage_opts_t *opts,
+                                        sigar_dir_usage_t *dirusage);
@@ -0,0 +1,223 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIGAR_PARSE_H
+#define SIGAR_PARSE_H
+
+/*
+ * tokenizing and number parsing of /proc text, in place of the locale
+ * aware ctype and strtoull.  each function is given the end of the
+ * text (its NUL, e.g. buffer + len) and never reads at or past it.
+ * where the byte order allows, runs of digits and of spaces are taken
+ * 8 bytes at a time in a 64 bit word.
+ *
+ * needs sigar.h and sigar_private.h first.
+ */
+
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+#  if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#    define SIGAR_PARSE_SWAR
+#  endif
+#elif defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM64)
+#  define SIGAR_PARSE_SWAR
+#endif
+
+/* the C locale's, whatever setlocale says */
+#define sigar_parse_isspace(c) \
+    (((c) == ' ') || ((unsigned char)((c) - '\t') < 5))
+
+#define sigar_parse_isdigit(c) \
+    ((unsigned char)((c) - '0') < 10)
+
+#define sigar_parse_isxdigit(c) \
+    (sigar_parse_isdigit(c) || \
+     ((unsigned char)(((c) | 0x20) - 'a') < 6))
+
+/* no checking, 'A'-'F' and 'a'-'f' have bit 6 set and 1-6 below */
+#define sigar_parse_xvalue(c) \
+    (((c) & 0x0f) + (9 * (((c) >> 6) & 1)))
+
+#define SIGAR_PARSE_ONES 0x0101010101010101ULL
+
+static SIGAR_INLINE sigar_uint64_t sigar_parse_load8(const char *p)
+{
+    sigar_uint64_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* the 8 bytes are all '0'-'9' */
+#define sigar_parse_is8digits(v) \
+    (((((v) & (SIGAR_PARSE_ONES * 0xf0)) | \
+       ((((v) + (SIGAR_PARSE_ONES * 0x06)) & \
+         (SIGAR_PARSE_ONES * 0xf0)) >> 4)) == (SIGAR_PARSE_ONES * 0x33)))
+
+/* 8 digits, the first in the low byte, in 3 multiplies */
+static SIGAR_INLINE sigar_uint64_t sigar_parse_8digits(sigar_uint64_t v)
+{
+    const sigar_uint64_t mask = 0x000000ff000000ffULL;
+
+    v -= SIGAR_PARSE_ONES * '0';
+    v = (v * 10) + (v >> 8);
+    v = (((v & mask) * (100 + (1000000ULL << 32))) +
+         (((v >> 16) & mask) * (1 + (10000ULL << 32)))) >> 32;
+
+    return v;
+}
+
+/* p past any spaces */
+static SIGAR_INLINE char *sigar_parse_space(char *p, const char *end)
+{
+#ifdef SIGAR_PARSE_SWAR
+    /* the column padding of the /proc/net tables */
+    while (((end - p) >= 8) &&
+           (sigar_parse_load8(p) == (SIGAR_PARSE_ONES * ' ')))
+    {
+        p += 8;
+    }
+#endif
+    while ((p < end) && sigar_parse_isspace(*p)) {
+        p++;
+    }
+
+    return p;
+}
+
+/* p past the token at or after it, as sigar_skip_token */
+static SIGAR_INLINE char *sigar_parse_skip(char *p, const char *end)
+{
+    p = sigar_parse_space(p, end);
+    while ((p < end) && !sigar_parse_isspace(*p)) {
+        p++;
+    }
+
+    return p;
+}
+
+/*
+ * the decimal after any spaces at *ptr, as strtoull reads it, '-'
+ * included.  *ptr is left past it, or where it was if there is none.
+ */
+static SIGAR_INLINE sigar_uint64_t sigar_parse_u64(char **ptr,
+                                                   const char *end)
+{
+    char *p = sigar_parse_space(*ptr, end), *digits;
+    sigar_uint64_t value = 0;
+    int negative = 0;
+
+    if ((p < end) && ((*p == '-') || (*p == '+'))) {
+        negative = (*p++ == '-');
+    }
+    digits = p;
+
+#ifdef SIGAR_PARSE_SWAR
+    while ((end - p) >= 8) {
+        sigar_uint64_t v = sigar_parse_load8(p);
+
+        if (!sigar_parse_is8digits(v)) {
+            break;
+        }
+        value = (value * 100000000) + sigar_parse_8digits(v);
+        p += 8;
+    }
+#endif
+    while ((p < end) && sigar_parse_isdigit(*p)) {
+        value = (value * 10) + (*p++ - '0');
+    }
+
+    if (p == digits) {
+        return 0;
+    }
+
+    *ptr = p;
+
+    return negative ? (0 - value) : value;
+}
+
+/* the hex digits after any spaces at *ptr, as strtoull(..., 16) */
+static SIGAR_INLINE sigar_uint64_t sigar_parse_x64(char **ptr,
+                                                   const char *end)
+{
+    char *p = sigar_parse_space(*ptr, end);
+    sigar_uint64_t value = 0;
+
+    while ((p < end) && sigar_parse_isxdigit(*p)) {
+        value = (value << 4) | sigar_parse_xvalue(*p);
+        p++;
+    }
+
+    *ptr = p;
+
+    return value;
+}
+
+/* the len hex digits at p, no checking, as the fixed width fields */
+static SIGAR_INLINE unsigned int sigar_parse_hex(const char *p, int len)
+{
+    unsigned int value = 0;
+
+    while (len-- > 0) {
+        value = (value << 4) | sigar_parse_xvalue(*p);
+        p++;
+    }
+
+    return value;
+}
+
+/* the 8 hex digits at p, the addresses and queues of /proc/net/tcp */
+static SIGAR_INLINE unsigned int sigar_parse_hex32(const char *p)
+{
+#ifdef SIGAR_PARSE_SWAR
+    sigar_uint64_t v = sigar_parse_load8(p);
+
+    /* a nibble per byte, then pairs, quads and the lot */
+    v = (v & (SIGAR_PARSE_ONES * 0x0f)) +
+        (9 * ((v >> 6) & SIGAR_PARSE_ONES));
+    v = ((v << 4) | (v >> 8)) & 0x00ff00ff00ff00ffULL;
+    v = ((v << 8) | (v >> 16)) & 0x0000ffff0000ffffULL;
+    v = ((v << 16) | (v >> 32)) & 0xffffffffULL;
+
+    return (unsigned int)v;
+#else
+    return sigar_parse_hex(p, 8);
+#endif
+}
+
+/*
+ * the start of each of up to max space separated fields from p, the
+ * jump table a parser then reads its fields from by number.  returns
+ * the number found.
+ */
+static SIGAR_INLINE int sigar_parse_fields(char *p, const char *end,
+                                           char **fields, int max)
+{
+    int num = 0;
+
+    while (num < max) {
+        if ((p = sigar_parse_space(p, end)) >= end) {
+            break;
+        }
+        fields[num++] = p;
+        while ((p < end) && !sigar_parse_isspace(*p)) {
+            p++;
+        }
+    }
+
+    return num;
+}
+
+#endif /* SIGAR_PARSE_H */
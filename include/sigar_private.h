@@ -40,6 +40,18 @@
 #include <dmalloc.h>
 #endif
 
+typedef struct sigar_fs_pool_t sigar_fs_pool_t;
+
+typedef struct sigar_threads_t sigar_threads_t;
+
+typedef struct sigar_stats_state_t sigar_stats_state_t;
+
+typedef struct sigar_replay_t sigar_replay_t;
+
+typedef struct sigar_list_pool_t sigar_list_pool_t;
+
+typedef struct sigar_intern_t sigar_intern_t;
+
 /* common to all os sigar_t's */
 /* XXX: this is ugly; but don't want the same stuffs
  * duplicated on 4 platforms and am too lazy to change
@@ -67,9 +79,20 @@
    sigar_cache_t *fsdev; \
    sigar_cache_t *proc_cpu; \
    sigar_cache_t *net_listen; \
+   sigar_uint64_t net_listen_time; \
    sigar_cache_t *net_services_tcp; \
    sigar_cache_t *net_services_udp;\
-   sigar_cache_t *proc_io
+   sigar_cache_t *proc_io; \
+   sigar_cache_t *rates; \
+   sigar_fs_pool_t *fs_pool; \
+   sigar_threads_t *threads; \
+   int stats_enabled; \
+   sigar_stats_state_t *stats; \
+   char *proc_root; \
+   char *sys_root; \
+   sigar_replay_t *replay; \
+   sigar_list_pool_t *list_pool; \
+   sigar_intern_t *intern
 
 #if defined(WIN32)
 #   define SIGAR_INLINE __inline
@@ -94,6 +117,115 @@
 #define SIGAR_ZERO(s) \
     memset(s, '\0', sizeof(*(s)))
 
+/*
+ * sigar_open_threadsafe: whatever sigar_t caches between calls
+ * is guarded by sigar_lock(), which is recursive and a no-op for
+ * a handle from plain sigar_open.  what one call needs only for
+ * its own duration lives in a per-thread sigar_thread_scratch_t.
+ */
+typedef struct sigar_thread_scratch_t sigar_thread_scratch_t;
+
+struct sigar_thread_scratch_t {
+    sigar_thread_scratch_t *next;
+    sigar_t *sigar;
+    char errbuf[256];
+    void *os; /* e.g. linux_proc_stat_t, free()d along with the rest */
+};
+
+void sigar_lock(sigar_t *sigar);
+
+void sigar_unlock(sigar_t *sigar);
+
+/* NULL unless threadsafe */
+sigar_thread_scratch_t *sigar_thread_scratch_get(sigar_t *sigar);
+
+/*
+ * publishing a sequence number to lock-free readers: the store
+ * releases what was written before it, the load acquires it.
+ */
+#if defined(__ATOMIC_ACQUIRE)
+#define SIGAR_ATOMIC_LOAD(p) \
+    __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define SIGAR_ATOMIC_STORE(p, v) \
+    __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define SIGAR_ATOMIC_FENCE() \
+    __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define SIGAR_ATOMIC_LOAD(p) \
+    __sync_fetch_and_add(p, 0)
+#define SIGAR_ATOMIC_STORE(p, v) \
+    (__sync_synchronize(), (void)__sync_lock_test_and_set(p, v))
+#define SIGAR_ATOMIC_FENCE() \
+    __sync_synchronize()
+#endif
+
+/* counters, no ordering implied */
+#if defined(_MSC_VER)
+#define SIGAR_ATOMIC_ADD(p, v) \
+    InterlockedExchangeAdd64((LONGLONG volatile *)(p), v)
+#elif defined(__ATOMIC_RELAXED)
+#define SIGAR_ATOMIC_ADD(p, v) \
+    __atomic_fetch_add(p, v, __ATOMIC_RELAXED)
+#else
+#define SIGAR_ATOMIC_ADD(p, v) \
+    __sync_fetch_and_add(p, v)
+#endif
+
+/* nonzero if *p was o and is now n */
+#if defined(_MSC_VER)
+#define SIGAR_ATOMIC_CAS(p, o, n) \
+    (InterlockedCompareExchange64((LONGLONG volatile *)(p), n, o) == \
+     (LONGLONG)(o))
+#else
+#define SIGAR_ATOMIC_CAS(p, o, n) \
+    __sync_bool_compare_and_swap(p, o, n)
+#endif
+
+/*
+ * instrumented calls, see sigar_stats_enable:
+ *
+ *   SIGAR_STATS_BEGIN(sigar);
+ *   int status = sigar_os_cpu_get(sigar, cpu);
+ *
+ *   return SIGAR_STATS_END(sigar, SIGAR_STATS_CPU, status);
+ *
+ * BEGIN is a declaration and goes with the others.
+ */
+sigar_uint64_t sigar_stats_now(void);
+
+int sigar_stats_end(sigar_t *sigar, int api,
+                    sigar_uint64_t start, int status);
+
+#define SIGAR_STATS_BEGIN(sigar) \
+    sigar_uint64_t stats_start = \
+        (sigar)->stats_enabled ? sigar_stats_now() : 0
+
+#define SIGAR_STATS_END(sigar, api, status) \
+    ((sigar)->stats_enabled ? \
+     sigar_stats_end(sigar, api, stats_start, status) : (status))
+
+/* the proc_cpu, proc_io and rates caches of a threadsafe handle's shards */
+void sigar_stats_shards(sigar_t *sigar, sigar_stats_t *stats);
+
+/* file reads of the whole process, counted while any handle has stats */
+extern volatile sigar_int64_t sigar_stats_users;
+
+void sigar_stats_file_read(int opened, sigar_uint64_t bytes);
+
+/*
+ * what the file, link and directory reads returned, for replay on
+ * another host (see sigar_record_start).  only worth the call while
+ * sigar_recording is set, paths outside /proc and /sys are ignored.
+ */
+extern volatile int sigar_recording;
+
+void sigar_record_file(const char *path, const char *data, size_t len);
+
+void sigar_record_link(const char *path, const char *target, size_t len);
+
+/* the entries of path and the targets of its numbered links */
+void sigar_record_dir(const char *path);
+
 #define SIGAR_STRNCPY(dest, src, len) \
     strncpy(dest, src, len); \
     dest[len-1] = '\0'
@@ -157,6 +289,8 @@
 
 #define SIGAR_FS_MAX 10
 
+#define SIGAR_DISK_IO_LIST_MAX 16
+
 #define SIGAR_CPU_INFO_MAX 4
 
 #define SIGAR_CPU_LIST_MAX 4
@@ -175,10 +309,44 @@
 
 #define SIGAR_WHO_LIST_MAX 12
 
+/* lists start out at their _MAX and double from there */
+#define SIGAR_LIST_GROW_SIZE(size, max) \
+    ((size) + (((size) > (max)) ? (size) : (max)))
+
+/* the lists sigar_list_recycle_set keeps the data of */
+enum {
+    SIGAR_LIST_PROC,
+    SIGAR_LIST_CPU,
+    SIGAR_LIST_FS,
+    SIGAR_LIST_DISK_IO,
+    SIGAR_LIST_NET_ROUTE,
+    SIGAR_LIST_NET_IFSTAT,
+    SIGAR_LIST_NET_CONN,
+    SIGAR_LIST_ARP,
+    SIGAR_LIST_WHO,
+    SIGAR_LIST_KINDS
+};
+
+/*
+ * data for at least *size entries of elt_size, kept from a list of the
+ * same kind if there is one, in which case *size is what it holds
+ */
+void *sigar_list_alloc(sigar_t *sigar, int kind, size_t elt_size,
+                       unsigned long *size);
+
+/* to be kept if recycling, free()d if not */
+void sigar_list_free(sigar_t *sigar, int kind, void *data,
+                     unsigned long size);
+
+void sigar_intern_destroy(sigar_intern_t *intern);
+
 int sigar_os_open(sigar_t **sigar);
 
 int sigar_os_close(sigar_t *sigar);
 
+/* after sigar_proc_root_set, drop whatever was read from the old roots */
+int sigar_os_proc_root_set(sigar_t *sigar);
+
 char *sigar_os_error_string(sigar_t *sigar, int err);
 
 char *sigar_strerror_get(int err, char *errbuf, int buflen);
@@ -194,7 +362,86 @@ int sigar_os_sys_info_get(sigar_t *sigar, sigar_sys_info_t *sysinfo);
 int sigar_os_proc_list_get(sigar_t *sigar,
                            sigar_proc_list_t *proclist);
 
-int sigar_proc_list_create(sigar_proc_list_t *proclist);
+/* the os side of the instrumented public calls */
+int sigar_os_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu);
+
+int sigar_os_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist);
+
+int sigar_os_mem_get(sigar_t *sigar, sigar_mem_t *mem);
+
+int sigar_os_swap_get(sigar_t *sigar, sigar_swap_t *swap);
+
+int sigar_os_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
+                            sigar_proc_state_t *procstate);
+
+int sigar_os_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
+                          sigar_proc_mem_t *procmem);
+
+int sigar_os_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
+                           sigar_proc_time_t *proctime);
+
+int sigar_os_file_system_list_get(sigar_t *sigar,
+                                  sigar_file_system_list_t *fslist);
+
+int sigar_os_disk_usage_get(sigar_t *sigar, const char *name,
+                            sigar_disk_usage_t *disk);
+
+int sigar_os_net_interface_stat_get(sigar_t *sigar, const char *name,
+                                    sigar_net_interface_stat_t *ifstat);
+
+int sigar_os_net_interface_stat_list_get(sigar_t *sigar,
+                                         sigar_net_interface_stat_list_t *iflist);
+
+int sigar_os_net_interface_config_list_get(sigar_t *sigar,
+                                           sigar_net_interface_config_list_t *iflist);
+
+int sigar_os_net_interface_address_list_get(sigar_t *sigar,
+                                            sigar_net_interface_address_list_t *addrlist);
+
+int sigar_os_net_connection_walk(sigar_net_connection_walker_t *walker);
+
+int sigar_os_net_connection_list_get(sigar_t *sigar,
+                                     sigar_net_connection_list_t *connlist,
+                                     int flags);
+
+int sigar_os_net_unix_connection_list_get(sigar_t *sigar,
+                                          sigar_net_unix_connection_list_t *connlist,
+                                          int flags);
+
+int sigar_os_net_connection_info_list_get(sigar_t *sigar,
+                                          sigar_net_connection_info_list_t *connlist,
+                                          int flags);
+
+int sigar_os_net_port_tcp_info_list_get(sigar_t *sigar,
+                                        sigar_net_port_tcp_info_list_t *portlist);
+
+int sigar_os_net_connection_proc_list_get(sigar_t *sigar,
+                                          sigar_net_connection_proc_list_t *connlist,
+                                          int flags);
+
+int sigar_os_net_proto_counter_list_get(sigar_t *sigar,
+                                        sigar_net_proto_counter_list_t *counters);
+
+int sigar_os_netns_list_get(sigar_t *sigar,
+                            sigar_netns_list_t *netnslist);
+
+int sigar_os_netns_interface_stat_list_get(sigar_t *sigar,
+                                           sigar_netns_t *netns,
+                                           sigar_net_interface_stat_list_t *iflist);
+
+int sigar_os_netns_connection_list_get(sigar_t *sigar,
+                                       sigar_netns_t *netns,
+                                       sigar_net_connection_list_t *connlist,
+                                       int flags);
+
+int sigar_os_netns_proto_counter_list_get(sigar_t *sigar,
+                                          sigar_netns_t *netns,
+                                          sigar_net_proto_counter_list_t *counters);
+
+int sigar_os_disk_io_list_get(sigar_t *sigar,
+                              sigar_disk_io_list_t *disklist);
+
+int sigar_proc_list_create(sigar_t *sigar, sigar_proc_list_t *proclist);
 
 int sigar_proc_list_grow(sigar_proc_list_t *proclist);
 
@@ -215,7 +462,7 @@ int sigar_proc_args_grow(sigar_proc_args_t *procargs);
 int sigar_os_proc_args_get(sigar_t *sigar, sigar_pid_t pid,
                            sigar_proc_args_t *procargs);
 
-int sigar_file_system_list_create(sigar_file_system_list_t *fslist);
+int sigar_file_system_list_create(sigar_t *sigar, sigar_file_system_list_t *fslist);
 
 int sigar_file_system_list_grow(sigar_file_system_list_t *fslist);
 
@@ -226,6 +473,17 @@ int sigar_file_system_list_grow(sigar_file_system_list_t *fslist);
 
 int sigar_os_fs_type_get(sigar_file_system_t *fsp);
 
+int sigar_disk_io_list_create(sigar_t *sigar, sigar_disk_io_list_t *disklist);
+
+int sigar_disk_io_list_grow(sigar_disk_io_list_t *disklist);
+
+#define SIGAR_DISK_IO_LIST_GROW(disklist) \
+    if (disklist->number >= disklist->size) { \
+        sigar_disk_io_list_grow(disklist); \
+    }
+
+void sigar_fs_pool_destroy(sigar_fs_pool_t *pool);
+
 /* os plugins that set fsp->type call fs_type_get directly */
 #define sigar_fs_type_init(fsp) \
    fsp->type = SIGAR_FSTYPE_UNKNOWN; \
@@ -242,7 +500,7 @@ int sigar_cpu_info_list_grow(sigar_cpu_info_list_t *cpu_infos);
         sigar_cpu_info_list_grow(cpu_infos); \
     }
 
-int sigar_cpu_list_create(sigar_cpu_list_t *cpulist);
+int sigar_cpu_list_create(sigar_t *sigar, sigar_cpu_list_t *cpulist);
 
 int sigar_cpu_list_grow(sigar_cpu_list_t *cpulist);
 
@@ -251,7 +509,7 @@ int sigar_cpu_list_grow(sigar_cpu_list_t *cpulist);
         sigar_cpu_list_grow(cpulist); \
     }
 
-int sigar_net_route_list_create(sigar_net_route_list_t *routelist);
+int sigar_net_route_list_create(sigar_t *sigar, sigar_net_route_list_t *routelist);
 
 int sigar_net_route_list_grow(sigar_net_route_list_t *net_routelist);
 
@@ -269,7 +527,16 @@ int sigar_net_interface_list_grow(sigar_net_interface_list_t *iflist);
         sigar_net_interface_list_grow(iflist); \
     }
 
-int sigar_net_connection_list_create(sigar_net_connection_list_t *connlist);
+int sigar_net_interface_stat_list_create(sigar_t *sigar, sigar_net_interface_stat_list_t *iflist);
+
+int sigar_net_interface_stat_list_grow(sigar_net_interface_stat_list_t *iflist);
+
+#define SIGAR_NET_IFSTAT_LIST_GROW(iflist) \
+    if (iflist->number >= iflist->size) { \
+        sigar_net_interface_stat_list_grow(iflist); \
+    }
+
+int sigar_net_connection_list_create(sigar_t *sigar, sigar_net_connection_list_t *connlist);
 
 int sigar_net_connection_list_grow(sigar_net_connection_list_t *connlist);
 
@@ -278,6 +545,95 @@ int sigar_net_connection_list_grow(sigar_net_connection_list_t *connlist);
         sigar_net_connection_list_grow(connlist); \
     }
 
+int sigar_net_connection_info_list_create(sigar_net_connection_info_list_t *connlist);
+
+int sigar_net_connection_info_list_grow(sigar_net_connection_info_list_t *connlist);
+
+#define SIGAR_NET_CONNINFO_LIST_GROW(connlist) \
+    if (connlist->number >= connlist->size) { \
+        sigar_net_connection_info_list_grow(connlist); \
+    }
+
+int sigar_net_unix_connection_list_create(sigar_net_unix_connection_list_t *connlist);
+
+int sigar_net_unix_connection_list_grow(sigar_net_unix_connection_list_t *connlist);
+
+#define SIGAR_NET_UNIX_CONNLIST_GROW(connlist) \
+    if (connlist->number >= connlist->size) { \
+        sigar_net_unix_connection_list_grow(connlist); \
+    }
+
+int sigar_net_port_tcp_info_list_create(sigar_net_port_tcp_info_list_t *portlist);
+
+int sigar_net_port_tcp_info_list_grow(sigar_net_port_tcp_info_list_t *portlist);
+
+#define SIGAR_NET_PORT_TCP_INFO_LIST_GROW(portlist) \
+    if (portlist->number >= portlist->size) { \
+        sigar_net_port_tcp_info_list_grow(portlist); \
+    }
+
+int sigar_net_connection_proc_list_create(sigar_net_connection_proc_list_t *connlist);
+
+int sigar_net_connection_proc_list_grow(sigar_net_connection_proc_list_t *connlist);
+
+#define SIGAR_NET_CONNPROC_LIST_GROW(connlist) \
+    if (connlist->number >= connlist->size) { \
+        sigar_net_connection_proc_list_grow(connlist); \
+    }
+
+#define SIGAR_NET_PORTMAP_MAX 64
+
+int sigar_net_port_stat_map_create(sigar_net_port_stat_map_t *portmap);
+
+int sigar_net_port_stat_map_grow(sigar_net_port_stat_map_t *portmap);
+
+#define SIGAR_NET_PORT_STAT_MAP_GROW(portmap) \
+    if (portmap->number >= portmap->size) { \
+        sigar_net_port_stat_map_grow(portmap); \
+    }
+
+#define SIGAR_NET_PROTO_COUNTER_MAX 128
+
+int sigar_net_proto_counter_list_create(sigar_net_proto_counter_list_t *counters);
+
+int sigar_net_proto_counter_list_grow(sigar_net_proto_counter_list_t *counters);
+
+#define SIGAR_NET_PROTO_COUNTER_LIST_GROW(counters) \
+    if (counters->number >= counters->size) { \
+        sigar_net_proto_counter_list_grow(counters); \
+    }
+
+#define SIGAR_NETNS_LIST_MAX 8
+
+int sigar_netns_list_create(sigar_netns_list_t *netnslist);
+
+int sigar_netns_list_grow(sigar_netns_list_t *netnslist);
+
+#define SIGAR_NETNS_LIST_GROW(netnslist) \
+    if (netnslist->number >= netnslist->size) { \
+        sigar_netns_list_grow(netnslist); \
+    }
+
+#define SIGAR_NET_ADDRESS_LIST_MAX 8
+
+int sigar_net_interface_address_list_create(sigar_net_interface_address_list_t *addrlist);
+
+int sigar_net_interface_address_list_grow(sigar_net_interface_address_list_t *addrlist);
+
+#define SIGAR_NET_ADDRESS_LIST_GROW(addrlist) \
+    if (addrlist->number >= addrlist->size) { \
+        sigar_net_interface_address_list_grow(addrlist); \
+    }
+
+int sigar_net_interface_config_list_create(sigar_net_interface_config_list_t *iflist);
+
+int sigar_net_interface_config_list_grow(sigar_net_interface_config_list_t *iflist);
+
+#define SIGAR_NET_IFCONFIG_LIST_GROW(iflist) \
+    if (iflist->number >= iflist->size) { \
+        sigar_net_interface_config_list_grow(iflist); \
+    }
+
 #define sigar_net_address_set(a, val) \
     (a).addr.in = val; \
     (a).family = SIGAR_AF_INET
@@ -299,6 +655,9 @@ int sigar_net_connection_list_grow(sigar_net_connection_list_t *connlist);
 int sigar_net_interface_ipv6_config_get(sigar_t *sigar, const char *name,
                                         sigar_net_interface_config_t *ifconfig);
 
+/* native IFF_* to SIGAR_IFF_* */
+sigar_uint64_t sigar_net_interface_flags_to_sigar(sigar_uint64_t flags);
+
 #define sigar_net_interface_ipv6_config_init(ifconfig) \
     ifconfig->address6.family = SIGAR_AF_INET6; \
     ifconfig->prefix6_length = 0; \
@@ -322,7 +681,7 @@ int sigar_net_interface_ipv6_config_get(sigar_t *sigar, const char *name,
 
 int sigar_tcp_curr_estab(sigar_t *sigar, sigar_tcp_t *tcp);
 
-int sigar_arp_list_create(sigar_arp_list_t *arplist);
+int sigar_arp_list_create(sigar_t *sigar, sigar_arp_list_t *arplist);
 
 int sigar_arp_list_grow(sigar_arp_list_t *arplist);
 
@@ -331,7 +690,7 @@ int sigar_arp_list_grow(sigar_arp_list_t *arplist);
         sigar_arp_list_grow(arplist); \
     }
 
-int sigar_who_list_create(sigar_who_list_t *wholist);
+int sigar_who_list_create(sigar_t *sigar, sigar_who_list_t *wholist);
 
 int sigar_who_list_grow(sigar_who_list_t *wholist);
 
@@ -18,6 +18,8 @@
 #ifndef SIGAR_UTIL_H
 #define SIGAR_UTIL_H
 
+#include <stdio.h>
+
 /* most of this is crap for dealing with linux /proc */
 #define UITOA_BUFFER_SIZE \
     (sizeof(int) * 3 + 1)
@@ -64,8 +66,15 @@
 #define PROCP_FS_ROOT "/proc/"
 #endif
 
+#ifndef SYS_FS_ROOT
+#define SYS_FS_ROOT "/sys/"
+#endif
+
 sigar_int64_t sigar_time_now_millis(void);
 
+/* not affected by the wall clock being set, for intervals */
+sigar_uint64_t sigar_time_monotonic_millis(void);
+
 char *sigar_uitoa(char *buf, unsigned int n, int *len);
 
 int sigar_inet_ntoa(sigar_t *sigar,
@@ -87,23 +96,39 @@ char *sigar_strcasestr(const char *s1, const char *s2);
 
 int sigar_file2str(const char *fname, char *buffer, int buflen);
 
-int sigar_proc_file2str(char *buffer, int buflen,
+/* fopen(fname, "r") and fclose, counted by sigar_stats_get */
+FILE *sigar_fopen(const char *fname);
+
+int sigar_fclose(FILE *fp);
+
+/*
+ * path, a PROC_FS_ROOT or SYS_FS_ROOT one, under sigar->proc_root or
+ * sigar->sys_root when set (see sigar_proc_root_set) and copied into
+ * buffer.  path itself otherwise.
+ */
+const char *sigar_root_path(sigar_t *sigar, const char *path,
+                            char *buffer, int buflen);
+
+#define SIGAR_ROOT_PATH(sigar, path, buffer) \
+    sigar_root_path(sigar, path, buffer, sizeof(buffer))
+
+int sigar_proc_file2str(sigar_t *sigar, char *buffer, int buflen,
                         sigar_pid_t pid,
                         const char *fname,
                         int fname_len);
 
-#define SIGAR_PROC_FILE2STR(buffer, pid, fname) \
-    sigar_proc_file2str(buffer, sizeof(buffer), \
+#define SIGAR_PROC_FILE2STR(sigar, buffer, pid, fname) \
+    sigar_proc_file2str(sigar, buffer, sizeof(buffer), \
                         pid, fname, SSTRLEN(fname))
 
-#define SIGAR_PROC_FILENAME(buffer, pid, fname) \
-    sigar_proc_filename(buffer, sizeof(buffer), \
+#define SIGAR_PROC_FILENAME(sigar, buffer, pid, fname) \
+    sigar_proc_filename(sigar, buffer, sizeof(buffer), \
                         pid, fname, SSTRLEN(fname))
 
 #define SIGAR_SKIP_SPACE(ptr) \
     while (sigar_isspace(*ptr)) ++ptr
 
-char *sigar_proc_filename(char *buffer, int buflen,
+char *sigar_proc_filename(sigar_t *sigar, char *buffer, int buflen,
                           sigar_pid_t pid,
                           const char *fname, int fname_len);
 
@@ -131,10 +156,27 @@ double sigar_file_system_usage_calc_used(sigar_t *sigar,
 #define SIGAR_NAME_IS_DEV(dev) \
     strnEQ(dev, SIGAR_DEV_PREFIX, SSTRLEN(SIGAR_DEV_PREFIX))
 
+/* the previous value of a counter, see sigar_rate_get */
+typedef struct {
+    sigar_uint64_t value;
+    sigar_uint64_t time; /* sigar_time_monotonic_millis, 0 until the first */
+    sigar_rate_t last;
+} sigar_rate_state_t;
+
+void sigar_rate_update(sigar_rate_state_t *state,
+                       sigar_uint64_t value,
+                       sigar_uint64_t now,
+                       int flags,
+                       sigar_rate_t *rate);
+
 typedef struct {
     char name[256];
     int is_partition;
     sigar_disk_usage_t disk;
+    /* reads + writes, time and qtime, for service_time and queue */
+    sigar_rate_state_t ios;
+    sigar_rate_state_t time;
+    sigar_rate_state_t qtime;
 } sigar_iodev_t;
 
 sigar_iodev_t *sigar_iodev_get(sigar_t *sigar,
@@ -180,6 +222,8 @@ typedef struct {
     sigar_uint64_t entry_expire_period;
     sigar_uint64_t cleanup_period_millis;
     sigar_uint64_t last_cleanup_time;
+    /* get or find of an existing entry, get of a new one */
+    sigar_uint64_t hits, misses;
 } sigar_cache_t;
 
 sigar_cache_t *sigar_cache_new(int size);
@@ -194,4 +238,23 @@ sigar_cache_entry_t *sigar_cache_find(sigar_cache_t *table,
 
 void sigar_cache_destroy(sigar_cache_t *table);
 
+/* with stats NULL the counters of cache are reset instead */
+void sigar_stats_cache(sigar_stats_t *stats, const char *name,
+                       sigar_cache_t *cache);
+
+/*
+ * the caches kept per pid or other entity, locked by shard of key on
+ * a threadsafe handle.  the handle's other caches (fsdev, diskstats,
+ * sock_owners, ...) are filled and swept a whole table at a time and
+ * stay behind sigar_lock.
+ */
+#define SIGAR_SHARD_PROC_CPU 0
+#define SIGAR_SHARD_PROC_IO  1
+#define SIGAR_SHARD_RATES    2
+
+sigar_cache_t **sigar_shard_cache_lock(sigar_t *sigar, sigar_uint64_t key,
+                                       int type);
+
+void sigar_shard_cache_unlock(sigar_t *sigar, sigar_uint64_t key);
+
 #endif /* SIGAR_UTIL_H */
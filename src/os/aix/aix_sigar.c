@@ -248,7 +248,7 @@ char *sigar_os_error_string(sigar_t *sigar, int err)
 #define PAGESHIFT(v) \
     ((v) << sigar->pagesize)
 
-int sigar_mem_get(sigar_t *sigar, sigar_mem_t *mem)
+int sigar_os_mem_get(sigar_t *sigar, sigar_mem_t *mem)
 {
     int status;
     perfstat_memory_total_t minfo;
@@ -421,7 +421,7 @@ static int sigar_swap_get_swapqry(sigar_t *sigar, sigar_swap_t *swap)
 
 #define SWAP_MB_TO_BYTES(v) ((v) * (1024 * 1024))
 
-int sigar_swap_get(sigar_t *sigar, sigar_swap_t *swap)
+int sigar_os_swap_get(sigar_t *sigar, sigar_swap_t *swap)
 {
     perfstat_memory_total_t minfo;
     perfstat_pagingspace_t ps;
@@ -469,7 +469,7 @@ int sigar_swap_get(sigar_t *sigar, sigar_swap_t *swap)
     return SIGAR_OK;
 }
 
-int sigar_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
+int sigar_os_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
 {
     int i, status;
     struct sysinfo data;
@@ -518,7 +518,7 @@ int sigar_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
  * };
  */
 
-int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
+int sigar_os_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
 {
     perfstat_cpu_t data;
     int i, ncpu = _system_configuration.ncpus; /* this can change */
@@ -526,7 +526,7 @@ int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
 
     id.name[0] = '\0';
 
-    sigar_cpu_list_create(cpulist);
+    sigar_cpu_list_create(sigar, cpulist);
 
     for (i=0; i<ncpu; i++) {
         sigar_cpu_t *cpu;
@@ -652,7 +652,7 @@ int sigar_who_list_get(sigar_t *sigar,
 {
     int status;
 
-    sigar_who_list_create(wholist);
+    sigar_who_list_create(sigar, wholist);
 
     status = sigar_who_utmp(sigar, wholist);
     if (status != SIGAR_OK) {
@@ -731,8 +731,8 @@ static int sigar_getprocs(sigar_t *sigar, sigar_pid_t pid)
     return SIGAR_OK;
 }
 
-int sigar_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
-                       sigar_proc_mem_t *procmem)
+int sigar_os_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
+                          sigar_proc_mem_t *procmem)
 {
     int status = sigar_getprocs(sigar, pid);
     struct procsinfo64 *pinfo = sigar->pinfo;
@@ -796,8 +796,8 @@ int sigar_proc_cred_get(sigar_t *sigar, sigar_pid_t pid,
     return SIGAR_OK;
 }
 
-int sigar_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
-                        sigar_proc_time_t *proctime)
+int sigar_os_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
+                           sigar_proc_time_t *proctime)
 {
     int status = sigar_getprocs(sigar, pid);
     struct procsinfo64 *pinfo = sigar->pinfo;
@@ -815,8 +815,8 @@ int sigar_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
     return SIGAR_OK;
 }
 
-int sigar_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
-                         sigar_proc_state_t *procstate)
+int sigar_os_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
+                            sigar_proc_state_t *procstate)
 {
     int status = sigar_getprocs(sigar, pid);
     struct procsinfo64 *pinfo = sigar->pinfo;
@@ -992,7 +992,7 @@ int sigar_proc_exe_get(sigar_t *sigar, sigar_pid_t pid,
     len = strlen(buffer);
     SIGAR_SSTRCPY(procexe->name, buffer);
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/cwd");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/cwd");
 
     if ((len = readlink(buffer, procexe->cwd,
                         sizeof(procexe->cwd)-1)) < 0)
@@ -1106,8 +1106,8 @@ int sigar_os_fs_type_get(sigar_file_system_t *fsp)
 int mntctl(int command, int size, char *buffer);
 #endif
 
-int sigar_file_system_list_get(sigar_t *sigar,
-                               sigar_file_system_list_t *fslist)
+int sigar_os_file_system_list_get(sigar_t *sigar,
+                                  sigar_file_system_list_t *fslist)
 {
     int i, size, num;
     char *buf, *mntlist;
@@ -1124,7 +1124,7 @@ int sigar_file_system_list_get(sigar_t *sigar,
         return errno;
     }
 
-    sigar_file_system_list_create(fslist);
+    sigar_file_system_list_create(sigar, fslist);
 
     for (i=0; i<num; i++) {
         char *devname;
@@ -1292,8 +1292,8 @@ static int create_diskmap(sigar_t *sigar)
     return SIGAR_OK;
 }
 
-int sigar_disk_usage_get(sigar_t *sigar, const char *name,
-                         sigar_disk_usage_t *usage)
+int sigar_os_disk_usage_get(sigar_t *sigar, const char *name,
+                            sigar_disk_usage_t *usage)
 {
     perfstat_disk_t disk;
     perfstat_id_t id;
@@ -1547,7 +1547,7 @@ int sigar_net_route_list_get(sigar_t *sigar,
         return errno;
     }
 
-    sigar_net_route_list_create(routelist);
+    sigar_net_route_list_create(sigar, routelist);
 
     lim = buf + needed;
 
@@ -1608,9 +1608,9 @@ int sigar_net_route_list_get(sigar_t *sigar,
     return SIGAR_OK;
 }
 
-int sigar_net_interface_stat_get(sigar_t *sigar,
-                                 const char *name,
-                                 sigar_net_interface_stat_t *ifstat)
+int sigar_os_net_interface_stat_get(sigar_t *sigar,
+                                    const char *name,
+                                    sigar_net_interface_stat_t *ifstat)
 {
     perfstat_id_t id;
     perfstat_netinterface_t data;
@@ -1782,7 +1782,7 @@ static int net_conn_get_tcp(sigar_net_connection_walker_t *walker)
     return SIGAR_OK;
 }
 
-int sigar_net_connection_walk(sigar_net_connection_walker_t *walker)
+int sigar_os_net_connection_walk(sigar_net_connection_walker_t *walker)
 {
     int status;
 
@@ -1969,7 +1969,7 @@ int sigar_arp_list_get(sigar_t *sigar,
         return errno;
     }
 
-    sigar_arp_list_create(arplist);
+    sigar_arp_list_create(sigar, arplist);
     status = SIGAR_OK;
 
     for (i=0; i<arptabsize; i++) {
@@ -430,7 +430,7 @@ static int sigar_vmstat(sigar_t *sigar, struct uvmexp *vmstat)
 }
 #endif
 
-int sigar_mem_get(sigar_t *sigar, sigar_mem_t *mem)
+int sigar_os_mem_get(sigar_t *sigar, sigar_mem_t *mem)
 {
     sigar_uint64_t kern = 0;
 #ifdef DARWIN
@@ -669,7 +669,7 @@ static int sigar_swap_sysctl_get(sigar_t *sigar, sigar_swap_t *swap)
 }
 #endif /* DARWIN */
 
-int sigar_swap_get(sigar_t *sigar, sigar_swap_t *swap)
+int sigar_os_swap_get(sigar_t *sigar, sigar_swap_t *swap)
 {
     int status;
 #if defined(DARWIN)
@@ -745,7 +745,7 @@ typedef uint64_t cp_time_t;
 typedef unsigned long cp_time_t;
 #endif
 
-int sigar_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
+int sigar_os_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
 {
 #if defined(DARWIN)
     kern_return_t status;
@@ -854,7 +854,7 @@ static int sigar_cp_times_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
 }
 #endif
 
-int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
+int sigar_os_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
 {
 #ifdef DARWIN
     kern_return_t status;
@@ -872,7 +872,7 @@ int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
         return errno;
     }
 
-    sigar_cpu_list_create(cpulist);
+    sigar_cpu_list_create(sigar, cpulist);
 
     for (i=0; i<ncpu; i++) {
         sigar_cpu_t *cpu;
@@ -899,7 +899,7 @@ int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
     int status, i;
     sigar_cpu_t *cpu;
 
-    sigar_cpu_list_create(cpulist);
+    sigar_cpu_list_create(sigar, cpulist);
 
 #ifdef HAVE_KERN_CP_TIMES
     if ((status = sigar_cp_times_get(sigar, cpulist)) == SIGAR_OK) {
@@ -1117,8 +1117,8 @@ static mach_vm_size_t sigar_shared_region_size(cpu_type_t type)
 }
 #endif /* DARWIN */
 
-int sigar_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
-                       sigar_proc_mem_t *procmem)
+int sigar_os_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
+                          sigar_proc_mem_t *procmem)
 {
 #if defined(DARWIN)
     mach_port_t task, self = mach_task_self();
@@ -1345,8 +1345,8 @@ static int get_proc_times(sigar_t *sigar, sigar_pid_t pid, sigar_proc_time_t *ti
 }
 #endif
 
-int sigar_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
-                        sigar_proc_time_t *proctime)
+int sigar_os_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
+                           sigar_proc_time_t *proctime)
 {
 #ifdef SIGAR_FREEBSD4
     struct user user;
@@ -1468,8 +1468,8 @@ static int sigar_proc_threads_get(sigar_t *sigar, sigar_pid_t pid,
 }
 #endif
 
-int sigar_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
-                         sigar_proc_state_t *procstate)
+int sigar_os_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
+                            sigar_proc_state_t *procstate)
 {
     int status = sigar_get_pinfo(sigar, pid);
     bsd_pinfo_t *pinfo = sigar->pinfo;
@@ -1955,7 +1955,7 @@ int sigar_proc_exe_get(sigar_t *sigar, sigar_pid_t pid,
     procexe->cwd[0] = '\0';
     procexe->root[0] = '\0';
 
-    (void)SIGAR_PROC_FILENAME(name, pid, "/file");
+    (void)SIGAR_PROC_FILENAME(sigar, name, pid, "/file");
 
     if ((len = readlink(name, procexe->name,
                         sizeof(procexe->name)-1)) < 0)
@@ -2131,8 +2131,8 @@ static void get_fs_options(char *opts, int osize, long flags)
 #define sigar_f_flags f_flags
 #endif
 
-int sigar_file_system_list_get(sigar_t *sigar,
-                               sigar_file_system_list_t *fslist)
+int sigar_os_file_system_list_get(sigar_t *sigar,
+                                  sigar_file_system_list_t *fslist)
 {
     struct sigar_statfs *fs;
     int num, i;
@@ -2151,7 +2151,7 @@ int sigar_file_system_list_get(sigar_t *sigar,
         return errno;
     }
 
-    sigar_file_system_list_create(fslist);
+    sigar_file_system_list_create(sigar, fslist);
 
     for (i=0; i<num; i++) {
         sigar_file_system_t *fsp;
@@ -2201,8 +2201,8 @@ int sigar_file_system_list_get(sigar_t *sigar,
         CFNumberGetValue(number, kCFNumberSInt64Type, &val)
 #endif
 
-int sigar_disk_usage_get(sigar_t *sigar, const char *name,
-                         sigar_disk_usage_t *disk)
+int sigar_os_disk_usage_get(sigar_t *sigar, const char *name,
+                            sigar_disk_usage_t *disk)
 {
 #if defined(DARWIN)
     kern_return_t status;
@@ -2498,7 +2498,7 @@ int sigar_net_route_list_get(sigar_t *sigar,
         return errno;
     }
 
-    sigar_net_route_list_create(routelist);
+    sigar_net_route_list_create(sigar, routelist);
 
     lim = buf + needed;
     for (next = buf; next < lim; next += rtm->rtm_msglen) {
@@ -2875,8 +2875,8 @@ int sigar_net_interface_config_get(sigar_t *sigar, const char *name,
     return SIGAR_OK;
 }
 
-int sigar_net_interface_stat_get(sigar_t *sigar, const char *name,
-                                 sigar_net_interface_stat_t *ifstat)
+int sigar_os_net_interface_stat_get(sigar_t *sigar, const char *name,
+                                    sigar_net_interface_stat_t *ifstat)
 {
     int status;
     ifmsg_iter_t iter;
@@ -3165,7 +3165,7 @@ static int net_connection_get(sigar_net_connection_walker_t *walker, int proto)
 }
 #endif
 
-int sigar_net_connection_walk(sigar_net_connection_walker_t *walker)
+int sigar_os_net_connection_walk(sigar_net_connection_walker_t *walker)
 {
     int flags = walker->flags;
     int status;
@@ -3387,7 +3387,7 @@ int sigar_arp_list_get(sigar_t *sigar,
         return errno;
     }
 
-    sigar_arp_list_create(arplist);
+    sigar_arp_list_create(sigar, arplist);
 
     lim = buf + needed;
     for (next = buf; next < lim; next += rtm->rtm_msglen) {
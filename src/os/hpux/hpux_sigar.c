@@ -74,7 +74,7 @@ char *sigar_os_error_string(sigar_t *sigar, int err)
     return NULL;
 }
 
-int sigar_mem_get(sigar_t *sigar, sigar_mem_t *mem)
+int sigar_os_mem_get(sigar_t *sigar, sigar_mem_t *mem)
 {
     struct pst_dynamic stats;
     struct pst_vminfo vminfo;
@@ -100,7 +100,7 @@ int sigar_mem_get(sigar_t *sigar, sigar_mem_t *mem)
     return SIGAR_OK;
 }
 
-int sigar_swap_get(sigar_t *sigar, sigar_swap_t *swap)
+int sigar_os_swap_get(sigar_t *sigar, sigar_swap_t *swap)
 {
     struct pst_swapinfo swapinfo;
     struct pst_vminfo vminfo;
@@ -153,7 +153,7 @@ static void get_cpu_metrics(sigar_t *sigar,
         cpu->user + cpu->sys + cpu->nice + cpu->idle + cpu->wait + cpu->irq;
 }
 
-int sigar_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
+int sigar_os_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
 {
     struct pst_dynamic stats;
 
@@ -165,7 +165,7 @@ int sigar_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
     return SIGAR_OK;
 }
 
-int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
+int sigar_os_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
 {
     int i;
     struct pst_dynamic stats;
@@ -173,7 +173,7 @@ int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
     pstat_getdynamic(&stats, sizeof(stats), 1, 0);
     sigar->ncpu = stats.psd_proc_cnt;
 
-    sigar_cpu_list_create(cpulist);
+    sigar_cpu_list_create(sigar, cpulist);
 
     for (i=0; i<sigar->ncpu; i++) {
         sigar_cpu_t *cpu;
@@ -272,8 +272,8 @@ static int sigar_pstat_getproc(sigar_t *sigar, sigar_pid_t pid)
     return SIGAR_OK;
 }
 
-int sigar_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
-                       sigar_proc_mem_t *procmem)
+int sigar_os_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
+                          sigar_proc_mem_t *procmem)
 {
     int pagesize = sigar->pstatic.page_size;
     int status = sigar_pstat_getproc(sigar, pid);
@@ -344,8 +344,8 @@ int sigar_proc_cred_get(sigar_t *sigar, sigar_pid_t pid,
     return SIGAR_OK;
 }
 
-int sigar_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
-                        sigar_proc_time_t *proctime)
+int sigar_os_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
+                           sigar_proc_time_t *proctime)
 {
     int status = sigar_pstat_getproc(sigar, pid);
     struct pst_status *pinfo = sigar->pinfo;
@@ -363,8 +363,8 @@ int sigar_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
     return SIGAR_OK;
 }
 
-int sigar_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
-                         sigar_proc_state_t *procstate)
+int sigar_os_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
+                            sigar_proc_state_t *procstate)
 {
     int status = sigar_pstat_getproc(sigar, pid);
     struct pst_status *pinfo = sigar->pinfo;
@@ -576,8 +576,8 @@ int sigar_os_fs_type_get(sigar_file_system_t *fsp)
     return fsp->type;
 }
 
-int sigar_file_system_list_get(sigar_t *sigar,
-                               sigar_file_system_list_t *fslist)
+int sigar_os_file_system_list_get(sigar_t *sigar,
+                                  sigar_file_system_list_t *fslist)
 {
     struct mntent *ent;
 
@@ -588,7 +588,7 @@ int sigar_file_system_list_get(sigar_t *sigar,
         return errno;
     }
 
-    sigar_file_system_list_create(fslist);
+    sigar_file_system_list_create(sigar, fslist);
 
     while ((ent = getmntent(fp))) {
         if ((*(ent->mnt_type) == 's') &&
@@ -650,8 +650,8 @@ static int create_fsdev_cache(sigar_t *sigar)
     return SIGAR_OK;
 }
 
-int sigar_disk_usage_get(sigar_t *sigar, const char *name,
-                         sigar_disk_usage_t *usage)
+int sigar_os_disk_usage_get(sigar_t *sigar, const char *name,
+                            sigar_disk_usage_t *usage)
 {
     return SIGAR_ENOTIMPL;
 }
@@ -853,7 +853,7 @@ int sigar_net_route_list_get(sigar_t *sigar,
 
     routelist->size = routelist->number = 0;
 
-    sigar_net_route_list_create(routelist);
+    sigar_net_route_list_create(sigar, routelist);
 
     for (i=0; i<count; i++) {
         mib_ipRouteEnt *ent = &routes[i];
@@ -911,8 +911,8 @@ static int get_mib_ifstat(sigar_t *sigar,
     return ENXIO;
 }
 
-int sigar_net_interface_stat_get(sigar_t *sigar, const char *name,
-                                 sigar_net_interface_stat_t *ifstat)
+int sigar_os_net_interface_stat_get(sigar_t *sigar, const char *name,
+                                    sigar_net_interface_stat_t *ifstat)
 {
     int status;
     mib_ifEntry mib;
@@ -1153,7 +1153,7 @@ static int net_conn_get_tcp(sigar_net_connection_walker_t *walker)
     return SIGAR_OK;
 }
 
-int sigar_net_connection_walk(sigar_net_connection_walker_t *walker)
+int sigar_os_net_connection_walk(sigar_net_connection_walker_t *walker)
 {
     int status;
 
@@ -1278,7 +1278,7 @@ int sigar_arp_list_get(sigar_t *sigar,
         return status;
     }
 
-    sigar_arp_list_create(arplist);
+    sigar_arp_list_create(sigar, arplist);
 
     for (i=0; i<count; i++) {
         mib_ipNetToMediaEnt *ent = &entries[i];
@@ -0,0 +1,137 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * netlink dump requests, used where /proc would need one read
+ * (or one full file scan) per object.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_util.h"
+#include "sigar_os.h"
+
+/* large enough for the biggest message the kernel will put in a dump */
+#define SIGAR_NETLINK_BUFSIZ (32 * 1024)
+
+#ifndef SOCK_CLOEXEC
+#define SOCK_CLOEXEC 0
+#endif
+
+#ifndef NLM_F_DUMP_INTR
+#define NLM_F_DUMP_INTR 0x10
+#endif
+
+static int netlink_dump(int protocol,
+                        struct nlmsghdr *req,
+                        sigar_netlink_handler_t handler,
+                        void *data)
+{
+    struct sockaddr_nl addr;
+    char *buf;
+    int sock, status = SIGAR_OK, done = 0;
+    unsigned int seq = (unsigned int)time(NULL);
+
+    if ((sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, protocol)) < 0) {
+        return errno;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+
+    req->nlmsg_flags |= NLM_F_REQUEST | NLM_F_DUMP;
+    req->nlmsg_seq = seq;
+    req->nlmsg_pid = 0;
+
+    if (sendto(sock, req, req->nlmsg_len, 0,
+               (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        status = errno;
+        close(sock);
+        return status;
+    }
+
+    buf = malloc(SIGAR_NETLINK_BUFSIZ);
+
+    while (!done) {
+        struct nlmsghdr *nlh;
+        int len = recv(sock, buf, SIGAR_NETLINK_BUFSIZ, 0);
+
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            status = errno;
+            break;
+        }
+        if (len == 0) {
+            status = EIO; /* closed before NLMSG_DONE, the dump is short */
+            break;
+        }
+
+        for (nlh = (struct nlmsghdr *)buf;
+             NLMSG_OK(nlh, (unsigned int)len);
+             nlh = NLMSG_NEXT(nlh, len))
+        {
+            if (nlh->nlmsg_seq != seq) {
+                continue;
+            }
+            if (nlh->nlmsg_flags & NLM_F_DUMP_INTR) {
+                /*
+                 * the table changed under the dump, what the handler
+                 * has seen may be missing or repeating entries.  it
+                 * has already passed them on, so not retried here.
+                 */
+                status = EAGAIN;
+                done = 1;
+                break;
+            }
+            if (nlh->nlmsg_type == NLMSG_DONE) {
+                done = 1;
+                break;
+            }
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                struct nlmsgerr *err = NLMSG_DATA(nlh);
+                status = err->error ? -err->error : SIGAR_OK;
+                done = 1;
+                break;
+            }
+            if ((status = handler(data, nlh)) != SIGAR_OK) {
+                done = 1;
+                break;
+            }
+        }
+    }
+
+    free(buf);
+    close(sock);
+
+    return status;
+}
+
+int sigar_netlink_dump(sigar_t *sigar, int protocol,
+                       struct nlmsghdr *req,
+                       sigar_netlink_handler_t handler,
+                       void *data)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = netlink_dump(protocol, req, handler, data);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NETLINK_DUMP, status);
+}
@@ -0,0 +1,540 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * network namespaces.  a namespace with a process in it can be read
+ * through /proc/PID/net without leaving our own, the others are
+ * entered with setns() on a short lived thread so the caller's
+ * namespace never changes.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* setns */
+#endif
+
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_util.h"
+#include "sigar_os.h"
+
+/* where "ip netns add" bind mounts them */
+#define NETNS_RUN_DIR "/run/netns"
+
+#define PROC_SELF_NETNS PROCP_FS_ROOT "self/ns/net"
+
+#ifndef CLONE_NEWNET
+#define CLONE_NEWNET 0x40000000
+#endif
+
+typedef int (*netns_func_t)(sigar_t *sigar, void *data);
+
+typedef struct {
+    sigar_t *sigar;
+    sigar_netns_t *netns;
+    netns_func_t func;
+    void *data;
+    int status;
+} netns_call_t;
+
+typedef struct {
+    sigar_net_proto_counter_list_t counters;
+    unsigned int gen; /* sigar->netns_gen it was last listed or read in */
+} netns_counters_t;
+
+static void netns_index_free(void *ptr)
+{
+    /* values are list offsets, not allocations */
+}
+
+/*
+ * forget the counters of namespaces that are gone, so the table does
+ * not grow with every pod that came and went and an inode used again
+ * starts over rather than taking the dead namespace's as its last.
+ */
+static void netns_counters_sweep(sigar_t *sigar,
+                                 sigar_netns_list_t *netnslist)
+{
+    sigar_cache_t *table;
+    unsigned long i;
+    unsigned int gen;
+
+    sigar_lock(sigar);
+
+    if (!(table = sigar->netns_counters)) {
+        sigar_unlock(sigar);
+        return;
+    }
+
+    gen = ++sigar->netns_gen;
+
+    for (i=0; i<netnslist->number; i++) {
+        sigar_cache_entry_t *entry =
+            sigar_cache_find(table, netnslist->data[i].id);
+
+        if (entry && entry->value) {
+            ((netns_counters_t *)entry->value)->gen = gen;
+        }
+    }
+
+    for (i=0; i<table->size; i++) {
+        sigar_cache_entry_t *entry, **ptr = &table->entries[i];
+
+        while ((entry = *ptr)) {
+            netns_counters_t *counters = entry->value;
+
+            if (counters && (counters->gen == gen)) {
+                ptr = &entry->next;
+                continue;
+            }
+
+            *ptr = entry->next;
+            if (counters) {
+                table->free_value(counters);
+            }
+            free(entry);
+            table->count--;
+        }
+    }
+
+    sigar_unlock(sigar);
+}
+
+int sigar_os_netns_list_get(sigar_t *sigar,
+                            sigar_netns_list_t *netnslist)
+{
+    DIR *dirp;
+    struct dirent *ent;
+    struct stat self;
+    sigar_cache_t *index;
+
+    /* the nsfs device, to tell namespaces from the files under /run/netns */
+    if (stat(PROC_SELF_NETNS, &self) < 0) {
+        return errno; /* pre 3.0 kernel */
+    }
+
+    if (!(dirp = opendir(PROCP_FS_ROOT))) {
+        return errno;
+    }
+
+    sigar_netns_list_create(netnslist);
+
+    index = sigar_cache_new(64);
+    index->free_value = netns_index_free;
+
+    while ((ent = readdir(dirp))) {
+        sigar_cache_entry_t *entry;
+        sigar_netns_t *netns;
+        char name[64];
+        struct stat sb;
+        sigar_pid_t pid;
+
+        if (!sigar_isdigit(*ent->d_name)) {
+            continue;
+        }
+
+        snprintf(name, sizeof(name), "%s/ns/net", ent->d_name);
+
+        /* EACCES for processes we cannot ptrace */
+        if (fstatat(dirfd(dirp), name, &sb, 0) < 0) {
+            continue;
+        }
+
+        pid = strtoul(ent->d_name, NULL, 10);
+        entry = sigar_cache_get(index, sb.st_ino);
+
+        if (entry->value) {
+            netns = &netnslist->data[(unsigned long)entry->value - 1];
+            netns->processes++;
+            if (pid < netns->pid) {
+                netns->pid = pid;
+            }
+            continue;
+        }
+
+        SIGAR_NETNS_LIST_GROW(netnslist);
+        netns = &netnslist->data[netnslist->number++];
+        entry->value = (void *)netnslist->number;
+
+        netns->id = sb.st_ino;
+        netns->pid = pid;
+        netns->processes = 1;
+        netns->path[0] = '\0';
+    }
+
+    closedir(dirp);
+
+    /* namespaces kept alive by a bind mount alone */
+    if ((dirp = opendir(NETNS_RUN_DIR))) {
+        while ((ent = readdir(dirp))) {
+            sigar_cache_entry_t *entry;
+            sigar_netns_t *netns;
+            char path[SIGAR_NETNS_PATH_LEN];
+            struct stat sb;
+
+            if (*ent->d_name == '.') {
+                continue;
+            }
+
+            snprintf(path, sizeof(path), "%s/%s",
+                     NETNS_RUN_DIR, ent->d_name);
+
+            /* an unmounted name is a plain file on tmpfs */
+            if ((stat(path, &sb) < 0) || (sb.st_dev != self.st_dev)) {
+                continue;
+            }
+
+            entry = sigar_cache_get(index, sb.st_ino);
+
+            if (entry->value) {
+                netns = &netnslist->data[(unsigned long)entry->value - 1];
+                if (!netns->path[0]) {
+                    SIGAR_SSTRCPY(netns->path, path);
+                }
+                continue;
+            }
+
+            SIGAR_NETNS_LIST_GROW(netnslist);
+            netns = &netnslist->data[netnslist->number++];
+            entry->value = (void *)netnslist->number;
+
+            netns->id = sb.st_ino;
+            netns->pid = 0;
+            netns->processes = 0;
+            SIGAR_SSTRCPY(netns->path, path);
+        }
+
+        closedir(dirp);
+    }
+
+    sigar_cache_destroy(index);
+
+    netns_counters_sweep(sigar, netnslist);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_netns_pid_get(sigar_t *sigar, sigar_pid_t pid,
+                    sigar_netns_t *netns)
+{
+    char path[64];
+    struct stat sb;
+
+    snprintf(path, sizeof(path), PROCP_FS_ROOT "%lu/ns/net",
+             (unsigned long)pid);
+
+    if (stat(path, &sb) < 0) {
+        return errno;
+    }
+
+    netns->id = sb.st_ino;
+    netns->pid = pid;
+    netns->processes = 0;
+    netns->path[0] = '\0';
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_netns_path_get(sigar_t *sigar, const char *path,
+                     sigar_netns_t *netns)
+{
+    struct stat self, sb;
+
+    if ((stat(PROC_SELF_NETNS, &self) < 0) || (stat(path, &sb) < 0)) {
+        return errno;
+    }
+
+    if (sb.st_dev != self.st_dev) {
+        return EINVAL; /* not a namespace */
+    }
+
+    if (strlen(path) >= sizeof(netns->path)) {
+        return ENAMETOOLONG;
+    }
+
+    netns->id = sb.st_ino;
+    netns->pid = 0;
+    netns->processes = 0;
+    SIGAR_SSTRCPY(netns->path, path);
+
+    return SIGAR_OK;
+}
+
+/*
+ * the handle kept for sigar_netns_* reads, opened once and with the
+ * caller's roots, or a new one while another thread has it.  of its
+ * own, so the caller's may be shared by other threads meanwhile.
+ */
+static int netns_sigar_get(sigar_t *sigar, sigar_t **nsigar)
+{
+    int status = SIGAR_OK;
+
+    sigar_lock(sigar);
+    *nsigar = sigar->netns_sigar;
+    sigar->netns_sigar = NULL;
+    sigar_unlock(sigar);
+
+    if (!*nsigar && ((status = sigar_open(nsigar)) != SIGAR_OK)) {
+        return status;
+    }
+
+    sigar_lock(sigar);
+
+    (*nsigar)->log_level = sigar->log_level;
+    (*nsigar)->log_impl = sigar->log_impl;
+    (*nsigar)->log_data = sigar->log_data;
+
+    if (!strEQ((*nsigar)->proc_root ? (*nsigar)->proc_root : "",
+               sigar->proc_root ? sigar->proc_root : "") ||
+        !strEQ((*nsigar)->sys_root ? (*nsigar)->sys_root : "",
+               sigar->sys_root ? sigar->sys_root : ""))
+    {
+        status = sigar_proc_root_set(*nsigar,
+                                     sigar->proc_root, sigar->sys_root);
+    }
+
+    sigar_unlock(sigar);
+
+    if (status != SIGAR_OK) {
+        sigar_close(*nsigar);
+    }
+
+    return status;
+}
+
+static void netns_sigar_put(sigar_t *sigar, sigar_t *nsigar)
+{
+    nsigar->proc_net = NULL;
+    nsigar->netns = NULL;
+
+    sigar_lock(sigar);
+    if (!sigar->netns_sigar) {
+        sigar->netns_sigar = nsigar;
+        nsigar = NULL;
+    }
+    sigar_unlock(sigar);
+
+    if (nsigar) {
+        sigar_close(nsigar);
+    }
+}
+
+/* run func with every /proc/net read taken from root/net */
+static int netns_call_root(netns_call_t *call, char *root)
+{
+    sigar_t *nsigar;
+    int status;
+
+    if ((status = netns_sigar_get(call->sigar, &nsigar)) != SIGAR_OK) {
+        return status;
+    }
+
+    nsigar->proc_net = root;
+    nsigar->netns = call->netns;
+
+    status = call->func(nsigar, call->data);
+
+    netns_sigar_put(call->sigar, nsigar);
+
+    return status;
+}
+
+static void *netns_call_thread(void *data)
+{
+    netns_call_t *call = data;
+    char root[64];
+    struct stat sb;
+    int fd;
+
+    if ((fd = open(call->netns->path, O_RDONLY|O_CLOEXEC)) < 0) {
+        call->status = errno;
+        return NULL;
+    }
+
+    /* the name may have been reused since it was looked up */
+    if ((fstat(fd, &sb) < 0) || (sb.st_ino != call->netns->id)) {
+        call->status = ESRCH;
+    }
+    else if (setns(fd, CLONE_NEWNET) < 0) {
+        call->status = errno;
+    }
+
+    close(fd);
+
+    if (call->status != SIGAR_OK) {
+        return NULL;
+    }
+
+    /* /proc/self/net is the thread group leader's, this thread is in netns */
+    snprintf(root, sizeof(root), PROCP_FS_ROOT "self/task/%ld",
+             (long)syscall(SYS_gettid));
+
+    call->status = netns_call_root(call, root);
+
+    return NULL;
+}
+
+static int netns_call(sigar_t *sigar, sigar_netns_t *netns,
+                      netns_func_t func, void *data)
+{
+    netns_call_t call;
+    pthread_t thread;
+    int status;
+
+    call.sigar = sigar;
+    call.netns = netns;
+    call.func = func;
+    call.data = data;
+    call.status = SIGAR_OK;
+
+    if (netns->pid) {
+        char name[64], buffer[SIGAR_PATH_MAX];
+        char root[SIGAR_PATH_MAX], path[SIGAR_PATH_MAX+8];
+        struct stat sb;
+
+        /* under the caller's proc_root, as the rest of its reads are */
+        snprintf(name, sizeof(name), PROCP_FS_ROOT "%lu",
+                 (unsigned long)netns->pid);
+        SIGAR_SSTRCPY(root, SIGAR_ROOT_PATH(sigar, name, buffer));
+        snprintf(path, sizeof(path), "%s/ns/net", root);
+
+        /* unless pid exited or moved to another namespace since */
+        if ((stat(path, &sb) == 0) && (sb.st_ino == netns->id)) {
+            return netns_call_root(&call, root);
+        }
+    }
+
+    if (!netns->path[0]) {
+        return ESRCH;
+    }
+
+    if ((status = pthread_create(&thread, NULL, netns_call_thread, &call))) {
+        return status;
+    }
+
+    pthread_join(thread, NULL);
+
+    return call.status;
+}
+
+static int netns_interface_stat_list_get(sigar_t *sigar, void *data)
+{
+    return sigar_net_interface_stat_list_get(sigar, data);
+}
+
+int sigar_os_netns_interface_stat_list_get(sigar_t *sigar,
+                                           sigar_netns_t *netns,
+                                           sigar_net_interface_stat_list_t *iflist)
+{
+    return netns_call(sigar, netns, netns_interface_stat_list_get, iflist);
+}
+
+typedef struct {
+    sigar_net_connection_list_t *connlist;
+    int flags;
+} netns_connection_list_t;
+
+static int netns_connection_list_get(sigar_t *sigar, void *data)
+{
+    netns_connection_list_t *args = data;
+
+    return sigar_net_connection_list_get(sigar, args->connlist, args->flags);
+}
+
+int sigar_os_netns_connection_list_get(sigar_t *sigar,
+                                       sigar_netns_t *netns,
+                                       sigar_net_connection_list_t *connlist,
+                                       int flags)
+{
+    netns_connection_list_t args;
+
+    args.connlist = connlist;
+    args.flags = flags;
+
+    return netns_call(sigar, netns, netns_connection_list_get, &args);
+}
+
+static void netns_counters_free(void *ptr)
+{
+    netns_counters_t *last = ptr;
+
+    if (last->counters.size) {
+        free(last->counters.data);
+    }
+    free(last);
+}
+
+typedef struct {
+    sigar_t *sigar;
+    sigar_net_proto_counter_list_t *counters;
+} netns_proto_counter_list_t;
+
+static int netns_proto_counter_list_get(sigar_t *nsigar, void *data)
+{
+    netns_proto_counter_list_t *args = data;
+    sigar_t *sigar = args->sigar;
+    sigar_cache_entry_t *entry;
+    netns_counters_t *last;
+    int status;
+
+    sigar_lock(sigar);
+
+    if (!sigar->netns_counters) {
+        sigar->netns_counters = sigar_cache_new(16);
+        sigar->netns_counters->free_value = netns_counters_free;
+    }
+
+    entry = sigar_cache_get(sigar->netns_counters, nsigar->netns->id);
+    if (!entry->value) {
+        entry->value = calloc(1, sizeof(netns_counters_t));
+    }
+    last = entry->value;
+    last->gen = sigar->netns_gen;
+
+    /* the previous snapshot of this namespace, for the deltas */
+    memcpy(&nsigar->proto_counters, &last->counters,
+           sizeof(nsigar->proto_counters));
+
+    status = sigar_net_proto_counter_list_get(nsigar, args->counters);
+
+    memcpy(&last->counters, &nsigar->proto_counters,
+           sizeof(nsigar->proto_counters));
+    SIGAR_ZERO(&nsigar->proto_counters); /* kept in last, not the handle's */
+
+    sigar_unlock(sigar);
+
+    return status;
+}
+
+int sigar_os_netns_proto_counter_list_get(sigar_t *sigar,
+                                          sigar_netns_t *netns,
+                                          sigar_net_proto_counter_list_t *counters)
+{
+    netns_proto_counter_list_t args;
+
+    args.sigar = sigar;
+    args.counters = counters;
+
+    return netns_call(sigar, netns, netns_proto_counter_list_get, &args);
+}
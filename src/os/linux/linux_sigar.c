@@ -22,6 +22,7 @@
 #include <errno.h>
 #include <sys/param.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <sys/times.h>
 #include <sys/utsname.h>
 
@@ -29,6 +30,7 @@
 #include "sigar_private.h"
 #include "sigar_util.h"
 #include "sigar_os.h"
+#include "sigar_parse.h"
 
 #define pageshift(x) ((x) << sigar->pagesize)
 
@@ -38,6 +40,7 @@
 #define PROC_STAT    PROC_FS_ROOT "stat"
 #define PROC_UPTIME  PROC_FS_ROOT "uptime"
 #define PROC_LOADAVG PROC_FS_ROOT "loadavg"
+#define PROC_CPUINFO PROC_FS_ROOT "cpuinfo"
 
 #define PROC_PSTAT   "/stat"
 #define PROC_PSTATUS "/status"
@@ -126,9 +129,10 @@ static int sigar_boot_time_get(sigar_t *sigar)
 {
     FILE *fp;
     char buffer[BUFSIZ], *ptr;
+    char path[SIGAR_PATH_MAX+1];
     int found = 0;
 
-    if (!(fp = fopen(PROC_STAT, "r"))) {
+    if (!(fp = sigar_fopen(SIGAR_ROOT_PATH(sigar, PROC_STAT, path)))) {
         return errno;
     }
 
@@ -142,7 +146,7 @@ static int sigar_boot_time_get(sigar_t *sigar)
         }
     }
 
-    fclose(fp);
+    sigar_fclose(fp);
 
     if (!found) {
         /* should never happen */
@@ -152,15 +156,37 @@ static int sigar_boot_time_get(sigar_t *sigar)
     return SIGAR_OK;
 }
 
+static void iostat_detect(sigar_t *sigar)
+{
+    char path[SIGAR_PATH_MAX+1];
+    struct stat sb;
+
+    if (stat(SIGAR_ROOT_PATH(sigar, PROC_DISKSTATS, path), &sb) == 0) {
+        sigar->iostat = IOSTAT_DISKSTATS;
+    }
+    else if (stat(SIGAR_ROOT_PATH(sigar, SYS_BLOCK, path), &sb) == 0) {
+        sigar->iostat = IOSTAT_SYS;
+    }
+    else if (stat(SIGAR_ROOT_PATH(sigar, PROC_PARTITIONS, path), &sb) == 0) {
+        /* XXX file exists does not mean is has the fields */
+        sigar->iostat = IOSTAT_PARTITIONS;
+    }
+    else {
+        sigar->iostat = IOSTAT_NONE;
+    }
+}
+
 int sigar_os_open(sigar_t **sigar)
 {
     int i, status;
     int kernel_rev, has_nptl;
-    struct stat sb;
     struct utsname name;
 
     *sigar = malloc(sizeof(**sigar));
 
+    /* read by SIGAR_ROOT_PATH below, before sigar_open gets to them */
+    (*sigar)->proc_root = (*sigar)->sys_root = NULL;
+
     (*sigar)->pagesize = 0;
     i = getpagesize();
     while ((i >>= 1) > 0) {
@@ -182,22 +208,26 @@ int sigar_os_open(sigar_t **sigar)
 
     (*sigar)->lcpu = -1;
 
-    if (stat(PROC_DISKSTATS, &sb) == 0) {
-        (*sigar)->iostat = IOSTAT_DISKSTATS;
-    }
-    else if (stat(SYS_BLOCK, &sb) == 0) {
-        (*sigar)->iostat = IOSTAT_SYS;
-    }
-    else if (stat(PROC_PARTITIONS, &sb) == 0) {
-        /* XXX file exists does not mean is has the fields */
-        (*sigar)->iostat = IOSTAT_PARTITIONS;
-    }
-    else {
-        (*sigar)->iostat = IOSTAT_NONE;
-    }
+    (*sigar)->diskstats = NULL;
+    (*sigar)->diskstats_time = 0;
+    (*sigar)->diskstats_gen = 0;
+    (*sigar)->sock_owners = NULL;
+    (*sigar)->sock_owners_time = 0;
+    (*sigar)->sock_owners_number = 0;
+    SIGAR_ZERO(&(*sigar)->proto_counters);
+
+    (*sigar)->mountinfo_fd = -1;
+    (*sigar)->mounts = NULL;
+    (*sigar)->mounts_number = (*sigar)->mounts_size = 0;
+
+    iostat_detect(*sigar);
 
     /* hook for using mirrored /proc/net/tcp file */
     (*sigar)->proc_net = getenv("SIGAR_PROC_NET");
+    (*sigar)->netns = NULL;
+    (*sigar)->netns_counters = NULL;
+    (*sigar)->netns_gen = 0;
+    (*sigar)->netns_sigar = NULL;
 
     uname(&name);
     /* 2.X.y.z -> just need X (unless there is ever a kernel version 3!) */
@@ -215,10 +245,62 @@ int sigar_os_open(sigar_t **sigar)
 
 int sigar_os_close(sigar_t *sigar)
 {
+    if (sigar->diskstats) {
+        sigar_cache_destroy(sigar->diskstats);
+    }
+
+    if (sigar->sock_owners) {
+        sigar_cache_destroy(sigar->sock_owners);
+    }
+
+    sigar_net_proto_counter_list_destroy(sigar, &sigar->proto_counters);
+    if (sigar->netns_counters) {
+        sigar_cache_destroy(sigar->netns_counters);
+    }
+    if (sigar->netns_sigar) {
+        sigar_close(sigar->netns_sigar);
+    }
+    if (sigar->mountinfo_fd != -1) {
+        close(sigar->mountinfo_fd);
+    }
+    if (sigar->mounts) {
+        free(sigar->mounts);
+    }
     free(sigar);
     return SIGAR_OK;
 }
 
+/* forget whatever was read from the old roots */
+int sigar_os_proc_root_set(sigar_t *sigar)
+{
+    sigar->ram = -1;
+    sigar->lcpu = -1;
+    sigar->last_proc_stat.pid = -1;
+
+    if (sigar->diskstats) {
+        sigar_cache_destroy(sigar->diskstats);
+        sigar->diskstats = NULL;
+    }
+    sigar->diskstats_time = 0;
+
+    if (sigar->sock_owners) {
+        sigar_cache_destroy(sigar->sock_owners);
+        sigar->sock_owners = NULL;
+    }
+    sigar->sock_owners_time = 0;
+    sigar->sock_owners_number = 0;
+
+    if (sigar->mountinfo_fd != -1) {
+        close(sigar->mountinfo_fd);
+        sigar->mountinfo_fd = -1;
+    }
+    sigar->mounts_number = 0;
+
+    iostat_detect(sigar);
+
+    return sigar_boot_time_get(sigar);
+}
+
 char *sigar_os_error_string(sigar_t *sigar, int err)
 {
     return NULL;
@@ -235,6 +317,7 @@ static int sigar_cpu_total_count(sigar_t *sigar)
 static int get_ram(sigar_t *sigar, sigar_mem_t *mem)
 {
     char buffer[BUFSIZ], *ptr;
+    char path[SIGAR_PATH_MAX+1];
     FILE *fp;
     int total = 0;
     sigar_uint64_t sys_total = (mem->total / (1024 * 1024));
@@ -256,7 +339,7 @@ static int get_ram(sigar_t *sigar, sigar_mem_t *mem)
      * at least one configuration where that is not the
      * case.
      */
-    if (!(fp = fopen(PROC_MTRR, "r"))) {
+    if (!(fp = sigar_fopen(SIGAR_ROOT_PATH(sigar, PROC_MTRR, path)))) {
         return errno;
     }
 
@@ -277,7 +360,7 @@ static int get_ram(sigar_t *sigar, sigar_mem_t *mem)
         total += atoi(ptr);
     }
 
-    fclose(fp);
+    sigar_fclose(fp);
 
     if ((total - sys_total) > 256) {
         /* mtrr write-back registers are way off
@@ -320,12 +403,13 @@ static SIGAR_INLINE sigar_uint64_t sigar_meminfo(char *buffer,
     return val;
 }
 
-int sigar_mem_get(sigar_t *sigar, sigar_mem_t *mem)
+int sigar_os_mem_get(sigar_t *sigar, sigar_mem_t *mem)
 {
     sigar_uint64_t buffers, cached, kern;
     char buffer[BUFSIZ];
+    char path[SIGAR_PATH_MAX+1];
 
-    int status = sigar_file2str(PROC_MEMINFO,
+    int status = sigar_file2str(SIGAR_ROOT_PATH(sigar, PROC_MEMINFO, path),
                                 buffer, sizeof(buffer));
 
     if (status != SIGAR_OK) {
@@ -352,12 +436,13 @@ int sigar_mem_get(sigar_t *sigar, sigar_mem_t *mem)
     return SIGAR_OK;
 }
 
-int sigar_swap_get(sigar_t *sigar, sigar_swap_t *swap)
+int sigar_os_swap_get(sigar_t *sigar, sigar_swap_t *swap)
 {
     char buffer[BUFSIZ], *ptr;
+    char path[SIGAR_PATH_MAX+1];
 
     /* XXX: we open/parse the same file here as sigar_mem_get */
-    int status = sigar_file2str(PROC_MEMINFO,
+    int status = sigar_file2str(SIGAR_ROOT_PATH(sigar, PROC_MEMINFO, path),
                                 buffer, sizeof(buffer));
 
     if (status != SIGAR_OK) {
@@ -370,7 +455,7 @@ int sigar_swap_get(sigar_t *sigar, sigar_swap_t *swap)
 
     swap->page_in = swap->page_out = -1;
 
-    status = sigar_file2str(PROC_VMSTAT,
+    status = sigar_file2str(SIGAR_ROOT_PATH(sigar, PROC_VMSTAT, path),
                             buffer, sizeof(buffer));
 
     if (status == SIGAR_OK) {
@@ -384,7 +469,7 @@ int sigar_swap_get(sigar_t *sigar, sigar_swap_t *swap)
     }
     else {
         /* 2.2, 2.4 kernels */
-        status = sigar_file2str(PROC_STAT,
+        status = sigar_file2str(SIGAR_ROOT_PATH(sigar, PROC_STAT, path),
                                 buffer, sizeof(buffer));
         if (status != SIGAR_OK) {
             return status;
@@ -402,31 +487,39 @@ int sigar_swap_get(sigar_t *sigar, sigar_swap_t *swap)
 
 static void get_cpu_metrics(sigar_t *sigar, sigar_cpu_t *cpu, char *line)
 {
-    char *ptr = sigar_skip_token(line); /* "cpu%d" */
+    char *end = strchr(line, '\n');
+    char *ptr;
+
+    if (!end) {
+        end = line + strlen(line);
+    }
+    ptr = sigar_parse_skip(line, end); /* "cpu%d" */
 
-    cpu->user += SIGAR_TICK2MSEC(sigar_strtoull(ptr));
-    cpu->nice += SIGAR_TICK2MSEC(sigar_strtoull(ptr));
-    cpu->sys  += SIGAR_TICK2MSEC(sigar_strtoull(ptr));
-    cpu->idle += SIGAR_TICK2MSEC(sigar_strtoull(ptr));
+    cpu->user += SIGAR_TICK2MSEC(sigar_parse_u64(&ptr, end));
+    cpu->nice += SIGAR_TICK2MSEC(sigar_parse_u64(&ptr, end));
+    cpu->sys  += SIGAR_TICK2MSEC(sigar_parse_u64(&ptr, end));
+    cpu->idle += SIGAR_TICK2MSEC(sigar_parse_u64(&ptr, end));
     if (*ptr == ' ') {
         /* 2.6+ kernels only */
-        cpu->wait += SIGAR_TICK2MSEC(sigar_strtoull(ptr));
-        cpu->irq += SIGAR_TICK2MSEC(sigar_strtoull(ptr));
-        cpu->soft_irq += SIGAR_TICK2MSEC(sigar_strtoull(ptr));
+        cpu->wait += SIGAR_TICK2MSEC(sigar_parse_u64(&ptr, end));
+        cpu->irq += SIGAR_TICK2MSEC(sigar_parse_u64(&ptr, end));
+        cpu->soft_irq += SIGAR_TICK2MSEC(sigar_parse_u64(&ptr, end));
     }
     if (*ptr == ' ') {
         /* 2.6.11+ kernels only */
-        cpu->stolen += SIGAR_TICK2MSEC(sigar_strtoull(ptr));
+        cpu->stolen += SIGAR_TICK2MSEC(sigar_parse_u64(&ptr, end));
     }
     cpu->total =
         cpu->user + cpu->nice + cpu->sys + cpu->idle +
         cpu->wait + cpu->irq + cpu->soft_irq + cpu->stolen;
 }
 
-int sigar_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
+int sigar_os_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
 {
     char buffer[BUFSIZ];
-    int status = sigar_file2str(PROC_STAT, buffer, sizeof(buffer));
+    char path[SIGAR_PATH_MAX+1];
+    int status = sigar_file2str(SIGAR_ROOT_PATH(sigar, PROC_STAT, path),
+                                buffer, sizeof(buffer));
 
     if (status != SIGAR_OK) {
         return status;
@@ -438,21 +531,22 @@ int sigar_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
     return SIGAR_OK;
 }
 
-int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
+int sigar_os_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
 {
     FILE *fp;
     char buffer[BUFSIZ], cpu_total[BUFSIZ], *ptr;
+    char path[SIGAR_PATH_MAX+1];
     int core_rollup = sigar_cpu_core_rollup(sigar), i=0;
     sigar_cpu_t *cpu;
 
-    if (!(fp = fopen(PROC_STAT, "r"))) {
+    if (!(fp = sigar_fopen(SIGAR_ROOT_PATH(sigar, PROC_STAT, path)))) {
         return errno;
     }
 
     /* skip first line */
     (void)fgets(cpu_total, sizeof(cpu_total), fp);
 
-    sigar_cpu_list_create(cpulist);
+    sigar_cpu_list_create(sigar, cpulist);
 
     /* XXX: merge times of logical processors if hyperthreading */
     while ((ptr = fgets(buffer, sizeof(buffer), fp))) {
@@ -475,7 +569,7 @@ int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
         i++;
     }
 
-    fclose(fp);
+    sigar_fclose(fp);
 
     if (cpulist->number == 0) {
         /* likely older kernel where cpu\d is not present */
@@ -491,7 +585,9 @@ int sigar_uptime_get(sigar_t *sigar,
                      sigar_uptime_t *uptime)
 {
     char buffer[BUFSIZ], *ptr = buffer;
-    int status = sigar_file2str(PROC_UPTIME, buffer, sizeof(buffer));
+    char path[SIGAR_PATH_MAX+1];
+    int status = sigar_file2str(SIGAR_ROOT_PATH(sigar, PROC_UPTIME, path),
+                                buffer, sizeof(buffer));
 
     if (status != SIGAR_OK) {
         return status;
@@ -506,7 +602,9 @@ int sigar_loadavg_get(sigar_t *sigar,
                       sigar_loadavg_t *loadavg)
 {
     char buffer[BUFSIZ], *ptr = buffer;
-    int status = sigar_file2str(PROC_LOADAVG, buffer, sizeof(buffer));
+    char path[SIGAR_PATH_MAX+1];
+    int status = sigar_file2str(SIGAR_ROOT_PATH(sigar, PROC_LOADAVG, path),
+                                buffer, sizeof(buffer));
 
     if (status != SIGAR_OK) {
         return status;
@@ -538,17 +636,23 @@ static SIGAR_INLINE int proc_isthread(sigar_t *sigar, char *pidstr, int len)
     char buffer[BUFSIZ], *ptr=buffer;
     int fd, n, offset=sigar->proc_signal_offset;
 
-    /* sprintf(buffer, "/proc/%s/stat", pidstr) */
-    memcpy(ptr, PROCP_FS_ROOT, SSTRLEN(PROCP_FS_ROOT));
-    ptr += SSTRLEN(PROCP_FS_ROOT);
+    if (sigar->proc_root) {
+        snprintf(buffer, sizeof(buffer), "%s/%.*s" PROC_PSTAT,
+                 sigar->proc_root, len, pidstr);
+    }
+    else {
+        /* sprintf(buffer, "/proc/%s/stat", pidstr) */
+        memcpy(ptr, PROCP_FS_ROOT, SSTRLEN(PROCP_FS_ROOT));
+        ptr += SSTRLEN(PROCP_FS_ROOT);
 
-    memcpy(ptr, pidstr, len);
-    ptr += len;
+        memcpy(ptr, pidstr, len);
+        ptr += len;
 
-    memcpy(ptr, PROC_PSTAT, SSTRLEN(PROC_PSTAT));
-    ptr += SSTRLEN(PROC_PSTAT);
+        memcpy(ptr, PROC_PSTAT, SSTRLEN(PROC_PSTAT));
+        ptr += SSTRLEN(PROC_PSTAT);
 
-    *ptr = '\0';
+        *ptr = '\0';
+    }
 
     if ((fd = open(buffer, O_RDONLY)) < 0) {
         /* unlikely if pid was from readdir proc */
@@ -602,7 +706,8 @@ static SIGAR_INLINE int proc_isthread(sigar_t *sigar, char *pidstr, int len)
 int sigar_os_proc_list_get(sigar_t *sigar,
                            sigar_proc_list_t *proclist)
 {
-    DIR *dirp = opendir(PROCP_FS_ROOT);
+    char path[SIGAR_PATH_MAX+1];
+    DIR *dirp = opendir(SIGAR_ROOT_PATH(sigar, PROCP_FS_ROOT, path));
     struct dirent *ent, dbuf;
     register const int threadbadhack = !sigar->has_nptl;
 
@@ -610,6 +715,10 @@ int sigar_os_proc_list_get(sigar_t *sigar,
         return errno;
     }
 
+    if (sigar_recording && !sigar->proc_root) {
+        sigar_record_dir(PROCP_FS_ROOT);
+    }
+
     if (threadbadhack && (sigar->proc_signal_offset == -1)) {
         sigar->proc_signal_offset = get_proc_signal_offset();
     }
@@ -642,12 +751,44 @@ int sigar_os_proc_list_get(sigar_t *sigar,
     return SIGAR_OK;
 }
 
+/* the last /proc/pid/stat read, per thread on a threadsafe handle */
+static linux_proc_stat_t *proc_stat_slot(sigar_t *sigar)
+{
+    sigar_thread_scratch_t *scratch = sigar_thread_scratch_get(sigar);
+    linux_proc_stat_t *pstat;
+
+    if (!scratch) {
+        return &sigar->last_proc_stat;
+    }
+
+    if (!(pstat = scratch->os)) {
+        pstat = scratch->os = malloc(sizeof(*pstat));
+        pstat->pid = -1;
+    }
+
+    return pstat;
+}
+
+/* the fields of /proc/pid/stat from (3) state on, see proc(5) */
+#define PSTAT_FIELD(n) ((n) - 3)
+#define PSTAT_FIELDS_MAX PSTAT_FIELD(40)
+
+static sigar_uint64_t pstat_field(char **fields, int num, int n,
+                                  const char *end)
+{
+    n = PSTAT_FIELD(n);
+
+    /* 0 for the fields older kernels do not have */
+    return (n < num) ? sigar_parse_u64(&fields[n], end) : 0;
+}
+
 static int proc_stat_read(sigar_t *sigar, sigar_pid_t pid)
 {
-    char buffer[BUFSIZ], *ptr=buffer, *tmp;
+    char buffer[BUFSIZ], *ptr=buffer, *tmp, *end;
+    char *fields[PSTAT_FIELDS_MAX];
     unsigned int len;
-    linux_proc_stat_t *pstat = &sigar->last_proc_stat;
-    int status;
+    linux_proc_stat_t *pstat = proc_stat_slot(sigar);
+    int status, num;
 
     time_t timenow = time(NULL);
 
@@ -664,7 +805,7 @@ static int proc_stat_read(sigar_t *sigar, sigar_pid_t pid)
     pstat->pid = pid;
     pstat->mtime = timenow;
 
-    status = SIGAR_PROC_FILE2STR(buffer, pid, PROC_PSTAT);
+    status = SIGAR_PROC_FILE2STR(sigar, buffer, pid, PROC_PSTAT);
 
     if (status != SIGAR_OK) {
         return status;
@@ -686,84 +827,63 @@ static int proc_stat_read(sigar_t *sigar, sigar_pid_t pid)
     memcpy(pstat->name, ptr, len);
     pstat->name[len] = '\0';
     ptr = tmp+1;
+    end = ptr + strlen(ptr);
 
-    SIGAR_SKIP_SPACE(ptr);
-    pstat->state = *ptr++; /* (3) */
-    SIGAR_SKIP_SPACE(ptr);
-
-    pstat->ppid = sigar_strtoul(ptr); /* (4) */
-    ptr = sigar_skip_token(ptr); /* (5) pgrp */
-    ptr = sigar_skip_token(ptr); /* (6) session */
-    pstat->tty = sigar_strtoul(ptr); /* (7) */
-    ptr = sigar_skip_token(ptr); /* (8) tty pgrp */
+    /* one pass to find the fields, the ones we want are read by number */
+    num = sigar_parse_fields(ptr, end, fields, PSTAT_FIELDS_MAX);
+    if (num == 0) {
+        return EINVAL;
+    }
 
-    ptr = sigar_skip_token(ptr); /* (9) flags */
-    pstat->minor_faults = sigar_strtoull(ptr); /* (10) */
-    ptr = sigar_skip_token(ptr); /* (11) cmin flt */
-    pstat->major_faults = sigar_strtoull(ptr); /* (12) */
-    ptr = sigar_skip_token(ptr); /* (13) cmaj flt */
+    pstat->state = *fields[PSTAT_FIELD(3)];
 
-    pstat->utime = SIGAR_TICK2MSEC(sigar_strtoull(ptr)); /* (14) */
-    pstat->stime = SIGAR_TICK2MSEC(sigar_strtoull(ptr)); /* (15) */
+    pstat->ppid = pstat_field(fields, num, 4, end);
+    pstat->tty = pstat_field(fields, num, 7, end);
 
-    ptr = sigar_skip_token(ptr); /* (16) cutime */
-    ptr = sigar_skip_token(ptr); /* (17) cstime */
+    pstat->minor_faults = pstat_field(fields, num, 10, end);
+    pstat->major_faults = pstat_field(fields, num, 12, end);
 
-    pstat->priority = sigar_strtoul(ptr); /* (18) */
-    pstat->nice     = sigar_strtoul(ptr); /* (19) */
+    pstat->utime = SIGAR_TICK2MSEC(pstat_field(fields, num, 14, end));
+    pstat->stime = SIGAR_TICK2MSEC(pstat_field(fields, num, 15, end));
 
-    ptr = sigar_skip_token(ptr); /* (20) timeout */
-    ptr = sigar_skip_token(ptr); /* (21) it_real_value */
+    pstat->priority = pstat_field(fields, num, 18, end);
+    pstat->nice     = pstat_field(fields, num, 19, end);
 
-    pstat->start_time  = sigar_strtoul(ptr); /* (22) */
+    pstat->start_time  = pstat_field(fields, num, 22, end);
     pstat->start_time /= sigar->ticks;
     pstat->start_time += sigar->boot_time; /* seconds */
     pstat->start_time *= 1000; /* milliseconds */
 
-    pstat->vsize = sigar_strtoull(ptr); /* (23) */
-    pstat->rss   = pageshift(sigar_strtoull(ptr)); /* (24) */
-
-    ptr = sigar_skip_token(ptr); /* (25) rlim */
-    ptr = sigar_skip_token(ptr); /* (26) startcode */
-    ptr = sigar_skip_token(ptr); /* (27) endcode */
-    ptr = sigar_skip_token(ptr); /* (28) startstack */
-    ptr = sigar_skip_token(ptr); /* (29) kstkesp */
-    ptr = sigar_skip_token(ptr); /* (30) kstkeip */
-    ptr = sigar_skip_token(ptr); /* (31) signal */
-    ptr = sigar_skip_token(ptr); /* (32) blocked */
-    ptr = sigar_skip_token(ptr); /* (33) sigignore */
-    ptr = sigar_skip_token(ptr); /* (34) sigcache */
-    ptr = sigar_skip_token(ptr); /* (35) wchan */
-    ptr = sigar_skip_token(ptr); /* (36) nswap */
-    ptr = sigar_skip_token(ptr); /* (37) cnswap */
-    ptr = sigar_skip_token(ptr); /* (38) exit_signal */
+    pstat->vsize = pstat_field(fields, num, 23, end);
+    pstat->rss   = pageshift(pstat_field(fields, num, 24, end));
 
-    pstat->processor = sigar_strtoul(ptr); /* (39) */
+    pstat->processor = pstat_field(fields, num, 39, end);
 
     return SIGAR_OK;
 }
 
-int sigar_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
-                       sigar_proc_mem_t *procmem)
+int sigar_os_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
+                          sigar_proc_mem_t *procmem)
 {
-    char buffer[BUFSIZ], *ptr=buffer;
+    char buffer[BUFSIZ], *ptr=buffer, *end;
     int status = proc_stat_read(sigar, pid);
-    linux_proc_stat_t *pstat = &sigar->last_proc_stat;
+    linux_proc_stat_t *pstat = proc_stat_slot(sigar);
 
     procmem->minor_faults = pstat->minor_faults;
     procmem->major_faults = pstat->major_faults;
     procmem->page_faults =
         procmem->minor_faults + procmem->major_faults;
     
-    status = SIGAR_PROC_FILE2STR(buffer, pid, "/statm");
+    status = SIGAR_PROC_FILE2STR(sigar, buffer, pid, "/statm");
 
     if (status != SIGAR_OK) {
         return status;
     }
 
-    procmem->size     = pageshift(sigar_strtoull(ptr));
-    procmem->resident = pageshift(sigar_strtoull(ptr));
-    procmem->share    = pageshift(sigar_strtoull(ptr));
+    end = buffer + strlen(buffer);
+    procmem->size     = pageshift(sigar_parse_u64(&ptr, end));
+    procmem->resident = pageshift(sigar_parse_u64(&ptr, end));
+    procmem->share    = pageshift(sigar_parse_u64(&ptr, end));
 
     return SIGAR_OK;
 }
@@ -783,7 +903,7 @@ int sigar_proc_cumulative_disk_io_get(sigar_t *sigar, sigar_pid_t pid,
 {
     char buffer[BUFSIZ];
     
-    int status = SIGAR_PROC_FILE2STR(buffer, pid, "/io");
+    int status = SIGAR_PROC_FILE2STR(sigar, buffer, pid, "/io");
     
     if (status != SIGAR_OK) {
         return status;
@@ -802,7 +922,7 @@ int sigar_proc_cred_get(sigar_t *sigar, sigar_pid_t pid,
                         sigar_proc_cred_t *proccred)
 {
     char buffer[BUFSIZ], *ptr;
-    int status = SIGAR_PROC_FILE2STR(buffer, pid, PROC_PSTATUS);
+    int status = SIGAR_PROC_FILE2STR(sigar, buffer, pid, PROC_PSTATUS);
 
     if (status != SIGAR_OK) {
         return status;
@@ -835,11 +955,11 @@ int sigar_proc_cred_get(sigar_t *sigar, sigar_pid_t pid,
     return SIGAR_OK;
 }
 
-int sigar_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
-                        sigar_proc_time_t *proctime)
+int sigar_os_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
+                           sigar_proc_time_t *proctime)
 {
     int status = proc_stat_read(sigar, pid);
-    linux_proc_stat_t *pstat = &sigar->last_proc_stat;
+    linux_proc_stat_t *pstat = proc_stat_slot(sigar);
 
     if (status != SIGAR_OK) {
         return status;
@@ -857,7 +977,7 @@ static int proc_status_get(sigar_t *sigar, sigar_pid_t pid,
                            sigar_proc_state_t *procstate)
 {
     char buffer[BUFSIZ], *ptr;
-    int status = SIGAR_PROC_FILE2STR(buffer, pid, PROC_PSTATUS);
+    int status = SIGAR_PROC_FILE2STR(sigar, buffer, pid, PROC_PSTATUS);
 
     if (status != SIGAR_OK) {
         return status;
@@ -876,11 +996,11 @@ static int proc_status_get(sigar_t *sigar, sigar_pid_t pid,
     return SIGAR_OK;
 }
 
-int sigar_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
-                         sigar_proc_state_t *procstate)
+int sigar_os_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
+                            sigar_proc_state_t *procstate)
 {
     int status = proc_stat_read(sigar, pid);
-    linux_proc_stat_t *pstat = &sigar->last_proc_stat;
+    linux_proc_stat_t *pstat = proc_stat_slot(sigar);
 
     if (status != SIGAR_OK) {
         return status;
@@ -927,7 +1047,7 @@ int sigar_proc_env_get(sigar_t *sigar, sigar_pid_t pid,
     /* optimize if pid == $$ and type == ENV_KEY */
     SIGAR_PROC_ENV_KEY_LOOKUP();
 
-    (void)SIGAR_PROC_FILENAME(name, pid, "/environ");
+    (void)SIGAR_PROC_FILENAME(sigar, name, pid, "/environ");
 
     if ((fd = open(name, O_RDONLY)) < 0) {
         if (errno == ENOENT) {
@@ -940,6 +1060,10 @@ int sigar_proc_env_get(sigar_t *sigar, sigar_pid_t pid,
 
     close(fd);
 
+    if (sigar_recording && (len != (size_t)-1)) {
+        sigar_record_file(name, buffer, len);
+    }
+
     buffer[len] = '\0';
     ptr = buffer;
 
@@ -989,7 +1113,7 @@ int sigar_proc_exe_get(sigar_t *sigar, sigar_pid_t pid,
     int len;
     char name[BUFSIZ];
 
-    (void)SIGAR_PROC_FILENAME(name, pid, "/cwd");
+    (void)SIGAR_PROC_FILENAME(sigar, name, pid, "/cwd");
 
     if ((len = readlink(name, procexe->cwd,
                         sizeof(procexe->cwd)-1)) < 0)
@@ -998,8 +1122,11 @@ int sigar_proc_exe_get(sigar_t *sigar, sigar_pid_t pid,
     }
 
     procexe->cwd[len] = '\0';
+    if (sigar_recording) {
+        sigar_record_link(name, procexe->cwd, len);
+    }
 
-    (void)SIGAR_PROC_FILENAME(name, pid, "/exe");
+    (void)SIGAR_PROC_FILENAME(sigar, name, pid, "/exe");
 
     if ((len = readlink(name, procexe->name,
                         sizeof(procexe->name)-1)) < 0)
@@ -1008,8 +1135,11 @@ int sigar_proc_exe_get(sigar_t *sigar, sigar_pid_t pid,
     }
 
     procexe->name[len] = '\0';
+    if (sigar_recording) {
+        sigar_record_link(name, procexe->name, len);
+    }
 
-    (void)SIGAR_PROC_FILENAME(name, pid, "/root");
+    (void)SIGAR_PROC_FILENAME(sigar, name, pid, "/root");
 
     if ((len = readlink(name, procexe->root,
                         sizeof(procexe->root)-1)) < 0)
@@ -1018,6 +1148,9 @@ int sigar_proc_exe_get(sigar_t *sigar, sigar_pid_t pid,
     }
 
     procexe->root[len] = '\0';
+    if (sigar_recording) {
+        sigar_record_link(name, procexe->root, len);
+    }
 
     return SIGAR_OK;
 }
@@ -1029,9 +1162,9 @@ int sigar_proc_modules_get(sigar_t *sigar, sigar_pid_t pid,
     char buffer[BUFSIZ], *ptr;
     unsigned long inode, last_inode = 0;
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/maps");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/maps");
 
-    if (!(fp = fopen(buffer, "r"))) {
+    if (!(fp = sigar_fopen(buffer))) {
         return errno;
     }
 
@@ -1061,7 +1194,7 @@ int sigar_proc_modules_get(sigar_t *sigar, sigar_pid_t pid,
         }
     }
     
-    fclose(fp);
+    sigar_fclose(fp);
 
     return SIGAR_OK;
 }
@@ -1086,6 +1219,7 @@ int sigar_thread_cpu_get(sigar_t *sigar,
 }
 
 #include <mntent.h>
+#include <poll.h>
 
 int sigar_os_fs_type_get(sigar_file_system_t *fsp)
 {
@@ -1142,8 +1276,8 @@ int sigar_os_fs_type_get(sigar_file_system_t *fsp)
     return fsp->type;
 }
 
-int sigar_file_system_list_get(sigar_t *sigar,
-                               sigar_file_system_list_t *fslist)
+static int file_system_list_mntent(sigar_t *sigar,
+                                   sigar_file_system_list_t *fslist)
 {
     struct mntent ent;
     char buf[1025]; /* buffer for strings within ent */
@@ -1154,7 +1288,7 @@ int sigar_file_system_list_get(sigar_t *sigar,
         return errno;
     }
 
-    sigar_file_system_list_create(fslist);
+    sigar_file_system_list_create(sigar, fslist);
 
     while (getmntent_r(fp, &ent, buf, sizeof(buf))) {
         SIGAR_FILE_SYSTEM_LIST_GROW(fslist);
@@ -1174,896 +1308,2916 @@ int sigar_file_system_list_get(sigar_t *sigar,
     return SIGAR_OK;
 }
 
-#define ST_MAJOR(sb) major((sb).st_rdev)
-#define ST_MINOR(sb) minor((sb).st_rdev)
+#define PROC_MOUNTINFO PROC_FS_ROOT "self/mountinfo"
 
-static int get_iostat_sys(sigar_t *sigar,
-                          const char *dirname,
-                          sigar_disk_usage_t *disk,
-                          sigar_iodev_t **iodev)
+/* split off the next space delimited field, NULL at end of line */
+static char *mountinfo_field(char **ptr)
 {
-    char stat[1025], dev[1025];
-    char *name, *ptr, *fsdev;
-    int partition, status;
+    char *start, *p = *ptr;
 
-    if (!(*iodev = sigar_iodev_get(sigar, dirname))) {
-        return ENXIO;
+    while (*p == ' ') {
+        p++;
     }
-
-    name = fsdev = (*iodev)->name;
-
-    if (SIGAR_NAME_IS_DEV(name)) {
-        name += SSTRLEN(SIGAR_DEV_PREFIX); /* strip "/dev/" */
+    if ((*p == '\0') || (*p == '\n')) {
+        return NULL;
     }
 
-    while (!sigar_isdigit(*fsdev)) {
-        fsdev++;
+    start = p;
+    while (*p && (*p != ' ') && (*p != '\n')) {
+        p++;
+    }
+    if (*p) {
+        *p++ = '\0';
     }
+    *ptr = p;
 
-    partition = strtoul(fsdev, NULL, 0);
-    *fsdev = '\0';
+    return start;
+}
 
-    snprintf(stat, sizeof(stat),
-             SYS_BLOCK "/%s/%s%d/stat", name, name, partition);
+/* mountinfo escapes space, tab, newline and backslash as \ooo */
+static void mountinfo_strcpy(char *dst, const char *src, int len)
+{
+    char *end = dst + len - 1;
 
-    status = sigar_file2str(stat, dev, sizeof(dev));
-    if (status != SIGAR_OK) {
-        return status;
+    while (*src && (dst < end)) {
+        if ((src[0] == '\\') &&
+            (src[1] >= '0') && (src[1] <= '3') &&
+            (src[2] >= '0') && (src[2] <= '7') &&
+            (src[3] >= '0') && (src[3] <= '7'))
+        {
+            *dst++ = ((src[1] - '0') << 6) |
+                     ((src[2] - '0') << 3) |
+                      (src[3] - '0');
+            src += 4;
+        }
+        else {
+            *dst++ = *src++;
+        }
     }
 
-    ptr = dev;
-    ptr = sigar_skip_token(ptr);
-    disk->reads = sigar_strtoull(ptr);
-    ptr = sigar_skip_token(ptr);
-    disk->writes = sigar_strtoull(ptr);
-
-    disk->read_bytes  = SIGAR_FIELD_NOTIMPL;
-    disk->write_bytes = SIGAR_FIELD_NOTIMPL;
-    disk->queue       = SIGAR_FIELD_NOTIMPL;
-
-    return SIGAR_OK;
+    *dst = '\0';
 }
 
-static int get_iostat_proc_dstat(sigar_t *sigar,
-                                 const char *dirname,
-                                 sigar_disk_usage_t *disk,
-                                 sigar_iodev_t **iodev,
-                                 sigar_disk_usage_t *device_usage)
+/*
+ * /proc/self/mountinfo fields:
+ * 1 - mount id
+ * 2 - parent id
+ * 3 - major:minor
+ * 4 - root
+ * 5 - mount point
+ * 6 - mount options
+ * 7 - optional fields, terminated by "-"
+ * 8 - filesystem type
+ * 9 - mount source
+ * 10 - super block options
+ */
+static int mountinfo_parse_line(linux_mount_t *mnt, char *line)
 {
-    FILE *fp;
-    char buffer[1025];
-    char *ptr;
-    struct stat sb;
-    int status=ENOENT;
+    sigar_file_system_t *fsp = &mnt->fs;
+    char *ptr = line, *field, *dir, *opts, *type, *source, *sopts;
 
-    SIGAR_DISK_STATS_INIT(device_usage);
+    if (!(field = mountinfo_field(&ptr))) {
+        return 0;
+    }
+    mnt->mount_id = strtoul(field, NULL, 10);
 
-    if (!(*iodev = sigar_iodev_get(sigar, dirname))) {
-        return ENXIO;
+    if (!mountinfo_field(&ptr)) { /* parent id */
+        return 0;
     }
 
-    if (stat((*iodev)->name, &sb) < 0) {
-        return errno;
+    if (!(field = mountinfo_field(&ptr))) {
+        return 0;
+    }
+    mnt->major = sigar_strtoul(field);
+    if (*field++ != ':') {
+        return 0;
     }
+    mnt->minor = sigar_strtoul(field);
 
-    if (SIGAR_LOG_IS_DEBUG(sigar)) {
-        sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
-                         PROC_DISKSTATS " %s -> %s [%d,%d]",
-                         dirname, (*iodev)->name,
-                         ST_MAJOR(sb), ST_MINOR(sb));
+    if (!mountinfo_field(&ptr) || /* root */
+        !(dir = mountinfo_field(&ptr)) ||
+        !(opts = mountinfo_field(&ptr)))
+    {
+        return 0;
     }
 
-    if (!(fp = fopen(PROC_DISKSTATS, "r"))) {
-        return errno;
+    while ((field = mountinfo_field(&ptr))) {
+        if ((field[0] == '-') && (field[1] == '\0')) {
+            break;
+        }
     }
 
-    while ((ptr = fgets(buffer, sizeof(buffer), fp))) {
-        unsigned long major, minor;
+    if (!field ||
+        !(type = mountinfo_field(&ptr)) ||
+        !(source = mountinfo_field(&ptr)))
+    {
+        return 0;
+    }
+    sopts = mountinfo_field(&ptr);
 
-        major = sigar_strtoul(ptr);
-        minor = sigar_strtoul(ptr);
+    fsp->type = SIGAR_FSTYPE_UNKNOWN; /* unknown, will be set later */
+    mountinfo_strcpy(fsp->dir_name, dir, sizeof(fsp->dir_name));
+    mountinfo_strcpy(fsp->dev_name, source, sizeof(fsp->dev_name));
+    mountinfo_strcpy(fsp->sys_type_name, type, sizeof(fsp->sys_type_name));
 
-        if ((major == ST_MAJOR(sb)) &&
-            ((minor == ST_MINOR(sb)) || (minor == 0)))
-        {
-            int num;
-            unsigned long
-                rio, rmerge, rsect, ruse,
-                wio, wmerge, wsect, wuse,
-                running, use, aveq;
+    /*
+     * /proc/mounts shows the super block options followed by the
+     * per-mount options; rw/ro is in both, so keep the per-mount one.
+     */
+    if (sopts && (strnEQ(sopts, "rw,", 3) || strnEQ(sopts, "ro,", 3))) {
+        snprintf(fsp->options, sizeof(fsp->options),
+                 "%s,%s", opts, sopts + 3);
+    }
+    else {
+        SIGAR_SSTRCPY(fsp->options, opts);
+    }
 
-            ptr = sigar_skip_token(ptr); /* name */
+    sigar_fs_type_get(fsp);
 
-            num = sscanf(ptr,
-                         "%lu %lu %lu %lu "
-                         "%lu %lu %lu %lu "
-                         "%lu %lu %lu",
-                         &rio,     /* 1  # reads issued */
-                         &rmerge,  /* 2  # reads merged */
-                         &rsect,   /* 3  # sectors read */
-                         &ruse,    /* 4  # millis spent reading */
-                         &wio,     /* 5  # writes completed */
-                         &wmerge,  /* 6  # writes merged */
-                         &wsect,   /* 7  # sectors written */
-                         &wuse,    /* 8  # millis spent writing */
-                         &running, /* 9  # I/Os currently in progress */
-                         &use,     /* 10 # millis spent doing I/Os */
-                         &aveq);   /* 11 # of millis spent doing I/Os (weighted) */
-
-            if (num == 11) {
-                disk->rtime = ruse;
-                disk->wtime = wuse;
-                disk->time = use;
-                disk->qtime = aveq;
-            }
-            else if (num == 4) {
-                wio = rsect;
-                rsect = rmerge;
-                wsect = ruse;
-                disk->time = disk->qtime = SIGAR_FIELD_NOTIMPL;
-            }
-            else {
-                status = ENOENT;
-            }
+    return 1;
+}
 
-            disk->reads = rio;
-            disk->writes = wio;
-            disk->read_bytes  = rsect;
-            disk->write_bytes = wsect;
+static int mountinfo_read(sigar_t *sigar, char **data)
+{
+    size_t size = 8192, len = 0;
+    char *buf = malloc(size);
 
-            /* convert sectors to bytes (512 is fixed size in 2.6 kernels) */
-            disk->read_bytes  *= 512;
-            disk->write_bytes *= 512;
+    if (lseek(sigar->mountinfo_fd, 0, SEEK_SET) < 0) {
+        free(buf);
+        return errno;
+    }
 
-            if (minor == ST_MINOR(sb)) {
-                status = SIGAR_OK;
-                break;
-            }
-            else if (minor == 0) {
-                memcpy(device_usage, disk, sizeof(*device_usage));
+    while (1) {
+        ssize_t nread;
+
+        if (len + 1 >= size) {
+            size *= 2;
+            buf = realloc(buf, size);
+        }
+
+        nread = read(sigar->mountinfo_fd, buf + len, size - len - 1);
+        if (nread < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            free(buf);
+            return errno;
         }
+        if (nread == 0) {
+            break;
+        }
+        len += nread;
     }
 
-    fclose(fp);
+    buf[len] = '\0';
+    *data = buf;
 
-    return status;
+    /* read through the kept fd, not sigar_file2str */
+    if (sigar_recording && !sigar->proc_root) {
+        sigar_record_file(PROC_MOUNTINFO, buf, len);
+    }
+
+    return SIGAR_OK;
 }
 
-static int get_iostat_procp(sigar_t *sigar,
-                            const char *dirname,
-                            sigar_disk_usage_t *disk,
-                            sigar_iodev_t **iodev)
+/*
+ * the kernel flags the mountinfo fd with POLLPRI|POLLERR whenever
+ * the mount namespace changes, so the parsed table is only rebuilt
+ * when something has actually been mounted or unmounted.
+ */
+static int mountinfo_refresh(sigar_t *sigar)
 {
-    FILE *fp;
-    char buffer[1025];
-    char *ptr;
-    struct stat sb;
+    struct pollfd pfd;
+    char *data, *line, *next;
+    int status;
 
-    if (!(*iodev = sigar_iodev_get(sigar, dirname))) {
-        return ENXIO;
-    }
+    if (sigar->mountinfo_fd == -1) {
+        char path[SIGAR_PATH_MAX+1];
 
-    if (stat((*iodev)->name, &sb) < 0) {
-        return errno;
+        sigar->mountinfo_fd =
+            open(SIGAR_ROOT_PATH(sigar, PROC_MOUNTINFO, path), O_RDONLY);
+        if (sigar->mountinfo_fd == -1) {
+            return errno;
+        }
+        fcntl(sigar->mountinfo_fd, F_SETFD, FD_CLOEXEC);
     }
+    else if (sigar->mounts) {
+        pfd.fd = sigar->mountinfo_fd;
+        pfd.events = POLLPRI;
+        pfd.revents = 0;
 
-    if (SIGAR_LOG_IS_DEBUG(sigar)) {
-        sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
-                         PROC_PARTITIONS " %s -> %s [%d,%d]",
-                         dirname, (*iodev)->name,
-                         ST_MAJOR(sb), ST_MINOR(sb));
+        if ((poll(&pfd, 1, 0) == 0) ||
+            !(pfd.revents & (POLLPRI|POLLERR)))
+        {
+            return SIGAR_OK; /* unchanged */
+        }
     }
 
-    if (!(fp = fopen(PROC_PARTITIONS, "r"))) {
-        return errno;
+    if ((status = mountinfo_read(sigar, &data)) != SIGAR_OK) {
+        return status;
     }
 
-    (void)fgets(buffer, sizeof(buffer), fp); /* skip header */
-    while ((ptr = fgets(buffer, sizeof(buffer), fp))) {
-        unsigned long major, minor;
-
-        major = sigar_strtoul(ptr);
-        minor = sigar_strtoul(ptr);
+    sigar->mounts_number = 0;
 
-        if ((major == ST_MAJOR(sb)) && (minor == ST_MINOR(sb))) {
-            ptr = sigar_skip_token(ptr); /* blocks */
-            ptr = sigar_skip_token(ptr); /* name */
-            disk->reads = sigar_strtoull(ptr); /* rio */
-            ptr = sigar_skip_token(ptr);  /* rmerge */ 
-            disk->read_bytes  = sigar_strtoull(ptr); /* rsect */
-            disk->rtime = sigar_strtoull(ptr); /* ruse */
-            disk->writes = sigar_strtoull(ptr); /* wio */
-            ptr = sigar_skip_token(ptr);  /* wmerge */ 
-            disk->write_bytes = sigar_strtoull(ptr); /* wsect */
-            disk->wtime = sigar_strtoull(ptr); /* wuse */
-            ptr = sigar_skip_token(ptr); /* running */
-            disk->time = sigar_strtoull(ptr); /* use */
-            disk->qtime  = sigar_strtoull(ptr); /* aveq */
+    for (line = data; line && *line; line = next) {
+        if ((next = strchr(line, '\n'))) {
+            *next++ = '\0';
+        }
 
-            /* convert sectors to bytes (512 is fixed size in 2.6 kernels) */
-            disk->read_bytes  *= 512;
-            disk->write_bytes *= 512;
+        if (sigar->mounts_number >= sigar->mounts_size) {
+            sigar->mounts_size += SIGAR_FS_MAX;
+            sigar->mounts =
+                realloc(sigar->mounts,
+                        sizeof(*sigar->mounts) * sigar->mounts_size);
+        }
 
-            fclose(fp);
-            return SIGAR_OK;
+        if (mountinfo_parse_line(&sigar->mounts[sigar->mounts_number],
+                                 line))
+        {
+            sigar->mounts_number++;
         }
     }
 
-    fclose(fp);
+    free(data);
 
-    return ENOENT;
+    if (!sigar->mounts) {
+        /* empty mount namespace, make sure we poll next time */
+        sigar->mounts = malloc(sizeof(*sigar->mounts));
+    }
+
+    return SIGAR_OK;
 }
 
-int sigar_disk_usage_get(sigar_t *sigar, const char *name,
-                         sigar_disk_usage_t *disk)
+static int mount_dev_name_get(sigar_t *sigar, dev_t dev,
+                              char *name, int len)
 {
+    unsigned long i;
     int status;
-    sigar_iodev_t *iodev = NULL;
-    sigar_disk_usage_t device_usage;
-    SIGAR_DISK_STATS_INIT(disk);
 
-    /*
-     * 2.2 has metrics /proc/stat, but wtf is the device mapping?
-     * 2.4 has /proc/partitions w/ the metrics.
-     * 2.6 has /proc/partitions w/o the metrics.
-     *     instead the metrics are within the /proc-like /sys filesystem.
-     *     also has /proc/diskstats
-     */
-    switch (sigar->iostat) {
-      case IOSTAT_SYS:
-        status = get_iostat_sys(sigar, name, disk, &iodev);
-        break;
-      case IOSTAT_DISKSTATS:
-        status = get_iostat_proc_dstat(sigar, name, disk, &iodev, &device_usage);
-        break;
-      case IOSTAT_PARTITIONS:
-        status = get_iostat_procp(sigar, name, disk, &iodev);
-        break;
-      /*
-       * case IOSTAT_SOME_OTHER_WIERD_THING:
-       * break;
-       */
-      case IOSTAT_NONE:
-      default:
-        status = ENOENT;
-        break;
+    if ((status = mountinfo_refresh(sigar)) != SIGAR_OK) {
+        return status;
     }
 
-    if ((status == SIGAR_OK) && iodev) {
-        sigar_uptime_t uptime;
-        sigar_uint64_t interval, ios;
-        double tput, util;
-        sigar_disk_usage_t *partition_usage=NULL;
-
-        sigar_uptime_get(sigar, &uptime);
+    for (i=0; i<sigar->mounts_number; i++) {
+        linux_mount_t *mnt = &sigar->mounts[i];
 
-        if (iodev->is_partition &&
-            (sigar->iostat == IOSTAT_DISKSTATS))
+        if ((mnt->major == major(dev)) &&
+            (mnt->minor == minor(dev)) &&
+            (mnt->fs.type == SIGAR_FSTYPE_LOCAL_DISK) &&
+            SIGAR_NAME_IS_DEV(mnt->fs.dev_name))
         {
-            /* 2.6 kernels do not have per-partition times */
-            partition_usage = disk;
-            disk = &device_usage;
+            strncpy(name, mnt->fs.dev_name, len);
+            name[len-1] = '\0';
+            return SIGAR_OK;
         }
+    }
+
+    return ENOENT;
+}
 
-        disk->snaptime = uptime.uptime;
+int sigar_mount_dev_name_get(sigar_t *sigar, dev_t dev,
+                             char *name, int len)
+{
+    int status;
 
-        if (iodev->disk.snaptime) {
-            interval = disk->snaptime - iodev->disk.snaptime;
-        }
-        else {
-            interval = disk->snaptime;
-        }
+    sigar_lock(sigar);
+    status = mount_dev_name_get(sigar, dev, name, len);
+    sigar_unlock(sigar);
 
-        ios =
-            (disk->reads - iodev->disk.reads) +
-            (disk->writes - iodev->disk.writes);
+    return status;
+}
 
-        if (disk->time == SIGAR_FIELD_NOTIMPL) {
-            disk->service_time = SIGAR_FIELD_NOTIMPL;
-        }
-        else {
-            tput = ((double)ios) * HZ / interval;
-            util = ((double)(disk->time - iodev->disk.time)) / interval * HZ;
-            disk->service_time = tput ? util / tput : 0.0;
-        }
-        if (disk->qtime == SIGAR_FIELD_NOTIMPL) {
-            disk->queue = SIGAR_FIELD_NOTIMPL;
-        }
-        else {
-            util = ((double)(disk->qtime - iodev->disk.qtime)) / interval;
-            disk->queue = util / 1000.0;
-        }
+static int file_system_list_get(sigar_t *sigar,
+                                sigar_file_system_list_t *fslist)
+{
+    unsigned long i;
 
-        memcpy(&iodev->disk, disk, sizeof(iodev->disk));
-        if (partition_usage) {
-            partition_usage->service_time = disk->service_time;
-            partition_usage->queue = disk->queue;
-        }
+    if (mountinfo_refresh(sigar) != SIGAR_OK) {
+        /* mountinfo is only available as of 2.6.26 */
+        return file_system_list_mntent(sigar, fslist);
+    }
+
+    sigar_file_system_list_create(sigar, fslist);
+
+    for (i=0; i<sigar->mounts_number; i++) {
+        SIGAR_FILE_SYSTEM_LIST_GROW(fslist);
+
+        memcpy(&fslist->data[fslist->number++],
+               &sigar->mounts[i].fs,
+               sizeof(sigar_file_system_t));
     }
 
+    return SIGAR_OK;
+}
+
+int sigar_os_file_system_list_get(sigar_t *sigar,
+                                  sigar_file_system_list_t *fslist)
+{
+    int status;
+
+    sigar_lock(sigar);
+    status = file_system_list_get(sigar, fslist);
+    sigar_unlock(sigar);
+
     return status;
 }
 
-int sigar_file_system_usage_get(sigar_t *sigar,
-                                const char *dirname,
-                                sigar_file_system_usage_t *fsusage)
+#define ST_MAJOR(sb) major((sb).st_rdev)
+#define ST_MINOR(sb) minor((sb).st_rdev)
+
+static int get_iostat_sys(sigar_t *sigar,
+                          const char *dirname,
+                          sigar_disk_usage_t *disk,
+                          sigar_iodev_t **iodev)
 {
-    int status = sigar_statvfs(sigar, dirname, fsusage);
+    char stat[1025], dev[1025];
+    char path[SIGAR_PATH_MAX+1];
+    char *name, *ptr, *fsdev;
+    int partition, status;
+
+    if (!(*iodev = sigar_iodev_get(sigar, dirname))) {
+        return ENXIO;
+    }
+
+    name = fsdev = (*iodev)->name;
+
+    if (SIGAR_NAME_IS_DEV(name)) {
+        name += SSTRLEN(SIGAR_DEV_PREFIX); /* strip "/dev/" */
+    }
+
+    while (!sigar_isdigit(*fsdev)) {
+        fsdev++;
+    }
+
+    partition = strtoul(fsdev, NULL, 0);
+    *fsdev = '\0';
 
+    snprintf(stat, sizeof(stat),
+             SYS_BLOCK "/%s/%s%d/stat", name, name, partition);
+
+    status = sigar_file2str(SIGAR_ROOT_PATH(sigar, stat, path),
+                            dev, sizeof(dev));
     if (status != SIGAR_OK) {
         return status;
     }
 
-    fsusage->use_percent = sigar_file_system_usage_calc_used(sigar, fsusage);
+    ptr = dev;
+    ptr = sigar_skip_token(ptr);
+    disk->reads = sigar_strtoull(ptr);
+    ptr = sigar_skip_token(ptr);
+    disk->writes = sigar_strtoull(ptr);
 
-    (void)sigar_disk_usage_get(sigar, dirname, &fsusage->disk);
+    disk->read_bytes  = SIGAR_FIELD_NOTIMPL;
+    disk->write_bytes = SIGAR_FIELD_NOTIMPL;
+    disk->queue       = SIGAR_FIELD_NOTIMPL;
 
     return SIGAR_OK;
 }
 
-static SIGAR_INLINE char *cpu_info_strval(char *ptr)
+#define DISKSTATS_ID(major, minor) \
+    (((sigar_uint64_t)(major) << 32) | (minor))
+
+#define DISKSTATS_FIELDS_MAX 17
+
+/*
+ * /proc/diskstats fields following "major minor name":
+ * 1  - reads completed        10 - millis spent doing I/Os
+ * 2  - reads merged           11 - weighted millis doing I/Os
+ * 3  - sectors read           12 - discards completed (4.18+)
+ * 4  - millis spent reading   13 - discards merged
+ * 5  - writes completed       14 - sectors discarded
+ * 6  - writes merged          15 - millis spent discarding
+ * 7  - sectors written        16 - flush requests (5.5+)
+ * 8  - millis spent writing   17 - millis spent flushing
+ * 9  - I/Os in progress
+ * partitions on 2.6 kernels only have: reads, rsect, writes, wsect
+ */
+static void diskstats_parse(linux_disk_io_t *dio, char *ptr, char *end,
+                            sigar_uint64_t mtime, sigar_uint64_t now)
 {
-    if ((ptr = strchr(ptr, ':'))) {
-        ptr++;
-        while (isspace (*ptr)) ptr++;
-        return ptr;
+    sigar_disk_io_t *io = &dio->io;
+    sigar_disk_usage_t *disk = &io->disk;
+    sigar_uint64_t val[DISKSTATS_FIELDS_MAX];
+    sigar_rate_t reads, writes, rbytes, wbytes, rate;
+    int i, num = 0;
+
+    while (num < DISKSTATS_FIELDS_MAX) {
+        char *start = ptr;
+        val[num] = sigar_parse_u64(&ptr, end);
+        if (ptr == start) {
+            break;
+        }
+        num++;
     }
-    return NULL;
-}
 
-static SIGAR_INLINE void cpu_info_strcpy(char *ptr, char *buf, int len)
-{
-    int slen;
-    ptr = cpu_info_strval(ptr);
-    if (!ptr) {
-        return;
+    for (i=num; i<DISKSTATS_FIELDS_MAX; i++) {
+        val[i] = SIGAR_FIELD_NOTIMPL;
     }
-    slen = strlen(ptr);
-    strncpy(buf, ptr, len);
-    buf[len] = '\0';
-    if (slen < len) {
-        buf[slen-1] = '\0'; /* rid \n */
+
+    SIGAR_DISK_STATS_INIT(disk);
+    io->read_merges = io->write_merges = io->in_progress =
+        SIGAR_FIELD_NOTIMPL;
+
+    if (num == 4) {
+        disk->reads       = val[0];
+        disk->read_bytes  = val[1] * 512;
+        disk->writes      = val[2];
+        disk->write_bytes = val[3] * 512;
+    }
+    else if (num >= 11) {
+        disk->reads        = val[0];
+        io->read_merges    = val[1];
+        /* convert sectors to bytes (512 is fixed size in 2.6 kernels) */
+        disk->read_bytes   = val[2] * 512;
+        disk->rtime        = val[3];
+        disk->writes       = val[4];
+        io->write_merges   = val[5];
+        disk->write_bytes  = val[6] * 512;
+        disk->wtime        = val[7];
+        io->in_progress    = val[8];
+        disk->time         = val[9];
+        disk->qtime        = val[10];
+    }
+
+    io->discards       = val[11];
+    io->discard_merges = val[12];
+    io->discard_bytes  =
+        (num > 13) ? val[13] * 512 : SIGAR_FIELD_NOTIMPL;
+    io->dtime          = val[14];
+    io->flushes        = val[15];
+    io->ftime          = val[16];
+
+    disk->snaptime = mtime / SIGAR_MSEC;
+    dio->mtime = mtime;
+
+    /* all 0 the first time a device is seen */
+    sigar_rate_update(&dio->reads, disk->reads, now, 0, &reads);
+    sigar_rate_update(&dio->writes, disk->writes, now, 0, &writes);
+    sigar_rate_update(&dio->read_bytes, disk->read_bytes, now, 0, &rbytes);
+    sigar_rate_update(&dio->write_bytes, disk->write_bytes, now, 0, &wbytes);
+
+    io->reads_per_sec = reads.rate;
+    io->writes_per_sec = writes.rate;
+    io->read_bytes_per_sec = rbytes.rate;
+    io->write_bytes_per_sec = wbytes.rate;
+
+    if (disk->time == SIGAR_FIELD_NOTIMPL) {
+        io->utilization = disk->service_time = SIGAR_FIELD_NOTIMPL;
+    }
+    else {
+        sigar_uint64_t ios = reads.delta + writes.delta;
+
+        sigar_rate_update(&dio->time, disk->time, now, 0, &rate);
+        /* msec busy per sec, as a percentage */
+        io->utilization = rate.rate * 100.0 / SIGAR_MSEC;
+        disk->service_time = ios ? (double)rate.delta / ios : 0.0;
+    }
+
+    if (disk->qtime == SIGAR_FIELD_NOTIMPL) {
+        disk->queue = SIGAR_FIELD_NOTIMPL;
+    }
+    else {
+        sigar_rate_update(&dio->qtime, disk->qtime, now, 0, &rate);
+        disk->queue = rate.rate / SIGAR_MSEC;
     }
 }
 
-static int get_cpu_info(sigar_t *sigar, sigar_cpu_info_t *info,
-                        FILE *fp)
+/* drop devices that were not in the last read, loop and iscsi
+ * devices come and go and would otherwise pile up */
+static void diskstats_sweep(sigar_cache_t *table, unsigned int gen)
 {
-    char buffer[BUFSIZ], *ptr;
-
-    int found = 0;
+    unsigned int i;
 
-    /* UML vm wont have "cpu MHz" or "cache size" fields */
-    info->mhz        = 0;
-    info->cache_size = 0;
+    for (i=0; i<table->size; i++) {
+        sigar_cache_entry_t *entry, **ptr = &table->entries[i];
 
-#ifdef __powerpc64__
-    SIGAR_SSTRCPY(info->vendor, "IBM");
-#endif
+        while ((entry = *ptr)) {
+            linux_disk_io_t *dio = entry->value;
 
-    while ((ptr = fgets(buffer, sizeof(buffer), fp))) {
-        switch (*ptr) {
-          case 'p': /* processor	: 0 */
-            if (strnEQ(ptr, "processor", 9)) {
-                found = 1;
-            }
-            break;
-          case 'v':
-            /* "vendor_id" or "vendor" */
-            if (strnEQ(ptr, "vendor", 6)) {
-                cpu_info_strcpy(ptr, info->vendor, sizeof(info->vendor));
-                if (strEQ(info->vendor, "GenuineIntel")) {
-                    SIGAR_SSTRCPY(info->vendor, "Intel");
-                }
-                else if (strEQ(info->vendor, "AuthenticAMD")) {
-                    SIGAR_SSTRCPY(info->vendor, "AMD");
-                }
-            }
-            break;
-          case 'f':
-            if (strnEQ(ptr, "family", 6)) {
-                /* IA64 version of "model name" */
-                cpu_info_strcpy(ptr, info->model, sizeof(info->model));
-                sigar_cpu_model_adjust(sigar, info);
-            }
-            break;
-          case 'm':
-            if (strnEQ(ptr, "model name", 10)) {
-                cpu_info_strcpy(ptr, info->model, sizeof(info->model));
-                sigar_cpu_model_adjust(sigar, info);
-            }
-            break;
-          case 'c':
-            if (strnEQ(ptr, "cpu MHz", 7)) {
-                ptr = cpu_info_strval(ptr);
-                info->mhz = atoi(ptr);
-            }
-            else if (strnEQ(ptr, "cache size", 10)) {
-                ptr = cpu_info_strval(ptr);
-                info->cache_size = sigar_strtoul(ptr);
-            }
-#ifdef __powerpc64__
-            /* each /proc/cpuinfo entry looks like so:
-             *   processor       : 0
-             *   cpu             : POWER5 (gr)
-             *   clock           : 1656.392000MHz
-             *   revision        : 2.2
-             */
-            else if (strnEQ(ptr, "clock", 5)) {
-                ptr = cpu_info_strval(ptr);
-                info->mhz = atoi(ptr);
+            if (dio && (dio->gen == gen)) {
+                ptr = &entry->next;
+                continue;
             }
-            else if (strnEQ(ptr, "cpu", 3)) {
-                cpu_info_strcpy(ptr, info->model, sizeof(info->model));
 
-                if ((ptr = strchr(info->model, ' '))) {
-                    /* "POWER5 (gr)" -> "POWER5" */
-                    *ptr = '\0';
-                }
+            *ptr = entry->next;
+            if (dio) {
+                table->free_value(dio);
             }
-#endif
-            break;
-           /* lone \n means end of info for this processor */
-          case '\n':
-            return found;
+            free(entry);
+            table->count--;
         }
     }
-
-    return found;
 }
 
-/* /proc/cpuinfo MHz will change w/ AMD + PowerNow */
-static void get_cpuinfo_max_freq(sigar_cpu_info_t *cpu_info, int num)
+/*
+ * read /proc/diskstats once for all devices.
+ * sigar_disk_usage_get reuses the snapshot for SIGAR_BUFFER_EXPIRE
+ * millis so a df across all mounts does not re-read it per mount.
+ */
+static int diskstats_refresh(sigar_t *sigar,
+                             sigar_disk_io_list_t *disklist)
 {
-    int status;
-    char max_freq[PATH_MAX];
-    snprintf(max_freq, sizeof(max_freq),
-             "/sys/devices/system/cpu/cpu%d"
-             "/cpufreq/cpuinfo_max_freq", num);
+    FILE *fp;
+    char buffer[1025], *ptr;
+    char path[SIGAR_PATH_MAX+1];
+    sigar_uint64_t timenow = sigar_time_now_millis();
+    sigar_uint64_t now = sigar_time_monotonic_millis();
 
-    status =
-        sigar_file2str(max_freq, max_freq, sizeof(max_freq)-1);
+    if (!disklist && sigar->diskstats &&
+        ((timenow - sigar->diskstats_time) < SIGAR_BUFFER_EXPIRE))
+    {
+        return SIGAR_OK;
+    }
 
-    if (status == SIGAR_OK) {
-        cpu_info->mhz_max = atoi(max_freq) / 1000;
+    if (!(fp = sigar_fopen(SIGAR_ROOT_PATH(sigar, PROC_DISKSTATS, path)))) {
+        return errno;
     }
-}
 
-static void get_cpuinfo_min_freq(sigar_cpu_info_t *cpu_info, int num)
-{
-    int status;
-    char min_freq[PATH_MAX];
-    snprintf(min_freq, sizeof(min_freq),
-             "/sys/devices/system/cpu/cpu%d"
-             "/cpufreq/cpuinfo_min_freq", num);
+    if (!sigar->diskstats) {
+        sigar->diskstats = sigar_cache_new(32);
+    }
 
-    status =
-        sigar_file2str(min_freq, min_freq, sizeof(min_freq)-1);
+    sigar->diskstats_time = timenow;
+    sigar->diskstats_gen++;
 
-    if (status == SIGAR_OK) {
-        cpu_info->mhz_min = atoi(min_freq) / 1000;
+    while ((ptr = fgets(buffer, sizeof(buffer), fp))) {
+        unsigned long major, minor;
+        char *name, *end = ptr + strlen(ptr);
+        int len;
+        sigar_cache_entry_t *entry;
+        linux_disk_io_t *dio;
+
+        major = sigar_parse_u64(&ptr, end);
+        minor = sigar_parse_u64(&ptr, end);
+        name = sigar_parse_space(ptr, end);
+        ptr = sigar_parse_skip(name, end);
+        len = ptr - name;
+        if (len == 0) {
+            continue;
+        }
+
+        entry = sigar_cache_get(sigar->diskstats,
+                                DISKSTATS_ID(major, minor));
+
+        if (!(dio = entry->value)) {
+            dio = entry->value = malloc(sizeof(*dio));
+            SIGAR_ZERO(dio);
+            dio->io.major = major;
+            dio->io.minor = minor;
+        }
+
+        if (len >= sizeof(dio->io.name)) {
+            len = sizeof(dio->io.name)-1;
+        }
+        memcpy(dio->io.name, name, len);
+        dio->io.name[len] = '\0';
+        dio->gen = sigar->diskstats_gen;
+
+        diskstats_parse(dio, ptr, end, timenow, now);
+
+        if (disklist) {
+            SIGAR_DISK_IO_LIST_GROW(disklist);
+            memcpy(&disklist->data[disklist->number++],
+                   &dio->io, sizeof(dio->io));
+        }
+    }
+
+    sigar_fclose(fp);
+
+    diskstats_sweep(sigar->diskstats, sigar->diskstats_gen);
+
+    return SIGAR_OK;
+}
+
+static linux_disk_io_t *diskstats_find(sigar_t *sigar,
+                                       unsigned long major,
+                                       unsigned long minor)
+{
+    sigar_cache_entry_t *entry =
+        sigar_cache_find(sigar->diskstats, DISKSTATS_ID(major, minor));
+    linux_disk_io_t *dio;
+
+    /* devices gone since are swept by diskstats_refresh */
+    if (!entry || !(dio = entry->value)) {
+        return NULL;
+    }
+
+    return dio;
+}
+
+static int disk_io_list_get(sigar_t *sigar,
+                            sigar_disk_io_list_t *disklist)
+{
+    int status;
+
+    sigar_disk_io_list_create(sigar, disklist);
+
+    status = diskstats_refresh(sigar, disklist);
+
+    if (status != SIGAR_OK) {
+        sigar_disk_io_list_destroy(sigar, disklist);
+    }
+
+    return status;
+}
+
+int sigar_os_disk_io_list_get(sigar_t *sigar,
+                              sigar_disk_io_list_t *disklist)
+{
+    int status;
+
+    sigar_lock(sigar);
+    status = disk_io_list_get(sigar, disklist);
+    sigar_unlock(sigar);
+
+    return status;
+}
+
+static int get_iostat_proc_dstat(sigar_t *sigar,
+                                 const char *dirname,
+                                 sigar_disk_usage_t *disk,
+                                 sigar_iodev_t **iodev,
+                                 sigar_disk_usage_t *device_usage)
+{
+    struct stat sb;
+    int status;
+    linux_disk_io_t *dio;
+
+    SIGAR_DISK_STATS_INIT(device_usage);
+
+    if (!(*iodev = sigar_iodev_get(sigar, dirname))) {
+        return ENXIO;
+    }
+
+    if (stat((*iodev)->name, &sb) < 0) {
+        return errno;
+    }
+
+    if (SIGAR_LOG_IS_DEBUG(sigar)) {
+        sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                         PROC_DISKSTATS " %s -> %s [%d,%d]",
+                         dirname, (*iodev)->name,
+                         ST_MAJOR(sb), ST_MINOR(sb));
+    }
+
+    if ((status = diskstats_refresh(sigar, NULL)) != SIGAR_OK) {
+        return status;
+    }
+
+    if ((dio = diskstats_find(sigar, ST_MAJOR(sb), 0))) {
+        memcpy(device_usage, &dio->io.disk, sizeof(*device_usage));
+    }
+
+    if (!(dio = diskstats_find(sigar, ST_MAJOR(sb), ST_MINOR(sb)))) {
+        return ENOENT;
+    }
+
+    if (dio->io.disk.reads == SIGAR_FIELD_NOTIMPL) {
+        return ENOENT; /* unknown diskstats format */
+    }
+
+    disk->reads       = dio->io.disk.reads;
+    disk->writes      = dio->io.disk.writes;
+    disk->read_bytes  = dio->io.disk.read_bytes;
+    disk->write_bytes = dio->io.disk.write_bytes;
+    disk->rtime       = dio->io.disk.rtime;
+    disk->wtime       = dio->io.disk.wtime;
+    disk->time        = dio->io.disk.time;
+    disk->qtime       = dio->io.disk.qtime;
+
+    return SIGAR_OK;
+}
+
+static int get_iostat_procp(sigar_t *sigar,
+                            const char *dirname,
+                            sigar_disk_usage_t *disk,
+                            sigar_iodev_t **iodev)
+{
+    FILE *fp;
+    char buffer[1025];
+    char path[SIGAR_PATH_MAX+1];
+    char *ptr;
+    struct stat sb;
+
+    if (!(*iodev = sigar_iodev_get(sigar, dirname))) {
+        return ENXIO;
+    }
+
+    if (stat((*iodev)->name, &sb) < 0) {
+        return errno;
+    }
+
+    if (SIGAR_LOG_IS_DEBUG(sigar)) {
+        sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                         PROC_PARTITIONS " %s -> %s [%d,%d]",
+                         dirname, (*iodev)->name,
+                         ST_MAJOR(sb), ST_MINOR(sb));
+    }
+
+    if (!(fp = sigar_fopen(SIGAR_ROOT_PATH(sigar, PROC_PARTITIONS, path)))) {
+        return errno;
+    }
+
+    (void)fgets(buffer, sizeof(buffer), fp); /* skip header */
+    while ((ptr = fgets(buffer, sizeof(buffer), fp))) {
+        unsigned long major, minor;
+
+        major = sigar_strtoul(ptr);
+        minor = sigar_strtoul(ptr);
+
+        if ((major == ST_MAJOR(sb)) && (minor == ST_MINOR(sb))) {
+            ptr = sigar_skip_token(ptr); /* blocks */
+            ptr = sigar_skip_token(ptr); /* name */
+            disk->reads = sigar_strtoull(ptr); /* rio */
+            ptr = sigar_skip_token(ptr);  /* rmerge */ 
+            disk->read_bytes  = sigar_strtoull(ptr); /* rsect */
+            disk->rtime = sigar_strtoull(ptr); /* ruse */
+            disk->writes = sigar_strtoull(ptr); /* wio */
+            ptr = sigar_skip_token(ptr);  /* wmerge */ 
+            disk->write_bytes = sigar_strtoull(ptr); /* wsect */
+            disk->wtime = sigar_strtoull(ptr); /* wuse */
+            ptr = sigar_skip_token(ptr); /* running */
+            disk->time = sigar_strtoull(ptr); /* use */
+            disk->qtime  = sigar_strtoull(ptr); /* aveq */
+
+            /* convert sectors to bytes (512 is fixed size in 2.6 kernels) */
+            disk->read_bytes  *= 512;
+            disk->write_bytes *= 512;
+
+            sigar_fclose(fp);
+            return SIGAR_OK;
+        }
+    }
+
+    sigar_fclose(fp);
+
+    return ENOENT;
+}
+
+static int disk_usage_get(sigar_t *sigar, const char *name,
+                          sigar_disk_usage_t *disk)
+{
+    int status;
+    sigar_iodev_t *iodev = NULL;
+    sigar_disk_usage_t device_usage;
+    SIGAR_DISK_STATS_INIT(disk);
+
+    /*
+     * 2.2 has metrics /proc/stat, but wtf is the device mapping?
+     * 2.4 has /proc/partitions w/ the metrics.
+     * 2.6 has /proc/partitions w/o the metrics.
+     *     instead the metrics are within the /proc-like /sys filesystem.
+     *     also has /proc/diskstats
+     */
+    switch (sigar->iostat) {
+      case IOSTAT_SYS:
+        status = get_iostat_sys(sigar, name, disk, &iodev);
+        break;
+      case IOSTAT_DISKSTATS:
+        status = get_iostat_proc_dstat(sigar, name, disk, &iodev, &device_usage);
+        break;
+      case IOSTAT_PARTITIONS:
+        status = get_iostat_procp(sigar, name, disk, &iodev);
+        break;
+      /*
+       * case IOSTAT_SOME_OTHER_WIERD_THING:
+       * break;
+       */
+      case IOSTAT_NONE:
+      default:
+        status = ENOENT;
+        break;
+    }
+
+    if ((status == SIGAR_OK) && iodev) {
+        sigar_uint64_t now = sigar_time_monotonic_millis();
+        sigar_rate_t ios, rate;
+        sigar_disk_usage_t *partition_usage=NULL;
+
+        if (iodev->is_partition &&
+            (sigar->iostat == IOSTAT_DISKSTATS))
+        {
+            /* 2.6 kernels do not have per-partition times */
+            partition_usage = disk;
+            disk = &device_usage;
+        }
+
+        disk->snaptime = sigar_time_now_millis() / SIGAR_MSEC;
+
+        sigar_rate_update(&iodev->ios, disk->reads + disk->writes,
+                          now, 0, &ios);
+
+        /* the first time, averages since boot */
+        if (disk->time == SIGAR_FIELD_NOTIMPL) {
+            disk->service_time = SIGAR_FIELD_NOTIMPL;
+        }
+        else {
+            sigar_rate_update(&iodev->time, disk->time, now, 0, &rate);
+            if (ios.interval) {
+                disk->service_time =
+                    ios.delta ? (double)rate.delta / ios.delta : 0.0;
+            }
+            else {
+                sigar_uint64_t total = disk->reads + disk->writes;
+                disk->service_time =
+                    total ? (double)disk->time / total : 0.0;
+            }
+        }
+        if (disk->qtime == SIGAR_FIELD_NOTIMPL) {
+            disk->queue = SIGAR_FIELD_NOTIMPL;
+        }
+        else {
+            sigar_rate_update(&iodev->qtime, disk->qtime, now, 0, &rate);
+            if (rate.interval) {
+                disk->queue = rate.rate / SIGAR_MSEC;
+            }
+            else {
+                sigar_uptime_t uptime;
+                sigar_uptime_get(sigar, &uptime);
+                disk->queue = uptime.uptime ?
+                    disk->qtime / (uptime.uptime * SIGAR_MSEC) : 0.0;
+            }
+        }
+
+        memcpy(&iodev->disk, disk, sizeof(iodev->disk));
+        if (partition_usage) {
+            partition_usage->service_time = disk->service_time;
+            partition_usage->queue = disk->queue;
+        }
+    }
+
+    return status;
+}
+
+/* the diskstats snapshot and each iodev's previous sample are shared */
+int sigar_os_disk_usage_get(sigar_t *sigar, const char *name,
+                            sigar_disk_usage_t *disk)
+{
+    int status;
+
+    sigar_lock(sigar);
+    status = disk_usage_get(sigar, name, disk);
+    sigar_unlock(sigar);
+
+    return status;
+}
+
+int sigar_file_system_usage_get(sigar_t *sigar,
+                                const char *dirname,
+                                sigar_file_system_usage_t *fsusage)
+{
+    int status = sigar_statvfs(sigar, dirname, fsusage);
+
+    if (status != SIGAR_OK) {
+        return status;
+    }
+
+    fsusage->use_percent = sigar_file_system_usage_calc_used(sigar, fsusage);
+
+    (void)sigar_disk_usage_get(sigar, dirname, &fsusage->disk);
+
+    return SIGAR_OK;
+}
+
+static SIGAR_INLINE char *cpu_info_strval(char *ptr)
+{
+    if ((ptr = strchr(ptr, ':'))) {
+        ptr++;
+        while (isspace (*ptr)) ptr++;
+        return ptr;
+    }
+    return NULL;
+}
+
+static SIGAR_INLINE void cpu_info_strcpy(char *ptr, char *buf, int len)
+{
+    int slen;
+    ptr = cpu_info_strval(ptr);
+    if (!ptr) {
+        return;
+    }
+    slen = strlen(ptr);
+    strncpy(buf, ptr, len);
+    buf[len] = '\0';
+    if (slen < len) {
+        buf[slen-1] = '\0'; /* rid \n */
+    }
+}
+
+static int get_cpu_info(sigar_t *sigar, sigar_cpu_info_t *info,
+                        FILE *fp)
+{
+    char buffer[BUFSIZ], *ptr;
+
+    int found = 0;
+
+    /* UML vm wont have "cpu MHz" or "cache size" fields */
+    info->mhz        = 0;
+    info->cache_size = 0;
+
+#ifdef __powerpc64__
+    SIGAR_SSTRCPY(info->vendor, "IBM");
+#endif
+
+    while ((ptr = fgets(buffer, sizeof(buffer), fp))) {
+        switch (*ptr) {
+          case 'p': /* processor	: 0 */
+            if (strnEQ(ptr, "processor", 9)) {
+                found = 1;
+            }
+            break;
+          case 'v':
+            /* "vendor_id" or "vendor" */
+            if (strnEQ(ptr, "vendor", 6)) {
+                cpu_info_strcpy(ptr, info->vendor, sizeof(info->vendor));
+                if (strEQ(info->vendor, "GenuineIntel")) {
+                    SIGAR_SSTRCPY(info->vendor, "Intel");
+                }
+                else if (strEQ(info->vendor, "AuthenticAMD")) {
+                    SIGAR_SSTRCPY(info->vendor, "AMD");
+                }
+            }
+            break;
+          case 'f':
+            if (strnEQ(ptr, "family", 6)) {
+                /* IA64 version of "model name" */
+                cpu_info_strcpy(ptr, info->model, sizeof(info->model));
+                sigar_cpu_model_adjust(sigar, info);
+            }
+            break;
+          case 'm':
+            if (strnEQ(ptr, "model name", 10)) {
+                cpu_info_strcpy(ptr, info->model, sizeof(info->model));
+                sigar_cpu_model_adjust(sigar, info);
+            }
+            break;
+          case 'c':
+            if (strnEQ(ptr, "cpu MHz", 7)) {
+                ptr = cpu_info_strval(ptr);
+                info->mhz = atoi(ptr);
+            }
+            else if (strnEQ(ptr, "cache size", 10)) {
+                ptr = cpu_info_strval(ptr);
+                info->cache_size = sigar_strtoul(ptr);
+            }
+#ifdef __powerpc64__
+            /* each /proc/cpuinfo entry looks like so:
+             *   processor       : 0
+             *   cpu             : POWER5 (gr)
+             *   clock           : 1656.392000MHz
+             *   revision        : 2.2
+             */
+            else if (strnEQ(ptr, "clock", 5)) {
+                ptr = cpu_info_strval(ptr);
+                info->mhz = atoi(ptr);
+            }
+            else if (strnEQ(ptr, "cpu", 3)) {
+                cpu_info_strcpy(ptr, info->model, sizeof(info->model));
+
+                if ((ptr = strchr(info->model, ' '))) {
+                    /* "POWER5 (gr)" -> "POWER5" */
+                    *ptr = '\0';
+                }
+            }
+#endif
+            break;
+           /* lone \n means end of info for this processor */
+          case '\n':
+            return found;
+        }
+    }
+
+    return found;
+}
+
+/* /proc/cpuinfo MHz will change w/ AMD + PowerNow */
+static void get_cpuinfo_max_freq(sigar_cpu_info_t *cpu_info, int num)
+{
+    int status;
+    char max_freq[PATH_MAX];
+    snprintf(max_freq, sizeof(max_freq),
+             "/sys/devices/system/cpu/cpu%d"
+             "/cpufreq/cpuinfo_max_freq", num);
+
+    status =
+        sigar_file2str(max_freq, max_freq, sizeof(max_freq)-1);
+
+    if (status == SIGAR_OK) {
+        cpu_info->mhz_max = atoi(max_freq) / 1000;
+    }
+}
+
+static void get_cpuinfo_min_freq(sigar_cpu_info_t *cpu_info, int num)
+{
+    int status;
+    char min_freq[PATH_MAX];
+    snprintf(min_freq, sizeof(min_freq),
+             "/sys/devices/system/cpu/cpu%d"
+             "/cpufreq/cpuinfo_min_freq", num);
+
+    status =
+        sigar_file2str(min_freq, min_freq, sizeof(min_freq)-1);
+
+    if (status == SIGAR_OK) {
+        cpu_info->mhz_min = atoi(min_freq) / 1000;
+    }
+}
+
+int sigar_cpu_info_list_get(sigar_t *sigar,
+                            sigar_cpu_info_list_t *cpu_infos)
+{
+    FILE *fp;
+    char path[SIGAR_PATH_MAX+1];
+    int core_rollup = sigar_cpu_core_rollup(sigar), i=0;
+
+    if (!(fp = sigar_fopen(SIGAR_ROOT_PATH(sigar, PROC_CPUINFO, path)))) {
+        return errno;
+    }
+
+    (void)sigar_cpu_total_count(sigar);
+    sigar_cpu_info_list_create(cpu_infos);
+
+    while (get_cpu_info(sigar, &cpu_infos->data[cpu_infos->number], fp)) {
+        sigar_cpu_info_t *info;
+
+        if (core_rollup && (i++ % sigar->lcpu)) {
+            continue; /* fold logical processors */
+        }
+
+        info = &cpu_infos->data[cpu_infos->number];
+        get_cpuinfo_max_freq(info, cpu_infos->number);
+        get_cpuinfo_min_freq(info, cpu_infos->number);
+
+        info->total_cores = sigar->ncpu;
+        info->cores_per_socket = sigar->lcpu;
+        info->total_sockets = sigar_cpu_socket_count(sigar);
+
+        ++cpu_infos->number;
+        SIGAR_CPU_INFO_LIST_GROW(cpu_infos);
+    }
+
+    sigar_fclose(fp);
+
+    return SIGAR_OK;
+}
+
+#define HEX_ENT_LEN 8
+
+#define RTF_UP 0x0001
+
+/* the columns of /proc/net/route */
+enum {
+    ROUTE_IFACE,
+    ROUTE_DESTINATION,
+    ROUTE_GATEWAY,
+    ROUTE_FLAGS,
+    ROUTE_REFCNT,
+    ROUTE_USE,
+    ROUTE_METRIC,
+    ROUTE_MASK,
+    ROUTE_MTU,
+    ROUTE_WINDOW,
+    ROUTE_IRTT,
+    ROUTE_FIELDS_MAX
+};
+
+/*
+ * the tables are files that netlink would not see, a mirror or
+ * another namespace through proc_net or a whole tree under proc_root.
+ * a recording reads them too, so that its replay has them.
+ */
+#define PROC_NET_MIRRORED(sigar) \
+    ((sigar)->proc_net || (sigar)->proc_root || sigar_recording)
+
+/*
+ * PROC_FS_ROOT "net/..." relative to SIGAR_PROC_NET, or to /proc/PID
+ * while reading another namespace; only the former falls back to ours
+ */
+static FILE *proc_net_fopen(sigar_t *sigar, const char *fname)
+{
+    FILE *fp;
+    char buffer[SIGAR_PATH_MAX];
+
+    if (!sigar->proc_net) {
+        return sigar_fopen(SIGAR_ROOT_PATH(sigar, fname, buffer));
+    }
+
+    snprintf(buffer, sizeof(buffer), "%s/%s",
+             sigar->proc_net, fname + sizeof(PROC_FS_ROOT)-1);
+
+    if ((fp = sigar_fopen(buffer)) || sigar->netns) {
+        return fp;
+    }
+
+    return sigar_fopen(SIGAR_ROOT_PATH(sigar, fname, buffer));
+}
+
+static int proc_net_route_walk(sigar_net_route_walker_t *walker)
+{
+    FILE *fp;
+    char buffer[1024];
+    char *fields[ROUTE_FIELDS_MAX], *end, *ptr;
+    int flags;
+    sigar_net_route_t route;
+
+    if (walker->family == SIGAR_AF_INET6) {
+        return SIGAR_OK;
+    }
+
+    if (!(fp = proc_net_fopen(walker->sigar, PROC_FS_ROOT "net/route"))) {
+        return errno;
+    }
+
+    (void)fgets(buffer, sizeof(buffer), fp); /* skip header */
+    while (fgets(buffer, sizeof(buffer), fp)) {
+        int num, len;
+
+        SIGAR_ZERO(&route);
+
+        end = buffer + strlen(buffer);
+        num = sigar_parse_fields(buffer, end, fields, ROUTE_FIELDS_MAX);
+
+        if (num < ROUTE_IRTT) {
+            continue;
+        }
+
+        ptr = fields[ROUTE_FLAGS];
+        flags = sigar_parse_x64(&ptr, end);
+        if (!(flags & RTF_UP)) {
+            continue;
+        }
+
+        len = sigar_parse_skip(fields[ROUTE_IFACE], end) - fields[ROUTE_IFACE];
+        if (len >= sizeof(route.ifname)) {
+            len = sizeof(route.ifname)-1;
+        }
+        memcpy(route.ifname, fields[ROUTE_IFACE], len);
+
+        route.flags = flags;
+        route.refcnt = sigar_parse_u64(&fields[ROUTE_REFCNT], end);
+        route.use = sigar_parse_u64(&fields[ROUTE_USE], end);
+        route.metric = sigar_parse_u64(&fields[ROUTE_METRIC], end);
+        route.mtu = sigar_parse_u64(&fields[ROUTE_MTU], end);
+        route.window = sigar_parse_u64(&fields[ROUTE_WINDOW], end);
+        if (num > ROUTE_IRTT) {
+            route.irtt = sigar_parse_u64(&fields[ROUTE_IRTT], end);
+        }
+
+        /* the addresses are the fixed width hex of in_addr_t */
+        if (((end - fields[ROUTE_DESTINATION]) < HEX_ENT_LEN) ||
+            ((end - fields[ROUTE_GATEWAY]) < HEX_ENT_LEN) ||
+            ((end - fields[ROUTE_MASK]) < HEX_ENT_LEN))
+        {
+            continue;
+        }
+
+        sigar_net_address_set(route.destination,
+                              sigar_parse_hex32(fields[ROUTE_DESTINATION]));
+        sigar_net_address_set(route.gateway,
+                              sigar_parse_hex32(fields[ROUTE_GATEWAY]));
+        sigar_net_address_set(route.mask,
+                              sigar_parse_hex32(fields[ROUTE_MASK]));
+
+        if (walker->add_route(walker, &route) != SIGAR_OK) {
+            break;
+        }
+    }
+
+    sigar_fclose(fp);
+
+    return SIGAR_OK;
+}
+
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+
+/*
+ * rtnetlink dumps, used over /proc/net/{route,arp} which are
+ * ipv4 only and sscanf'd a line at a time.
+ */
+typedef struct {
+    void *walker;
+    sigar_cache_t *ifindexes;
+    unsigned long count;
+    int stopped;
+} rtnl_walker_t;
+
+typedef struct {
+    char name[IF_NAMESIZE];
+    int type; /* ARPHRD_*, -1 until needed */
+} rtnl_ifindex_t;
+
+static rtnl_ifindex_t *rtnl_ifindex_get(rtnl_walker_t *rtnl, int index)
+{
+    sigar_cache_entry_t *entry;
+    rtnl_ifindex_t *ifx;
+
+    if (!rtnl->ifindexes) {
+        rtnl->ifindexes = sigar_cache_new(16);
+    }
+
+    entry = sigar_cache_get(rtnl->ifindexes, index);
+
+    if (!(ifx = entry->value)) {
+        ifx = entry->value = malloc(sizeof(*ifx));
+        if (!if_indextoname(index, ifx->name)) {
+            ifx->name[0] = '\0';
+        }
+        ifx->type = -1;
+    }
+
+    return ifx;
+}
+
+static int rtnl_family(int family)
+{
+    switch (family) {
+      case SIGAR_AF_INET:
+        return AF_INET;
+      case SIGAR_AF_INET6:
+        return AF_INET6;
+      default:
+        return AF_UNSPEC;
+    }
+}
+
+static int rtnl_address_set(sigar_net_address_t *address,
+                            int family, struct rtattr *attr)
+{
+    if (family == AF_INET) {
+        if (RTA_PAYLOAD(attr) < sizeof(address->addr.in)) {
+            return !SIGAR_OK;
+        }
+        memcpy(&address->addr.in, RTA_DATA(attr), sizeof(address->addr.in));
+        address->family = SIGAR_AF_INET;
+    }
+    else {
+        if (RTA_PAYLOAD(attr) < sizeof(address->addr.in6)) {
+            return !SIGAR_OK;
+        }
+        memcpy(address->addr.in6, RTA_DATA(attr), sizeof(address->addr.in6));
+        address->family = SIGAR_AF_INET6;
+    }
+
+    return SIGAR_OK;
+}
+
+static void rtnl_prefix_mask(sigar_net_address_t *mask,
+                             int family, int prefix)
+{
+    if (family == AF_INET) {
+        mask->family = SIGAR_AF_INET;
+        mask->addr.in = prefix ? htonl(~0U << (32 - prefix)) : 0;
+    }
+    else {
+        unsigned char *bytes = (unsigned char *)mask->addr.in6;
+        int i;
+
+        mask->family = SIGAR_AF_INET6;
+        for (i=0; i<16; i++, prefix -= 8) {
+            bytes[i] = (prefix >= 8) ? 0xff :
+                (prefix > 0) ? (0xff << (8 - prefix)) & 0xff : 0;
+        }
+    }
+}
+
+static int rtnl_dump(sigar_t *sigar, int type, int family, int hdrlen,
+                     sigar_netlink_handler_t handler,
+                     rtnl_walker_t *rtnl)
+{
+    struct {
+        struct nlmsghdr nlh;
+        union {
+            struct rtgenmsg gen;
+            struct rtmsg rtm;
+            struct ndmsg ndm;
+            struct ifaddrmsg ifa;
+            struct ifinfomsg ifi;
+        } msg;
+    } req;
+    int status;
+
+    /* sendto reads hdrlen bytes of req.msg */
+    if (hdrlen > sizeof(req.msg)) {
+        return EINVAL;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(hdrlen);
+    req.nlh.nlmsg_type = type;
+    /* the family is the first byte of each of them */
+    req.msg.gen.rtgen_family = family;
+
+    rtnl->ifindexes = NULL;
+    rtnl->count = 0;
+    rtnl->stopped = 0;
+
+    status = sigar_netlink_dump(sigar, NETLINK_ROUTE, &req.nlh,
+                                handler, rtnl);
+
+    if (rtnl->ifindexes) {
+        sigar_cache_destroy(rtnl->ifindexes);
+    }
+
+    return rtnl->stopped ? SIGAR_OK : status;
+}
+
+/* the same fields /proc/net/route shows, from fib_route_seq_show */
+static void rtnl_route_metrics(sigar_net_route_t *route,
+                               struct rtattr *metrics)
+{
+    struct rtattr *attr = RTA_DATA(metrics);
+    int len = RTA_PAYLOAD(metrics);
+
+    for (; RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        __u32 value = *(__u32 *)RTA_DATA(attr);
+
+        switch (attr->rta_type) {
+          case RTAX_ADVMSS:
+            route->mtu = value ? value + 40 : 0;
+            break;
+          case RTAX_WINDOW:
+            route->window = value;
+            break;
+          case RTAX_RTT:
+            route->irtt = value >> 3;
+            break;
+        }
+    }
+}
+
+static int rtnl_route_handler(void *data, struct nlmsghdr *nlh)
+{
+    rtnl_walker_t *rtnl = data;
+    sigar_net_route_walker_t *walker = rtnl->walker;
+    struct rtmsg *rtm = NLMSG_DATA(nlh);
+    struct rtattr *attr = RTM_RTA(rtm);
+    int len = RTM_PAYLOAD(nlh);
+    int family = rtm->rtm_family;
+    unsigned int table = rtm->rtm_table;
+    int oif = 0;
+    sigar_net_route_t route;
+
+    if ((nlh->nlmsg_type != RTM_NEWROUTE) ||
+        !((family == AF_INET) || (family == AF_INET6)) ||
+        (rtm->rtm_flags & RTM_F_CLONED))
+    {
+        return SIGAR_OK;
+    }
+
+    SIGAR_ZERO(&route);
+    route.destination.family = route.gateway.family =
+        (family == AF_INET) ? SIGAR_AF_INET : SIGAR_AF_INET6;
+    rtnl_prefix_mask(&route.mask, family, rtm->rtm_dst_len);
+
+    route.flags = SIGAR_RTF_UP;
+    if (rtm->rtm_dst_len == ((family == AF_INET) ? 32 : 128)) {
+        route.flags |= SIGAR_RTF_HOST;
+    }
+
+    for (; RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        switch (attr->rta_type) {
+          case RTA_TABLE:
+            table = *(__u32 *)RTA_DATA(attr);
+            break;
+          case RTA_DST:
+            rtnl_address_set(&route.destination, family, attr);
+            break;
+          case RTA_GATEWAY:
+            if (rtnl_address_set(&route.gateway, family, attr) == SIGAR_OK) {
+                route.flags |= SIGAR_RTF_GATEWAY;
+            }
+            break;
+          case RTA_OIF:
+            oif = *(int *)RTA_DATA(attr);
+            break;
+          case RTA_PRIORITY:
+            route.metric = *(__u32 *)RTA_DATA(attr);
+            break;
+          case RTA_METRICS:
+            rtnl_route_metrics(&route, attr);
+            break;
+          case RTA_MULTIPATH:
+            /* /proc/net/route shows the first hop as well */
+            if (RTA_PAYLOAD(attr) >= sizeof(struct rtnexthop)) {
+                struct rtnexthop *nh = RTA_DATA(attr);
+                struct rtattr *nattr = RTNH_DATA(nh);
+                int nlen = nh->rtnh_len - sizeof(*nh);
+
+                oif = nh->rtnh_ifindex;
+                for (; RTA_OK(nattr, nlen); nattr = RTA_NEXT(nattr, nlen)) {
+                    if ((nattr->rta_type == RTA_GATEWAY) &&
+                        (rtnl_address_set(&route.gateway, family,
+                                          nattr) == SIGAR_OK))
+                    {
+                        route.flags |= SIGAR_RTF_GATEWAY;
+                    }
+                }
+            }
+            break;
+        }
+    }
+
+    /* local/broadcast routes live in the local table */
+    if (table != RT_TABLE_MAIN) {
+        return SIGAR_OK;
+    }
+
+    if (oif) {
+        SIGAR_SSTRCPY(route.ifname, rtnl_ifindex_get(rtnl, oif)->name);
+    }
+
+    rtnl->count++;
+
+    if (walker->add_route(walker, &route) != SIGAR_OK) {
+        rtnl->stopped = 1;
+        return !SIGAR_OK; /* stop the dump */
+    }
+
+    return SIGAR_OK;
+}
+
+int sigar_net_route_walk(sigar_net_route_walker_t *walker)
+{
+    sigar_t *sigar = walker->sigar;
+    int status;
+
+    if (!PROC_NET_MIRRORED(sigar)) {
+        rtnl_walker_t rtnl;
+
+        rtnl.walker = walker;
+        status = rtnl_dump(sigar, RTM_GETROUTE,
+                           rtnl_family(walker->family),
+                           sizeof(struct rtmsg), rtnl_route_handler, &rtnl);
+
+        if ((status == SIGAR_OK) || rtnl.count) {
+            return status;
+        }
+
+        if (SIGAR_LOG_IS_DEBUG(sigar)) {
+            sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                             "[net_route] RTM_GETROUTE failed: %s",
+                             sigar_strerror(sigar, status));
+        }
+    }
+
+    return proc_net_route_walk(walker);
+}
+
+static int net_route_list_walker(sigar_net_route_walker_t *walker,
+                                 sigar_net_route_t *route)
+{
+    sigar_net_route_list_t *routelist = walker->data;
+
+    SIGAR_NET_ROUTE_LIST_GROW(routelist);
+    memcpy(&routelist->data[routelist->number++],
+           route, sizeof(*route));
+
+    return SIGAR_OK;
+}
+
+int sigar_net_route_list_get(sigar_t *sigar,
+                             sigar_net_route_list_t *routelist)
+{
+    sigar_net_route_walker_t walker;
+    int status;
+
+    sigar_net_route_list_create(sigar, routelist);
+
+    walker.sigar = sigar;
+    walker.family = SIGAR_AF_INET;
+    walker.data = routelist;
+    walker.add_route = net_route_list_walker;
+
+    status = sigar_net_route_walk(&walker);
+
+    if (status != SIGAR_OK) {
+        sigar_net_route_list_destroy(sigar, routelist);
+    }
+
+    return status;
+}
+
+static int rtnl_address_handler(void *data, struct nlmsghdr *nlh)
+{
+    rtnl_walker_t *rtnl = data;
+    sigar_net_interface_address_walker_t *walker = rtnl->walker;
+    struct ifaddrmsg *ifa = NLMSG_DATA(nlh);
+    struct rtattr *attr = IFA_RTA(ifa);
+    int len = IFA_PAYLOAD(nlh);
+    int family = ifa->ifa_family, have_local = 0;
+    sigar_net_interface_address_t address;
+
+    if ((nlh->nlmsg_type != RTM_NEWADDR) ||
+        !((family == AF_INET) || (family == AF_INET6)))
+    {
+        return SIGAR_OK;
+    }
+
+    SIGAR_ZERO(&address);
+    address.ifindex = ifa->ifa_index;
+    address.prefix_length = ifa->ifa_prefixlen;
+    address.scope = ifa->ifa_scope;
+    address.flags = ifa->ifa_flags;
+
+    for (; RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        switch (attr->rta_type) {
+          case IFA_LOCAL:
+            rtnl_address_set(&address.address, family, attr);
+            have_local = 1;
+            break;
+          case IFA_ADDRESS:
+            /* the peer on point-to-point links, else the same as local */
+            rtnl_address_set(&address.destination, family, attr);
+            break;
+          case IFA_BROADCAST:
+            rtnl_address_set(&address.broadcast, family, attr);
+            break;
+          case IFA_LABEL:
+            SIGAR_SSTRCPY(address.ifname, (char *)RTA_DATA(attr));
+            break;
+#ifdef IFA_FLAGS
+          case IFA_FLAGS:
+            address.flags = *(__u32 *)RTA_DATA(attr);
+            break;
+#endif
+        }
+    }
+
+    /* ipv6 only sends IFA_LOCAL along with a peer */
+    if (!have_local) {
+        address.address = address.destination;
+        SIGAR_ZERO(&address.destination.addr);
+        address.destination.family = address.address.family;
+    }
+
+    /* ipv6 addresses carry no label */
+    if (!address.ifname[0]) {
+        SIGAR_SSTRCPY(address.ifname,
+                      rtnl_ifindex_get(rtnl, ifa->ifa_index)->name);
+    }
+
+    rtnl->count++;
+
+    if (walker->add_address(walker, &address) != SIGAR_OK) {
+        rtnl->stopped = 1;
+        return !SIGAR_OK;
+    }
+
+    return SIGAR_OK;
+}
+
+int sigar_net_interface_address_walk(sigar_net_interface_address_walker_t *walker)
+{
+    rtnl_walker_t rtnl;
+
+    rtnl.walker = walker;
+
+    return rtnl_dump(walker->sigar, RTM_GETADDR,
+                     rtnl_family(walker->family),
+                     sizeof(struct ifaddrmsg), rtnl_address_handler, &rtnl);
+}
+
+static int net_address_list_walker(sigar_net_interface_address_walker_t *walker,
+                                   sigar_net_interface_address_t *address)
+{
+    sigar_net_interface_address_list_t *addrlist = walker->data;
+
+    SIGAR_NET_ADDRESS_LIST_GROW(addrlist);
+    memcpy(&addrlist->data[addrlist->number++],
+           address, sizeof(*address));
+
+    return SIGAR_OK;
+}
+
+int sigar_os_net_interface_address_list_get(sigar_t *sigar,
+                                            sigar_net_interface_address_list_t *addrlist)
+{
+    sigar_net_interface_address_walker_t walker;
+    int status;
+
+    sigar_net_interface_address_list_create(addrlist);
+
+    walker.sigar = sigar;
+    walker.family = SIGAR_AF_UNSPEC;
+    walker.data = addrlist;
+    walker.add_address = net_address_list_walker;
+
+    status = sigar_net_interface_address_walk(&walker);
+
+    if (status != SIGAR_OK) {
+        sigar_net_interface_address_list_destroy(sigar, addrlist);
+    }
+
+    return status;
+}
+
+static int rtnl_link_config_handler(void *data, struct nlmsghdr *nlh)
+{
+    rtnl_walker_t *rtnl = data;
+    sigar_net_interface_config_list_t *iflist = rtnl->walker;
+    struct ifinfomsg *ifi = NLMSG_DATA(nlh);
+    struct rtattr *attr = IFLA_RTA(ifi);
+    int len = IFLA_PAYLOAD(nlh);
+    sigar_net_interface_config_entry_t *entry;
+    sigar_net_interface_config_t *ifconfig;
+
+    if (nlh->nlmsg_type != RTM_NEWLINK) {
+        return SIGAR_OK;
+    }
+
+    SIGAR_NET_IFCONFIG_LIST_GROW(iflist);
+    entry = &iflist->data[iflist->number++];
+    SIGAR_ZERO(entry);
+    ifconfig = &entry->config;
+
+    entry->ifindex = ifi->ifi_index;
+    /* SIOCGIFFLAGS only has room for the low 16 (no IFF_LOWER_UP) */
+    ifconfig->flags =
+        sigar_net_interface_flags_to_sigar(ifi->ifi_flags & 0xffff);
+    ifconfig->metric = 1; /* SIOCGIFMETRIC is always 0 on linux */
+    ifconfig->tx_queue_len = -1;
+    sigar_net_interface_ipv6_config_init(ifconfig);
+    sigar_hwaddr_set_null(ifconfig);
+
+    for (; RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        switch (attr->rta_type) {
+          case IFLA_IFNAME:
+            SIGAR_SSTRCPY(ifconfig->name, (char *)RTA_DATA(attr));
+            break;
+          case IFLA_ADDRESS:
+            sigar_net_address_mac_set(ifconfig->hwaddr, RTA_DATA(attr),
+                                      RTA_PAYLOAD(attr) < SIGAR_IFHWADDRLEN ?
+                                      RTA_PAYLOAD(attr) : SIGAR_IFHWADDRLEN);
+            break;
+          case IFLA_MTU:
+            ifconfig->mtu = *(__u32 *)RTA_DATA(attr);
+            break;
+          case IFLA_TXQLEN:
+            ifconfig->tx_queue_len = *(__u32 *)RTA_DATA(attr);
+            break;
+        }
+    }
+
+    if (ifconfig->flags & SIGAR_IFF_LOOPBACK) {
+        sigar_hwaddr_set_null(ifconfig);
+        SIGAR_SSTRCPY(ifconfig->type, SIGAR_NIC_LOOPBACK);
+    }
+    else {
+        sigar_net_interface_type_set(ifconfig, ifi->ifi_type);
+    }
+
+    SIGAR_SSTRCPY(ifconfig->description, ifconfig->name);
+
+    return SIGAR_OK;
+}
+
+/* /proc/net/if_inet6 scope column, which sigar_net_interface_config_get reports */
+static int rtnl_scope6(int scope)
+{
+    switch (scope) {
+      case RT_SCOPE_HOST:
+        return SIGAR_IPV6_ADDR_LOOPBACK;
+      case RT_SCOPE_LINK:
+        return SIGAR_IPV6_ADDR_LINKLOCAL;
+      case RT_SCOPE_SITE:
+        return SIGAR_IPV6_ADDR_SITELOCAL;
+      default:
+        return SIGAR_IPV6_ADDR_ANY;
+    }
+}
+
+static int net_ifindex_compare(const void *a, const void *b)
+{
+    const sigar_net_interface_config_entry_t *e1 = a, *e2 = b;
+
+    return (e1->ifindex > e2->ifindex) - (e1->ifindex < e2->ifindex);
+}
+
+/*
+ * one RTM_GETLINK and one RTM_GETADDR dump, then the addresses are
+ * grouped by interface so each entry can point at its own run.
+ */
+int sigar_os_net_interface_config_list_get(sigar_t *sigar,
+                                           sigar_net_interface_config_list_t *iflist)
+{
+    sigar_net_interface_address_list_t addrlist;
+    sigar_net_interface_address_t *grouped;
+    unsigned long i, offset;
+    rtnl_walker_t rtnl;
+    int status;
+
+    sigar_net_interface_config_list_create(iflist);
+
+    rtnl.walker = iflist;
+    status = rtnl_dump(sigar, RTM_GETLINK, AF_UNSPEC,
+                       sizeof(struct ifinfomsg),
+                       rtnl_link_config_handler, &rtnl);
+
+    if (status == SIGAR_OK) {
+        status = sigar_net_interface_address_list_get(sigar, &addrlist);
+    }
+    if (status != SIGAR_OK) {
+        sigar_net_interface_config_list_destroy(sigar, iflist);
+        return status;
+    }
+
+    /* the kernel dumps links in index order, but do not count on it */
+    qsort(iflist->data, iflist->number, sizeof(*iflist->data),
+          net_ifindex_compare);
+
+    /* count per interface, then place each address in its run */
+    for (i=0; i<addrlist.number; i++) {
+        sigar_net_interface_config_entry_t key, *entry;
+
+        key.ifindex = addrlist.data[i].ifindex;
+        entry = bsearch(&key, iflist->data, iflist->number,
+                        sizeof(*iflist->data), net_ifindex_compare);
+        if (entry) {
+            entry->addresses_number++;
+        }
+    }
+
+    grouped = iflist->addresses.data;
+    if (iflist->addresses.size < addrlist.number) {
+        grouped = realloc(grouped, sizeof(*grouped) * addrlist.number);
+        iflist->addresses.data = grouped;
+        iflist->addresses.size = addrlist.number;
+    }
+
+    for (i=0, offset=0; i<iflist->number; i++) {
+        sigar_net_interface_config_entry_t *entry = &iflist->data[i];
+
+        entry->addresses = &grouped[offset];
+        offset += entry->addresses_number;
+        entry->addresses_number = 0;
+    }
+    iflist->addresses.number = offset;
+
+    for (i=0; i<addrlist.number; i++) {
+        sigar_net_interface_address_t *address = &addrlist.data[i];
+        sigar_net_interface_config_entry_t key, *entry;
+        sigar_net_interface_config_t *ifconfig;
+
+        key.ifindex = address->ifindex;
+        entry = bsearch(&key, iflist->data, iflist->number,
+                        sizeof(*iflist->data), net_ifindex_compare);
+        if (!entry) {
+            continue; /* link appeared between the two dumps */
+        }
+
+        entry->addresses[entry->addresses_number++] = *address;
+        ifconfig = &entry->config;
+
+        /* the first address is the one the ioctls would have returned */
+        if ((address->address.family == SIGAR_AF_INET) &&
+            !ifconfig->address.addr.in &&
+            strEQ(address->ifname, ifconfig->name))
+        {
+            ifconfig->address = address->address;
+            rtnl_prefix_mask(&ifconfig->netmask, AF_INET,
+                             address->prefix_length);
+            ifconfig->broadcast = address->broadcast;
+            ifconfig->broadcast.family = SIGAR_AF_INET;
+            ifconfig->destination = address->destination;
+        }
+        else if ((address->address.family == SIGAR_AF_INET6) &&
+                 !ifconfig->prefix6_length)
+        {
+            ifconfig->address6 = address->address;
+            ifconfig->prefix6_length = address->prefix_length;
+            ifconfig->scope6 = rtnl_scope6(address->scope);
+        }
+    }
+
+    for (i=0; i<iflist->number; i++) {
+        sigar_net_interface_config_t *ifconfig = &iflist->data[i].config;
+
+        if (ifconfig->flags & SIGAR_IFF_LOOPBACK) {
+            ifconfig->destination = ifconfig->address;
+            sigar_net_address_set(ifconfig->broadcast, 0);
+        }
+    }
+
+    sigar_net_interface_address_list_destroy(sigar, &addrlist);
+
+    return SIGAR_OK;
+}
+
+
+#define PROC_NET_DEV PROC_FS_ROOT "net/dev"
+
+/*
+ * /proc/net/dev fields following "name:":
+ * rx: bytes packets errs drop fifo frame compressed multicast
+ * tx: bytes packets errs drop fifo colls carrier compressed
+ */
+static void proc_net_dev_parse(char *ptr, char *end,
+                               sigar_net_interface_stat_entry_t *entry)
+{
+    sigar_net_interface_stat_t *ifstat = &entry->stat;
+
+    ifstat->rx_bytes    = sigar_parse_u64(&ptr, end);
+    ifstat->rx_packets  = sigar_parse_u64(&ptr, end);
+    ifstat->rx_errors   = sigar_parse_u64(&ptr, end);
+    ifstat->rx_dropped  = sigar_parse_u64(&ptr, end);
+    ifstat->rx_overruns = sigar_parse_u64(&ptr, end);
+    ifstat->rx_frame    = sigar_parse_u64(&ptr, end);
+
+    entry->rx_compressed = sigar_parse_u64(&ptr, end);
+    entry->rx_multicast  = sigar_parse_u64(&ptr, end);
+
+    ifstat->tx_bytes      = sigar_parse_u64(&ptr, end);
+    ifstat->tx_packets    = sigar_parse_u64(&ptr, end);
+    ifstat->tx_errors     = sigar_parse_u64(&ptr, end);
+    ifstat->tx_dropped    = sigar_parse_u64(&ptr, end);
+    ifstat->tx_overruns   = sigar_parse_u64(&ptr, end);
+    ifstat->tx_collisions = sigar_parse_u64(&ptr, end);
+    ifstat->tx_carrier    = sigar_parse_u64(&ptr, end);
+
+    entry->tx_compressed = sigar_parse_u64(&ptr, end);
+
+    ifstat->speed         = SIGAR_FIELD_NOTIMPL;
+
+    /* only available in aggregate here */
+    entry->index = SIGAR_FIELD_NOTIMPL;
+    entry->rx_length_errors = entry->rx_over_errors =
+        entry->rx_crc_errors = entry->rx_frame_errors =
+        entry->rx_fifo_errors = entry->rx_missed_errors =
+        entry->tx_aborted_errors = entry->tx_carrier_errors =
+        entry->tx_fifo_errors = entry->tx_heartbeat_errors =
+        entry->tx_window_errors = SIGAR_FIELD_NOTIMPL;
+}
+
+/* calls the parser for name, or every interface if name is NULL */
+static int proc_net_dev_read(sigar_t *sigar,
+                             const char *name,
+                             sigar_net_interface_stat_entry_t *found,
+                             sigar_net_interface_stat_list_t *iflist)
+{
+    char buffer[BUFSIZ];
+    FILE *fp = proc_net_fopen(sigar, PROC_NET_DEV);
+    int status = ENXIO;
+
+    if (!fp) {
+        return errno;
+    }
+
+    /* skip header */
+    fgets(buffer, sizeof(buffer), fp);
+    fgets(buffer, sizeof(buffer), fp);
+
+    while (fgets(buffer, sizeof(buffer), fp)) {
+        sigar_net_interface_stat_entry_t *entry;
+        char *ptr, *dev, *end = buffer + strlen(buffer);
+
+        dev = sigar_parse_space(buffer, end);
+
+        if (!(ptr = memchr(dev, ':', end - dev))) {
+            continue;
+        }
+
+        *ptr++ = 0;
+
+        if (name) {
+            if (!strEQ(dev, name)) {
+                continue;
+            }
+            proc_net_dev_parse(ptr, end, found);
+            status = SIGAR_OK;
+            break;
+        }
+
+        SIGAR_NET_IFSTAT_LIST_GROW(iflist);
+        entry = &iflist->data[iflist->number++];
+        SIGAR_SSTRCPY(entry->name, dev);
+        proc_net_dev_parse(ptr, end, entry);
+        status = SIGAR_OK;
+    }
+
+    sigar_fclose(fp);
+
+    return name ? status : SIGAR_OK;
+}
+
+int sigar_os_net_interface_stat_get(sigar_t *sigar, const char *name,
+                                    sigar_net_interface_stat_t *ifstat)
+{
+    sigar_net_interface_stat_entry_t entry;
+    int status = proc_net_dev_read(sigar, name, &entry, NULL);
+
+    if (status == SIGAR_OK) {
+        memcpy(ifstat, &entry.stat, sizeof(*ifstat));
+    }
+
+    return status;
+}
+
+static int link_stat_handler(void *data, struct nlmsghdr *nlh)
+{
+    sigar_net_interface_stat_list_t *iflist = data;
+    sigar_net_interface_stat_entry_t *entry;
+    sigar_net_interface_stat_t *ifstat;
+    struct ifinfomsg *ifi = NLMSG_DATA(nlh);
+    struct rtattr *rta;
+    int len = IFLA_PAYLOAD(nlh);
+    struct rtnl_link_stats64 stats;
+    char *name = NULL;
+    int have_stats = 0;
+
+    if (nlh->nlmsg_type != RTM_NEWLINK) {
+        return SIGAR_OK;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+
+    for (rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        switch (rta->rta_type) {
+          case IFLA_IFNAME:
+            name = RTA_DATA(rta);
+            break;
+          case IFLA_STATS64:
+            memcpy(&stats, RTA_DATA(rta),
+                   RTA_PAYLOAD(rta) < sizeof(stats) ?
+                   RTA_PAYLOAD(rta) : sizeof(stats));
+            have_stats = 2;
+            break;
+          case IFLA_STATS:
+            if (have_stats == 0) {
+                /* pre 2.6.35 kernels only have 32-bit counters */
+                struct rtnl_link_stats *s32 = RTA_DATA(rta);
+                stats.rx_packets = s32->rx_packets;
+                stats.tx_packets = s32->tx_packets;
+                stats.rx_bytes = s32->rx_bytes;
+                stats.tx_bytes = s32->tx_bytes;
+                stats.rx_errors = s32->rx_errors;
+                stats.tx_errors = s32->tx_errors;
+                stats.rx_dropped = s32->rx_dropped;
+                stats.tx_dropped = s32->tx_dropped;
+                stats.multicast = s32->multicast;
+                stats.collisions = s32->collisions;
+                stats.rx_length_errors = s32->rx_length_errors;
+                stats.rx_over_errors = s32->rx_over_errors;
+                stats.rx_crc_errors = s32->rx_crc_errors;
+                stats.rx_frame_errors = s32->rx_frame_errors;
+                stats.rx_fifo_errors = s32->rx_fifo_errors;
+                stats.rx_missed_errors = s32->rx_missed_errors;
+                stats.tx_aborted_errors = s32->tx_aborted_errors;
+                stats.tx_carrier_errors = s32->tx_carrier_errors;
+                stats.tx_fifo_errors = s32->tx_fifo_errors;
+                stats.tx_heartbeat_errors = s32->tx_heartbeat_errors;
+                stats.tx_window_errors = s32->tx_window_errors;
+                stats.rx_compressed = s32->rx_compressed;
+                stats.tx_compressed = s32->tx_compressed;
+                have_stats = 1;
+            }
+            break;
+        }
+    }
+
+    if (!name || !have_stats) {
+        return SIGAR_OK;
+    }
+
+    SIGAR_NET_IFSTAT_LIST_GROW(iflist);
+    entry = &iflist->data[iflist->number++];
+    ifstat = &entry->stat;
+
+    SIGAR_SSTRCPY(entry->name, name);
+    entry->index = ifi->ifi_index;
+
+    /* fold the error counters the same way /proc/net/dev does */
+    ifstat->rx_packets    = stats.rx_packets;
+    ifstat->rx_bytes      = stats.rx_bytes;
+    ifstat->rx_errors     = stats.rx_errors;
+    ifstat->rx_dropped    = stats.rx_dropped + stats.rx_missed_errors;
+    ifstat->rx_overruns   = stats.rx_fifo_errors;
+    ifstat->rx_frame      =
+        stats.rx_length_errors + stats.rx_over_errors +
+        stats.rx_crc_errors + stats.rx_frame_errors;
+    ifstat->tx_packets    = stats.tx_packets;
+    ifstat->tx_bytes      = stats.tx_bytes;
+    ifstat->tx_errors     = stats.tx_errors;
+    ifstat->tx_dropped    = stats.tx_dropped;
+    ifstat->tx_overruns   = stats.tx_fifo_errors;
+    ifstat->tx_collisions = stats.collisions;
+    ifstat->tx_carrier    =
+        stats.tx_carrier_errors + stats.tx_aborted_errors +
+        stats.tx_window_errors + stats.tx_heartbeat_errors;
+    ifstat->speed         = SIGAR_FIELD_NOTIMPL;
+
+    entry->rx_multicast        = stats.multicast;
+    entry->rx_compressed       = stats.rx_compressed;
+    entry->rx_length_errors    = stats.rx_length_errors;
+    entry->rx_over_errors      = stats.rx_over_errors;
+    entry->rx_crc_errors       = stats.rx_crc_errors;
+    entry->rx_frame_errors     = stats.rx_frame_errors;
+    entry->rx_fifo_errors      = stats.rx_fifo_errors;
+    entry->rx_missed_errors    = stats.rx_missed_errors;
+    entry->tx_compressed       = stats.tx_compressed;
+    entry->tx_aborted_errors   = stats.tx_aborted_errors;
+    entry->tx_carrier_errors   = stats.tx_carrier_errors;
+    entry->tx_fifo_errors      = stats.tx_fifo_errors;
+    entry->tx_heartbeat_errors = stats.tx_heartbeat_errors;
+    entry->tx_window_errors    = stats.tx_window_errors;
+
+    return SIGAR_OK;
+}
+
+int sigar_os_net_interface_stat_list_get(sigar_t *sigar,
+                                         sigar_net_interface_stat_list_t *iflist)
+{
+    struct {
+        struct nlmsghdr nlh;
+        struct ifinfomsg ifi;
+    } req;
+    int status;
+
+    sigar_net_interface_stat_list_create(sigar, iflist);
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(req.ifi));
+    req.nlh.nlmsg_type = RTM_GETLINK;
+    req.ifi.ifi_family = AF_UNSPEC;
+
+    if (PROC_NET_MIRRORED(sigar)) {
+        status = ENOENT; /* netlink would not see the same namespace */
+    }
+    else {
+        status = sigar_netlink_dump(sigar, NETLINK_ROUTE, &req.nlh,
+                                    link_stat_handler, iflist);
+    }
+
+    if (status != SIGAR_OK) {
+        if (!PROC_NET_MIRRORED(sigar) && SIGAR_LOG_IS_DEBUG(sigar)) {
+            sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                             "[ifstat_list] RTM_GETLINK failed: %s",
+                             sigar_strerror(sigar, status));
+        }
+        /* no netlink, a single pass over /proc/net/dev will do */
+        iflist->number = 0;
+        status = proc_net_dev_read(sigar, NULL, NULL, iflist);
+    }
+
+    if (status != SIGAR_OK) {
+        sigar_net_interface_stat_list_destroy(sigar, iflist);
+    }
+
+    return status;
+}
+
+static SIGAR_INLINE void convert_hex_address(sigar_net_address_t *address,
+                                             char *ptr, int len)
+{
+    if (len > HEX_ENT_LEN) {
+        int i;
+        for (i=0; i<=3; i++, ptr+=HEX_ENT_LEN) {
+            address->addr.in6[i] = sigar_parse_hex32(ptr);
+        }
+
+        address->family = SIGAR_AF_INET6;
+    }
+    else {
+        address->addr.in =
+            (len == HEX_ENT_LEN) ? sigar_parse_hex32(ptr) : 0;
+
+        address->family = SIGAR_AF_INET;
+    }
+}
+
+typedef struct {
+    sigar_net_connection_list_t *connlist;
+    sigar_net_connection_t *conn;
+    unsigned long port;
+} net_conn_getter_t;
+
+static int proc_net_walker(sigar_net_connection_walker_t *walker,
+                           sigar_net_connection_t *conn)
+{
+    net_conn_getter_t *getter =
+        (net_conn_getter_t *)walker->data;
+
+    if (getter->connlist) {
+        SIGAR_NET_CONNLIST_GROW(getter->connlist);
+        memcpy(&getter->connlist->data[getter->connlist->number++],
+               conn, sizeof(*conn));
+    }
+    else {
+        if ((getter->port == conn->local_port) &&
+            (conn->remote_port == 0))
+        {
+            memcpy(getter->conn, conn, sizeof(*conn));
+            return !SIGAR_OK; /* break loop */
+        }
+    }
+
+    return SIGAR_OK; /* continue loop */
+}
+
+#define SKIP_WHILE(p, c) while (*p == c) p++
+#define SKIP_PAST(p, c) \
+   while(*p && (*p != c)) p++; \
+   SKIP_WHILE(p, c)
+
+typedef struct {
+    FILE *fp;
+    int (*close)(FILE *);
+} xproc_t;
+
+static FILE *xproc_open(const char *command, xproc_t *xproc)
+{
+    struct stat sb;
+    if (stat(command, &sb) == 0) {
+        if (sb.st_mode & S_IXUSR) {
+            /* executable script for testing large
+             * conn table where we can sleep() to better
+             * simulate /proc/net/tcp behavior
+             */
+            xproc->fp = popen(command, "r");
+            xproc->close = pclose;
+        }
+        else {
+            xproc->fp = fopen(command, "r");
+            xproc->close = fclose;
+        }
+        return xproc->fp;
+    }
+    else {
+        return NULL;
+    }
+}
+
+static int proc_net_read(sigar_net_connection_walker_t *walker,
+                         const char *fname,
+                         int type)
+{
+    FILE *fp = NULL;
+    char buffer[8192];
+    sigar_t *sigar = walker->sigar;
+    char *ptr = sigar->proc_net;
+    int flags = walker->flags;
+    xproc_t xproc = { NULL, sigar_fclose };
+
+    if (ptr) {
+        snprintf(buffer, sizeof(buffer),
+                 "%s/%s", ptr,
+                 fname + sizeof(PROC_FS_ROOT)-1);
+
+        if ((fp = xproc_open(buffer, &xproc))) {
+            if (SIGAR_LOG_IS_DEBUG(sigar)) {
+                sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                                 "[proc_net] using %s",
+                                 buffer);
+            }
+        }
+        else if (SIGAR_LOG_IS_DEBUG(sigar)) {
+            sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                             "[proc_net] cannot open %s",
+                             buffer);
+        }
+    }
+
+    if (!fp && sigar->netns) {
+        return ENOENT; /* not the host's table */
+    }
+    if (!(fp || (fp = sigar_fopen(SIGAR_ROOT_PATH(sigar, fname, buffer))))) {
+        return errno;
+    }
+
+    fgets(buffer, sizeof(buffer), fp); /* skip header */
+
+    while ((ptr = fgets(buffer, sizeof(buffer), fp))) {
+        sigar_net_connection_t conn;
+        char *laddr, *raddr, *end = ptr + strlen(ptr);
+        int laddr_len, raddr_len;
+        int more;
+
+        /* skip "%d: " */
+        laddr = sigar_parse_space(sigar_parse_skip(ptr, end), end);
+
+        if (!(ptr = memchr(laddr, ':', end - laddr))) {
+            continue;
+        }
+        laddr_len = ptr++ - laddr;
+
+        conn.local_port = (sigar_parse_x64(&ptr, end) & 0xffff);
+
+        raddr = sigar_parse_space(ptr, end);
+
+        if (!(ptr = memchr(raddr, ':', end - raddr))) {
+            continue;
+        }
+        raddr_len = ptr++ - raddr;
+
+        conn.remote_port = (sigar_parse_x64(&ptr, end) & 0xffff);
+
+        ptr = sigar_parse_space(ptr, end);
+
+        if (!((conn.remote_port && (flags & SIGAR_NETCONN_CLIENT)) ||
+              (!conn.remote_port && (flags & SIGAR_NETCONN_SERVER))))
+        {
+            continue;
+        }
+
+        conn.type = type;
+
+        convert_hex_address(&conn.local_address,
+                            laddr, laddr_len);
+
+        convert_hex_address(&conn.remote_address,
+                            raddr, raddr_len);
+
+        /* the fixed width st tx_queue:rx_queue */
+        if ((end - ptr) < (2 + 1 + HEX_ENT_LEN + 1 + HEX_ENT_LEN)) {
+            continue;
+        }
+
+        /* SIGAR_TCP_* currently matches TCP_* in linux/tcp.h */
+        conn.state = sigar_parse_hex(ptr, 2);
+        ptr += 3;
+
+        conn.send_queue = sigar_parse_hex32(ptr);
+        ptr += HEX_ENT_LEN+1; /* tx + ':' */;
+
+        conn.receive_queue = sigar_parse_hex32(ptr);
+        ptr += HEX_ENT_LEN;
+
+        ptr = sigar_parse_skip(ptr, end); /* tr:tm->whem */
+        ptr = sigar_parse_skip(ptr, end); /* retrnsmt */
+
+        conn.uid = sigar_parse_u64(&ptr, end);
+
+        ptr = sigar_parse_skip(ptr, end); /* timeout */
+
+        conn.inode = sigar_parse_u64(&ptr, end);
+
+        more = walker->add_connection(walker, &conn);
+        if (more != SIGAR_OK) {
+            xproc.close(fp);
+            return SIGAR_OK;
+        }
+    }
+
+    xproc.close(fp);
+
+    return SIGAR_OK;
+}
+
+#include <stddef.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include <linux/tcp.h>
+
+#ifndef TCP_NEW_SYN_RECV
+#define TCP_NEW_SYN_RECV 12
+#endif
+
+#define INET_DIAG_BC_LEN 32
+
+typedef struct {
+    sigar_net_connection_walker_t *walker;
+    int type;
+    int ext; /* connections are passed as sigar_net_connection_info_t */
+    int stopped;
+    unsigned long records; /* passed to the walker */
+} inet_diag_walker_t;
+
+/* older kernels send a shorter struct tcp_info */
+#define TCP_INFO_HAS(len, field) \
+    ((len) >= offsetof(struct tcp_info, field) + \
+     sizeof(((struct tcp_info *)0)->field))
+
+#define TCP_INFO_SET(info, tcpi, len, name) \
+    info->name = TCP_INFO_HAS(len, tcpi_##name) ? \
+        tcpi->tcpi_##name : SIGAR_FIELD_NOTIMPL
+
+static void inet_diag_tcp_info(sigar_net_connection_info_t *info,
+                               struct tcp_info *tcpi, int len)
+{
+    TCP_INFO_SET(info, tcpi, len, rtt);
+    TCP_INFO_SET(info, tcpi, len, rttvar);
+    TCP_INFO_SET(info, tcpi, len, rto);
+    TCP_INFO_SET(info, tcpi, len, retransmits);
+    TCP_INFO_SET(info, tcpi, len, total_retrans);
+    TCP_INFO_SET(info, tcpi, len, lost);
+    TCP_INFO_SET(info, tcpi, len, unacked);
+    TCP_INFO_SET(info, tcpi, len, snd_cwnd);
+    TCP_INFO_SET(info, tcpi, len, snd_ssthresh);
+    TCP_INFO_SET(info, tcpi, len, snd_mss);
+    TCP_INFO_SET(info, tcpi, len, delivery_rate);
+    TCP_INFO_SET(info, tcpi, len, bytes_acked);
+    TCP_INFO_SET(info, tcpi, len, bytes_received);
+}
+
+static void inet_diag_meminfo(sigar_net_connection_info_t *info,
+                              __u32 *mem, int len)
+{
+    int num = len / sizeof(*mem);
+
+#define SK_MEMINFO_SET(name, idx) \
+    info->name = (num > idx) ? mem[idx] : SIGAR_FIELD_NOTIMPL
+
+    SK_MEMINFO_SET(rmem_alloc, SK_MEMINFO_RMEM_ALLOC);
+    SK_MEMINFO_SET(rcvbuf, SK_MEMINFO_RCVBUF);
+    SK_MEMINFO_SET(wmem_alloc, SK_MEMINFO_WMEM_ALLOC);
+    SK_MEMINFO_SET(sndbuf, SK_MEMINFO_SNDBUF);
+    SK_MEMINFO_SET(fwd_alloc, SK_MEMINFO_FWD_ALLOC);
+    SK_MEMINFO_SET(wmem_queued, SK_MEMINFO_WMEM_QUEUED);
+
+#undef SK_MEMINFO_SET
+}
+
+static void inet_diag_info(sigar_net_connection_info_t *info,
+                           struct nlmsghdr *nlh,
+                           struct inet_diag_msg *msg)
+{
+    struct rtattr *attr = (struct rtattr *)(msg + 1);
+    int len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*msg));
+    sigar_uint64_t *field = &info->rtt;
+    sigar_uint64_t *last = &info->wmem_queued;
+
+    while (field <= last) {
+        *field++ = SIGAR_FIELD_NOTIMPL;
+    }
+
+    if (msg->idiag_state == SIGAR_TCP_LISTEN) {
+        info->accept_queue = msg->idiag_rqueue;
+        info->accept_queue_max = msg->idiag_wqueue;
+    }
+
+    for (; RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        switch (attr->rta_type) {
+          case INET_DIAG_INFO:
+            inet_diag_tcp_info(info, RTA_DATA(attr), RTA_PAYLOAD(attr));
+            break;
+          case INET_DIAG_SKMEMINFO:
+            inet_diag_meminfo(info, RTA_DATA(attr), RTA_PAYLOAD(attr));
+            break;
+        }
     }
 }
 
-int sigar_cpu_info_list_get(sigar_t *sigar,
-                            sigar_cpu_info_list_t *cpu_infos)
+static int inet_diag_handler(void *data, struct nlmsghdr *nlh)
 {
-    FILE *fp;
-    int core_rollup = sigar_cpu_core_rollup(sigar), i=0;
+    inet_diag_walker_t *diag = data;
+    sigar_net_connection_walker_t *walker = diag->walker;
+    struct inet_diag_msg *msg = NLMSG_DATA(nlh);
+    sigar_net_connection_info_t info;
+    sigar_net_connection_t conn;
+    int flags = walker->flags;
 
-    if (!(fp = fopen(PROC_FS_ROOT "cpuinfo", "r"))) {
-        return errno;
+    if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY) {
+        return SIGAR_OK;
     }
 
-    (void)sigar_cpu_total_count(sigar);
-    sigar_cpu_info_list_create(cpu_infos);
+    conn.local_port = ntohs(msg->id.idiag_sport);
+    conn.remote_port = ntohs(msg->id.idiag_dport);
 
-    while (get_cpu_info(sigar, &cpu_infos->data[cpu_infos->number], fp)) {
-        sigar_cpu_info_t *info;
+    /* the kernel filter should have done this, but same contract as /proc */
+    if (!((conn.remote_port && (flags & SIGAR_NETCONN_CLIENT)) ||
+          (!conn.remote_port && (flags & SIGAR_NETCONN_SERVER))))
+    {
+        return SIGAR_OK;
+    }
 
-        if (core_rollup && (i++ % sigar->lcpu)) {
-            continue; /* fold logical processors */
-        }
+    conn.type = diag->type;
 
-        info = &cpu_infos->data[cpu_infos->number];
-        get_cpuinfo_max_freq(info, cpu_infos->number);
-        get_cpuinfo_min_freq(info, cpu_infos->number);
+    /* same byte order as the hex words in /proc/net/{tcp,udp}{,6} */
+    if (msg->idiag_family == AF_INET6) {
+        memcpy(conn.local_address.addr.in6, msg->id.idiag_src,
+               sizeof(conn.local_address.addr.in6));
+        memcpy(conn.remote_address.addr.in6, msg->id.idiag_dst,
+               sizeof(conn.remote_address.addr.in6));
+        conn.local_address.family = conn.remote_address.family =
+            SIGAR_AF_INET6;
+    }
+    else {
+        conn.local_address.addr.in = msg->id.idiag_src[0];
+        conn.remote_address.addr.in = msg->id.idiag_dst[0];
+        conn.local_address.family = conn.remote_address.family =
+            SIGAR_AF_INET;
+    }
 
-        info->total_cores = sigar->ncpu;
-        info->cores_per_socket = sigar->lcpu;
-        info->total_sockets = sigar_cpu_socket_count(sigar);
+    /* SIGAR_TCP_* currently matches TCP_* in linux/tcp.h */
+    conn.state = (msg->idiag_state == TCP_NEW_SYN_RECV) ?
+        SIGAR_TCP_SYN_RECV : msg->idiag_state;
+    /* for listeners wqueue is the backlog limit, /proc shows 0 */
+    conn.send_queue = (msg->idiag_state == SIGAR_TCP_LISTEN) ?
+        0 : msg->idiag_wqueue;
+    conn.receive_queue = msg->idiag_rqueue;
+    conn.uid = msg->idiag_uid;
+    conn.inode = msg->idiag_inode;
 
-        ++cpu_infos->number;
-        SIGAR_CPU_INFO_LIST_GROW(cpu_infos);
+    if (diag->ext) {
+        memcpy(&info.conn, &conn, sizeof(conn));
+        inet_diag_info(&info, nlh, msg);
     }
 
-    fclose(fp);
+    diag->records++;
+
+    if (walker->add_connection(walker,
+                               diag->ext ? &info.conn : &conn) != SIGAR_OK)
+    {
+        diag->stopped = 1;
+        return !SIGAR_OK; /* stop the dump */
+    }
 
     return SIGAR_OK;
 }
 
-static SIGAR_INLINE unsigned int hex2int(const char *x, int len)
+/* append a port comparison, rejecting the socket if it does not hold */
+static int inet_diag_bc_port(char *bc, int offset, int len,
+                             int code, unsigned short port)
 {
-    int i;
-    unsigned int j;
+    struct inet_diag_bc_op *op = (struct inet_diag_bc_op *)(bc + offset);
 
-    for (i=0, j=0; i<len; i++) {
-        register int ch = x[i];
-        j <<= 4;
-        if (isdigit(ch)) {
-            j |= ch - '0';
-        }
-        else if (isupper(ch)) {
-            j |= ch - ('A' - 10);
-        }
-        else {
-            j |= ch - ('a' - 10);
-        }
-    }
+    op[0].code = code;
+    op[0].yes = sizeof(*op) * 2;
+    op[0].no = len - offset + 4; /* past the end == reject */
+    op[1].code = INET_DIAG_BC_NOP;
+    op[1].yes = 0;
+    op[1].no = port;
 
-    return j;
+    return offset + sizeof(*op) * 2;
 }
 
-#define HEX_ENT_LEN 8
-
-#ifdef SIGAR_64BIT
-#define ROUTE_FMT "%16s %128s %128s %X %ld %ld %ld %128s %ld %ld %ld\n"
-#else
-#define ROUTE_FMT "%16s %128s %128s %X %lld %lld %lld %128s %lld %lld %lld\n"
-#endif
-#define RTF_UP 0x0001
-
-int sigar_net_route_list_get(sigar_t *sigar,
-                             sigar_net_route_list_t *routelist)
+/*
+ * dump sockets over NETLINK_SOCK_DIAG, filtering by remote and
+ * local port in the kernel so only matching sockets are copied out.
+ * port is the local port to match, 0 for any.
+ * with ext set tcp_info and socket memory are requested as well.
+ * the number of connections passed to the walker is added to records,
+ * which tells a failure up front from one part way through the dump.
+ */
+static int inet_diag_read(sigar_net_connection_walker_t *walker,
+                          int family, int protocol, int type,
+                          unsigned long port, int ext,
+                          unsigned long *records)
 {
-    FILE *fp;
-    char buffer[1024];
-    char net_addr[128], gate_addr[128], mask_addr[128];
-    int flags;
-    sigar_net_route_t *route;
+    struct {
+        struct nlmsghdr nlh;
+        struct inet_diag_req_v2 req;
+        struct rtattr rta;
+        char bc[INET_DIAG_BC_LEN];
+    } req;
+    inet_diag_walker_t diag;
+    int flags = walker->flags;
+    int server = flags & SIGAR_NETCONN_SERVER;
+    int client = flags & SIGAR_NETCONN_CLIENT;
+    int len = 0, offset = 0, status;
 
-    routelist->size = routelist->number = 0;
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    req.req.sdiag_family = family;
+    req.req.sdiag_protocol = protocol;
 
-    if (!(fp = fopen(PROC_FS_ROOT "net/route", "r"))) {
-        return errno;
+    if (ext) {
+        req.req.idiag_ext =
+            (1 << (INET_DIAG_INFO - 1)) | (1 << (INET_DIAG_SKMEMINFO - 1));
     }
 
-    sigar_net_route_list_create(routelist);
-
-    (void)fgets(buffer, sizeof(buffer), fp); /* skip header */
-    while (fgets(buffer, sizeof(buffer), fp)) {
-        int num;
+    /*
+     * servers are sockets without a remote port, as in proc_net_read,
+     * rather than tcp's LISTEN state so a bound socket in CLOSE is
+     * reported the same by both.
+     */
+    req.req.idiag_states = ~0;
 
-        SIGAR_NET_ROUTE_LIST_GROW(routelist);
-        route = &routelist->data[routelist->number++];
+    if (!(server && client)) {
+        len += sizeof(struct inet_diag_bc_op) * 2;
+    }
+    if (port) {
+        len += sizeof(struct inet_diag_bc_op) * 4;
+    }
 
-        /* XXX rid sscanf */
-        num = sscanf(buffer, ROUTE_FMT,
-                     route->ifname, net_addr, gate_addr,
-                     &flags, &route->refcnt, &route->use,
-                     &route->metric, mask_addr,
-                     &route->mtu, &route->window, &route->irtt);
-
-        if ((num < 10) || !(flags & RTF_UP)) {
-            --routelist->number;
-            continue;
-        }
+    if (!(server && client)) {
+        offset = server ?
+            inet_diag_bc_port(req.bc, offset, len, INET_DIAG_BC_D_LE, 0) :
+            inet_diag_bc_port(req.bc, offset, len, INET_DIAG_BC_D_GE, 1);
+    }
+    if (port) {
+        offset = inet_diag_bc_port(req.bc, offset, len,
+                                   INET_DIAG_BC_S_GE, port);
+        offset = inet_diag_bc_port(req.bc, offset, len,
+                                   INET_DIAG_BC_S_LE, port);
+    }
 
-        route->flags = flags;
-        
-        sigar_net_address_set(route->destination, hex2int(net_addr, HEX_ENT_LEN));
-        sigar_net_address_set(route->gateway, hex2int(gate_addr, HEX_ENT_LEN));
-        sigar_net_address_set(route->mask, hex2int(mask_addr, HEX_ENT_LEN));
+    if (len) {
+        req.rta.rta_type = INET_DIAG_REQ_BYTECODE;
+        req.rta.rta_len = RTA_LENGTH(len);
+        req.nlh.nlmsg_len =
+            NLMSG_LENGTH(sizeof(req.req)) + RTA_SPACE(len);
+    }
+    else {
+        req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(req.req));
     }
 
-    fclose(fp);
+    diag.walker = walker;
+    diag.type = type;
+    diag.ext = ext;
+    diag.stopped = 0;
+    diag.records = 0;
 
-    return SIGAR_OK;
+    status = sigar_netlink_dump(walker->sigar, NETLINK_SOCK_DIAG, &req.nlh,
+                                inet_diag_handler, &diag);
+
+    *records += diag.records;
+
+    return diag.stopped ? SIGAR_OK : status;
 }
 
-int sigar_net_interface_stat_get(sigar_t *sigar, const char *name,
-                                 sigar_net_interface_stat_t *ifstat)
+/*
+ * both address families.  no ipv6 in the kernel fails the second
+ * before it passes anything, same as a missing tcp6, that is not
+ * an error.
+ */
+static int inet_diag_read_all(sigar_net_connection_walker_t *walker,
+                              int protocol, int type,
+                              unsigned long port, int ext,
+                              unsigned long *records)
 {
-    int found = 0;
-    char buffer[BUFSIZ];
-    FILE *fp = fopen(PROC_FS_ROOT "net/dev", "r");
-    
-    if (!fp) {
-        return errno;
+    unsigned long inet6 = 0;
+    int status;
+
+    status = inet_diag_read(walker, AF_INET, protocol, type, port, ext,
+                            records);
+
+    if (status != SIGAR_OK) {
+        return status;
     }
 
-    /* skip header */
-    fgets(buffer, sizeof(buffer), fp);
-    fgets(buffer, sizeof(buffer), fp);
+    status = inet_diag_read(walker, AF_INET6, protocol, type, port, ext,
+                            &inet6);
 
-    while (fgets(buffer, sizeof(buffer), fp)) {
-        char *ptr, *dev;
+    *records += inet6;
 
-        dev = buffer;
-        while (isspace(*dev)) {
-            dev++;
-        }
+    return inet6 ? status : SIGAR_OK;
+}
 
-        if (!(ptr = strchr(dev, ':'))) {
-            continue;
-        }
+/* sock_diag for both address families, /proc if it is unavailable */
+static int net_connection_read(sigar_net_connection_walker_t *walker,
+                               int protocol, int type,
+                               const char *fname, const char *fname6,
+                               unsigned long port)
+{
+    sigar_t *sigar = walker->sigar;
+    unsigned long records = 0;
+    int status;
 
-        *ptr++ = 0;
+    if (!PROC_NET_MIRRORED(sigar)) {
+        status = inet_diag_read_all(walker, protocol, type, port, 0,
+                                    &records);
 
-        if (!strEQ(dev, name)) {
-            continue;
+        /* /proc would pass what the walker already has a second time */
+        if ((status == SIGAR_OK) || records) {
+            return status;
         }
 
-        found = 1;
-        ifstat->rx_bytes    = sigar_strtoull(ptr);
-        ifstat->rx_packets  = sigar_strtoull(ptr);
-        ifstat->rx_errors   = sigar_strtoull(ptr);
-        ifstat->rx_dropped  = sigar_strtoull(ptr);
-        ifstat->rx_overruns = sigar_strtoull(ptr);
-        ifstat->rx_frame    = sigar_strtoull(ptr);
+        if (SIGAR_LOG_IS_DEBUG(sigar)) {
+            sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                             "[net_connection] sock_diag failed: %s",
+                             sigar_strerror(sigar, status));
+        }
+    }
 
-        /* skip: compressed multicast */
-        ptr = sigar_skip_multiple_token(ptr, 2);
+    status = proc_net_read(walker, fname, type);
 
-        ifstat->tx_bytes      = sigar_strtoull(ptr);
-        ifstat->tx_packets    = sigar_strtoull(ptr);
-        ifstat->tx_errors     = sigar_strtoull(ptr);
-        ifstat->tx_dropped    = sigar_strtoull(ptr);
-        ifstat->tx_overruns   = sigar_strtoull(ptr);
-        ifstat->tx_collisions = sigar_strtoull(ptr);
-        ifstat->tx_carrier    = sigar_strtoull(ptr);
+    if (status != SIGAR_OK) {
+        return status;
+    }
 
-        ifstat->speed         = SIGAR_FIELD_NOTIMPL;
+    status = proc_net_read(walker, fname6, type);
 
-        break;
+    if (!((status == SIGAR_OK) || (status == ENOENT))) {
+        return status;
     }
 
-    fclose(fp);
-
-    return found ? SIGAR_OK : ENXIO;
+    return SIGAR_OK;
 }
 
-static SIGAR_INLINE void convert_hex_address(sigar_net_address_t *address,
-                                             char *ptr, int len)
-{
-    if (len > HEX_ENT_LEN) {
-        int i;
-        for (i=0; i<=3; i++, ptr+=HEX_ENT_LEN) {
-            address->addr.in6[i] = hex2int(ptr, HEX_ENT_LEN);
-        }
-
-        address->family = SIGAR_AF_INET6;
-    }
-    else {
-        address->addr.in =
-            (len == HEX_ENT_LEN) ? hex2int(ptr, HEX_ENT_LEN) : 0;
+#include <linux/unix_diag.h>
 
-        address->family = SIGAR_AF_INET;
-    }
-}
+typedef struct unix_walker_t unix_walker_t;
 
-typedef struct {
-    sigar_net_connection_list_t *connlist;
-    sigar_net_connection_t *conn;
-    unsigned long port;
-} net_conn_getter_t;
+/* the unix readers pass sigar_net_unix_connection_t to either list */
+struct unix_walker_t {
+    sigar_t *sigar;
+    int flags;
+    void *data;
+    int (*add_connection)(unix_walker_t *walker,
+                          sigar_net_unix_connection_t *conn);
+    int stopped;
+    unsigned long records; /* passed to add_connection */
+};
 
-static int proc_net_walker(sigar_net_connection_walker_t *walker,
-                           sigar_net_connection_t *conn)
+/* the unix side of SIGAR_NETCONN_SERVER/CLIENT */
+static int unix_connection_wanted(int flags,
+                                  sigar_net_unix_connection_t *conn)
 {
-    net_conn_getter_t *getter =
-        (net_conn_getter_t *)walker->data;
+    int server = (conn->state == SIGAR_TCP_LISTEN) ||
+        (!conn->peer_inode && conn->path[0] &&
+         (conn->state != SIGAR_TCP_ESTABLISHED));
 
-    if (getter->connlist) {
-        SIGAR_NET_CONNLIST_GROW(getter->connlist);
-        memcpy(&getter->connlist->data[getter->connlist->number++],
-               conn, sizeof(*conn));
-    }
-    else {
-        if ((getter->port == conn->local_port) &&
-            (conn->remote_port == 0))
-        {
-            memcpy(getter->conn, conn, sizeof(*conn));
-            return !SIGAR_OK; /* break loop */
-        }
+    return server ?
+        (flags & SIGAR_NETCONN_SERVER) : (flags & SIGAR_NETCONN_CLIENT);
+}
+
+static int unix_connection_add(unix_walker_t *walker,
+                               sigar_net_unix_connection_t *conn)
+{
+    if (!unix_connection_wanted(walker->flags, conn)) {
+        return SIGAR_OK;
     }
 
-    return SIGAR_OK; /* continue loop */
-}
+    walker->records++;
 
-#define SKIP_WHILE(p, c) while (*p == c) p++
-#define SKIP_PAST(p, c) \
-   while(*p && (*p != c)) p++; \
-   SKIP_WHILE(p, c)
+    if (walker->add_connection(walker, conn) != SIGAR_OK) {
+        walker->stopped = 1;
+        return !SIGAR_OK;
+    }
 
-typedef struct {
-    FILE *fp;
-    int (*close)(FILE *);
-} xproc_t;
+    return SIGAR_OK;
+}
 
-static FILE *xproc_open(const char *command, xproc_t *xproc)
+/* names are not \0 terminated, abstract ones start with \0 */
+static void unix_path_set(sigar_net_unix_connection_t *conn,
+                          const char *name, int len)
 {
-    struct stat sb;
-    if (stat(command, &sb) == 0) {
-        if (sb.st_mode & S_IXUSR) {
-            /* executable script for testing large
-             * conn table where we can sleep() to better
-             * simulate /proc/net/tcp behavior
-             */
-            xproc->fp = popen(command, "r");
-            xproc->close = pclose;
-        }
-        else {
-            xproc->fp = fopen(command, "r");
-            xproc->close = fclose;
-        }
-        return xproc->fp;
+    if (len >= sizeof(conn->path)) {
+        len = sizeof(conn->path) - 1;
     }
-    else {
-        return NULL;
+    memcpy(conn->path, name, len);
+    conn->path[len] = '\0';
+    if (len && (conn->path[0] == '\0')) {
+        conn->path[0] = '@';
     }
 }
 
-static int proc_net_read(sigar_net_connection_walker_t *walker,
-                         const char *fname,
-                         int type)
+static int unix_diag_handler(void *data, struct nlmsghdr *nlh)
 {
-    FILE *fp = NULL;
-    char buffer[8192];
-    sigar_t *sigar = walker->sigar;
-    char *ptr = sigar->proc_net;
-    int flags = walker->flags;
-    xproc_t xproc = { NULL, fclose };
+    unix_walker_t *walker = data;
+    struct unix_diag_msg *msg = NLMSG_DATA(nlh);
+    struct rtattr *attr = (struct rtattr *)(msg + 1);
+    int len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*msg));
+    sigar_net_unix_connection_t conn;
 
-    if (ptr) {
-        snprintf(buffer, sizeof(buffer),
-                 "%s/%s", ptr,
-                 fname + sizeof(PROC_FS_ROOT)-1);
+    if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY) {
+        return SIGAR_OK;
+    }
 
-        if ((fp = xproc_open(buffer, &xproc))) {
-            if (SIGAR_LOG_IS_DEBUG(sigar)) {
-                sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
-                                 "[proc_net] using %s",
-                                 buffer);
+    SIGAR_ZERO(&conn);
+    conn.socket_type = msg->udiag_type;
+    /* sk_state: TCP_LISTEN, TCP_ESTABLISHED or TCP_CLOSE */
+    conn.state = msg->udiag_state;
+    conn.inode = msg->udiag_ino;
+    conn.uid = (sigar_uid_t)-1; /* UDIAG_SHOW_UID is 5.3+ */
+
+    for (; RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        switch (attr->rta_type) {
+          case UNIX_DIAG_NAME:
+            unix_path_set(&conn, RTA_DATA(attr), RTA_PAYLOAD(attr));
+            break;
+          case UNIX_DIAG_PEER:
+            conn.peer_inode = *(__u32 *)RTA_DATA(attr);
+            break;
+          case UNIX_DIAG_RQLEN:
+            {
+                struct unix_diag_rqlen *rql = RTA_DATA(attr);
+                conn.receive_queue = rql->udiag_rqueue;
+                /* for listeners wqueue is the backlog limit */
+                conn.send_queue = (conn.state == SIGAR_TCP_LISTEN) ?
+                    0 : rql->udiag_wqueue;
             }
-        }
-        else if (SIGAR_LOG_IS_DEBUG(sigar)) {
-            sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
-                             "[proc_net] cannot open %s",
-                             buffer);
+            break;
+#ifdef UDIAG_SHOW_UID
+          case UNIX_DIAG_UID:
+            conn.uid = *(__u32 *)RTA_DATA(attr);
+            break;
+#endif
         }
     }
 
-    if (!(fp || (fp = fopen(fname, "r")))) {
+    return unix_connection_add(walker, &conn);
+}
+
+static int unix_diag_read(unix_walker_t *walker)
+{
+    struct {
+        struct nlmsghdr nlh;
+        struct unix_diag_req req;
+    } req;
+    int status;
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = sizeof(req);
+    req.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    req.req.sdiag_family = AF_UNIX;
+    req.req.udiag_states = ~0;
+    req.req.udiag_show =
+        UDIAG_SHOW_NAME | UDIAG_SHOW_PEER | UDIAG_SHOW_RQLEN;
+#ifdef UDIAG_SHOW_UID
+    req.req.udiag_show |= UDIAG_SHOW_UID;
+#endif
+
+    status = sigar_netlink_dump(walker->sigar, NETLINK_SOCK_DIAG, &req.nlh,
+                                unix_diag_handler, walker);
+
+    return walker->stopped ? SIGAR_OK : status;
+}
+
+#define SS_UNIX_UNCONNECTED   1
+#define SS_UNIX_CONNECTING    2
+#define SS_UNIX_CONNECTED     3
+#define SS_UNIX_DISCONNECTING 4
+#define SO_UNIX_ACCEPTCON     (1<<16)
+
+/*
+ * Num RefCount Protocol Flags Type St Inode Path
+ * no peer, queue or uid in here.
+ */
+static int proc_net_unix_read(unix_walker_t *walker)
+{
+    FILE *fp;
+    char buffer[8192], *ptr;
+
+    if (!(fp = proc_net_fopen(walker->sigar, PROC_FS_ROOT "net/unix"))) {
         return errno;
     }
 
-    fgets(buffer, sizeof(buffer), fp); /* skip header */
+    (void)fgets(buffer, sizeof(buffer), fp); /* skip header */
 
     while ((ptr = fgets(buffer, sizeof(buffer), fp))) {
-        sigar_net_connection_t conn;
-        char *laddr, *raddr;
-        int laddr_len=0, raddr_len=0;
-        int more;
+        sigar_net_unix_connection_t conn;
+        unsigned long flags, state;
+        int len;
+
+        SIGAR_ZERO(&conn);
+        conn.uid = (sigar_uid_t)-1;
+
+        SKIP_PAST(ptr, ' '); /* Num: */
+        SKIP_PAST(ptr, ' '); /* RefCount */
+        SKIP_PAST(ptr, ' '); /* Protocol */
+        flags = strtoul(ptr, &ptr, 16);
+        conn.socket_type = strtoul(ptr, &ptr, 16);
+        state = strtoul(ptr, &ptr, 16);
+        conn.inode = sigar_strtoul(ptr);
 
-        /* skip leading space */
-        SKIP_WHILE(ptr, ' ');
+        switch (state) {
+          case SS_UNIX_CONNECTED:
+            conn.state = SIGAR_TCP_ESTABLISHED;
+            break;
+          case SS_UNIX_CONNECTING:
+            conn.state = SIGAR_TCP_SYN_SENT;
+            break;
+          case SS_UNIX_DISCONNECTING:
+            conn.state = SIGAR_TCP_CLOSING;
+            break;
+          default:
+            conn.state = (flags & SO_UNIX_ACCEPTCON) ?
+                SIGAR_TCP_LISTEN : SIGAR_TCP_CLOSE;
+            break;
+        }
 
-        /* skip "%d: " */
-        SKIP_PAST(ptr, ' ');
+        SKIP_WHILE(ptr, ' ');
+        len = strlen(ptr);
+        while (len && ((ptr[len-1] == '\n') || (ptr[len-1] == ' '))) {
+            len--;
+        }
+        unix_path_set(&conn, ptr, len);
 
-        laddr = ptr;
-        while (*ptr && (*ptr != ':')) {
-            laddr_len++;
-            ptr++;
+        if (unix_connection_add(walker, &conn) != SIGAR_OK) {
+            break;
         }
-        SKIP_WHILE(ptr, ':');
+    }
 
-        conn.local_port = (strtoul(ptr, &ptr, 16) & 0xffff);
+    sigar_fclose(fp);
 
-        SKIP_WHILE(ptr, ' ');
+    return SIGAR_OK;
+}
 
-        raddr = ptr;
-        while (*ptr && (*ptr != ':')) {
-            raddr_len++;
-            ptr++;
+/* unix_diag, /proc/net/unix if it fails before passing anything */
+static int unix_connection_read(unix_walker_t *walker)
+{
+    sigar_t *sigar = walker->sigar;
+
+    walker->stopped = 0;
+    walker->records = 0;
+
+    if (!PROC_NET_MIRRORED(sigar)) {
+        int status = unix_diag_read(walker);
+
+        if ((status == SIGAR_OK) || walker->records) {
+            return status;
         }
-        SKIP_WHILE(ptr, ':');
 
-        conn.remote_port = (strtoul(ptr, &ptr, 16) & 0xffff);
+        if (SIGAR_LOG_IS_DEBUG(sigar)) {
+            sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                             "[net_connection] unix_diag failed: %s",
+                             sigar_strerror(sigar, status));
+        }
+    }
 
-        SKIP_WHILE(ptr, ' ');
+    return proc_net_unix_read(walker);
+}
 
-        if (!((conn.remote_port && (flags & SIGAR_NETCONN_CLIENT)) ||
-              (!conn.remote_port && (flags & SIGAR_NETCONN_SERVER))))
-        {
-            continue;
-        }
+/* the walk gets the fields unix sockets share with inet ones */
+static int unix_connection_walker(unix_walker_t *walker,
+                                  sigar_net_unix_connection_t *unix_conn)
+{
+    sigar_net_connection_walker_t *conn_walker = walker->data;
+    sigar_net_connection_t conn;
+
+    SIGAR_ZERO(&conn);
+    conn.type = SIGAR_NETCONN_UNIX;
+    conn.local_address.family = conn.remote_address.family =
+        SIGAR_AF_UNSPEC;
+    conn.uid = unix_conn->uid;
+    conn.inode = unix_conn->inode;
+    conn.state = unix_conn->state;
+    conn.send_queue = unix_conn->send_queue;
+    conn.receive_queue = unix_conn->receive_queue;
+
+    return conn_walker->add_connection(conn_walker, &conn);
+}
 
-        conn.type = type;
+static int unix_connection_walk(sigar_net_connection_walker_t *walker)
+{
+    unix_walker_t unix_walker;
 
-        convert_hex_address(&conn.local_address,
-                            laddr, laddr_len);
+    unix_walker.sigar = walker->sigar;
+    unix_walker.flags = walker->flags;
+    unix_walker.data = walker;
+    unix_walker.add_connection = unix_connection_walker;
 
-        convert_hex_address(&conn.remote_address,
-                            raddr, raddr_len);
+    return unix_connection_read(&unix_walker);
+}
 
-        /* SIGAR_TCP_* currently matches TCP_* in linux/tcp.h */
-        conn.state = hex2int(ptr, 2);
-        ptr += 2;
-        SKIP_WHILE(ptr, ' ');
+static int unix_connection_list_walker(unix_walker_t *walker,
+                                       sigar_net_unix_connection_t *conn)
+{
+    sigar_net_unix_connection_list_t *connlist = walker->data;
 
-        conn.send_queue = hex2int(ptr, HEX_ENT_LEN);
-        ptr += HEX_ENT_LEN+1; /* tx + ':' */;
+    SIGAR_NET_UNIX_CONNLIST_GROW(connlist);
+    memcpy(&connlist->data[connlist->number++], conn, sizeof(*conn));
 
-        conn.receive_queue = hex2int(ptr, HEX_ENT_LEN);
-        ptr += HEX_ENT_LEN;
-        SKIP_WHILE(ptr, ' ');
+    return SIGAR_OK;
+}
 
-        SKIP_PAST(ptr, ' '); /* tr:tm->whem */
-        SKIP_PAST(ptr, ' '); /* retrnsmt */
+int sigar_os_net_unix_connection_list_get(sigar_t *sigar,
+                                          sigar_net_unix_connection_list_t *connlist,
+                                          int flags)
+{
+    unix_walker_t walker;
+    int status;
 
-        conn.uid = sigar_strtoul(ptr);
+    sigar_net_unix_connection_list_create(connlist);
 
-        SKIP_WHILE(ptr, ' ');
-        SKIP_PAST(ptr, ' '); /* timeout */
+    walker.sigar = sigar;
+    walker.flags = flags;
+    walker.data = connlist;
+    walker.add_connection = unix_connection_list_walker;
 
-        conn.inode = sigar_strtoul(ptr);
+    status = unix_connection_read(&walker);
 
-        more = walker->add_connection(walker, &conn);
-        if (more != SIGAR_OK) {
-            xproc.close(fp);
-            return SIGAR_OK;
-        }
+    if (status != SIGAR_OK) {
+        sigar_net_unix_connection_list_destroy(sigar, connlist);
     }
 
-    xproc.close(fp);
-
-    return SIGAR_OK;
+    return status;
 }
 
-int sigar_net_connection_walk(sigar_net_connection_walker_t *walker)
+static int net_connection_walk(sigar_net_connection_walker_t *walker,
+                               unsigned long port)
 {
     int flags = walker->flags;
     int status;
 
     if (flags & SIGAR_NETCONN_TCP) {
-        status = proc_net_read(walker,
-                               PROC_FS_ROOT "net/tcp",
-                               SIGAR_NETCONN_TCP);
+        status = net_connection_read(walker,
+                                     IPPROTO_TCP, SIGAR_NETCONN_TCP,
+                                     PROC_FS_ROOT "net/tcp",
+                                     PROC_FS_ROOT "net/tcp6",
+                                     port);
 
         if (status != SIGAR_OK) {
             return status;
         }
-
-        status = proc_net_read(walker,
-                               PROC_FS_ROOT "net/tcp6",
-                               SIGAR_NETCONN_TCP);
-
-        if (!((status == SIGAR_OK) || (status == ENOENT))) {
-            return status;
-        }
     }
 
     if (flags & SIGAR_NETCONN_UDP) {
-        status = proc_net_read(walker,
-                               PROC_FS_ROOT "net/udp",
-                               SIGAR_NETCONN_UDP);
+        status = net_connection_read(walker,
+                                     IPPROTO_UDP, SIGAR_NETCONN_UDP,
+                                     PROC_FS_ROOT "net/udp",
+                                     PROC_FS_ROOT "net/udp6",
+                                     port);
 
         if (status != SIGAR_OK) {
             return status;
         }
-
-        status = proc_net_read(walker,
-                               PROC_FS_ROOT "net/udp6",
-                               SIGAR_NETCONN_UDP);
-
-        if (!((status == SIGAR_OK) || (status == ENOENT))) {
-            return status;
-        }
     }
 
+    /* raw_diag is a late (4.14) optional module, stick with /proc */
     if (flags & SIGAR_NETCONN_RAW) {
         status = proc_net_read(walker,
                                PROC_FS_ROOT "net/raw",
@@ -2082,20 +4236,31 @@ int sigar_net_connection_walk(sigar_net_connection_walker_t *walker)
         }
     }
 
-    /* XXX /proc/net/unix */
+    if (flags & SIGAR_NETCONN_UNIX) {
+        status = unix_connection_walk(walker);
+
+        if (status != SIGAR_OK) {
+            return status;
+        }
+    }
 
     return SIGAR_OK;
 }
 
-int sigar_net_connection_list_get(sigar_t *sigar,
-                                  sigar_net_connection_list_t *connlist,
-                                  int flags)
+int sigar_os_net_connection_walk(sigar_net_connection_walker_t *walker)
+{
+    return net_connection_walk(walker, 0);
+}
+
+int sigar_os_net_connection_list_get(sigar_t *sigar,
+                                     sigar_net_connection_list_t *connlist,
+                                     int flags)
 {
     int status;
     sigar_net_connection_walker_t walker;
     net_conn_getter_t getter;
 
-    sigar_net_connection_list_create(connlist);
+    sigar_net_connection_list_create(sigar, connlist);
 
     getter.conn = NULL;
     getter.connlist = connlist;
@@ -2114,6 +4279,185 @@ int sigar_net_connection_list_get(sigar_t *sigar,
     return status;
 }
 
+static int net_connection_info_walker(sigar_net_connection_walker_t *walker,
+                                      sigar_net_connection_t *conn)
+{
+    sigar_net_connection_info_list_t *connlist = walker->data;
+
+    SIGAR_NET_CONNINFO_LIST_GROW(connlist);
+    memcpy(&connlist->data[connlist->number++],
+           conn, sizeof(sigar_net_connection_info_t));
+
+    return SIGAR_OK;
+}
+
+/* sock_diag only, /proc has no tcp_info */
+static int net_connection_info_walk(sigar_net_connection_walker_t *walker)
+{
+    int flags = walker->flags;
+    unsigned long records = 0;
+    int status;
+
+    if (flags & SIGAR_NETCONN_TCP) {
+        status = inet_diag_read_all(walker, IPPROTO_TCP, SIGAR_NETCONN_TCP,
+                                    0, 1, &records);
+        if (status != SIGAR_OK) {
+            return status;
+        }
+    }
+
+    if (flags & SIGAR_NETCONN_UDP) {
+        status = inet_diag_read_all(walker, IPPROTO_UDP, SIGAR_NETCONN_UDP,
+                                    0, 1, &records);
+        if (status != SIGAR_OK) {
+            return status;
+        }
+    }
+
+    return SIGAR_OK;
+}
+
+int sigar_os_net_connection_info_list_get(sigar_t *sigar,
+                                          sigar_net_connection_info_list_t *connlist,
+                                          int flags)
+{
+    int status;
+    sigar_net_connection_walker_t walker;
+
+    sigar_net_connection_info_list_create(connlist);
+
+    walker.sigar = sigar;
+    walker.flags = flags;
+    walker.data = connlist;
+    walker.add_connection = net_connection_info_walker;
+
+    status = net_connection_info_walk(&walker);
+
+    if (status != SIGAR_OK) {
+        sigar_net_connection_info_list_destroy(sigar, connlist);
+    }
+
+    return status;
+}
+
+typedef struct {
+    sigar_net_port_tcp_info_list_t *portlist;
+    unsigned int *ports; /* local port -> index + 1 */
+} net_port_tcp_info_getter_t;
+
+static int net_histogram_bucket(sigar_uint64_t value, int shift)
+{
+    int bucket = 0;
+
+    if (value == SIGAR_FIELD_NOTIMPL) {
+        return 0;
+    }
+
+    value >>= shift;
+
+    while (value && (bucket < SIGAR_NET_HISTOGRAM_BUCKETS-1)) {
+        value >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+static int net_port_tcp_info_walker(sigar_net_connection_walker_t *walker,
+                                    sigar_net_connection_t *conn)
+{
+    net_port_tcp_info_getter_t *getter = walker->data;
+    sigar_net_port_tcp_info_list_t *portlist = getter->portlist;
+    sigar_net_connection_info_t *info = (sigar_net_connection_info_t *)conn;
+    sigar_net_port_tcp_info_t *port;
+    unsigned int idx;
+
+    if (conn->state != SIGAR_TCP_ESTABLISHED) {
+        return SIGAR_OK;
+    }
+
+    idx = getter->ports[conn->local_port & 0xffff];
+
+    if (idx) {
+        port = &portlist->data[idx-1];
+    }
+    else {
+        SIGAR_NET_PORT_TCP_INFO_LIST_GROW(portlist);
+        port = &portlist->data[portlist->number++];
+        getter->ports[conn->local_port & 0xffff] = portlist->number;
+        SIGAR_ZERO(port);
+        port->local_port = conn->local_port;
+        port->rtt_min = SIGAR_FIELD_NOTIMPL;
+    }
+
+    port->connections++;
+
+    if (info->rtt != SIGAR_FIELD_NOTIMPL) {
+        if ((port->rtt_min == SIGAR_FIELD_NOTIMPL) ||
+            (info->rtt < port->rtt_min))
+        {
+            port->rtt_min = info->rtt;
+        }
+        if (info->rtt > port->rtt_max) {
+            port->rtt_max = info->rtt;
+        }
+        port->rtt_avg += info->rtt; /* sum until the walk is done */
+    }
+    port->rtt_histogram[net_histogram_bucket(info->rtt, 7)]++;
+
+    if (info->total_retrans != SIGAR_FIELD_NOTIMPL) {
+        port->total_retrans += info->total_retrans;
+    }
+    port->retrans_histogram[net_histogram_bucket(info->total_retrans, 0)]++;
+
+    return SIGAR_OK;
+}
+
+int sigar_os_net_port_tcp_info_list_get(sigar_t *sigar,
+                                        sigar_net_port_tcp_info_list_t *portlist)
+{
+    int status;
+    unsigned long i;
+    sigar_net_connection_walker_t walker;
+    net_port_tcp_info_getter_t getter;
+
+    getter.ports = calloc(0x10000, sizeof(*getter.ports));
+    if (!getter.ports) {
+        return ENOMEM;
+    }
+    getter.portlist = portlist;
+
+    sigar_net_port_tcp_info_list_create(portlist);
+
+    walker.sigar = sigar;
+    walker.flags = SIGAR_NETCONN_CLIENT|SIGAR_NETCONN_TCP;
+    walker.data = &getter;
+    walker.add_connection = net_port_tcp_info_walker;
+
+    status = net_connection_info_walk(&walker);
+
+    free(getter.ports);
+
+    if (status != SIGAR_OK) {
+        sigar_net_port_tcp_info_list_destroy(sigar, portlist);
+        return status;
+    }
+
+    for (i=0; i<portlist->number; i++) {
+        sigar_net_port_tcp_info_t *port = &portlist->data[i];
+
+        if (port->rtt_min == SIGAR_FIELD_NOTIMPL) {
+            port->rtt_min = port->rtt_max = port->rtt_avg =
+                SIGAR_FIELD_NOTIMPL;
+        }
+        else {
+            port->rtt_avg /= port->connections;
+        }
+    }
+
+    return SIGAR_OK;
+}
+
 static int sigar_net_connection_get(sigar_t *sigar,
                                     sigar_net_connection_t *netconn,
                                     unsigned long port,
@@ -2123,55 +4467,246 @@ static int sigar_net_connection_get(sigar_t *sigar,
     sigar_net_connection_walker_t walker;
     net_conn_getter_t getter;
 
-    getter.conn = netconn;
-    getter.connlist = NULL;
-    getter.port = port;
+    getter.conn = netconn;
+    getter.connlist = NULL;
+    getter.port = port;
+
+    walker.sigar = sigar;
+    walker.flags = flags;
+    walker.data = &getter;
+    walker.add_connection = proc_net_walker;
+
+    status = net_connection_walk(&walker, port);
+
+    return status;
+}
+
+int sigar_net_interface_ipv6_config_get(sigar_t *sigar, const char *name,
+                                        sigar_net_interface_config_t *ifconfig)
+{
+    FILE *fp;
+    char addr[32+1], ifname[8+1];
+    int status = SIGAR_ENOENT;
+    int idx, prefix, scope, flags;
+
+    if (!(fp = proc_net_fopen(sigar, PROC_FS_ROOT "net/if_inet6"))) {
+        return errno;
+    }
+
+    while (fscanf(fp, "%32s %02x %02x %02x %02x %8s\n",
+                  addr, &idx, &prefix, &scope, &flags, ifname) != EOF)
+    {
+        if (strEQ(name, ifname)) {
+            status = SIGAR_OK;
+            break;
+        }
+    }
+
+    sigar_fclose(fp);
+
+    if (status == SIGAR_OK) {
+        int i=0;
+        unsigned char *addr6 = (unsigned char *)&(ifconfig->address6.addr.in6);
+        char *ptr = addr;
+
+        for (i=0; i<16; i++, ptr+=2) {
+            addr6[i] = (unsigned char)sigar_parse_hex(ptr, 2);
+        }
+
+        ifconfig->prefix6_length = prefix;
+        ifconfig->scope6 = scope;
+    }
+
+    return status;
+}
+
+static void proto_counter_strcpy(char *dest, int size,
+                                 const char *src, int len)
+{
+    if (len >= size) {
+        len = size - 1;
+    }
+    memcpy(dest, src, len);
+    dest[len] = '\0';
+}
+
+/*
+ * /proc/net/snmp and /proc/net/netstat come in line pairs:
+ * "Tcp: RtoAlgorithm RtoMin ..." followed by "Tcp: 1 200 ...".
+ */
+static int proto_counters_read_pairs(sigar_t *sigar,
+                                     sigar_net_proto_counter_list_t *counters,
+                                     const char *fname)
+{
+    FILE *fp;
+    char *names = NULL, *values = NULL;
+    size_t names_size = 0, values_size = 0;
+
+    if (!(fp = proc_net_fopen(sigar, fname))) {
+        return errno;
+    }
+
+    while ((getline(&names, &names_size, fp) > 0) &&
+           (getline(&values, &values_size, fp) > 0))
+    {
+        char *group = names, *name, *value;
+        char *ptr = strchr(names, ':');
+        int glen;
+
+        if (!ptr || !strnEQ(names, values, ptr - names + 1)) {
+            break; /* out of step, not a format we know */
+        }
+
+        glen = ptr - group;
+        name = ptr + 1;
+        value = values + glen + 1;
+
+        while (1) {
+            sigar_net_proto_counter_t *counter;
+            int nlen;
+
+            SIGAR_SKIP_SPACE(name);
+            SIGAR_SKIP_SPACE(value);
+            if (!*name || !*value) {
+                break;
+            }
+
+            for (nlen=0; name[nlen] && !sigar_isspace(name[nlen]); nlen++) ;
+
+            SIGAR_NET_PROTO_COUNTER_LIST_GROW(counters);
+            counter = &counters->data[counters->number++];
+
+            proto_counter_strcpy(counter->group, sizeof(counter->group),
+                                 group, glen);
+            proto_counter_strcpy(counter->name, sizeof(counter->name),
+                                 name, nlen);
+            /* a few are signed, e.g. Tcp MaxConn -1 */
+            counter->value = (*value == '-') ?
+                (sigar_uint64_t)strtoll(value, &value, 10) :
+                sigar_strtoull(value);
+
+            name += nlen;
+            while (*value && !sigar_isspace(*value)) {
+                value++;
+            }
+        }
+    }
+
+    free(names);
+    free(values);
+    sigar_fclose(fp);
+
+    return SIGAR_OK;
+}
+
+/* /proc/net/snmp6 is one "Ip6InReceives 5" pair per line */
+static int proto_counters_read_snmp6(sigar_t *sigar,
+                                     sigar_net_proto_counter_list_t *counters,
+                                     const char *fname)
+{
+    FILE *fp;
+    char buffer[BUFSIZ], *ptr;
+
+    if (!(fp = proc_net_fopen(sigar, fname))) {
+        return errno;
+    }
+
+    while ((ptr = fgets(buffer, sizeof(buffer), fp))) {
+        sigar_net_proto_counter_t *counter;
+        char *name = strchr(buffer, '6');
+
+        if (!name) {
+            continue;
+        }
+        name++; /* the group is everything up to the '6' */
+
+        for (ptr=name; *ptr && !sigar_isspace(*ptr); ptr++) ;
+        if (!*ptr) {
+            continue;
+        }
+        *ptr++ = '\0';
+
+        SIGAR_NET_PROTO_COUNTER_LIST_GROW(counters);
+        counter = &counters->data[counters->number++];
 
-    walker.sigar = sigar;
-    walker.flags = flags;
-    walker.data = &getter;
-    walker.add_connection = proc_net_walker;
+        proto_counter_strcpy(counter->group, sizeof(counter->group),
+                             buffer, name - buffer);
+        SIGAR_SSTRCPY(counter->name, name);
+        counter->value = sigar_strtoull(ptr);
+    }
 
-    status = sigar_net_connection_walk(&walker);
+    sigar_fclose(fp);
 
-    return status;
+    return SIGAR_OK;
 }
 
-int sigar_net_interface_ipv6_config_get(sigar_t *sigar, const char *name,
-                                        sigar_net_interface_config_t *ifconfig)
+static int proto_counter_list_get(sigar_t *sigar,
+                                  sigar_net_proto_counter_list_t *counters)
 {
-    FILE *fp;
-    char addr[32+1], ifname[8+1];
-    int status = SIGAR_ENOENT;
-    int idx, prefix, scope, flags;
+    sigar_net_proto_counter_list_t *last = &sigar->proto_counters;
+    unsigned long i;
+    int status;
 
-    if (!(fp = fopen(PROC_FS_ROOT "net/if_inet6", "r"))) {
-        return errno;
-    }
+    sigar_net_proto_counter_list_create(counters);
 
-    while (fscanf(fp, "%32s %02x %02x %02x %02x %8s\n",
-                  addr, &idx, &prefix, &scope, &flags, ifname) != EOF)
-    {
-        if (strEQ(name, ifname)) {
-            status = SIGAR_OK;
-            break;
-        }
+    status = proto_counters_read_pairs(sigar, counters, PROC_FS_ROOT "net/snmp");
+    if (status != SIGAR_OK) {
+        sigar_net_proto_counter_list_destroy(sigar, counters);
+        return status;
     }
 
-    fclose(fp);
+    /* TcpExt/IpExt/MPTcpExt: 2.6+ */
+    (void)proto_counters_read_pairs(sigar, counters, PROC_FS_ROOT "net/netstat");
+    /* missing without ipv6 */
+    (void)proto_counters_read_snmp6(sigar, counters, PROC_FS_ROOT "net/snmp6");
 
-    if (status == SIGAR_OK) {
-        int i=0;
-        unsigned char *addr6 = (unsigned char *)&(ifconfig->address6.addr.in6);
-        char *ptr = addr;
+    for (i=0; i<counters->number; i++) {
+        sigar_net_proto_counter_t *counter = &counters->data[i];
+        sigar_net_proto_counter_t *prev;
 
-        for (i=0; i<16; i++, ptr+=2) {
-            addr6[i] = (unsigned char)hex2int(ptr, 2);
+        /* the layout only changes across kernel versions */
+        if ((i < last->number) &&
+            strEQ(last->data[i].name, counter->name) &&
+            strEQ(last->data[i].group, counter->group))
+        {
+            prev = &last->data[i];
+        }
+        else {
+            prev = sigar_net_proto_counter_find(last,
+                                                counter->group,
+                                                counter->name);
         }
 
-        ifconfig->prefix6_length = prefix;
-        ifconfig->scope6 = scope;
+        /* a smaller value is a gauge going down or a counter reset */
+        if (prev && (counter->value >= prev->value)) {
+            counter->delta = counter->value - prev->value;
+        }
+        else {
+            counter->delta = 0;
+        }
+    }
+
+    /* keep a copy for the next delta */
+    if (last->size < counters->number) {
+        sigar_net_proto_counter_list_destroy(sigar, last);
+        last->size = counters->size;
+        last->data = malloc(sizeof(*(last->data)) * last->size);
     }
+    memcpy(last->data, counters->data,
+           sizeof(*(counters->data)) * counters->number);
+    last->number = counters->number;
+
+    return SIGAR_OK;
+}
+
+int sigar_os_net_proto_counter_list_get(sigar_t *sigar,
+                                        sigar_net_proto_counter_list_t *counters)
+{
+    int status;
+
+    sigar_lock(sigar);
+    status = proto_counter_list_get(sigar, counters);
+    sigar_unlock(sigar);
 
     return status;
 }
@@ -2186,7 +4721,7 @@ sigar_tcp_get(sigar_t *sigar,
     char buffer[1024], *ptr=buffer;
     int status = SIGAR_ENOENT;
 
-    if (!(fp = fopen(PROC_FS_ROOT "net/snmp", "r"))) {
+    if (!(fp = proc_net_fopen(sigar, PROC_FS_ROOT "net/snmp"))) {
         return errno;
     }
 
@@ -2199,7 +4734,7 @@ sigar_tcp_get(sigar_t *sigar,
         }
     }
 
-    fclose(fp);
+    sigar_fclose(fp);
 
     if (status == SIGAR_OK) {
         /* assuming field order, same in 2.2, 2.4 and 2.6 kernels */ 
@@ -2225,7 +4760,7 @@ static int sigar_proc_nfs_gets(char *file, char *tok,
 {
     int status = ENOENT;
     int len = strlen(tok);
-    FILE *fp = fopen(file, "r");
+    FILE *fp = sigar_fopen(file);
     
     if (!fp) {
         return SIGAR_ENOTIMPL;
@@ -2238,7 +4773,7 @@ static int sigar_proc_nfs_gets(char *file, char *tok,
         }
     }
 
-    fclose(fp);
+    sigar_fclose(fp);
 
     return status;
 }
@@ -2403,182 +4938,510 @@ static char *get_hw_type(int type)
     }
 }
 
-int sigar_arp_list_get(sigar_t *sigar,
-                       sigar_arp_list_t *arplist)
+static int proc_net_arp_walk(sigar_arp_walker_t *walker)
 {
+    sigar_t *sigar = walker->sigar;
     FILE *fp;
     char buffer[1024];
     char net_addr[128], hwaddr[128], mask_addr[128];
     int flags, type, status;
-    sigar_arp_t *arp;
+    sigar_arp_t arp;
 
-    arplist->size = arplist->number = 0;
+    if (walker->family == SIGAR_AF_INET6) {
+        return SIGAR_OK;
+    }
 
-    if (!(fp = fopen(PROC_FS_ROOT "net/arp", "r"))) {
+    if (!(fp = proc_net_fopen(walker->sigar, PROC_FS_ROOT "net/arp"))) {
         return errno;
     }
 
-    sigar_arp_list_create(arplist);
-
     (void)fgets(buffer, sizeof(buffer), fp); /* skip header */
     while (fgets(buffer, sizeof(buffer), fp)) {
         int num;
 
-        SIGAR_ARP_LIST_GROW(arplist);
-        arp = &arplist->data[arplist->number++];
+        SIGAR_ZERO(&arp);
 
         /* XXX rid sscanf */
         num = sscanf(buffer, "%128s 0x%x 0x%x %128s %128s %16s",
                      net_addr, &type, &flags,
-                     hwaddr, mask_addr, arp->ifname);
+                     hwaddr, mask_addr, arp.ifname);
 
         if (num < 6) {
-            --arplist->number;
             continue;
         }
 
-        arp->flags = flags;
-        status = inet_pton(AF_INET, net_addr, &arp->address.addr);
+        arp.flags = flags;
+        status = inet_pton(AF_INET, net_addr, &arp.address.addr);
         if (status > 0) {
-            arp->address.family = SIGAR_AF_INET;
+            arp.address.family = SIGAR_AF_INET;
         }
-        else if ((status = inet_pton(AF_INET6, net_addr, &arp->address.addr)) > 0) {
-            arp->address.family = SIGAR_AF_INET6;
+        else if ((status = inet_pton(AF_INET6, net_addr, &arp.address.addr)) > 0) {
+            arp.address.family = SIGAR_AF_INET6;
         }
         else {
             sigar_log_printf(sigar, SIGAR_LOG_WARN,
                              "[arp] failed to parse address='%s' (%s)\n", net_addr,
                              ((status == 0) ? "Invalid format" : sigar_strerror(sigar, errno)));
-            --arplist->number;
             continue;
         }
 
         num = sscanf(hwaddr, "%02hhx:%02hhx:%02hhx:%02hhx:%02hhx:%02hhx",
-                     &arp->hwaddr.addr.mac[0],
-                     &arp->hwaddr.addr.mac[1],
-                     &arp->hwaddr.addr.mac[2],
-                     &arp->hwaddr.addr.mac[3],
-                     &arp->hwaddr.addr.mac[4],
-                     &arp->hwaddr.addr.mac[5]);
+                     &arp.hwaddr.addr.mac[0],
+                     &arp.hwaddr.addr.mac[1],
+                     &arp.hwaddr.addr.mac[2],
+                     &arp.hwaddr.addr.mac[3],
+                     &arp.hwaddr.addr.mac[4],
+                     &arp.hwaddr.addr.mac[5]);
         if (num < 6) {
             sigar_log_printf(sigar, SIGAR_LOG_WARN,
                              "[arp] failed to parse hwaddr='%s' (%s)\n", hwaddr);
-            --arplist->number;
             continue;
         }
-        arp->hwaddr.family = SIGAR_AF_LINK;
+        arp.hwaddr.family = SIGAR_AF_LINK;
 
-        SIGAR_SSTRCPY(arp->type, get_hw_type(type));
+        SIGAR_SSTRCPY(arp.type, get_hw_type(type));
+
+        if (walker->add_arp(walker, &arp) != SIGAR_OK) {
+            break;
+        }
     }
 
-    fclose(fp);
+    sigar_fclose(fp);
 
     return SIGAR_OK;
 }
 
-int sigar_proc_port_get(sigar_t *sigar, int protocol,
-                        unsigned long port, sigar_pid_t *pid)
+static int rtnl_ifindex_type(rtnl_ifindex_t *ifx)
+{
+    if (ifx->type < 0) {
+        char buffer[BUFSIZ];
+
+        snprintf(buffer, sizeof(buffer),
+                 "/sys/class/net/%s/type", ifx->name);
+
+        ifx->type = (sigar_file2str(buffer, buffer, sizeof(buffer)) == SIGAR_OK) ?
+            atoi(buffer) : ARPHRD_VOID;
+    }
+
+    return ifx->type;
+}
+
+/* kernel internal, include/net/neighbour.h */
+#ifndef NUD_VALID
+#define NUD_VALID \
+    (NUD_PERMANENT|NUD_NOARP|NUD_REACHABLE|NUD_PROBE|NUD_STALE|NUD_DELAY)
+#endif
+
+static int rtnl_neigh_handler(void *data, struct nlmsghdr *nlh)
+{
+    rtnl_walker_t *rtnl = data;
+    sigar_arp_walker_t *walker = rtnl->walker;
+    struct ndmsg *ndm = NLMSG_DATA(nlh);
+    struct rtattr *attr = (struct rtattr *)((char *)ndm +
+                                            NLMSG_ALIGN(sizeof(*ndm)));
+    int len = NLMSG_PAYLOAD(nlh, sizeof(*ndm));
+    int family = ndm->ndm_family;
+    rtnl_ifindex_t *ifx;
+    sigar_arp_t arp;
+
+    if ((nlh->nlmsg_type != RTM_NEWNEIGH) ||
+        !((family == AF_INET) || (family == AF_INET6)) ||
+        (ndm->ndm_state & NUD_NOARP)) /* hidden from /proc/net/arp too */
+    {
+        return SIGAR_OK;
+    }
+
+    SIGAR_ZERO(&arp);
+    arp.hwaddr.family = SIGAR_AF_LINK;
+
+    for (; RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        switch (attr->rta_type) {
+          case NDA_DST:
+            rtnl_address_set(&arp.address, family, attr);
+            break;
+          case NDA_LLADDR:
+            memcpy(arp.hwaddr.addr.mac, RTA_DATA(attr),
+                   RTA_PAYLOAD(attr) < sizeof(arp.hwaddr.addr.mac) ?
+                   RTA_PAYLOAD(attr) : sizeof(arp.hwaddr.addr.mac));
+            break;
+        }
+    }
+
+    if (!arp.address.family) {
+        return SIGAR_OK;
+    }
+
+    if (ndm->ndm_state & NUD_VALID) {
+        arp.flags |= ATF_COM;
+    }
+    if (ndm->ndm_state & NUD_PERMANENT) {
+        arp.flags |= ATF_PERM;
+    }
+
+    ifx = rtnl_ifindex_get(rtnl, ndm->ndm_ifindex);
+    SIGAR_SSTRCPY(arp.ifname, ifx->name);
+    SIGAR_SSTRCPY(arp.type, get_hw_type(rtnl_ifindex_type(ifx)));
+
+    rtnl->count++;
+
+    if (walker->add_arp(walker, &arp) != SIGAR_OK) {
+        rtnl->stopped = 1;
+        return !SIGAR_OK;
+    }
+
+    return SIGAR_OK;
+}
+
+int sigar_arp_walk(sigar_arp_walker_t *walker)
 {
+    sigar_t *sigar = walker->sigar;
     int status;
-    sigar_net_connection_t netconn;
-    DIR *dirp;
-    struct dirent *ent, dbuf;
 
-    SIGAR_ZERO(&netconn);
-    *pid = 0;
+    if (!PROC_NET_MIRRORED(sigar)) {
+        rtnl_walker_t rtnl;
 
-    status = sigar_net_connection_get(sigar, &netconn, port,
-                                      SIGAR_NETCONN_SERVER|protocol);
+        rtnl.walker = walker;
+        status = rtnl_dump(sigar, RTM_GETNEIGH,
+                           rtnl_family(walker->family),
+                           sizeof(struct ndmsg), rtnl_neigh_handler, &rtnl);
+
+        if ((status == SIGAR_OK) || rtnl.count) {
+            return status;
+        }
+
+        if (SIGAR_LOG_IS_DEBUG(sigar)) {
+            sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                             "[arp] RTM_GETNEIGH failed: %s",
+                             sigar_strerror(sigar, status));
+        }
+    }
+
+    return proc_net_arp_walk(walker);
+}
+
+static int arp_list_walker(sigar_arp_walker_t *walker,
+                           sigar_arp_t *arp)
+{
+    sigar_arp_list_t *arplist = walker->data;
+
+    SIGAR_ARP_LIST_GROW(arplist);
+    memcpy(&arplist->data[arplist->number++],
+           arp, sizeof(*arp));
+
+    return SIGAR_OK;
+}
+
+int sigar_arp_list_get(sigar_t *sigar,
+                       sigar_arp_list_t *arplist)
+{
+    sigar_arp_walker_t walker;
+    int status;
+
+    sigar_arp_list_create(sigar, arplist);
+
+    walker.sigar = sigar;
+    walker.family = SIGAR_AF_INET;
+    walker.data = arplist;
+    walker.add_arp = arp_list_walker;
+
+    status = sigar_arp_walk(&walker);
 
     if (status != SIGAR_OK) {
-        return status;
+        sigar_arp_list_destroy(sigar, arplist);
     }
 
-    if (netconn.local_port != port) {
-        return SIGAR_OK; /* XXX or ENOENT? */
+    return status;
+}
+
+#include <fcntl.h>
+
+#define SOCK_INODE_PREFIX "socket:["
+
+/*
+ * map every socket inode to the process and fd holding it,
+ * one readlinkat() per fd instead of a stat() per fd per lookup.
+ * entries not seen in the latest pass are left in the table with
+ * an older mtime and treated as missing.
+ * unlike the per-lookup scan this replaced, processes are not
+ * skipped by the uid of the socket: the one pass serves every
+ * socket, and the holder of a socket need not run as the uid that
+ * opened it (fds passed over unix sockets, setuid after bind).
+ */
+static int sock_owners_refresh(sigar_t *sigar, int force)
+{
+    DIR *dirp;
+    struct dirent *ent;
+    char path[SIGAR_PATH_MAX+1];
+    sigar_uint64_t timenow = sigar_time_now_millis();
+    unsigned long number = 0;
+
+    /* sock_owners_time can be ahead of the clock, see below */
+    if (!force && sigar->sock_owners &&
+        (timenow < sigar->sock_owners_time + SIGAR_BUFFER_EXPIRE))
+    {
+        return SIGAR_OK;
     }
 
-    if (!(dirp = opendir(PROCP_FS_ROOT))) {
+    if (!(dirp = opendir(SIGAR_ROOT_PATH(sigar, PROCP_FS_ROOT, path)))) {
         return errno;
     }
 
-    while (readdir_r(dirp, &dbuf, &ent) == 0) {
-        DIR *fd_dirp;
-        struct dirent *fd_ent, fd_dbuf;
-        struct stat sb;
-        char fd_name[BUFSIZ], pid_name[BUFSIZ];
-        int len, slen;
+    if (sigar_recording && !sigar->proc_root) {
+        sigar_record_dir(PROCP_FS_ROOT);
+    }
 
-        if (ent == NULL) {
-            break;
-        }
+    /* drop the stale entries once they outnumber the live ones */
+    if (sigar->sock_owners &&
+        (sigar->sock_owners->count > (sigar->sock_owners_number * 2) + 64))
+    {
+        sigar_cache_destroy(sigar->sock_owners);
+        sigar->sock_owners = NULL;
+    }
+    if (!sigar->sock_owners) {
+        sigar->sock_owners = sigar_cache_new(256);
+    }
 
-        if (!sigar_isdigit(*ent->d_name)) {
-            continue;
-        }
+    /* never equal to a previous pass, even within the same msec */
+    if (timenow <= sigar->sock_owners_time) {
+        timenow = sigar->sock_owners_time + 1;
+    }
+    sigar->sock_owners_time = timenow;
 
-        /* sprintf(pid_name, "/proc/%s", ent->d_name) */
-        memcpy(&pid_name[0], PROCP_FS_ROOT, SSTRLEN(PROCP_FS_ROOT));
-        len = SSTRLEN(PROCP_FS_ROOT);
-        pid_name[len++] = '/';
+    while ((ent = readdir(dirp))) {
+        DIR *fd_dirp;
+        struct dirent *fd_ent;
+        char fd_name[32];
+        sigar_pid_t pid;
+        int fd;
 
-        slen = strlen(ent->d_name);
-        memcpy(&pid_name[len], ent->d_name, slen);
-        len += slen;
-        pid_name[len] = '\0';
-        
-        if (stat(pid_name, &sb) < 0) {
-            continue;
-        }
-        if (sb.st_uid != netconn.uid) {
+        if (!sigar_isdigit(*ent->d_name)) {
             continue;
         }
 
-        /* sprintf(fd_name, "%s/fd", pid_name) */
-        memcpy(&fd_name[0], pid_name, len);
-        memcpy(&fd_name[len], "/fd", 3);
-        fd_name[len+=3] = '\0';
+        snprintf(fd_name, sizeof(fd_name), "%s/fd", ent->d_name);
 
-        if (!(fd_dirp = opendir(fd_name))) {
+        fd = openat(dirfd(dirp), fd_name, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+        if (fd < 0) {
+            continue; /* gone or not ours */
+        }
+        if (!(fd_dirp = fdopendir(fd))) {
+            close(fd);
             continue;
         }
 
-        while (readdir_r(fd_dirp, &fd_dbuf, &fd_ent) == 0) {
-            char fd_ent_name[BUFSIZ];
+        pid = strtoul(ent->d_name, NULL, 10);
 
-            if (fd_ent == NULL) {
-                break;
-            }
+        while ((fd_ent = readdir(fd_dirp))) {
+            char link[64], *ptr;
+            sigar_cache_entry_t *entry;
+            linux_sock_owner_t *owner;
+            sigar_uint64_t inode;
+            ssize_t len;
 
             if (!sigar_isdigit(*fd_ent->d_name)) {
                 continue;
             }
 
-            /* sprintf(fd_ent_name, "%s/%s", fd_name, fd_ent->d_name) */
-            slen = strlen(fd_ent->d_name);
-            memcpy(&fd_ent_name[0], fd_name, len);
-            fd_ent_name[len] = '/';
-            memcpy(&fd_ent_name[len+1], fd_ent->d_name, slen);
-            fd_ent_name[len+1+slen] = '\0';
-
-            if (stat(fd_ent_name, &sb) < 0) {
+            len = readlinkat(fd, fd_ent->d_name, link, sizeof(link)-1);
+            if ((len <= SSTRLEN(SOCK_INODE_PREFIX)) ||
+                !strnEQ(link, SOCK_INODE_PREFIX, SSTRLEN(SOCK_INODE_PREFIX)))
+            {
                 continue;
             }
+            link[len] = '\0';
+            ptr = link + SSTRLEN(SOCK_INODE_PREFIX);
+            inode = sigar_strtoull(ptr);
 
-            if (sb.st_ino == netconn.inode) {
-                closedir(fd_dirp);
-                closedir(dirp);
-                *pid = strtoul(ent->d_name, NULL, 10);
-                return SIGAR_OK;
+            entry = sigar_cache_get(sigar->sock_owners, inode);
+            if (!(owner = entry->value)) {
+                owner = entry->value = malloc(sizeof(*owner));
+            }
+            else if (owner->mtime == timenow) {
+                continue; /* shared with a forked child, keep the first */
             }
-            
+            owner->pid = pid;
+            owner->fd = strtoul(fd_ent->d_name, NULL, 10);
+            owner->mtime = timenow;
+            number++;
         }
 
         closedir(fd_dirp);
+
+        /* after closedir, see sigar_proc_fd_count */
+        if (sigar_recording && !sigar->proc_root) {
+            char fd_path[SIGAR_PATH_MAX+1];
+
+            snprintf(fd_path, sizeof(fd_path),
+                     PROCP_FS_ROOT "%s", fd_name);
+            sigar_record_dir(fd_path);
+        }
     }
 
     closedir(dirp);
 
+    sigar->sock_owners_number = number;
+
+    return SIGAR_OK;
+}
+
+/* the entry from the latest pass, pid 0 if that pass missed it */
+static linux_sock_owner_t *sock_owner_find(sigar_t *sigar,
+                                           sigar_uint64_t inode)
+{
+    sigar_cache_entry_t *entry =
+        sigar_cache_find(sigar->sock_owners, inode);
+    linux_sock_owner_t *owner;
+
+    if (!entry || !(owner = entry->value)) {
+        return NULL;
+    }
+    if (owner->mtime != sigar->sock_owners_time) {
+        return NULL; /* closed since */
+    }
+
+    return owner;
+}
+
+/*
+ * remember that the latest pass has no owner for inode, so looking
+ * it up again does not rescan /proc until the pass expires.
+ * the normal case for a socket of a process we cannot read.
+ */
+static void sock_owner_miss(sigar_t *sigar, sigar_uint64_t inode)
+{
+    sigar_cache_entry_t *entry =
+        sigar_cache_get(sigar->sock_owners, inode);
+    linux_sock_owner_t *owner;
+
+    if (!(owner = entry->value)) {
+        owner = entry->value = malloc(sizeof(*owner));
+    }
+    owner->pid = 0;
+    owner->fd = -1;
+    owner->mtime = sigar->sock_owners_time;
+}
+
+/*
+ * lookup in the cached index, rebuilding it once if the socket
+ * was opened after the last pass.
+ */
+static linux_sock_owner_t *sock_owner_get(sigar_t *sigar,
+                                          sigar_uint64_t inode,
+                                          int *rebuilt)
+{
+    linux_sock_owner_t *owner;
+    sigar_uint64_t last = sigar->sock_owners_time;
+
+    if (sock_owners_refresh(sigar, 0) != SIGAR_OK) {
+        return NULL;
+    }
+
+    if (!(owner = sock_owner_find(sigar, inode)) &&
+        (sigar->sock_owners_time == last) && !*rebuilt)
+    {
+        *rebuilt = 1;
+        if (sock_owners_refresh(sigar, 1) != SIGAR_OK) {
+            return NULL;
+        }
+        owner = sock_owner_find(sigar, inode);
+    }
+
+    if (!owner) {
+        sock_owner_miss(sigar, inode);
+        return NULL;
+    }
+
+    return owner->pid ? owner : NULL;
+}
+
+int sigar_proc_port_get(sigar_t *sigar, int protocol,
+                        unsigned long port, sigar_pid_t *pid)
+{
+    int status, rebuilt = 0;
+    sigar_net_connection_t netconn;
+    linux_sock_owner_t *owner;
+
+    SIGAR_ZERO(&netconn);
+    *pid = 0;
+
+    status = sigar_net_connection_get(sigar, &netconn, port,
+                                      SIGAR_NETCONN_SERVER|protocol);
+
+    if (status != SIGAR_OK) {
+        return status;
+    }
+
+    if (netconn.local_port != port) {
+        return SIGAR_OK; /* XXX or ENOENT? */
+    }
+
+    sigar_lock(sigar);
+    if ((owner = sock_owner_get(sigar, netconn.inode, &rebuilt))) {
+        *pid = owner->pid;
+    }
+    sigar_unlock(sigar);
+
+    return SIGAR_OK;
+}
+
+static int net_connection_proc_walker(sigar_net_connection_walker_t *walker,
+                                      sigar_net_connection_t *conn)
+{
+    sigar_net_connection_proc_list_t *connlist = walker->data;
+    sigar_net_connection_proc_t *entry;
+
+    SIGAR_NET_CONNPROC_LIST_GROW(connlist);
+    entry = &connlist->data[connlist->number++];
+    memcpy(&entry->conn, conn, sizeof(*conn));
+
+    return SIGAR_OK;
+}
+
+int sigar_os_net_connection_proc_list_get(sigar_t *sigar,
+                                          sigar_net_connection_proc_list_t *connlist,
+                                          int flags)
+{
+    int status, rebuilt = 0;
+    unsigned long i;
+    sigar_net_connection_walker_t walker;
+
+    sigar_net_connection_proc_list_create(connlist);
+
+    walker.sigar = sigar;
+    walker.flags = flags;
+    walker.data = connlist;
+    walker.add_connection = net_connection_proc_walker;
+
+    status = net_connection_walk(&walker, 0);
+
+    if (status != SIGAR_OK) {
+        sigar_net_connection_proc_list_destroy(sigar, connlist);
+        return status;
+    }
+
+    sigar_lock(sigar);
+
+    for (i=0; i<connlist->number; i++) {
+        sigar_net_connection_proc_t *entry = &connlist->data[i];
+        linux_sock_owner_t *owner = NULL;
+
+        /* time-wait and friends have no inode and no owner */
+        if (entry->conn.inode) {
+            owner = sock_owner_get(sigar, entry->conn.inode, &rebuilt);
+        }
+
+        if (owner) {
+            entry->pid = owner->pid;
+            entry->fd = owner->fd;
+        }
+        else {
+            entry->pid = 0;
+            entry->fd = -1;
+        }
+    }
+
+    sigar_unlock(sigar);
+
     return SIGAR_OK;
 }
 
@@ -49,6 +49,31 @@ typedef struct {
     int processor;
 } linux_proc_stat_t;
 
+typedef struct {
+    sigar_disk_io_t io;
+    sigar_uint64_t mtime;
+    unsigned int gen;
+    sigar_rate_state_t reads;
+    sigar_rate_state_t writes;
+    sigar_rate_state_t read_bytes;
+    sigar_rate_state_t write_bytes;
+    sigar_rate_state_t time;
+    sigar_rate_state_t qtime;
+} linux_disk_io_t;
+
+typedef struct {
+    sigar_file_system_t fs;
+    unsigned long mount_id;
+    unsigned long major;
+    unsigned long minor;
+} linux_mount_t;
+
+typedef struct {
+    sigar_pid_t pid; /* 0 if no fd we can read held it in the pass */
+    int fd;
+    sigar_uint64_t mtime;
+} linux_sock_owner_t;
+
 typedef enum {
     IOSTAT_NONE,
     IOSTAT_PARTITIONS, /* 2.4 */
@@ -64,11 +89,51 @@ struct sigar_t {
     linux_proc_stat_t last_proc_stat;
     int lcpu;
     linux_iostat_e iostat;
+    /* /proc/diskstats snapshot keyed by major:minor */
+    sigar_cache_t *diskstats;
+    sigar_uint64_t diskstats_time;
+    unsigned int diskstats_gen; /* of the last read, to sweep the rest */
+    /* /proc/self/mountinfo table, rebuilt when poll() reports POLLPRI */
+    int mountinfo_fd;
+    linux_mount_t *mounts;
+    unsigned long mounts_number;
+    unsigned long mounts_size;
+    /* socket inode -> owning pid/fd, from one pass over /proc/NNN/fd */
+    sigar_cache_t *sock_owners;
+    sigar_uint64_t sock_owners_time;
+    unsigned long sock_owners_number;
+    /* previous sigar_net_proto_counter_list_get, for deltas */
+    sigar_net_proto_counter_list_t proto_counters;
     char *proc_net;
+    /* on the handle a sigar_netns_* call reads /proc/PID/net through */
+    sigar_netns_t *netns;
+    /* proto_counters of other namespaces, keyed by namespace inode */
+    sigar_cache_t *netns_counters;
+    unsigned int netns_gen; /* of the last sigar_netns_list_get */
+    /* the handle sigar_netns_* reads run on, NULL while one is */
+    sigar_t *netns_sigar;
     /* Native POSIX Thread Library 2.6+ kernel */
     int has_nptl;
 };
 
+/* ARPHRD_* to SIGAR_NIC_*, sigar.c */
+void sigar_net_interface_type_set(sigar_net_interface_config_t *ifconfig,
+                                  int family);
+
+int sigar_mount_dev_name_get(sigar_t *sigar, dev_t dev,
+                             char *name, int len);
+
+struct nlmsghdr;
+
+/* return SIGAR_OK to keep reading, anything else stops the dump */
+typedef int (*sigar_netlink_handler_t)(void *data, struct nlmsghdr *nlh);
+
+/* counted as SIGAR_STATS_NETLINK_DUMP, on top of the call it is for */
+int sigar_netlink_dump(sigar_t *sigar, int protocol,
+                       struct nlmsghdr *req,
+                       sigar_netlink_handler_t handler,
+                       void *data);
+
 #define HAVE_STRERROR_R
 #ifndef __USE_XOPEN2K
 /* use gnu version of strerror_r */
@@ -41,7 +41,7 @@ int sigar_proc_psinfo_get(sigar_t *sigar, sigar_pid_t pid)
     sigar->last_pid = pid;
     sigar->last_getprocs = timenow;
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/psinfo");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/psinfo");
 
     if ((fd = open(buffer, O_RDONLY)) < 0) {
         return ESRCH;
@@ -61,7 +61,7 @@ int sigar_proc_usage_get(sigar_t *sigar, prusage_t *prusage, sigar_pid_t pid)
     int fd, retval = SIGAR_OK;
     char buffer[BUFSIZ];
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/usage");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/usage");
 
     if ((fd = open(buffer, O_RDONLY)) < 0) {
         return ESRCH;
@@ -81,7 +81,7 @@ int sigar_proc_status_get(sigar_t *sigar, pstatus_t *pstatus, sigar_pid_t pid)
     int fd, retval = SIGAR_OK;
     char buffer[BUFSIZ];
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/status");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/status");
 
     if ((fd = open(buffer, O_RDONLY)) < 0) {
         return ESRCH;
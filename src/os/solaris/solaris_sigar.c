@@ -188,7 +188,7 @@ char *sigar_os_error_string(sigar_t *sigar, int err)
     }
 }
 
-int sigar_mem_get(sigar_t *sigar, sigar_mem_t *mem)
+int sigar_os_mem_get(sigar_t *sigar, sigar_mem_t *mem)
 {
     kstat_ctl_t *kc = sigar->kc; 
     kstat_t *ksp;
@@ -245,7 +245,7 @@ int sigar_mem_get(sigar_t *sigar, sigar_mem_t *mem)
     return SIGAR_OK;
 }
 
-int sigar_swap_get(sigar_t *sigar, sigar_swap_t *swap)
+int sigar_os_swap_get(sigar_t *sigar, sigar_swap_t *swap)
 {
     kstat_t *ksp;
     kstat_named_t *kn;
@@ -387,7 +387,7 @@ static int get_chip_id(sigar_t *sigar, int processor)
     }
 }
 
-int sigar_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
+int sigar_os_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
 {
     int status, i;
 
@@ -413,7 +413,7 @@ int sigar_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
     return SIGAR_OK;
 }
 
-int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
+int sigar_os_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
 {
     kstat_ctl_t *kc = sigar->kc; 
     kstat_t *ksp;
@@ -429,7 +429,7 @@ int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
     if (cpulist == &sigar->cpulist) {
         if (sigar->cpulist.size == 0) {
             /* create once */
-            sigar_cpu_list_create(cpulist);
+            sigar_cpu_list_create(sigar, cpulist);
         }
         else {
             /* reset, re-using cpulist.data */
@@ -437,7 +437,7 @@ int sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
         }
     }
     else {
-        sigar_cpu_list_create(cpulist);
+        sigar_cpu_list_create(sigar, cpulist);
     }
 
     if (is_debug) {
@@ -688,8 +688,8 @@ int sigar_os_proc_list_get(sigar_t *sigar,
     return sigar_proc_list_procfs_get(sigar, proclist);
 }
 
-int sigar_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
-                       sigar_proc_mem_t *procmem)
+int sigar_os_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
+                          sigar_proc_mem_t *procmem)
 {
     int status = sigar_proc_psinfo_get(sigar, pid);
     psinfo_t *pinfo = sigar->pinfo;
@@ -755,8 +755,8 @@ int sigar_proc_cred_get(sigar_t *sigar, sigar_pid_t pid,
 #define TIMESTRUCT_2MSEC(t) \
     ((t.tv_sec * MILLISEC) + (t.tv_nsec / (NANOSEC/MILLISEC)))
 
-int sigar_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
-                        sigar_proc_time_t *proctime)
+int sigar_os_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
+                           sigar_proc_time_t *proctime)
 {
     prusage_t usage;
     int status;
@@ -790,8 +790,8 @@ int sigar_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
     return SIGAR_OK;
 }
 
-int sigar_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
-                         sigar_proc_state_t *procstate)
+int sigar_os_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
+                            sigar_proc_state_t *procstate)
 {
     int status = sigar_proc_psinfo_get(sigar, pid);
     psinfo_t *pinfo = sigar->pinfo;
@@ -956,7 +956,7 @@ int sigar_os_proc_args_get(sigar_t *sigar, sigar_pid_t pid,
 
     argv_size = sizeof(*argvp) * pinfo->pr_argc;
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/as");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/as");
 
     if ((fd = open(buffer, O_RDONLY)) < 0) {
         if ((errno == EACCES) && sigar->use_ucb_ps) {
@@ -1024,7 +1024,7 @@ int sigar_proc_env_get(sigar_t *sigar, sigar_pid_t pid,
     }
     pinfo = sigar->pinfo;
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/as");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/as");
 
     if ((fd = open(buffer, O_RDONLY)) < 0) {
         return PROC_ERRNO;
@@ -1091,17 +1091,17 @@ static int sigar_proc_path_exe_get(sigar_t *sigar, sigar_pid_t pid,
     /* solaris 10+ */
     char buffer[BUFSIZ];
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/path/a.out");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/path/a.out");
     if (!proc_readlink(buffer, procexe->name, sizeof(procexe->name))) {
         procexe->name[0] = '\0';
     }
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/path/cwd");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/path/cwd");
     if (!proc_readlink(buffer, procexe->cwd, sizeof(procexe->cwd))) {
         procexe->cwd[0] = '\0';
     }
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/path/root");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/path/root");
     if (!proc_readlink(buffer, procexe->root, sizeof(procexe->root))) {
         procexe->root[0] = '\0';
     }
@@ -1187,13 +1187,13 @@ int sigar_proc_exe_get(sigar_t *sigar, sigar_pid_t pid,
         /*XXX*/
     }
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/cwd");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/cwd");
 
     if (!sigar->pdirname(buffer, procexe->cwd, sizeof(procexe->cwd))) {
         procexe->cwd[0] = '\0';
     }
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/root");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/root");
 
     if (!(sigar->pdirname(buffer, procexe->root, sizeof(procexe->root)))) {
         procexe->root[0] = '\0';
@@ -1251,7 +1251,7 @@ static int sigar_pgrab_modules(sigar_t *sigar, sigar_pid_t pid,
     struct stat statbuf;
     char buffer[BUFSIZ];
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/xmap");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/xmap");
 
     if ((fd = open(buffer, O_RDONLY)) < 0) {
         return errno;
@@ -1370,8 +1370,8 @@ int sigar_os_fs_type_get(sigar_file_system_t *fsp)
     return fsp->type;
 }
 
-int sigar_file_system_list_get(sigar_t *sigar,
-                               sigar_file_system_list_t *fslist)
+int sigar_os_file_system_list_get(sigar_t *sigar,
+                                  sigar_file_system_list_t *fslist)
 {
     struct mnttab ent;
     sigar_file_system_t *fsp;
@@ -1381,7 +1381,7 @@ int sigar_file_system_list_get(sigar_t *sigar,
         return errno;
     }
 
-    sigar_file_system_list_create(fslist);
+    sigar_file_system_list_create(sigar, fslist);
 
     while (getmntent(fp, &ent) == 0) {
         if (strstr(ent.mnt_mntopts, "ignore")) {
@@ -1656,8 +1656,8 @@ static int simple_hash(const char *s)
     return hash;
 }
 
-int sigar_disk_usage_get(sigar_t *sigar, const char *name,
-                         sigar_disk_usage_t *disk)
+int sigar_os_disk_usage_get(sigar_t *sigar, const char *name,
+                            sigar_disk_usage_t *disk)
 {
     kstat_t *ksp;
     int status;
@@ -1907,7 +1907,7 @@ int sigar_net_route_list_get(sigar_t *sigar,
     size_t nread=0, size=0;
     const char *size_from;
 
-    sigar_net_route_list_create(routelist);
+    sigar_net_route_list_create(sigar, routelist);
 
     while ((rc = get_mib2(&sigar->mib2, &op, &data, &len)) == GET_MIB2_OK) {
         mib2_ipRouteEntry_t *entry;
@@ -2143,8 +2143,8 @@ static int sigar_net_ifstat_get_lo(sigar_t *sigar, const char *name,
     return sigar_net_ifstat_get_any(sigar, name, ifstat);
 }
 
-int sigar_net_interface_stat_get(sigar_t *sigar, const char *name,
-                                 sigar_net_interface_stat_t *ifstat)
+int sigar_os_net_interface_stat_get(sigar_t *sigar, const char *name,
+                                    sigar_net_interface_stat_t *ifstat)
 {
     ifstat->speed = SIGAR_FIELD_NOTIMPL;
 
@@ -2309,7 +2309,7 @@ static int udp_connection_get(sigar_net_connection_walker_t *walker,
     return SIGAR_OK;
 }
 
-int sigar_net_connection_walk(sigar_net_connection_walker_t *walker)
+int sigar_os_net_connection_walk(sigar_net_connection_walker_t *walker)
 {
     sigar_t *sigar = walker->sigar;
     int flags = walker->flags;
@@ -2515,7 +2515,7 @@ int sigar_arp_list_get(sigar_t *sigar,
     size_t nread=0, size=0;
     const char *size_from;
 
-    sigar_arp_list_create(arplist);
+    sigar_arp_list_create(sigar, arplist);
 
     while ((rc = get_mib2(&sigar->mib2, &op, &data, &len)) == GET_MIB2_OK) {
         mib2_ipNetToMediaEntry_t *entry;
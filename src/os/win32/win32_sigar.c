@@ -739,7 +739,7 @@ char *sigar_os_error_string(sigar_t *sigar, int err)
 #define sigar_GlobalMemoryStatusEx \
     sigar->kernel.memory_status.func
 
-SIGAR_DECLARE(int) sigar_mem_get(sigar_t *sigar, sigar_mem_t *mem)
+int sigar_os_mem_get(sigar_t *sigar, sigar_mem_t *mem)
 {
     DLLMOD_INIT(kernel, TRUE);
 
@@ -774,7 +774,7 @@ SIGAR_DECLARE(int) sigar_mem_get(sigar_t *sigar, sigar_mem_t *mem)
     return SIGAR_OK;
 }
 
-SIGAR_DECLARE(int) sigar_swap_get(sigar_t *sigar, sigar_swap_t *swap)
+int sigar_os_swap_get(sigar_t *sigar, sigar_swap_t *swap)
 {
     int status;
     DLLMOD_INIT(kernel, TRUE);
@@ -964,7 +964,7 @@ static int sigar_cpu_ntsys_get(sigar_t *sigar, sigar_cpu_t *cpu)
     return SIGAR_OK;
 }
 
-SIGAR_DECLARE(int) sigar_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
+int sigar_os_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
 {
     DLLMOD_INIT(ntdll, FALSE);
     if (sigar_NtQuerySystemInformation) {
@@ -998,7 +998,7 @@ static int sigar_cpu_list_perflib_get(sigar_t *sigar,
         inst = PdhNextInstance(inst);
     }
 
-    sigar_cpu_list_create(cpulist);
+    sigar_cpu_list_create(sigar, cpulist);
 
     /* verify there's a counter for each logical cpu */
     if (core_rollup && (sigar->ncpu != num)) {
@@ -1053,7 +1053,7 @@ static int sigar_cpu_list_ntsys_get(sigar_t *sigar,
     }
     num = retval/sizeof(info[0]);
 
-    sigar_cpu_list_create(cpulist);
+    sigar_cpu_list_create(sigar, cpulist);
 
     /* verify there's a counter for each logical cpu */
     if (core_rollup && (sigar->ncpu != num)) {
@@ -1088,8 +1088,8 @@ static int sigar_cpu_list_ntsys_get(sigar_t *sigar,
     return SIGAR_OK;
 }
 
-SIGAR_DECLARE(int) sigar_cpu_list_get(sigar_t *sigar,
-                                      sigar_cpu_list_t *cpulist)
+int sigar_os_cpu_list_get(sigar_t *sigar,
+                          sigar_cpu_list_t *cpulist)
 {
     DLLMOD_INIT(ntdll, FALSE);
     if (sigar_NtQuerySystemInformation) {
@@ -1267,8 +1267,8 @@ static HANDLE open_process(sigar_pid_t pid)
  * Pretty good explanation of counters:
  * http://www.semack.net/wiki/default.asp?db=SemackNetWiki&o=VirtualMemory
  */
-SIGAR_DECLARE(int) sigar_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
-                                      sigar_proc_mem_t *procmem)
+int sigar_os_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
+                          sigar_proc_mem_t *procmem)
 {
     int status = get_proc_info(sigar, pid);
     sigar_win32_pinfo_t *pinfo = &sigar->pinfo;
@@ -1402,8 +1402,13 @@ sigar_int64_t sigar_time_now_millis(void)
     return sigar_FileTimeToTime(&time) / 1000;
 }
 
-SIGAR_DECLARE(int) sigar_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
-                                       sigar_proc_time_t *proctime)
+sigar_uint64_t sigar_time_monotonic_millis(void)
+{
+    return GetTickCount64();
+}
+
+int sigar_os_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
+                           sigar_proc_time_t *proctime)
 {
     HANDLE proc = open_process(pid);
     FILETIME start_time, exit_time, system_time, user_time;
@@ -1441,8 +1446,8 @@ SIGAR_DECLARE(int) sigar_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
     return SIGAR_OK;
 }
 
-SIGAR_DECLARE(int) sigar_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
-					sigar_proc_state_t *procstate)
+int sigar_os_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
+                            sigar_proc_state_t *procstate)
 {
     int status = get_proc_info(sigar, pid);
     sigar_win32_pinfo_t *pinfo = &sigar->pinfo;
@@ -1603,7 +1608,7 @@ static int sigar_remote_proc_args_get(sigar_t *sigar, sigar_pid_t pid,
 }
 
 int sigar_os_proc_args_get(sigar_t *sigar, sigar_pid_t pid,
-                          sigar_proc_args_t *procargs)
+                           sigar_proc_args_t *procargs)
 {
     if (pid == sigar->pid) {
         return sigar_parse_proc_args(sigar, NULL, procargs);
@@ -1925,8 +1930,8 @@ static void get_fs_options(char *opts, int osize, long flags)
 #define sigar_WNetGetConnection \
     sigar->mpr.get_net_connection.func
 
-SIGAR_DECLARE(int) sigar_file_system_list_get(sigar_t *sigar,
-                                              sigar_file_system_list_t *fslist)
+int sigar_os_file_system_list_get(sigar_t *sigar,
+                                  sigar_file_system_list_t *fslist)
 {
     char name[256];
     char *ptr = name;
@@ -1939,7 +1944,7 @@ SIGAR_DECLARE(int) sigar_file_system_list_get(sigar_t *sigar,
         return GetLastError();
     }
 
-    sigar_file_system_list_create(fslist);
+    sigar_file_system_list_create(sigar, fslist);
 
     while (*ptr) {
         sigar_file_system_t *fsp;
@@ -2082,9 +2087,9 @@ static PERF_INSTANCE_DEFINITION *get_disk_instance(sigar_t *sigar,
     return PdhFirstInstance(object);
 }
 
-SIGAR_DECLARE(int) sigar_disk_usage_get(sigar_t *sigar,
-                                        const char *dirname,
-                                        sigar_disk_usage_t *disk)
+int sigar_os_disk_usage_get(sigar_t *sigar,
+                            const char *dirname,
+                            sigar_disk_usage_t *disk)
 {
     DWORD i, err;
     PERF_OBJECT_TYPE *object =
@@ -2641,8 +2646,7 @@ SIGAR_DECLARE(int) sigar_net_route_list_get(sigar_t *sigar,
         sigar_net_interface_list_get(sigar, NULL);
     }
 
-    sigar_net_route_list_create(routelist);
-    routelist->size = routelist->number = 0;
+    sigar_net_route_list_create(sigar, routelist);
 
     ipt = buffer;
 
@@ -3032,9 +3036,9 @@ sigar_net_interface_config_get(sigar_t *sigar,
     return SIGAR_OK;
 }
 
-SIGAR_DECLARE(int)
-sigar_net_interface_stat_get(sigar_t *sigar, const char *name,
-                             sigar_net_interface_stat_t *ifstat)
+int
+sigar_os_net_interface_stat_get(sigar_t *sigar, const char *name,
+                                sigar_net_interface_stat_t *ifstat)
 {
     MIB_IFROW *ifr;
     int status;
@@ -3235,8 +3239,7 @@ static int net_conn_get_udp(sigar_net_connection_walker_t *walker)
     return SIGAR_OK;
 }
 
-SIGAR_DECLARE(int)
-sigar_net_connection_walk(sigar_net_connection_walker_t *walker)
+int sigar_os_net_connection_walk(sigar_net_connection_walker_t *walker)
 {
     int status;
 
@@ -3424,7 +3427,7 @@ SIGAR_DECLARE(int) sigar_arp_list_get(sigar_t *sigar,
         return GetLastError();
     }
 
-    sigar_arp_list_create(arplist);
+    sigar_arp_list_create(sigar, arplist);
 
     if (!sigar->netif_names) {
         /* dwIndex -> name map */
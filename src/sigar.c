@@ -42,6 +42,50 @@
 #include "sigar_os.h"
 #include "sigar_format.h"
 
+#ifndef WIN32
+#include <pthread.h>
+
+#define SIGAR_THREAD_SHARDS 16
+
+typedef struct {
+    pthread_mutex_t lock;
+    sigar_cache_t *proc_cpu;
+    sigar_cache_t *proc_io;
+    sigar_cache_t *rates;
+} sigar_thread_shard_t;
+
+struct sigar_threads_t {
+    /* recursive, for all the state that is not sharded */
+    pthread_mutex_t lock;
+    pthread_key_t key;
+    /* every thread's scratch, whatever is left is freed by sigar_close */
+    sigar_thread_scratch_t *scratch;
+    /* proc_cpu and proc_io by pid, rates by entity */
+    sigar_thread_shard_t shards[SIGAR_THREAD_SHARDS];
+};
+#endif
+
+/* one per kind is enough for a poll that destroys what it got */
+struct sigar_list_pool_t {
+    struct {
+        void *data;
+        unsigned long size;
+    } kept[SIGAR_LIST_KINDS];
+};
+
+static void sigar_list_pool_free(sigar_list_pool_t *pool)
+{
+    int i;
+
+    for (i=0; i<SIGAR_LIST_KINDS; i++) {
+        if (pool->kept[i].data) {
+            free(pool->kept[i].data);
+        }
+    }
+
+    free(pool);
+}
+
 SIGAR_DECLARE(int) sigar_open(sigar_t **sigar)
 {
     int status = sigar_os_open(sigar);
@@ -62,16 +106,225 @@ SIGAR_DECLARE(int) sigar_open(sigar_t **sigar)
         (*sigar)->pids = NULL;
         (*sigar)->proc_cpu = NULL;
         (*sigar)->net_listen = NULL;
+        (*sigar)->net_listen_time = 0;
         (*sigar)->net_services_tcp = NULL;
         (*sigar)->net_services_udp = NULL;
 	(*sigar)->proc_io = NULL;
+        (*sigar)->rates = NULL;
+        (*sigar)->fs_pool = NULL;
+        (*sigar)->threads = NULL;
+        (*sigar)->stats_enabled = 0;
+        (*sigar)->stats = NULL;
+        (*sigar)->proc_root = NULL;
+        (*sigar)->sys_root = NULL;
+        (*sigar)->replay = NULL;
+        (*sigar)->list_pool = NULL;
+        (*sigar)->intern = NULL;
+
+        if (getenv("SIGAR_PROC_ROOT") || getenv("SIGAR_SYS_ROOT")) {
+            status = sigar_proc_root_set(*sigar,
+                                         getenv("SIGAR_PROC_ROOT"),
+                                         getenv("SIGAR_SYS_ROOT"));
+            if (status != SIGAR_OK) {
+                sigar_close(*sigar);
+                *sigar = NULL;
+            }
+        }
+    }
+
+    return status;
+}
+
+SIGAR_DECLARE(int) sigar_proc_root_set(sigar_t *sigar,
+                                       const char *proc_root,
+                                       const char *sys_root)
+{
+    int status;
+
+    sigar_lock(sigar);
+
+    if (sigar->proc_root) {
+        free(sigar->proc_root);
     }
+    if (sigar->sys_root) {
+        free(sigar->sys_root);
+    }
+    sigar->proc_root = proc_root ? sigar_strdup(proc_root) : NULL;
+    sigar->sys_root = sys_root ? sigar_strdup(sys_root) : NULL;
+
+    status = sigar_os_proc_root_set(sigar);
+
+    sigar_unlock(sigar);
 
     return status;
 }
 
+#if !defined(__linux__)
+/* only the procfs pid files follow the root, nothing cached from it */
+int sigar_os_proc_root_set(sigar_t *sigar)
+{
+    return SIGAR_OK;
+}
+#endif
+
+#ifndef WIN32
+/* a thread exited, the scratch is no longer needed */
+static void sigar_thread_scratch_free(void *data)
+{
+    sigar_thread_scratch_t *scratch = data, **ptr;
+    sigar_t *sigar = scratch->sigar;
+
+    sigar_lock(sigar);
+    for (ptr = &sigar->threads->scratch; *ptr; ptr = &(*ptr)->next) {
+        if (*ptr == scratch) {
+            *ptr = scratch->next;
+            break;
+        }
+    }
+    sigar_unlock(sigar);
+
+    if (scratch->os) {
+        free(scratch->os);
+    }
+    free(scratch);
+}
+#endif
+
+SIGAR_DECLARE(int) sigar_open_threadsafe(sigar_t **sigar)
+{
+#ifdef WIN32
+    return SIGAR_ENOTIMPL;
+#else
+    sigar_threads_t *threads;
+    pthread_mutexattr_t attr;
+    sigar_mem_t mem;
+    int i, status = sigar_open(sigar);
+
+    if (status != SIGAR_OK) {
+        return status;
+    }
+
+    /* host facts otherwise filled in on first use */
+    (void)sigar_cpu_core_count(*sigar);
+    (void)sigar_mem_get(*sigar, &mem);
+
+    threads = malloc(sizeof(*threads));
+    SIGAR_ZERO(threads);
+
+    if ((status = pthread_key_create(&threads->key,
+                                     sigar_thread_scratch_free)))
+    {
+        free(threads);
+        sigar_close(*sigar);
+        *sigar = NULL;
+        return status;
+    }
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&threads->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    for (i=0; i<SIGAR_THREAD_SHARDS; i++) {
+        pthread_mutex_init(&threads->shards[i].lock, NULL);
+    }
+
+    (*sigar)->threads = threads;
+
+    return SIGAR_OK;
+#endif
+}
+
+void sigar_lock(sigar_t *sigar)
+{
+#ifndef WIN32
+    if (sigar->threads) {
+        pthread_mutex_lock(&sigar->threads->lock);
+    }
+#endif
+}
+
+void sigar_unlock(sigar_t *sigar)
+{
+#ifndef WIN32
+    if (sigar->threads) {
+        pthread_mutex_unlock(&sigar->threads->lock);
+    }
+#endif
+}
+
+sigar_thread_scratch_t *sigar_thread_scratch_get(sigar_t *sigar)
+{
+#ifdef WIN32
+    return NULL;
+#else
+    sigar_threads_t *threads = sigar->threads;
+    sigar_thread_scratch_t *scratch;
+
+    if (!threads) {
+        return NULL;
+    }
+
+    if ((scratch = pthread_getspecific(threads->key))) {
+        return scratch;
+    }
+
+    scratch = malloc(sizeof(*scratch));
+    SIGAR_ZERO(scratch);
+    scratch->sigar = sigar;
+
+    sigar_lock(sigar);
+    scratch->next = threads->scratch;
+    threads->scratch = scratch;
+    sigar_unlock(sigar);
+
+    pthread_setspecific(threads->key, scratch);
+
+    return scratch;
+#endif
+}
+
+#ifndef WIN32
+static void sigar_threads_destroy(sigar_threads_t *threads)
+{
+    int i;
+
+    pthread_key_delete(threads->key);
+
+    while (threads->scratch) {
+        sigar_thread_scratch_t *scratch = threads->scratch;
+
+        threads->scratch = scratch->next;
+        if (scratch->os) {
+            free(scratch->os);
+        }
+        free(scratch);
+    }
+
+    for (i=0; i<SIGAR_THREAD_SHARDS; i++) {
+        sigar_thread_shard_t *shard = &threads->shards[i];
+
+        if (shard->proc_cpu) {
+            sigar_cache_destroy(shard->proc_cpu);
+        }
+        if (shard->proc_io) {
+            sigar_cache_destroy(shard->proc_io);
+        }
+        if (shard->rates) {
+            sigar_cache_destroy(shard->rates);
+        }
+        pthread_mutex_destroy(&shard->lock);
+    }
+
+    pthread_mutex_destroy(&threads->lock);
+    free(threads);
+}
+#endif
+
 SIGAR_DECLARE(int) sigar_close(sigar_t *sigar)
 {
+    sigar_replay_close(sigar);
+
     if (sigar->ifconf_buf) {
         free(sigar->ifconf_buf);
     }
@@ -100,6 +353,35 @@ SIGAR_DECLARE(int) sigar_close(sigar_t *sigar)
     if (sigar->proc_io) {
         sigar_cache_destroy(sigar->proc_io);
     }
+    if (sigar->rates) {
+        sigar_cache_destroy(sigar->rates);
+    }
+    if (sigar->fs_pool) {
+        sigar_fs_pool_destroy(sigar->fs_pool);
+    }
+    if (sigar->stats) {
+        sigar_stats_enable(sigar, 0);
+        free(sigar->stats);
+    }
+    if (sigar->proc_root) {
+        free(sigar->proc_root);
+    }
+    if (sigar->sys_root) {
+        free(sigar->sys_root);
+    }
+    if (sigar->intern) {
+        sigar_intern_destroy(sigar->intern);
+    }
+    if (sigar->list_pool) {
+        /* what sigar_os_close destroys is then just free()d */
+        sigar_list_pool_free(sigar->list_pool);
+        sigar->list_pool = NULL;
+    }
+#ifndef WIN32
+    if (sigar->threads) {
+        sigar_threads_destroy(sigar->threads);
+    }
+#endif
 
 
 
@@ -117,199 +399,547 @@ SIGAR_DECLARE(sigar_pid_t) sigar_pid_get(sigar_t *sigar)
 }
 #endif
 
-/* XXX: add clear() function */
-/* XXX: check for stale-ness using start_time */
-SIGAR_DECLARE(int) sigar_proc_cpu_get(sigar_t *sigar, sigar_pid_t pid,
-                                      sigar_proc_cpu_t *proccpu)
+/* the os implementations, instrumented */
+SIGAR_DECLARE(int) sigar_cpu_get(sigar_t *sigar, sigar_cpu_t *cpu)
 {
-    sigar_cache_entry_t *entry;
-    sigar_proc_cpu_t *prev;
-    sigar_uint64_t otime, time_now = sigar_time_now_millis();
-    sigar_uint64_t time_diff, total_diff;
-    int status;
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_cpu_get(sigar, cpu);
 
-    if (!sigar->proc_cpu) {
-        sigar->proc_cpu = sigar_expired_cache_new(128, PID_CACHE_CLEANUP_PERIOD, PID_CACHE_ENTRY_EXPIRE_PERIOD);
-    }
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_CPU, status);
+}
 
-    entry = sigar_cache_get(sigar->proc_cpu, pid);
-    if (entry->value) {
-        prev = (sigar_proc_cpu_t *)entry->value;
-    }
-    else {
-        prev = entry->value = malloc(sizeof(*prev));
-        SIGAR_ZERO(prev);
-    }
+SIGAR_DECLARE(int)
+sigar_cpu_list_get(sigar_t *sigar, sigar_cpu_list_t *cpulist)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_cpu_list_get(sigar, cpulist);
 
-    time_diff = time_now - prev->last_time;
-    proccpu->last_time = prev->last_time = time_now;
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_CPU_LIST, status);
+}
 
-    if (time_diff == 0) {
-        /* we were just called within < 1 second ago. */
-        memcpy(proccpu, prev, sizeof(*proccpu));
-        return SIGAR_OK;
-    }
+SIGAR_DECLARE(int) sigar_mem_get(sigar_t *sigar, sigar_mem_t *mem)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_mem_get(sigar, mem);
 
-    otime = prev->total;
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_MEM, status);
+}
 
-    status =
-        sigar_proc_time_get(sigar, pid,
-                            (sigar_proc_time_t *)proccpu);
+SIGAR_DECLARE(int) sigar_swap_get(sigar_t *sigar, sigar_swap_t *swap)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_swap_get(sigar, swap);
 
-    if (status != SIGAR_OK) {
-        return status;
-    }
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_SWAP, status);
+}
 
-    memcpy(prev, proccpu, sizeof(*prev));
+SIGAR_DECLARE(int) sigar_proc_state_get(sigar_t *sigar, sigar_pid_t pid,
+                                        sigar_proc_state_t *procstate)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_proc_state_get(sigar, pid, procstate);
 
-    if (proccpu->total < otime) {
-        /* XXX this should not happen */
-        otime = 0;
-    }
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_PROC_STATE, status);
+}
 
-    if (otime == 0) {
-        proccpu->percent = 0.0;
-        /* first time called */
-        return SIGAR_OK;
-    }
+SIGAR_DECLARE(int) sigar_proc_mem_get(sigar_t *sigar, sigar_pid_t pid,
+                                      sigar_proc_mem_t *procmem)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_proc_mem_get(sigar, pid, procmem);
 
-    total_diff = proccpu->total - otime;
-    proccpu->percent = total_diff / (double)time_diff;
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_PROC_MEM, status);
+}
 
-    return SIGAR_OK;
+SIGAR_DECLARE(int) sigar_proc_time_get(sigar_t *sigar, sigar_pid_t pid,
+                                       sigar_proc_time_t *proctime)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_proc_time_get(sigar, pid, proctime);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_PROC_TIME, status);
 }
-void copy_cached_disk_io_into_disk_io( sigar_cached_proc_disk_io_t *cached,  sigar_proc_disk_io_t *proc_disk_io) {
-   proc_disk_io->bytes_read = cached->bytes_read_diff;
-   proc_disk_io->bytes_written = cached->bytes_written_diff;
-   proc_disk_io->bytes_total = cached->bytes_total_diff;
+
+SIGAR_DECLARE(int)
+sigar_file_system_list_get(sigar_t *sigar,
+                           sigar_file_system_list_t *fslist)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_file_system_list_get(sigar, fslist);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_FILE_SYSTEM_LIST, status);
 }
 
-sigar_uint64_t get_io_diff(sigar_uint64_t current_value, sigar_uint64_t prev_value,  sigar_uint64_t time_diff) {
-   double io_diff;
-   sigar_uint64_t int_io_diff;
-   if ( current_value == SIGAR_FIELD_NOTIMPL ) {
-      return SIGAR_FIELD_NOTIMPL;
-   }
-   io_diff = (( current_value - prev_value)/(double)time_diff)*SIGAR_MSEC;
-   int_io_diff = (sigar_uint64_t)io_diff;
-   if (int_io_diff >=0) {
-      return int_io_diff;
-   }
-   return 0;
+SIGAR_DECLARE(int) sigar_disk_usage_get(sigar_t *sigar, const char *name,
+                                        sigar_disk_usage_t *disk)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_disk_usage_get(sigar, name, disk);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_DISK_USAGE, status);
 }
 
-void calculate_io_diff(sigar_proc_cumulative_disk_io_t * proc_disk_io, sigar_cached_proc_disk_io_t *cached,  sigar_uint64_t time_diff, int is_first_time) {
-   /*calculate avg diff /read/write/total per second*/
-   if (!is_first_time) {
-       cached->bytes_written_diff = get_io_diff(proc_disk_io->bytes_written, cached->bytes_written, time_diff);
-       cached->bytes_read_diff = get_io_diff(proc_disk_io->bytes_read, cached->bytes_read, time_diff);
-       cached->bytes_total_diff = get_io_diff(proc_disk_io->bytes_total, cached->bytes_total, time_diff);
-   }
-   else {
-       cached->bytes_total_diff =  cached->bytes_read_diff =  cached->bytes_written_diff = 0.0;
-   }
-   // now put in cache the current cumulative values
-   cached->bytes_written = proc_disk_io->bytes_written;
-   cached->bytes_read = proc_disk_io->bytes_read;
-   cached->bytes_total = proc_disk_io->bytes_total;
+SIGAR_DECLARE(int)
+sigar_net_interface_stat_get(sigar_t *sigar, const char *name,
+                             sigar_net_interface_stat_t *ifstat)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_net_interface_stat_get(sigar, name, ifstat);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_INTERFACE_STAT, status);
 }
 
-SIGAR_DECLARE(int) sigar_proc_disk_io_get(sigar_t *sigar, sigar_pid_t pid,
-                                          sigar_proc_disk_io_t *proc_disk_io)
+SIGAR_DECLARE(int)
+sigar_net_interface_stat_list_get(sigar_t *sigar,
+                                  sigar_net_interface_stat_list_t *iflist)
 {
-    sigar_cache_entry_t *entry;
-    sigar_cached_proc_disk_io_t *prev;
-    sigar_proc_cumulative_disk_io_t  cumulative_proc_disk_io;
-    sigar_uint64_t time_now = sigar_time_now_millis();
-    sigar_uint64_t time_diff;
-    int status, is_first_time;
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_net_interface_stat_list_get(sigar, iflist);
 
-    if (!sigar->proc_io) {
-        sigar->proc_io =  sigar_expired_cache_new(128, PID_CACHE_CLEANUP_PERIOD, PID_CACHE_ENTRY_EXPIRE_PERIOD);
-    }
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_INTERFACE_STAT_LIST,
+                           status);
+}
 
-    entry = sigar_cache_get(sigar->proc_io, pid);
-    if (entry->value) {
-        prev = (sigar_cached_proc_disk_io_t *)entry->value;
-    }
-    else {
-        prev = entry->value = malloc(sizeof(*prev));
-        SIGAR_ZERO(prev);
-    }
-    is_first_time = (prev->last_time == 0);
-    time_diff = time_now - prev->last_time;
+SIGAR_DECLARE(int)
+sigar_net_interface_config_list_get(sigar_t *sigar,
+                                    sigar_net_interface_config_list_t *iflist)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_net_interface_config_list_get(sigar, iflist);
 
-    if (time_diff < 1000) {
-        /* we were just called within < 1 second ago. */
-        copy_cached_disk_io_into_disk_io(prev, proc_disk_io);
-	if (time_diff < 0) {
-	   // something is wrong at least from now on the time will be ok
- 	   prev->last_time = time_now;
-        }
-        return SIGAR_OK;
-    }
-    prev->last_time = time_now;
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_INTERFACE_CONFIG_LIST,
+                           status);
+}
 
+SIGAR_DECLARE(int)
+sigar_net_interface_address_list_get(sigar_t *sigar,
+                                     sigar_net_interface_address_list_t *addrlist)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_net_interface_address_list_get(sigar, addrlist);
 
-    status =
-        sigar_proc_cumulative_disk_io_get(sigar, pid,
-                            &cumulative_proc_disk_io);
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_INTERFACE_ADDRESS_LIST,
+                           status);
+}
 
-    if (status != SIGAR_OK) {
-        return status;
-    }
-    calculate_io_diff(&cumulative_proc_disk_io, prev, time_diff,  is_first_time);
-    copy_cached_disk_io_into_disk_io(prev, proc_disk_io);
-    return SIGAR_OK;
+SIGAR_DECLARE(int)
+sigar_net_connection_walk(sigar_net_connection_walker_t *walker)
+{
+    sigar_t *sigar = walker->sigar;
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_net_connection_walk(walker);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_CONNECTION_WALK, status);
 }
 
-void get_cache_info(sigar_cache_t * cache, char * name){
-   if (cache == NULL) {
-      return;
-   }
+SIGAR_DECLARE(int)
+sigar_net_connection_list_get(sigar_t *sigar,
+                              sigar_net_connection_list_t *connlist,
+                              int flags)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_net_connection_list_get(sigar, connlist, flags);
 
-   printf("******** %s *********\n", name);
-   sigar_cache_dump(cache);
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_CONNECTION_LIST, status);
 }
 
-SIGAR_DECLARE(int) sigar_dump_pid_cache_get(sigar_t *sigar, sigar_dump_pid_cache_t *info) {
-  
-  get_cache_info(sigar->proc_cpu, "proc cpu cache");
-  get_cache_info(sigar->proc_io, "proc io cache");
-  return SIGAR_OK;
+SIGAR_DECLARE(int)
+sigar_net_unix_connection_list_get(sigar_t *sigar,
+                                   sigar_net_unix_connection_list_t *connlist,
+                                   int flags)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status =
+        sigar_os_net_unix_connection_list_get(sigar, connlist, flags);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_UNIX_CONNECTION_LIST,
+                           status);
 }
 
-SIGAR_DECLARE(int) sigar_proc_stat_get(sigar_t *sigar,
-                                       sigar_proc_stat_t *procstat)
+SIGAR_DECLARE(int)
+sigar_net_connection_info_list_get(sigar_t *sigar,
+                                   sigar_net_connection_info_list_t *connlist,
+                                   int flags)
 {
-    int status, i;
-    sigar_proc_list_t *pids;
+    SIGAR_STATS_BEGIN(sigar);
+    int status =
+        sigar_os_net_connection_info_list_get(sigar, connlist, flags);
 
-    SIGAR_ZERO(procstat);
-    procstat->threads = SIGAR_FIELD_NOTIMPL;
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_CONNECTION_INFO_LIST,
+                           status);
+}
 
-    if ((status = sigar_proc_list_get(sigar, NULL)) != SIGAR_OK) {
-        return status;
-    }
+SIGAR_DECLARE(int)
+sigar_net_port_tcp_info_list_get(sigar_t *sigar,
+                                 sigar_net_port_tcp_info_list_t *portlist)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_net_port_tcp_info_list_get(sigar, portlist);
 
-    pids = sigar->pids;
-    procstat->total = pids->number;
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_PORT_TCP_INFO_LIST,
+                           status);
+}
 
-    for (i=0; i<pids->number; i++) {
-        sigar_proc_state_t state;
+SIGAR_DECLARE(int)
+sigar_net_connection_proc_list_get(sigar_t *sigar,
+                                   sigar_net_connection_proc_list_t *connlist,
+                                   int flags)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status =
+        sigar_os_net_connection_proc_list_get(sigar, connlist, flags);
 
-        status = sigar_proc_state_get(sigar, pids->data[i], &state);
-        if (status != SIGAR_OK) {
-            continue;
-        }
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_CONNECTION_PROC_LIST,
+                           status);
+}
 
-        if (state.threads != SIGAR_FIELD_NOTIMPL) {
-            procstat->threads += state.threads;
-        }
+SIGAR_DECLARE(int)
+sigar_net_proto_counter_list_get(sigar_t *sigar,
+                                 sigar_net_proto_counter_list_t *counters)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_net_proto_counter_list_get(sigar, counters);
 
-        switch (state.state) {
-          case SIGAR_PROC_STATE_IDLE:
-            procstat->idle++;
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_PROTO_COUNTER_LIST,
+                           status);
+}
+
+SIGAR_DECLARE(int)
+sigar_netns_list_get(sigar_t *sigar,
+                     sigar_netns_list_t *netnslist)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_netns_list_get(sigar, netnslist);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NETNS_LIST, status);
+}
+
+SIGAR_DECLARE(int)
+sigar_netns_interface_stat_list_get(sigar_t *sigar,
+                                    sigar_netns_t *netns,
+                                    sigar_net_interface_stat_list_t *iflist)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status =
+        sigar_os_netns_interface_stat_list_get(sigar, netns, iflist);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NETNS_INTERFACE_STAT_LIST,
+                           status);
+}
+
+SIGAR_DECLARE(int)
+sigar_netns_connection_list_get(sigar_t *sigar,
+                                sigar_netns_t *netns,
+                                sigar_net_connection_list_t *connlist,
+                                int flags)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status =
+        sigar_os_netns_connection_list_get(sigar, netns, connlist, flags);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NETNS_CONNECTION_LIST,
+                           status);
+}
+
+SIGAR_DECLARE(int)
+sigar_netns_proto_counter_list_get(sigar_t *sigar,
+                                   sigar_netns_t *netns,
+                                   sigar_net_proto_counter_list_t *counters)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status =
+        sigar_os_netns_proto_counter_list_get(sigar, netns, counters);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NETNS_PROTO_COUNTER_LIST,
+                           status);
+}
+
+SIGAR_DECLARE(int) sigar_disk_io_list_get(sigar_t *sigar,
+                                          sigar_disk_io_list_t *disklist)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = sigar_os_disk_io_list_get(sigar, disklist);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_DISK_IO_LIST, status);
+}
+
+sigar_cache_t **sigar_shard_cache_lock(sigar_t *sigar, sigar_uint64_t key,
+                                       int type)
+{
+#ifndef WIN32
+    if (sigar->threads) {
+        sigar_thread_shard_t *shard =
+            &sigar->threads->shards[key % SIGAR_THREAD_SHARDS];
+
+        pthread_mutex_lock(&shard->lock);
+
+        switch (type) {
+          case SIGAR_SHARD_PROC_CPU:
+            return &shard->proc_cpu;
+          case SIGAR_SHARD_PROC_IO:
+            return &shard->proc_io;
+          default:
+            return &shard->rates;
+        }
+    }
+#endif
+
+    switch (type) {
+      case SIGAR_SHARD_PROC_CPU:
+        return &sigar->proc_cpu;
+      case SIGAR_SHARD_PROC_IO:
+        return &sigar->proc_io;
+      default:
+        return &sigar->rates;
+    }
+}
+
+void sigar_shard_cache_unlock(sigar_t *sigar, sigar_uint64_t key)
+{
+#ifndef WIN32
+    if (sigar->threads) {
+        pthread_mutex_unlock(&sigar->threads->shards[key % SIGAR_THREAD_SHARDS].lock);
+    }
+#endif
+}
+
+/* the proc_cpu or proc_io cache for pid, its shard locked if threadsafe */
+static sigar_cache_t *proc_cache_lock(sigar_t *sigar, sigar_pid_t pid,
+                                      int type)
+{
+    sigar_cache_t **cache = sigar_shard_cache_lock(sigar, pid, type);
+
+    if (!*cache) {
+        *cache = sigar_expired_cache_new(128, PID_CACHE_CLEANUP_PERIOD, PID_CACHE_ENTRY_EXPIRE_PERIOD);
+    }
+
+    return *cache;
+}
+
+typedef struct {
+    sigar_proc_cpu_t cpu;
+    sigar_rate_state_t total;
+} proc_cpu_cache_t;
+
+/* XXX: add clear() function */
+static int proc_cpu_get(sigar_t *sigar, sigar_cache_t *cache,
+                        sigar_pid_t pid, sigar_proc_cpu_t *proccpu)
+{
+    sigar_cache_entry_t *entry;
+    proc_cpu_cache_t *prev;
+    sigar_uint64_t now = sigar_time_monotonic_millis();
+    sigar_rate_t rate;
+    int status;
+
+    entry = sigar_cache_get(cache, pid);
+    if (entry->value) {
+        prev = (proc_cpu_cache_t *)entry->value;
+    }
+    else {
+        prev = entry->value = malloc(sizeof(*prev));
+        SIGAR_ZERO(prev);
+    }
+
+    if (now == prev->total.time) {
+        /* we were just called within < 1 msec ago. */
+        memcpy(proccpu, &prev->cpu, sizeof(*proccpu));
+        return SIGAR_OK;
+    }
+
+    status =
+        sigar_proc_time_get(sigar, pid,
+                            (sigar_proc_time_t *)proccpu);
+
+    if (status != SIGAR_OK) {
+        return status;
+    }
+
+    /* total going back means pid was reused, percent is 0 until next time */
+    sigar_rate_update(&prev->total, proccpu->total, now, 0, &rate);
+
+    proccpu->last_time = sigar_time_now_millis();
+    /* total is in msec, so msec per sec of cpu */
+    proccpu->percent = rate.rate / SIGAR_MSEC;
+
+    memcpy(&prev->cpu, proccpu, sizeof(prev->cpu));
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_proc_cpu_get(sigar_t *sigar, sigar_pid_t pid,
+                                      sigar_proc_cpu_t *proccpu)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    sigar_cache_t *cache = proc_cache_lock(sigar, pid, SIGAR_SHARD_PROC_CPU);
+    int status = proc_cpu_get(sigar, cache, pid, proccpu);
+
+    sigar_shard_cache_unlock(sigar, pid);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_PROC_CPU, status);
+}
+
+typedef struct {
+    sigar_proc_disk_io_t io; /* per sec, as last returned */
+    sigar_rate_state_t bytes_read;
+    sigar_rate_state_t bytes_written;
+    sigar_rate_state_t bytes_total;
+} proc_io_cache_t;
+
+static sigar_uint64_t proc_io_rate(sigar_rate_state_t *state,
+                                   sigar_uint64_t value,
+                                   sigar_uint64_t now)
+{
+    sigar_rate_t rate;
+
+    if (value == SIGAR_FIELD_NOTIMPL) {
+        return SIGAR_FIELD_NOTIMPL;
+    }
+
+    sigar_rate_update(state, value, now, 0, &rate);
+
+    return (sigar_uint64_t)rate.rate;
+}
+
+static int proc_disk_io_get(sigar_t *sigar, sigar_cache_t *cache,
+                            sigar_pid_t pid,
+                            sigar_proc_disk_io_t *proc_disk_io)
+{
+    sigar_cache_entry_t *entry;
+    proc_io_cache_t *prev;
+    sigar_proc_cumulative_disk_io_t cumulative;
+    sigar_uint64_t now = sigar_time_monotonic_millis();
+    int status;
+
+    entry = sigar_cache_get(cache, pid);
+    if (entry->value) {
+        prev = (proc_io_cache_t *)entry->value;
+    }
+    else {
+        prev = entry->value = malloc(sizeof(*prev));
+        SIGAR_ZERO(prev);
+    }
+
+    if (now == prev->bytes_total.time) {
+        memcpy(proc_disk_io, &prev->io, sizeof(*proc_disk_io));
+        return SIGAR_OK;
+    }
+
+    status =
+        sigar_proc_cumulative_disk_io_get(sigar, pid, &cumulative);
+
+    if (status != SIGAR_OK) {
+        return status;
+    }
+
+    /* bytes per sec since the previous call, 0 the first time */
+    prev->io.bytes_read =
+        proc_io_rate(&prev->bytes_read, cumulative.bytes_read, now);
+    prev->io.bytes_written =
+        proc_io_rate(&prev->bytes_written, cumulative.bytes_written, now);
+    prev->io.bytes_total =
+        proc_io_rate(&prev->bytes_total, cumulative.bytes_total, now);
+
+    memcpy(proc_disk_io, &prev->io, sizeof(*proc_disk_io));
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_proc_disk_io_get(sigar_t *sigar, sigar_pid_t pid,
+                                          sigar_proc_disk_io_t *proc_disk_io)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    sigar_cache_t *cache = proc_cache_lock(sigar, pid, SIGAR_SHARD_PROC_IO);
+    int status = proc_disk_io_get(sigar, cache, pid, proc_disk_io);
+
+    sigar_shard_cache_unlock(sigar, pid);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_PROC_DISK_IO, status);
+}
+
+void get_cache_info(sigar_cache_t * cache, char * name){
+   if (cache == NULL) {
+      return;
+   }
+
+   printf("******** %s *********\n", name);
+   sigar_cache_dump(cache);
+}
+
+SIGAR_DECLARE(int) sigar_dump_pid_cache_get(sigar_t *sigar, sigar_dump_pid_cache_t *info) {
+  
+  get_cache_info(sigar->proc_cpu, "proc cpu cache");
+  get_cache_info(sigar->proc_io, "proc io cache");
+#ifndef WIN32
+  if (sigar->threads) {
+      int i;
+      for (i=0; i<SIGAR_THREAD_SHARDS; i++) {
+          sigar_thread_shard_t *shard = &sigar->threads->shards[i];
+          pthread_mutex_lock(&shard->lock);
+          get_cache_info(shard->proc_cpu, "proc cpu cache shard");
+          get_cache_info(shard->proc_io, "proc io cache shard");
+          pthread_mutex_unlock(&shard->lock);
+      }
+  }
+#endif
+  return SIGAR_OK;
+}
+
+void sigar_stats_shards(sigar_t *sigar, sigar_stats_t *stats)
+{
+#ifndef WIN32
+    int i;
+
+    if (!sigar->threads) {
+        return;
+    }
+
+    for (i=0; i<SIGAR_THREAD_SHARDS; i++) {
+        sigar_thread_shard_t *shard = &sigar->threads->shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+        sigar_stats_cache(stats, "proc_cpu", shard->proc_cpu);
+        sigar_stats_cache(stats, "proc_io", shard->proc_io);
+        sigar_stats_cache(stats, "rates", shard->rates);
+        pthread_mutex_unlock(&shard->lock);
+    }
+#endif
+}
+
+static int proc_stat_get(sigar_t *sigar, sigar_proc_stat_t *procstat)
+{
+    int status, i;
+    sigar_proc_list_t proclist, *pids;
+
+    SIGAR_ZERO(procstat);
+    procstat->threads = SIGAR_FIELD_NOTIMPL;
+
+    /* sigar->pids is shared, threads get a list of their own */
+    pids = sigar->threads ? &proclist : NULL;
+
+    if ((status = sigar_proc_list_get(sigar, pids)) != SIGAR_OK) {
+        return status;
+    }
+
+    if (!pids) {
+        pids = sigar->pids;
+    }
+    procstat->total = pids->number;
+
+    for (i=0; i<pids->number; i++) {
+        sigar_proc_state_t state;
+
+        status = sigar_proc_state_get(sigar, pids->data[i], &state);
+        if (status != SIGAR_OK) {
+            continue;
+        }
+
+        if (state.threads != SIGAR_FIELD_NOTIMPL) {
+            procstat->threads += state.threads;
+        }
+
+        switch (state.state) {
+          case SIGAR_PROC_STATE_IDLE:
+            procstat->idle++;
             break;
           case SIGAR_PROC_STATE_RUN:
             procstat->running++;
@@ -328,9 +958,22 @@ SIGAR_DECLARE(int) sigar_proc_stat_get(sigar_t *sigar,
         }
     }
 
+    if (pids == &proclist) {
+        sigar_proc_list_destroy(sigar, pids);
+    }
+
     return SIGAR_OK;
 }
 
+SIGAR_DECLARE(int) sigar_proc_stat_get(sigar_t *sigar,
+                                       sigar_proc_stat_t *procstat)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = proc_stat_get(sigar, procstat);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_PROC_STAT, status);
+}
+
 SIGAR_DECLARE(int) sigar_sys_info_get(sigar_t *sigar,
                                       sigar_sys_info_t *sysinfo)
 {
@@ -394,21 +1037,87 @@ sigar_proc_cred_name_get(sigar_t *sigar, sigar_pid_t pid,
 
 #endif /* WIN32 */
 
-int sigar_proc_list_create(sigar_proc_list_t *proclist)
+SIGAR_DECLARE(int) sigar_list_recycle_set(sigar_t *sigar, int enable)
+{
+    sigar_lock(sigar);
+
+    if (enable && !sigar->list_pool) {
+        sigar->list_pool = malloc(sizeof(*sigar->list_pool));
+        SIGAR_ZERO(sigar->list_pool);
+    }
+    else if (!enable && sigar->list_pool) {
+        sigar_list_pool_free(sigar->list_pool);
+        sigar->list_pool = NULL;
+    }
+
+    sigar_unlock(sigar);
+
+    return SIGAR_OK;
+}
+
+void *sigar_list_alloc(sigar_t *sigar, int kind, size_t elt_size,
+                       unsigned long *size)
+{
+    sigar_list_pool_t *pool;
+    void *data = NULL;
+
+    sigar_lock(sigar);
+    if ((pool = sigar->list_pool) && pool->kept[kind].data) {
+        data = pool->kept[kind].data;
+        if (pool->kept[kind].size > *size) {
+            *size = pool->kept[kind].size;
+        }
+        pool->kept[kind].data = NULL;
+        pool->kept[kind].size = 0;
+    }
+    sigar_unlock(sigar);
+
+    if (data) {
+        return data;
+    }
+
+    return malloc(elt_size * *size);
+}
+
+void sigar_list_free(sigar_t *sigar, int kind, void *data,
+                     unsigned long size)
+{
+    sigar_list_pool_t *pool;
+
+    sigar_lock(sigar);
+    if ((pool = sigar->list_pool) && (pool->kept[kind].size < size)) {
+        /* the larger of the two is the one worth keeping */
+        void *smaller = pool->kept[kind].data;
+
+        pool->kept[kind].data = data;
+        pool->kept[kind].size = size;
+        data = smaller;
+    }
+    sigar_unlock(sigar);
+
+    if (data) {
+        free(data);
+    }
+}
+
+int sigar_proc_list_create(sigar_t *sigar, sigar_proc_list_t *proclist)
 {
     proclist->number = 0;
     proclist->size = SIGAR_PROC_LIST_MAX;
-    proclist->data = malloc(sizeof(*(proclist->data)) *
-                            proclist->size);
+    proclist->data = sigar_list_alloc(sigar, SIGAR_LIST_PROC,
+                                      sizeof(*(proclist->data)),
+                                      &proclist->size);
     return SIGAR_OK;
 }
 
 int sigar_proc_list_grow(sigar_proc_list_t *proclist)
 {
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(proclist->size, SIGAR_PROC_LIST_MAX);
+
     proclist->data = realloc(proclist->data,
-                             sizeof(*(proclist->data)) *
-                             (proclist->size + SIGAR_PROC_LIST_MAX));
-    proclist->size += SIGAR_PROC_LIST_MAX;
+                             sizeof(*(proclist->data)) * size);
+    proclist->size = size;
 
     return SIGAR_OK;
 }
@@ -417,7 +1126,7 @@ SIGAR_DECLARE(int) sigar_proc_list_destroy(sigar_t *sigar,
                                            sigar_proc_list_t *proclist)
 {
     if (proclist->size) {
-        free(proclist->data);
+        sigar_list_free(sigar, SIGAR_LIST_PROC, proclist->data, proclist->size);
         proclist->number = proclist->size = 0;
     }
 
@@ -427,11 +1136,14 @@ SIGAR_DECLARE(int) sigar_proc_list_destroy(sigar_t *sigar,
 SIGAR_DECLARE(int) sigar_proc_list_get(sigar_t *sigar,
                                        sigar_proc_list_t *proclist)
 {
+    SIGAR_STATS_BEGIN(sigar);
+    int status;
+
     if (proclist == NULL) {
         /* internal re-use */
         if (sigar->pids == NULL) {
             sigar->pids = malloc(sizeof(*sigar->pids));
-            sigar_proc_list_create(sigar->pids);
+            sigar_proc_list_create(sigar, sigar->pids);
         }
         else {
             sigar->pids->number = 0;
@@ -439,10 +1151,12 @@ SIGAR_DECLARE(int) sigar_proc_list_get(sigar_t *sigar,
         proclist = sigar->pids;
     }
     else {
-        sigar_proc_list_create(proclist);
+        sigar_proc_list_create(sigar, proclist);
     }
 
-    return sigar_os_proc_list_get(sigar, proclist);
+    status = sigar_os_proc_list_get(sigar, proclist);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_PROC_LIST, status);
 }
 
 int sigar_proc_args_create(sigar_proc_args_t *procargs)
@@ -456,10 +1170,12 @@ int sigar_proc_args_create(sigar_proc_args_t *procargs)
 
 int sigar_proc_args_grow(sigar_proc_args_t *procargs)
 {
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(procargs->size, SIGAR_PROC_ARGS_MAX);
+
     procargs->data = realloc(procargs->data,
-                             sizeof(*(procargs->data)) *
-                             (procargs->size + SIGAR_PROC_ARGS_MAX));
-    procargs->size += SIGAR_PROC_ARGS_MAX;
+                             sizeof(*(procargs->data)) * size);
+    procargs->size = size;
 
     return SIGAR_OK;
 }
@@ -484,30 +1200,34 @@ SIGAR_DECLARE(int) sigar_proc_args_get(sigar_t *sigar,
                                        sigar_pid_t pid,
                                        sigar_proc_args_t *procargs)
 {
+    SIGAR_STATS_BEGIN(sigar);
     int status;
     sigar_proc_args_create(procargs);
     status = sigar_os_proc_args_get(sigar, pid, procargs);
     if (status != SIGAR_OK) {
         sigar_proc_args_destroy(sigar, procargs);
     }
-    return status;
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_PROC_ARGS, status);
 }
 
-int sigar_file_system_list_create(sigar_file_system_list_t *fslist)
+int sigar_file_system_list_create(sigar_t *sigar, sigar_file_system_list_t *fslist)
 {
     fslist->number = 0;
     fslist->size = SIGAR_FS_MAX;
-    fslist->data = malloc(sizeof(*(fslist->data)) *
-                          fslist->size);
+    fslist->data = sigar_list_alloc(sigar, SIGAR_LIST_FS,
+                                    sizeof(*(fslist->data)),
+                                    &fslist->size);
     return SIGAR_OK;
 }
 
 int sigar_file_system_list_grow(sigar_file_system_list_t *fslist)
 {
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(fslist->size, SIGAR_FS_MAX);
+
     fslist->data = realloc(fslist->data,
-                           sizeof(*(fslist->data)) *
-                           (fslist->size + SIGAR_FS_MAX));
-    fslist->size += SIGAR_FS_MAX;
+                           sizeof(*(fslist->data)) * size);
+    fslist->size = size;
 
     return SIGAR_OK;
 }
@@ -603,38 +1323,144 @@ sigar_file_system_list_destroy(sigar_t *sigar,
                                sigar_file_system_list_t *fslist)
 {
     if (fslist->size) {
-        free(fslist->data);
+        sigar_list_free(sigar, SIGAR_LIST_FS, fslist->data, fslist->size);
         fslist->number = fslist->size = 0;
     }
 
     return SIGAR_OK;
 }
 
-#ifndef NFS_PROGRAM
-#define NFS_PROGRAM 100003
-#endif
+int sigar_disk_io_list_create(sigar_t *sigar, sigar_disk_io_list_t *disklist)
+{
+    disklist->number = 0;
+    disklist->size = SIGAR_DISK_IO_LIST_MAX;
+    disklist->data = sigar_list_alloc(sigar, SIGAR_LIST_DISK_IO,
+                                      sizeof(*(disklist->data)),
+                                      &disklist->size);
+    return SIGAR_OK;
+}
 
-#ifndef NFS_VERSION
-#define NFS_VERSION 2
-#endif
+int sigar_disk_io_list_grow(sigar_disk_io_list_t *disklist)
+{
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(disklist->size, SIGAR_DISK_IO_LIST_MAX);
+
+    disklist->data = realloc(disklist->data,
+                             sizeof(*(disklist->data)) * size);
+    disklist->size = size;
+
+    return SIGAR_OK;
+}
 
 SIGAR_DECLARE(int)
-sigar_file_system_ping(sigar_t *sigar,
-                       sigar_file_system_t *fs)
+sigar_disk_io_list_destroy(sigar_t *sigar,
+                           sigar_disk_io_list_t *disklist)
 {
-    int status = SIGAR_OK;
-#ifndef WIN32
-    char *ptr;
+    if (disklist->size) {
+        sigar_list_free(sigar, SIGAR_LIST_DISK_IO, disklist->data, disklist->size);
+        disklist->number = disklist->size = 0;
+    }
 
-    if ((fs->type == SIGAR_FSTYPE_NETWORK) &&
-        strEQ(fs->sys_type_name, "nfs") &&
-        (ptr = strchr(fs->dev_name, ':')))
-    {
-        *ptr = '\0'; /* "hostname:/mount" -> "hostname" */
+    return SIGAR_OK;
+}
 
-        status = sigar_rpc_ping(fs->dev_name,
-                                SIGAR_NETCONN_UDP,
-                                NFS_PROGRAM, NFS_VERSION);
+#if !defined(__linux__)
+/*
+ * implement sigar_disk_io_list_get using the mounted local disks.
+ * linux has its own impl which reads /proc/diskstats once.
+ */
+static int disk_io_list_has(sigar_disk_io_list_t *disklist,
+                            const char *name)
+{
+    unsigned long i;
+
+    for (i=0; i<disklist->number; i++) {
+        if (strEQ(disklist->data[i].name, name)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int sigar_os_disk_io_list_get(sigar_t *sigar,
+                              sigar_disk_io_list_t *disklist)
+{
+    int status;
+    unsigned long i;
+    sigar_file_system_list_t fslist;
+
+    status = sigar_file_system_list_get(sigar, &fslist);
+    if (status != SIGAR_OK) {
+        return status;
+    }
+
+    sigar_disk_io_list_create(sigar, disklist);
+
+    for (i=0; i<fslist.number; i++) {
+        sigar_file_system_t *fsp = &fslist.data[i];
+        sigar_disk_io_t *dio;
+
+        if ((fsp->type != SIGAR_FSTYPE_LOCAL_DISK) ||
+            disk_io_list_has(disklist, fsp->dev_name))
+        {
+            continue;
+        }
+
+        SIGAR_DISK_IO_LIST_GROW(disklist);
+        dio = &disklist->data[disklist->number];
+
+        if (sigar_disk_usage_get(sigar, fsp->dev_name,
+                                 &dio->disk) != SIGAR_OK)
+        {
+            continue;
+        }
+
+        SIGAR_SSTRCPY(dio->name, fsp->dev_name);
+        dio->major = dio->minor = 0;
+        dio->read_merges = dio->write_merges = dio->in_progress =
+            dio->discards = dio->discard_merges =
+            dio->discard_bytes = dio->dtime =
+            dio->flushes = dio->ftime = SIGAR_FIELD_NOTIMPL;
+        dio->utilization =
+            dio->reads_per_sec = dio->writes_per_sec =
+            dio->read_bytes_per_sec = dio->write_bytes_per_sec =
+            SIGAR_FIELD_NOTIMPL;
+
+        disklist->number++;
+    }
+
+    sigar_file_system_list_destroy(sigar, &fslist);
+
+    return SIGAR_OK;
+}
+#endif
+
+#ifndef NFS_PROGRAM
+#define NFS_PROGRAM 100003
+#endif
+
+#ifndef NFS_VERSION
+#define NFS_VERSION 2
+#endif
+
+SIGAR_DECLARE(int)
+sigar_file_system_ping(sigar_t *sigar,
+                       sigar_file_system_t *fs)
+{
+    int status = SIGAR_OK;
+#ifndef WIN32
+    char *ptr;
+
+    if ((fs->type == SIGAR_FSTYPE_NETWORK) &&
+        strEQ(fs->sys_type_name, "nfs") &&
+        (ptr = strchr(fs->dev_name, ':')))
+    {
+        *ptr = '\0'; /* "hostname:/mount" -> "hostname" */
+
+        status = sigar_rpc_ping(fs->dev_name,
+                                SIGAR_NETCONN_UDP,
+                                NFS_PROGRAM, NFS_VERSION);
 
         if (SIGAR_LOG_IS_DEBUG(sigar)) {
             sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
@@ -661,10 +1487,12 @@ int sigar_cpu_info_list_create(sigar_cpu_info_list_t *cpu_infos)
 
 int sigar_cpu_info_list_grow(sigar_cpu_info_list_t *cpu_infos)
 {
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(cpu_infos->size, SIGAR_CPU_INFO_MAX);
+
     cpu_infos->data = realloc(cpu_infos->data,
-                              sizeof(*(cpu_infos->data)) *
-                              (cpu_infos->size + SIGAR_CPU_INFO_MAX));
-    cpu_infos->size += SIGAR_CPU_INFO_MAX;
+                              sizeof(*(cpu_infos->data)) * size);
+    cpu_infos->size = size;
 
     return SIGAR_OK;
 }
@@ -681,21 +1509,24 @@ sigar_cpu_info_list_destroy(sigar_t *sigar,
     return SIGAR_OK;
 }
 
-int sigar_cpu_list_create(sigar_cpu_list_t *cpulist)
+int sigar_cpu_list_create(sigar_t *sigar, sigar_cpu_list_t *cpulist)
 {
     cpulist->number = 0;
     cpulist->size = SIGAR_CPU_INFO_MAX;
-    cpulist->data = malloc(sizeof(*(cpulist->data)) *
-                           cpulist->size);
+    cpulist->data = sigar_list_alloc(sigar, SIGAR_LIST_CPU,
+                                     sizeof(*(cpulist->data)),
+                                     &cpulist->size);
     return SIGAR_OK;
 }
 
 int sigar_cpu_list_grow(sigar_cpu_list_t *cpulist)
 {
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(cpulist->size, SIGAR_CPU_INFO_MAX);
+
     cpulist->data = realloc(cpulist->data,
-                            sizeof(*(cpulist->data)) *
-                            (cpulist->size + SIGAR_CPU_INFO_MAX));
-    cpulist->size += SIGAR_CPU_INFO_MAX;
+                            sizeof(*(cpulist->data)) * size);
+    cpulist->size = size;
 
     return SIGAR_OK;
 }
@@ -704,29 +1535,31 @@ SIGAR_DECLARE(int) sigar_cpu_list_destroy(sigar_t *sigar,
                                           sigar_cpu_list_t *cpulist)
 {
     if (cpulist->size) {
-        free(cpulist->data);
+        sigar_list_free(sigar, SIGAR_LIST_CPU, cpulist->data, cpulist->size);
         cpulist->number = cpulist->size = 0;
     }
 
     return SIGAR_OK;
 }
 
-int sigar_net_route_list_create(sigar_net_route_list_t *routelist)
+int sigar_net_route_list_create(sigar_t *sigar, sigar_net_route_list_t *routelist)
 {
     routelist->number = 0;
     routelist->size = SIGAR_NET_ROUTE_LIST_MAX;
-    routelist->data = malloc(sizeof(*(routelist->data)) *
-                             routelist->size);
+    routelist->data = sigar_list_alloc(sigar, SIGAR_LIST_NET_ROUTE,
+                                       sizeof(*(routelist->data)),
+                                       &routelist->size);
     return SIGAR_OK;
 }
 
 int sigar_net_route_list_grow(sigar_net_route_list_t *routelist)
 {
-    routelist->data =
-        realloc(routelist->data,
-                sizeof(*(routelist->data)) *
-                (routelist->size + SIGAR_NET_ROUTE_LIST_MAX));
-    routelist->size += SIGAR_NET_ROUTE_LIST_MAX;
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(routelist->size, SIGAR_NET_ROUTE_LIST_MAX);
+
+    routelist->data = realloc(routelist->data,
+                              sizeof(*(routelist->data)) * size);
+    routelist->size = size;
 
     return SIGAR_OK;
 }
@@ -735,7 +1568,7 @@ SIGAR_DECLARE(int) sigar_net_route_list_destroy(sigar_t *sigar,
                                                 sigar_net_route_list_t *routelist)
 {
     if (routelist->size) {
-        free(routelist->data);
+        sigar_list_free(sigar, SIGAR_LIST_NET_ROUTE, routelist->data, routelist->size);
         routelist->number = routelist->size = 0;
     }
 
@@ -753,10 +1586,12 @@ int sigar_net_interface_list_create(sigar_net_interface_list_t *iflist)
 
 int sigar_net_interface_list_grow(sigar_net_interface_list_t *iflist)
 {
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(iflist->size, SIGAR_NET_IFLIST_MAX);
+
     iflist->data = realloc(iflist->data,
-                           sizeof(*(iflist->data)) *
-                           (iflist->size + SIGAR_NET_IFLIST_MAX));
-    iflist->size += SIGAR_NET_IFLIST_MAX;
+                           sizeof(*(iflist->data)) * size);
+    iflist->size = size;
 
     return SIGAR_OK;
 }
@@ -778,22 +1613,105 @@ sigar_net_interface_list_destroy(sigar_t *sigar,
     return SIGAR_OK;
 }
 
-int sigar_net_connection_list_create(sigar_net_connection_list_t *connlist)
+int sigar_net_interface_stat_list_create(sigar_t *sigar, sigar_net_interface_stat_list_t *iflist)
+{
+    iflist->number = 0;
+    iflist->size = SIGAR_NET_IFLIST_MAX;
+    iflist->data = sigar_list_alloc(sigar, SIGAR_LIST_NET_IFSTAT,
+                                    sizeof(*(iflist->data)),
+                                    &iflist->size);
+    return SIGAR_OK;
+}
+
+int sigar_net_interface_stat_list_grow(sigar_net_interface_stat_list_t *iflist)
+{
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(iflist->size, SIGAR_NET_IFLIST_MAX);
+
+    iflist->data = realloc(iflist->data,
+                           sizeof(*(iflist->data)) * size);
+    iflist->size = size;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_net_interface_stat_list_destroy(sigar_t *sigar,
+                                      sigar_net_interface_stat_list_t *iflist)
+{
+    if (iflist->size) {
+        sigar_list_free(sigar, SIGAR_LIST_NET_IFSTAT, iflist->data, iflist->size);
+        iflist->number = iflist->size = 0;
+    }
+
+    return SIGAR_OK;
+}
+
+#ifndef __linux__
+/* linux reads every interface from one netlink dump */
+int sigar_os_net_interface_stat_list_get(sigar_t *sigar,
+                                         sigar_net_interface_stat_list_t *iflist)
+{
+    sigar_net_interface_list_t names;
+    unsigned long i;
+    int status;
+
+    if ((status = sigar_net_interface_list_get(sigar, &names)) != SIGAR_OK) {
+        return status;
+    }
+
+    sigar_net_interface_stat_list_create(sigar, iflist);
+
+    for (i=0; i<names.number; i++) {
+        sigar_net_interface_stat_entry_t *entry;
+
+        SIGAR_NET_IFSTAT_LIST_GROW(iflist);
+        entry = &iflist->data[iflist->number];
+
+        if (sigar_net_interface_stat_get(sigar, names.data[i],
+                                         &entry->stat) != SIGAR_OK)
+        {
+            continue;
+        }
+
+        SIGAR_SSTRCPY(entry->name, names.data[i]);
+        entry->index = SIGAR_FIELD_NOTIMPL;
+        entry->rx_multicast = entry->rx_compressed =
+            entry->rx_length_errors = entry->rx_over_errors =
+            entry->rx_crc_errors = entry->rx_frame_errors =
+            entry->rx_fifo_errors = entry->rx_missed_errors =
+            entry->tx_compressed = entry->tx_aborted_errors =
+            entry->tx_carrier_errors = entry->tx_fifo_errors =
+            entry->tx_heartbeat_errors = entry->tx_window_errors =
+            SIGAR_FIELD_NOTIMPL;
+
+        iflist->number++;
+    }
+
+    sigar_net_interface_list_destroy(sigar, &names);
+
+    return SIGAR_OK;
+}
+#endif
+
+int sigar_net_connection_list_create(sigar_t *sigar, sigar_net_connection_list_t *connlist)
 {
     connlist->number = 0;
     connlist->size = SIGAR_NET_CONNLIST_MAX;
-    connlist->data = malloc(sizeof(*(connlist->data)) *
-                            connlist->size);
+    connlist->data = sigar_list_alloc(sigar, SIGAR_LIST_NET_CONN,
+                                      sizeof(*(connlist->data)),
+                                      &connlist->size);
     return SIGAR_OK;
 }
 
 int sigar_net_connection_list_grow(sigar_net_connection_list_t *connlist)
 {
-    connlist->data =
-        realloc(connlist->data,
-                sizeof(*(connlist->data)) *
-                (connlist->size + SIGAR_NET_CONNLIST_MAX));
-    connlist->size += SIGAR_NET_CONNLIST_MAX;
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(connlist->size, SIGAR_NET_CONNLIST_MAX);
+
+    connlist->data = realloc(connlist->data,
+                             sizeof(*(connlist->data)) * size);
+    connlist->size = size;
 
     return SIGAR_OK;
 }
@@ -801,6 +1719,138 @@ int sigar_net_connection_list_grow(sigar_net_connection_list_t *connlist)
 SIGAR_DECLARE(int)
 sigar_net_connection_list_destroy(sigar_t *sigar,
                                   sigar_net_connection_list_t *connlist)
+{
+    if (connlist->size) {
+        sigar_list_free(sigar, SIGAR_LIST_NET_CONN, connlist->data, connlist->size);
+        connlist->number = connlist->size = 0;
+    }
+
+    return SIGAR_OK;
+}
+
+int sigar_net_connection_info_list_create(sigar_net_connection_info_list_t *connlist)
+{
+    connlist->number = 0;
+    connlist->size = SIGAR_NET_CONNLIST_MAX;
+    connlist->data = malloc(sizeof(*(connlist->data)) *
+                            connlist->size);
+    return SIGAR_OK;
+}
+
+int sigar_net_connection_info_list_grow(sigar_net_connection_info_list_t *connlist)
+{
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(connlist->size, SIGAR_NET_CONNLIST_MAX);
+
+    connlist->data = realloc(connlist->data,
+                             sizeof(*(connlist->data)) * size);
+    connlist->size = size;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_net_connection_info_list_destroy(sigar_t *sigar,
+                                       sigar_net_connection_info_list_t *connlist)
+{
+    if (connlist->size) {
+        free(connlist->data);
+        connlist->number = connlist->size = 0;
+    }
+
+    return SIGAR_OK;
+}
+
+int sigar_net_unix_connection_list_create(sigar_net_unix_connection_list_t *connlist)
+{
+    connlist->number = 0;
+    connlist->size = SIGAR_NET_CONNLIST_MAX;
+    connlist->data = malloc(sizeof(*(connlist->data)) *
+                            connlist->size);
+    return SIGAR_OK;
+}
+
+int sigar_net_unix_connection_list_grow(sigar_net_unix_connection_list_t *connlist)
+{
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(connlist->size, SIGAR_NET_CONNLIST_MAX);
+
+    connlist->data = realloc(connlist->data,
+                             sizeof(*(connlist->data)) * size);
+    connlist->size = size;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_net_unix_connection_list_destroy(sigar_t *sigar,
+                                       sigar_net_unix_connection_list_t *connlist)
+{
+    if (connlist->size) {
+        free(connlist->data);
+        connlist->number = connlist->size = 0;
+    }
+
+    return SIGAR_OK;
+}
+
+int sigar_net_port_tcp_info_list_create(sigar_net_port_tcp_info_list_t *portlist)
+{
+    portlist->number = 0;
+    portlist->size = SIGAR_NET_CONNLIST_MAX;
+    portlist->data = malloc(sizeof(*(portlist->data)) *
+                            portlist->size);
+    return SIGAR_OK;
+}
+
+int sigar_net_port_tcp_info_list_grow(sigar_net_port_tcp_info_list_t *portlist)
+{
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(portlist->size, SIGAR_NET_CONNLIST_MAX);
+
+    portlist->data = realloc(portlist->data,
+                             sizeof(*(portlist->data)) * size);
+    portlist->size = size;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_net_port_tcp_info_list_destroy(sigar_t *sigar,
+                                     sigar_net_port_tcp_info_list_t *portlist)
+{
+    if (portlist->size) {
+        free(portlist->data);
+        portlist->number = portlist->size = 0;
+    }
+
+    return SIGAR_OK;
+}
+
+int sigar_net_connection_proc_list_create(sigar_net_connection_proc_list_t *connlist)
+{
+    connlist->number = 0;
+    connlist->size = SIGAR_NET_CONNLIST_MAX;
+    connlist->data = malloc(sizeof(*(connlist->data)) *
+                            connlist->size);
+    return SIGAR_OK;
+}
+
+int sigar_net_connection_proc_list_grow(sigar_net_connection_proc_list_t *connlist)
+{
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(connlist->size, SIGAR_NET_CONNLIST_MAX);
+
+    connlist->data = realloc(connlist->data,
+                             sizeof(*(connlist->data)) * size);
+    connlist->size = size;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_net_connection_proc_list_destroy(sigar_t *sigar,
+                                       sigar_net_connection_proc_list_t *connlist)
 {
     if (connlist->size) {
         free(connlist->data);
@@ -810,6 +1860,75 @@ sigar_net_connection_list_destroy(sigar_t *sigar,
     return SIGAR_OK;
 }
 
+#if !defined(__linux__)
+/* only listeners can be resolved with sigar_proc_port_get */
+int sigar_os_net_connection_proc_list_get(sigar_t *sigar,
+                                          sigar_net_connection_proc_list_t *connlist,
+                                          int flags)
+{
+    sigar_net_connection_list_t netlist;
+    unsigned long i;
+    int status;
+
+    status = sigar_net_connection_list_get(sigar, &netlist, flags);
+    if (status != SIGAR_OK) {
+        return status;
+    }
+
+    sigar_net_connection_proc_list_create(connlist);
+
+    for (i=0; i<netlist.number; i++) {
+        sigar_net_connection_proc_t *entry;
+        sigar_net_connection_t *conn = &netlist.data[i];
+
+        SIGAR_NET_CONNPROC_LIST_GROW(connlist);
+        entry = &connlist->data[connlist->number++];
+        memcpy(&entry->conn, conn, sizeof(*conn));
+        entry->pid = 0;
+        entry->fd = -1;
+
+        if (conn->remote_port == 0) {
+            if (sigar_proc_port_get(sigar, conn->type,
+                                    conn->local_port,
+                                    &entry->pid) != SIGAR_OK)
+            {
+                entry->pid = 0;
+            }
+        }
+    }
+
+    sigar_net_connection_list_destroy(sigar, &netlist);
+
+    return SIGAR_OK;
+}
+#endif
+
+#if !defined(__linux__)
+/* tcp_info is only exported in bulk by linux sock_diag */
+int sigar_os_net_connection_info_list_get(sigar_t *sigar,
+                                          sigar_net_connection_info_list_t *connlist,
+                                          int flags)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+int sigar_os_net_port_tcp_info_list_get(sigar_t *sigar,
+                                        sigar_net_port_tcp_info_list_t *portlist)
+{
+    return SIGAR_ENOTIMPL;
+}
+#endif
+
+#if !defined(__linux__)
+/* only the linux walk has SIGAR_NETCONN_UNIX */
+int sigar_os_net_unix_connection_list_get(sigar_t *sigar,
+                                          sigar_net_unix_connection_list_t *connlist,
+                                          int flags)
+{
+    return SIGAR_ENOTIMPL;
+}
+#endif
+
 #if !defined(__linux__)
 /* 
  * implement sigar_net_connection_list_get using sigar_net_connection_walk
@@ -828,15 +1947,14 @@ static int net_connection_list_walker(sigar_net_connection_walker_t *walker,
     return SIGAR_OK; /* continue loop */
 }
 
-SIGAR_DECLARE(int)
-sigar_net_connection_list_get(sigar_t *sigar,
-                              sigar_net_connection_list_t *connlist,
-                              int flags)
+int sigar_os_net_connection_list_get(sigar_t *sigar,
+                                     sigar_net_connection_list_t *connlist,
+                                     int flags)
 {
     int status;
     sigar_net_connection_walker_t walker;
 
-    sigar_net_connection_list_create(connlist);
+    sigar_net_connection_list_create(sigar, connlist);
 
     walker.sigar = sigar;
     walker.flags = flags;
@@ -853,23 +1971,125 @@ sigar_net_connection_list_get(sigar_t *sigar,
 }
 #endif
 
+/*
+ * net_listen maps a tcp port to the address it listens on.
+ * it is filled in bulk by one server side walk and refreshed
+ * at most once per SIGAR_BUFFER_EXPIRE; entries the latest walk
+ * did not see are dropped, ports are reused often enough.
+ */
+typedef struct {
+    sigar_net_address_t address;
+    sigar_uint64_t seen; /* net_listen_time of the walk that saw it */
+} net_listen_t;
+
+static net_listen_t *net_listen_find(sigar_t *sigar, unsigned long port)
+{
+    sigar_cache_entry_t *entry;
+
+    if (!sigar->net_listen ||
+        !(entry = sigar_cache_find(sigar->net_listen, port)))
+    {
+        return NULL;
+    }
+
+    return entry->value; /* NULL once dropped */
+}
+
 static void sigar_net_listen_address_add(sigar_t *sigar,
                                          sigar_net_connection_t *conn)
 {
     sigar_cache_entry_t *entry =
         sigar_cache_get(sigar->net_listen, conn->local_port);
+    net_listen_t *listen = entry->value;
 
-    if (entry->value) {
+    if (listen && (listen->seen == sigar->net_listen_time)) {
         if (conn->local_address.family == SIGAR_AF_INET6) {
             return; /* prefer ipv4 */
         }
     }
-    else {
-        entry->value = malloc(sizeof(conn->local_address));
+    else if (!listen) {
+        entry->value = listen = malloc(sizeof(*listen));
     }
 
-    memcpy(entry->value, &conn->local_address,
-           sizeof(conn->local_address));
+    memcpy(&listen->address, &conn->local_address,
+           sizeof(listen->address));
+    listen->seen = sigar->net_listen_time;
+}
+
+static int net_listen_walker(sigar_net_connection_walker_t *walker,
+                             sigar_net_connection_t *conn)
+{
+    if ((conn->type == SIGAR_NETCONN_TCP) &&
+        (conn->state == SIGAR_TCP_LISTEN))
+    {
+        sigar_net_listen_address_add(walker->sigar, conn);
+    }
+
+    return SIGAR_OK;
+}
+
+static void net_listen_begin(sigar_t *sigar)
+{
+    sigar_uint64_t timenow = sigar_time_now_millis();
+
+    if (!sigar->net_listen) {
+        sigar->net_listen = sigar_cache_new(32);
+    }
+
+    /* never equal to a previous walk, even within the same msec */
+    if (timenow <= sigar->net_listen_time) {
+        timenow = sigar->net_listen_time + 1;
+    }
+    sigar->net_listen_time = timenow;
+}
+
+/* drop what the walk just done did not see */
+static void net_listen_end(sigar_t *sigar)
+{
+    sigar_cache_t *table = sigar->net_listen;
+    unsigned int i;
+
+    for (i=0; i<table->size; i++) {
+        sigar_cache_entry_t *entry;
+
+        for (entry = table->entries[i]; entry; entry = entry->next) {
+            net_listen_t *listen = entry->value;
+
+            if (listen && (listen->seen != sigar->net_listen_time)) {
+                free(listen);
+                entry->value = NULL;
+            }
+        }
+    }
+}
+
+static int sigar_net_listen_refresh(sigar_t *sigar)
+{
+    sigar_net_connection_walker_t walker;
+    int status;
+
+    if (sigar->net_listen &&
+        ((sigar_time_now_millis() - sigar->net_listen_time) <
+         SIGAR_BUFFER_EXPIRE))
+    {
+        return SIGAR_OK;
+    }
+
+    net_listen_begin(sigar);
+
+    walker.sigar = sigar;
+    walker.flags = SIGAR_NETCONN_SERVER|SIGAR_NETCONN_TCP;
+    walker.data = NULL;
+    walker.add_connection = net_listen_walker;
+
+    if ((status = sigar_net_connection_walk(&walker)) != SIGAR_OK) {
+        sigar->net_listen_time = 0; /* try again next time */
+        return status;
+    }
+
+    net_listen_end(sigar);
+
+    return SIGAR_OK;
 }
 
 SIGAR_DECLARE(int)
@@ -877,27 +2097,67 @@ sigar_net_listen_address_get(sigar_t *sigar,
                              unsigned long port,
                              sigar_net_address_t *address)
 {
-    if (!sigar->net_listen ||
-        !sigar_cache_find(sigar->net_listen, port))
-    {
-        sigar_net_stat_t netstat;
-        int status =
-            sigar_net_stat_get(sigar, &netstat,
-                               SIGAR_NETCONN_SERVER|SIGAR_NETCONN_TCP);
+    net_listen_t *listen;
+    int status;
 
-        if (status != SIGAR_OK) {
-            return status;
+    sigar_lock(sigar);
+
+    if ((status = sigar_net_listen_refresh(sigar)) == SIGAR_OK) {
+        if ((listen = net_listen_find(sigar, port))) {
+            memcpy(address, &listen->address, sizeof(*address));
+        }
+        else {
+            status = ENOENT;
         }
     }
 
-    if (sigar_cache_find(sigar->net_listen, port)) {
-        void *value = sigar_cache_get(sigar->net_listen, port)->value;
-        memcpy(address, value, sizeof(*address));
-        return SIGAR_OK;
+    sigar_unlock(sigar);
+
+    return status;
+}
+
+static int net_listener_list_get(sigar_t *sigar,
+                                 sigar_net_connection_proc_list_t *connlist)
+{
+    unsigned long i;
+    int status =
+        sigar_net_connection_proc_list_get(sigar, connlist,
+                                           SIGAR_NETCONN_SERVER|
+                                           SIGAR_NETCONN_TCP|
+                                           SIGAR_NETCONN_UDP);
+
+    if (status != SIGAR_OK) {
+        return status;
     }
-    else {
-        return ENOENT;
+
+    /* the same walk is as good as a listen cache refresh */
+    sigar_lock(sigar);
+    net_listen_begin(sigar);
+
+    for (i=0; i<connlist->number; i++) {
+        sigar_net_connection_t *conn = &connlist->data[i].conn;
+
+        if ((conn->type == SIGAR_NETCONN_TCP) &&
+            (conn->state == SIGAR_TCP_LISTEN))
+        {
+            sigar_net_listen_address_add(sigar, conn);
+        }
     }
+
+    net_listen_end(sigar);
+    sigar_unlock(sigar);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_net_listener_list_get(sigar_t *sigar,
+                            sigar_net_connection_proc_list_t *connlist)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = net_listener_list_get(sigar, connlist);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_NET_LISTENER_LIST, status);
 }
 
 typedef struct {
@@ -909,7 +2169,6 @@ static int net_stat_walker(sigar_net_connection_walker_t *walker,
                            sigar_net_connection_t *conn)
 {
     int state = conn->state;
-    sigar_cache_t *listen_ports = walker->sigar->net_listen;
     net_stat_getter_t *getter =
         (net_stat_getter_t *)walker->data;
 
@@ -921,9 +2180,7 @@ static int net_stat_walker(sigar_net_connection_walker_t *walker,
             sigar_net_listen_address_add(walker->sigar, conn);
         }
         else {
-            if (sigar_cache_find(listen_ports,
-                                 conn->local_port))
-            {
+            if (net_listen_find(walker->sigar, conn->local_port)) {
                 getter->netstat->tcp_inbound_total++;
             }
             else {
@@ -934,6 +2191,9 @@ static int net_stat_walker(sigar_net_connection_walker_t *walker,
     else if (conn->type == SIGAR_NETCONN_UDP) {
         /*XXX*/
     }
+    else if (conn->type == SIGAR_NETCONN_UNIX) {
+        getter->netstat->unix_states[state]++;
+    }
 
     getter->netstat->all_inbound_total =
         getter->netstat->tcp_inbound_total;
@@ -951,6 +2211,9 @@ sigar_net_stat_get(sigar_t *sigar,
 {
     sigar_net_connection_walker_t walker;
     net_stat_getter_t getter;
+    int status;
+
+    sigar_lock(sigar);
 
     if (!sigar->net_listen) {
         sigar->net_listen = sigar_cache_new(32);
@@ -966,87 +2229,502 @@ sigar_net_stat_get(sigar_t *sigar,
 
     walker.flags = flags;
 
+    status = sigar_net_connection_walk(&walker);
+
+    sigar_unlock(sigar);
+
+    return status;
+}
+
+typedef struct {
+    sigar_net_stat_t *netstat;
+    sigar_net_address_t *address;
+    unsigned long port;
+} net_stat_port_getter_t;
+
+static int net_stat_port_walker(sigar_net_connection_walker_t *walker,
+                                sigar_net_connection_t *conn)
+{
+    net_stat_port_getter_t *getter =
+        (net_stat_port_getter_t *)walker->data;
+    sigar_net_stat_t *netstat = getter->netstat;
+
+    if (conn->type == SIGAR_NETCONN_TCP) {
+        if (conn->local_port == getter->port) {
+            netstat->all_inbound_total++;
+
+            if (sigar_net_address_equals(getter->address,
+                                         &conn->local_address) == SIGAR_OK)
+            {
+                netstat->tcp_inbound_total++;
+            }
+        }
+        else if (conn->remote_port == getter->port) {
+            netstat->all_outbound_total++;
+
+            if (sigar_net_address_equals(getter->address,
+                                         &conn->remote_address) == SIGAR_OK)
+            {
+                netstat->tcp_outbound_total++;
+            }
+        }
+        else {
+            return SIGAR_OK;
+        }
+
+        netstat->tcp_states[conn->state]++;
+    }
+    else if (conn->type == SIGAR_NETCONN_UDP) {
+        /*XXX*/
+    }
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_net_stat_port_get(sigar_t *sigar,
+                        sigar_net_stat_t *netstat,
+                        int flags,
+                        sigar_net_address_t *address,
+                        unsigned long port)
+{
+    sigar_net_connection_walker_t walker;
+    net_stat_port_getter_t getter;
+
+    SIGAR_ZERO(netstat);
+
+    getter.netstat = netstat;
+    getter.address = address;
+    getter.port = port;
+
+    walker.sigar = sigar;
+    walker.data = &getter;
+    walker.add_connection = net_stat_port_walker;
+
+    walker.flags = flags;
+
+    if (SIGAR_LOG_IS_DEBUG(sigar)) {
+        char name[SIGAR_FQDN_LEN];
+        sigar_net_address_to_string(sigar, address, name);
+
+        sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                         "[net_stat_port] using address '%s:%d'",
+                         name, port);
+    }
+
     return sigar_net_connection_walk(&walker);
 }
 
-typedef struct {
-    sigar_net_stat_t *netstat;
-    sigar_net_address_t *address;
-    unsigned long port;
-} net_stat_port_getter_t;
-
-static int net_stat_port_walker(sigar_net_connection_walker_t *walker,
-                                sigar_net_connection_t *conn)
+#define NET_PORT_STAT_HASH(port, mask) \
+    ((unsigned long)(((sigar_uint32_t)(port) * 0x9E3779B1U) >> 16) & (mask))
+
+static unsigned int *net_port_stat_slot(sigar_net_port_stat_map_t *portmap,
+                                        unsigned long port)
+{
+    unsigned long mask = portmap->index_size - 1;
+    unsigned long i = NET_PORT_STAT_HASH(port, mask);
+
+    while (portmap->index[i] &&
+           (portmap->data[portmap->index[i]-1].port != port))
+    {
+        i = (i + 1) & mask;
+    }
+
+    return &portmap->index[i];
+}
+
+static void net_port_stat_rehash(sigar_net_port_stat_map_t *portmap)
+{
+    unsigned long i;
+
+    free(portmap->index);
+    portmap->index_size *= 2;
+    portmap->index = calloc(portmap->index_size, sizeof(*portmap->index));
+
+    for (i=0; i<portmap->number; i++) {
+        *net_port_stat_slot(portmap, portmap->data[i].port) = i + 1;
+    }
+}
+
+static sigar_net_port_stat_t *
+net_port_stat_get(sigar_net_port_stat_map_t *portmap,
+                  unsigned long port)
+{
+    unsigned int *slot = net_port_stat_slot(portmap, port);
+    sigar_net_port_stat_t *entry;
+
+    if (*slot) {
+        return &portmap->data[*slot-1];
+    }
+
+    /* keep the index at most half full */
+    if ((portmap->number + 1) * 2 > portmap->index_size) {
+        net_port_stat_rehash(portmap);
+        slot = net_port_stat_slot(portmap, port);
+    }
+
+    SIGAR_NET_PORT_STAT_MAP_GROW(portmap);
+    entry = &portmap->data[portmap->number++];
+    SIGAR_ZERO(entry);
+    entry->port = port;
+    *slot = portmap->number;
+
+    return entry;
+}
+
+/* a connection to count against its remote port after the walk */
+typedef struct {
+    unsigned short local_port;
+    unsigned short remote_port;
+    int state;
+} net_port_stat_conn_t;
+
+typedef struct {
+    sigar_net_port_stat_map_t *portmap;
+    net_port_stat_conn_t *conns;
+    unsigned long number;
+    unsigned long size;
+} net_port_stat_walk_t;
+
+#define NET_PORT_STAT_CONNS_MAX 128
+
+static int net_port_stat_walker(sigar_net_connection_walker_t *walker,
+                                sigar_net_connection_t *conn)
+{
+    net_port_stat_walk_t *walk = walker->data;
+    sigar_net_port_stat_map_t *portmap = walk->portmap;
+    sigar_net_port_stat_t *entry;
+    int state = conn->state;
+
+    if (conn->type != SIGAR_NETCONN_TCP) {
+        return SIGAR_OK; /*XXX same as net_stat_walker */
+    }
+
+    portmap->total.tcp_states[state]++;
+
+    if (state == SIGAR_TCP_LISTEN) {
+        sigar_net_listen_address_add(walker->sigar, conn);
+    }
+
+    if (conn->local_port) {
+        entry = net_port_stat_get(portmap, conn->local_port);
+        entry->local.tcp_states[state]++;
+    }
+
+    if (conn->remote_port && (state != SIGAR_TCP_LISTEN)) {
+        net_port_stat_conn_t *remote;
+
+        if (walk->number >= walk->size) {
+            walk->size =
+                SIGAR_LIST_GROW_SIZE(walk->size, NET_PORT_STAT_CONNS_MAX);
+            walk->conns =
+                realloc(walk->conns, sizeof(*walk->conns) * walk->size);
+        }
+        remote = &walk->conns[walk->number++];
+        remote->local_port = conn->local_port;
+        remote->remote_port = conn->remote_port;
+        remote->state = state;
+    }
+
+    return SIGAR_OK;
+}
+
+static int net_port_stat_listening(sigar_t *sigar,
+                                   sigar_net_port_stat_map_t *portmap,
+                                   unsigned long port)
+{
+    sigar_net_port_stat_t *entry =
+        sigar_net_port_stat_map_find(portmap, port);
+
+    return (entry && entry->local.tcp_states[SIGAR_TCP_LISTEN]) ||
+        net_listen_find(sigar, port);
+}
+
+SIGAR_DECLARE(int)
+sigar_net_port_stat_map_get(sigar_t *sigar,
+                            sigar_net_port_stat_map_t *portmap,
+                            int flags)
+{
+    sigar_net_connection_walker_t walker;
+    net_port_stat_walk_t walk;
+    unsigned long i;
+    int status;
+
+    sigar_lock(sigar);
+
+    if (!sigar->net_listen) {
+        sigar->net_listen = sigar_cache_new(32);
+    }
+
+    sigar_net_port_stat_map_create(portmap);
+
+    walk.portmap = portmap;
+    walk.conns = NULL;
+    walk.number = walk.size = 0;
+
+    walker.sigar = sigar;
+    walker.data = &walk;
+    walker.add_connection = net_port_stat_walker;
+    walker.flags = flags;
+
+    status = sigar_net_connection_walk(&walker);
+
+    if (status != SIGAR_OK) {
+        sigar_unlock(sigar);
+        free(walk.conns);
+        sigar_net_port_stat_map_destroy(sigar, portmap);
+        return status;
+    }
+
+    /*
+     * listeners and connections arrive in any order, so direction
+     * is only known once the walk is done.
+     */
+    for (i=0; i<portmap->number; i++) {
+        sigar_net_port_stat_t *entry = &portmap->data[i];
+        sigar_net_stat_t *local = &entry->local;
+        sigar_uint32_t conns = 0;
+        int state;
+
+        for (state=0; state<SIGAR_TCP_UNKNOWN; state++) {
+            if (state != SIGAR_TCP_LISTEN) {
+                conns += local->tcp_states[state];
+            }
+        }
+
+        if (local->tcp_states[SIGAR_TCP_LISTEN] ||
+            net_listen_find(sigar, entry->port))
+        {
+            local->tcp_inbound_total = conns;
+        }
+        else {
+            local->tcp_outbound_total = conns;
+        }
+
+        local->all_inbound_total = local->tcp_inbound_total;
+        local->all_outbound_total = local->tcp_outbound_total;
+
+        portmap->total.tcp_inbound_total += local->tcp_inbound_total;
+        portmap->total.tcp_outbound_total += local->tcp_outbound_total;
+    }
+
+    /*
+     * the remote port of an accepted connection is the client's
+     * ephemeral port, only those made from a port without a listener
+     * count against the port on the other end.
+     */
+    for (i=0; i<walk.number; i++) {
+        net_port_stat_conn_t *conn = &walk.conns[i];
+        sigar_net_port_stat_t *entry;
+
+        if (net_port_stat_listening(sigar, portmap, conn->local_port)) {
+            continue;
+        }
+
+        entry = net_port_stat_get(portmap, conn->remote_port);
+        entry->remote.tcp_states[conn->state]++;
+        entry->remote.tcp_outbound_total++;
+        entry->remote.all_outbound_total++;
+    }
+
+    sigar_unlock(sigar);
+
+    free(walk.conns);
+
+    portmap->total.all_inbound_total = portmap->total.tcp_inbound_total;
+    portmap->total.all_outbound_total = portmap->total.tcp_outbound_total;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(sigar_net_port_stat_t *)
+sigar_net_port_stat_map_find(sigar_net_port_stat_map_t *portmap,
+                             unsigned long port)
+{
+    unsigned int *slot;
+
+    if (!portmap->index_size) {
+        return NULL;
+    }
+
+    slot = net_port_stat_slot(portmap, port);
+
+    return *slot ? &portmap->data[*slot-1] : NULL;
+}
+
+int sigar_net_port_stat_map_create(sigar_net_port_stat_map_t *portmap)
+{
+    portmap->number = 0;
+    portmap->size = SIGAR_NET_PORTMAP_MAX;
+    portmap->data = malloc(sizeof(*(portmap->data)) *
+                           portmap->size);
+    portmap->index_size = SIGAR_NET_PORTMAP_MAX * 2;
+    portmap->index = calloc(portmap->index_size,
+                            sizeof(*(portmap->index)));
+    SIGAR_ZERO(&portmap->total);
+    return SIGAR_OK;
+}
+
+int sigar_net_port_stat_map_grow(sigar_net_port_stat_map_t *portmap)
+{
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(portmap->size, SIGAR_NET_PORTMAP_MAX);
+
+    portmap->data = realloc(portmap->data,
+                            sizeof(*(portmap->data)) * size);
+    portmap->size = size;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_net_port_stat_map_destroy(sigar_t *sigar,
+                                sigar_net_port_stat_map_t *portmap)
+{
+    if (portmap->size) {
+        free(portmap->data);
+        free(portmap->index);
+        portmap->number = portmap->size = portmap->index_size = 0;
+        portmap->index = NULL;
+    }
+
+    return SIGAR_OK;
+}
+
+int sigar_net_proto_counter_list_create(sigar_net_proto_counter_list_t *counters)
+{
+    counters->number = 0;
+    counters->size = SIGAR_NET_PROTO_COUNTER_MAX;
+    counters->data = malloc(sizeof(*(counters->data)) *
+                            counters->size);
+    return SIGAR_OK;
+}
+
+int sigar_net_proto_counter_list_grow(sigar_net_proto_counter_list_t *counters)
+{
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(counters->size, SIGAR_NET_PROTO_COUNTER_MAX);
+
+    counters->data = realloc(counters->data,
+                             sizeof(*(counters->data)) * size);
+    counters->size = size;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(sigar_net_proto_counter_t *)
+sigar_net_proto_counter_find(sigar_net_proto_counter_list_t *counters,
+                             const char *group, const char *name)
 {
-    net_stat_port_getter_t *getter =
-        (net_stat_port_getter_t *)walker->data;
-    sigar_net_stat_t *netstat = getter->netstat;
+    unsigned long i;
 
-    if (conn->type == SIGAR_NETCONN_TCP) {
-        if (conn->local_port == getter->port) {
-            netstat->all_inbound_total++;
+    for (i=0; i<counters->number; i++) {
+        sigar_net_proto_counter_t *counter = &counters->data[i];
 
-            if (sigar_net_address_equals(getter->address,
-                                         &conn->local_address) == SIGAR_OK)
-            {
-                netstat->tcp_inbound_total++;
-            }
+        if (strEQ(counter->name, name) && strEQ(counter->group, group)) {
+            return counter;
         }
-        else if (conn->remote_port == getter->port) {
-            netstat->all_outbound_total++;
+    }
 
-            if (sigar_net_address_equals(getter->address,
-                                         &conn->remote_address) == SIGAR_OK)
-            {
-                netstat->tcp_outbound_total++;
-            }
-        }
-        else {
-            return SIGAR_OK;
-        }
+    return NULL;
+}
 
-        netstat->tcp_states[conn->state]++;
-    }
-    else if (conn->type == SIGAR_NETCONN_UDP) {
-        /*XXX*/
+SIGAR_DECLARE(int)
+sigar_net_proto_counter_list_destroy(sigar_t *sigar,
+                                     sigar_net_proto_counter_list_t *counters)
+{
+    if (counters->size) {
+        free(counters->data);
+        counters->number = counters->size = 0;
     }
 
     return SIGAR_OK;
 }
 
+#if !defined(__linux__)
+int sigar_os_net_proto_counter_list_get(sigar_t *sigar,
+                                        sigar_net_proto_counter_list_t *counters)
+{
+    return SIGAR_ENOTIMPL;
+}
+#endif
+
+int sigar_netns_list_create(sigar_netns_list_t *netnslist)
+{
+    netnslist->number = 0;
+    netnslist->size = SIGAR_NETNS_LIST_MAX;
+    netnslist->data = malloc(sizeof(*(netnslist->data)) *
+                             netnslist->size);
+    return SIGAR_OK;
+}
+
+int sigar_netns_list_grow(sigar_netns_list_t *netnslist)
+{
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(netnslist->size, SIGAR_NETNS_LIST_MAX);
+
+    netnslist->data = realloc(netnslist->data,
+                              sizeof(*(netnslist->data)) * size);
+    netnslist->size = size;
+
+    return SIGAR_OK;
+}
+
 SIGAR_DECLARE(int)
-sigar_net_stat_port_get(sigar_t *sigar,
-                        sigar_net_stat_t *netstat,
-                        int flags,
-                        sigar_net_address_t *address,
-                        unsigned long port)
+sigar_netns_list_destroy(sigar_t *sigar,
+                         sigar_netns_list_t *netnslist)
 {
-    sigar_net_connection_walker_t walker;
-    net_stat_port_getter_t getter;
+    if (netnslist->size) {
+        free(netnslist->data);
+        netnslist->number = netnslist->size = 0;
+    }
 
-    SIGAR_ZERO(netstat);
+    return SIGAR_OK;
+}
 
-    getter.netstat = netstat;
-    getter.address = address;
-    getter.port = port;
+#if !defined(__linux__)
+int sigar_os_netns_list_get(sigar_t *sigar,
+                            sigar_netns_list_t *netnslist)
+{
+    return SIGAR_ENOTIMPL;
+}
 
-    walker.sigar = sigar;
-    walker.data = &getter;
-    walker.add_connection = net_stat_port_walker;
+SIGAR_DECLARE(int)
+sigar_netns_pid_get(sigar_t *sigar, sigar_pid_t pid,
+                    sigar_netns_t *netns)
+{
+    return SIGAR_ENOTIMPL;
+}
 
-    walker.flags = flags;
+SIGAR_DECLARE(int)
+sigar_netns_path_get(sigar_t *sigar, const char *path,
+                     sigar_netns_t *netns)
+{
+    return SIGAR_ENOTIMPL;
+}
 
-    if (SIGAR_LOG_IS_DEBUG(sigar)) {
-        char name[SIGAR_FQDN_LEN];
-        sigar_net_address_to_string(sigar, address, name);
+int sigar_os_netns_interface_stat_list_get(sigar_t *sigar,
+                                           sigar_netns_t *netns,
+                                           sigar_net_interface_stat_list_t *iflist)
+{
+    return SIGAR_ENOTIMPL;
+}
 
-        sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
-                         "[net_stat_port] using address '%s:%d'",
-                         name, port);
-    }
+int sigar_os_netns_connection_list_get(sigar_t *sigar,
+                                       sigar_netns_t *netns,
+                                       sigar_net_connection_list_t *connlist,
+                                       int flags)
+{
+    return SIGAR_ENOTIMPL;
+}
 
-    return sigar_net_connection_walk(&walker);
+int sigar_os_netns_proto_counter_list_get(sigar_t *sigar,
+                                          sigar_netns_t *netns,
+                                          sigar_net_proto_counter_list_t *counters)
+{
+    return SIGAR_ENOTIMPL;
 }
+#endif
 
 static int tcp_curr_estab_count(sigar_net_connection_walker_t *walker,
                                 sigar_net_connection_t *conn)
@@ -1075,21 +2753,24 @@ int sigar_tcp_curr_estab(sigar_t *sigar, sigar_tcp_t *tcp)
     return sigar_net_connection_walk(&walker);
 }
 
-int sigar_arp_list_create(sigar_arp_list_t *arplist)
+int sigar_arp_list_create(sigar_t *sigar, sigar_arp_list_t *arplist)
 {
     arplist->number = 0;
     arplist->size = SIGAR_ARP_LIST_MAX;
-    arplist->data = malloc(sizeof(*(arplist->data)) *
-                           arplist->size);
+    arplist->data = sigar_list_alloc(sigar, SIGAR_LIST_ARP,
+                                     sizeof(*(arplist->data)),
+                                     &arplist->size);
     return SIGAR_OK;
 }
 
 int sigar_arp_list_grow(sigar_arp_list_t *arplist)
 {
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(arplist->size, SIGAR_ARP_LIST_MAX);
+
     arplist->data = realloc(arplist->data,
-                            sizeof(*(arplist->data)) *
-                            (arplist->size + SIGAR_ARP_LIST_MAX));
-    arplist->size += SIGAR_ARP_LIST_MAX;
+                            sizeof(*(arplist->data)) * size);
+    arplist->size = size;
 
     return SIGAR_OK;
 }
@@ -1098,28 +2779,256 @@ SIGAR_DECLARE(int) sigar_arp_list_destroy(sigar_t *sigar,
                                           sigar_arp_list_t *arplist)
 {
     if (arplist->size) {
-        free(arplist->data);
+        sigar_list_free(sigar, SIGAR_LIST_ARP, arplist->data, arplist->size);
         arplist->number = arplist->size = 0;
     }
 
     return SIGAR_OK;
 }
 
-int sigar_who_list_create(sigar_who_list_t *wholist)
+int sigar_net_interface_address_list_create(sigar_net_interface_address_list_t *addrlist)
+{
+    addrlist->number = 0;
+    addrlist->size = SIGAR_NET_ADDRESS_LIST_MAX;
+    addrlist->data = malloc(sizeof(*(addrlist->data)) *
+                            addrlist->size);
+    return SIGAR_OK;
+}
+
+int sigar_net_interface_address_list_grow(sigar_net_interface_address_list_t *addrlist)
+{
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(addrlist->size, SIGAR_NET_ADDRESS_LIST_MAX);
+
+    addrlist->data = realloc(addrlist->data,
+                             sizeof(*(addrlist->data)) * size);
+    addrlist->size = size;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_net_interface_address_list_destroy(sigar_t *sigar,
+                                         sigar_net_interface_address_list_t *addrlist)
+{
+    if (addrlist->size) {
+        free(addrlist->data);
+        addrlist->number = addrlist->size = 0;
+    }
+
+    return SIGAR_OK;
+}
+
+int sigar_net_interface_config_list_create(sigar_net_interface_config_list_t *iflist)
+{
+    iflist->number = 0;
+    iflist->size = SIGAR_NET_IFLIST_MAX;
+    iflist->data = malloc(sizeof(*(iflist->data)) *
+                          iflist->size);
+    sigar_net_interface_address_list_create(&iflist->addresses);
+    return SIGAR_OK;
+}
+
+int sigar_net_interface_config_list_grow(sigar_net_interface_config_list_t *iflist)
+{
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(iflist->size, SIGAR_NET_IFLIST_MAX);
+
+    iflist->data = realloc(iflist->data,
+                           sizeof(*(iflist->data)) * size);
+    iflist->size = size;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_net_interface_config_list_destroy(sigar_t *sigar,
+                                        sigar_net_interface_config_list_t *iflist)
+{
+    if (iflist->size) {
+        free(iflist->data);
+        iflist->number = iflist->size = 0;
+        sigar_net_interface_address_list_destroy(sigar, &iflist->addresses);
+    }
+
+    return SIGAR_OK;
+}
+
+#ifndef __linux__
+static unsigned long net_mask_prefix_length(sigar_uint32_t mask)
+{
+    unsigned long len = 0;
+
+    for (; mask; mask >>= 1) {
+        len += mask & 1;
+    }
+
+    return len;
+}
+
+/* one sigar_net_interface_config_get per interface */
+int sigar_os_net_interface_config_list_get(sigar_t *sigar,
+                                           sigar_net_interface_config_list_t *iflist)
+{
+    sigar_net_interface_list_t names;
+    sigar_net_interface_address_list_t *addrlist = &iflist->addresses;
+    unsigned long i, offset;
+    int status;
+
+    status = sigar_net_interface_list_get(sigar, &names);
+    if (status != SIGAR_OK) {
+        return status;
+    }
+
+    sigar_net_interface_config_list_create(iflist);
+
+    for (i=0; i<names.number; i++) {
+        sigar_net_interface_config_entry_t *entry;
+        sigar_net_interface_config_t *ifconfig;
+        sigar_net_interface_address_t *address;
+
+        SIGAR_NET_IFCONFIG_LIST_GROW(iflist);
+        entry = &iflist->data[iflist->number];
+        ifconfig = &entry->config;
+
+        if (sigar_net_interface_config_get(sigar, names.data[i],
+                                           ifconfig) != SIGAR_OK)
+        {
+            continue; /* went away */
+        }
+        iflist->number++;
+        entry->ifindex = 0;
+        entry->addresses_number = 0;
+
+        if (ifconfig->address.addr.in) {
+            SIGAR_NET_ADDRESS_LIST_GROW(addrlist);
+            address = &addrlist->data[addrlist->number++];
+            SIGAR_ZERO(address);
+            SIGAR_SSTRCPY(address->ifname, ifconfig->name);
+            address->address = ifconfig->address;
+            address->destination = ifconfig->destination;
+            address->broadcast = ifconfig->broadcast;
+            address->prefix_length =
+                net_mask_prefix_length(ifconfig->netmask.addr.in);
+            entry->addresses_number++;
+        }
+
+        if (ifconfig->address6.addr.in6[0] ||
+            ifconfig->address6.addr.in6[1] ||
+            ifconfig->address6.addr.in6[2] ||
+            ifconfig->address6.addr.in6[3])
+        {
+            SIGAR_NET_ADDRESS_LIST_GROW(addrlist);
+            address = &addrlist->data[addrlist->number++];
+            SIGAR_ZERO(address);
+            SIGAR_SSTRCPY(address->ifname, ifconfig->name);
+            address->address = ifconfig->address6;
+            address->prefix_length = ifconfig->prefix6_length;
+            address->scope = ifconfig->scope6;
+            entry->addresses_number++;
+        }
+    }
+
+    sigar_net_interface_list_destroy(sigar, &names);
+
+    /* the address list is complete, point into it */
+    for (i=0, offset=0; i<iflist->number; i++) {
+        sigar_net_interface_config_entry_t *entry = &iflist->data[i];
+
+        entry->addresses = &addrlist->data[offset];
+        offset += entry->addresses_number;
+    }
+
+    return SIGAR_OK;
+}
+
+/* the native lists are ipv4 only */
+SIGAR_DECLARE(int)
+sigar_net_route_walk(sigar_net_route_walker_t *walker)
+{
+    sigar_net_route_list_t routelist;
+    unsigned long i;
+    int status;
+
+    if (walker->family == SIGAR_AF_INET6) {
+        return SIGAR_OK;
+    }
+
+    status = sigar_net_route_list_get(walker->sigar, &routelist);
+    if (status != SIGAR_OK) {
+        return status;
+    }
+
+    for (i=0; i<routelist.number; i++) {
+        if (walker->add_route(walker, &routelist.data[i]) != SIGAR_OK) {
+            break;
+        }
+    }
+
+    sigar_net_route_list_destroy(walker->sigar, &routelist);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_arp_walk(sigar_arp_walker_t *walker)
+{
+    sigar_arp_list_t arplist;
+    unsigned long i;
+    int status;
+
+    status = sigar_arp_list_get(walker->sigar, &arplist);
+    if (status != SIGAR_OK) {
+        return status;
+    }
+
+    for (i=0; i<arplist.number; i++) {
+        sigar_arp_t *arp = &arplist.data[i];
+
+        if (walker->family && (walker->family != arp->address.family)) {
+            continue;
+        }
+        if (walker->add_arp(walker, arp) != SIGAR_OK) {
+            break;
+        }
+    }
+
+    sigar_arp_list_destroy(walker->sigar, &arplist);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_net_interface_address_walk(sigar_net_interface_address_walker_t *walker)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+int sigar_os_net_interface_address_list_get(sigar_t *sigar,
+                                            sigar_net_interface_address_list_t *addrlist)
+{
+    return SIGAR_ENOTIMPL;
+}
+#endif
+
+int sigar_who_list_create(sigar_t *sigar, sigar_who_list_t *wholist)
 {
     wholist->number = 0;
     wholist->size = SIGAR_WHO_LIST_MAX;
-    wholist->data = malloc(sizeof(*(wholist->data)) *
-                           wholist->size);
+    wholist->data = sigar_list_alloc(sigar, SIGAR_LIST_WHO,
+                                     sizeof(*(wholist->data)),
+                                     &wholist->size);
     return SIGAR_OK;
 }
 
 int sigar_who_list_grow(sigar_who_list_t *wholist)
 {
+    unsigned long size =
+        SIGAR_LIST_GROW_SIZE(wholist->size, SIGAR_WHO_LIST_MAX);
+
     wholist->data = realloc(wholist->data,
-                            sizeof(*(wholist->data)) *
-                            (wholist->size + SIGAR_WHO_LIST_MAX));
-    wholist->size += SIGAR_WHO_LIST_MAX;
+                            sizeof(*(wholist->data)) * size);
+    wholist->size = size;
 
     return SIGAR_OK;
 }
@@ -1128,7 +3037,7 @@ SIGAR_DECLARE(int) sigar_who_list_destroy(sigar_t *sigar,
                                           sigar_who_list_t *wholist)
 {
     if (wholist->size) {
-        free(wholist->data);
+        sigar_list_free(sigar, SIGAR_LIST_WHO, wholist->data, wholist->size);
         wholist->number = wholist->size = 0;
     }
 
@@ -1227,7 +3136,7 @@ int sigar_who_list_get_win32(sigar_t *sigar,
 SIGAR_DECLARE(int) sigar_who_list_get(sigar_t *sigar,
                                       sigar_who_list_t *wholist)
 {
-    sigar_who_list_create(wholist);
+    sigar_who_list_create(sigar, wholist);
 
     /* cygwin ssh */
     sigar_who_utmp(sigar, wholist);
@@ -1277,7 +3186,7 @@ int sigar_who_list_get(sigar_t *sigar,
 {
     int status;
 
-    sigar_who_list_create(wholist);
+    sigar_who_list_create(sigar, wholist);
 
     status = sigar_who_utmp(sigar, wholist);
     if (status != SIGAR_OK) {
@@ -1555,8 +3464,8 @@ static void hwaddr_arp_lookup(sigar_net_interface_config_t *ifconfig, int sock)
 #define ARPHRD_CISCO 513 /* Cisco HDLC. */
 #endif
 
-static void get_interface_type(sigar_net_interface_config_t *ifconfig,
-                               int family)
+void sigar_net_interface_type_set(sigar_net_interface_config_t *ifconfig,
+                                  int family)
 {
     char *type;
 
@@ -1640,6 +3549,40 @@ static void get_interface_type(sigar_net_interface_config_t *ifconfig,
 
 #endif
 
+sigar_uint64_t sigar_net_interface_flags_to_sigar(sigar_uint64_t flags)
+{
+#ifdef __linux__
+# ifndef IFF_DYNAMIC
+#  define IFF_DYNAMIC 0x8000 /* not in 2.2 kernel */
+# endif /* IFF_DYNAMIC */
+    int is_mcast = flags & IFF_MULTICAST;
+    int is_slave = flags & IFF_SLAVE;
+    int is_master = flags & IFF_MASTER;
+    int is_dynamic = flags & IFF_DYNAMIC;
+    /*
+     * XXX: should just define SIGAR_IFF_*
+     * and test IFF_* bits on given platform.
+     * this is the only diff between solaris/hpux/linux
+     * for the flags we care about.
+     *
+     */
+    flags &= ~(IFF_MULTICAST|IFF_SLAVE|IFF_MASTER);
+    if (is_mcast) {
+        flags |= SIGAR_IFF_MULTICAST;
+    }
+    if (is_slave) {
+        flags |= SIGAR_IFF_SLAVE;
+    }
+    if (is_master) {
+        flags |= SIGAR_IFF_MASTER;
+    }
+    if (is_dynamic) {
+        flags |= SIGAR_IFF_DYNAMIC;
+    }
+#endif
+    return flags;
+}
+
 int sigar_net_interface_config_get(sigar_t *sigar, const char *name,
                                    sigar_net_interface_config_t *ifconfig)
 {
@@ -1673,37 +3616,7 @@ int sigar_net_interface_config_get(sigar_t *sigar, const char *name,
     }
     
     if (!ioctl(sock, SIOCGIFFLAGS, &ifr)) {
-        sigar_uint64_t flags = ifr.ifr_flags;
-#ifdef __linux__
-# ifndef IFF_DYNAMIC
-#  define IFF_DYNAMIC 0x8000 /* not in 2.2 kernel */
-# endif /* IFF_DYNAMIC */
-        int is_mcast = flags & IFF_MULTICAST;
-        int is_slave = flags & IFF_SLAVE;
-        int is_master = flags & IFF_MASTER;
-        int is_dynamic = flags & IFF_DYNAMIC;
-        /*
-         * XXX: should just define SIGAR_IFF_*
-         * and test IFF_* bits on given platform.
-         * this is the only diff between solaris/hpux/linux
-         * for the flags we care about.
-         *
-         */
-        flags &= ~(IFF_MULTICAST|IFF_SLAVE|IFF_MASTER);
-        if (is_mcast) {
-            flags |= SIGAR_IFF_MULTICAST;
-        }
-        if (is_slave) {
-            flags |= SIGAR_IFF_SLAVE;
-        }
-        if (is_master) {
-            flags |= SIGAR_IFF_MASTER;
-        }
-        if (is_dynamic) {
-            flags |= SIGAR_IFF_DYNAMIC;
-        }
-#endif
-        ifconfig->flags = flags;
+        ifconfig->flags = sigar_net_interface_flags_to_sigar(ifr.ifr_flags);
     }
     else {
         /* should always be able to get flags for existing device */
@@ -1733,8 +3646,8 @@ int sigar_net_interface_config_get(sigar_t *sigar, const char *name,
 
 #if defined(SIOCGIFHWADDR)
         if (!ioctl(sock, SIOCGIFHWADDR, &ifr)) {
-            get_interface_type(ifconfig,
-                               ifr.ifr_hwaddr.sa_family);
+            sigar_net_interface_type_set(ifconfig,
+                                         ifr.ifr_hwaddr.sa_family);
             sigar_net_address_mac_set(ifconfig->hwaddr,
                                       ifr.ifr_hwaddr.sa_data,
                                       IFHWADDRLEN);
@@ -1878,8 +3791,8 @@ static int proc_net_interface_list_get(sigar_t *sigar,
 }
 #endif
 
-int sigar_net_interface_list_get(sigar_t *sigar,
-                                 sigar_net_interface_list_t *iflist)
+static int net_interface_list_get(sigar_t *sigar,
+                                  sigar_net_interface_list_t *iflist)
 {
     int n, lastlen=0;
     struct ifreq *ifr;
@@ -1958,6 +3871,19 @@ int sigar_net_interface_list_get(sigar_t *sigar,
     return SIGAR_OK;
 }
 
+/* ifconf_buf is kept for the lookups that follow on aix */
+int sigar_net_interface_list_get(sigar_t *sigar,
+                                 sigar_net_interface_list_t *iflist)
+{
+    int status;
+
+    sigar_lock(sigar);
+    status = net_interface_list_get(sigar, iflist);
+    sigar_unlock(sigar);
+
+    return status;
+}
+
 #endif /* WIN32 */
 
 SIGAR_DECLARE(int)
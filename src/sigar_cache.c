@@ -46,6 +46,7 @@ sigar_cache_t *sigar_expired_cache_new(int size, sigar_uint64_t cleanup_period_m
     table->cleanup_period_millis = cleanup_period_millis;
     table->last_cleanup_time = sigar_time_now_millis();
     table->entry_expire_period = entry_expire_period;
+    table->hits = table->misses = 0;
     return table;
 }
 
@@ -182,10 +183,12 @@ sigar_cache_entry_t *sigar_cache_find(sigar_cache_t *table,
     {
         if (entry->id == key) {
             entry->last_access_time = sigar_time_now_millis();
+            table->hits++;
             return entry;
         }
     }
 
+    table->misses++;
     return NULL;
 }
 
@@ -202,10 +205,13 @@ sigar_cache_entry_t *sigar_cache_get(sigar_cache_t *table,
     {
         if (entry->id == key) {
             entry->last_access_time = sigar_time_now_millis();
+            table->hits++;
             return entry;
         }
     }
 
+    table->misses++;
+
     if (++table->count > table->size) {
         sigar_cache_rehash(table);
 
@@ -0,0 +1,875 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_util.h"
+#include "sigar_collector.h"
+
+#ifndef WIN32
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* darwin has no pthread_condattr_setclock */
+#if defined(CLOCK_MONOTONIC) && !defined(__APPLE__)
+#define COLLECTOR_MONOTONIC
+#define COLLECTOR_CLOCK CLOCK_MONOTONIC
+#else
+#define COLLECTOR_CLOCK CLOCK_REALTIME
+#endif
+
+#define COLLECTOR_SETS_GROW 8
+
+#define COLLECTOR_SHM_MAGIC "SIGARSHM"
+#define COLLECTOR_SHM_VERSION 2
+
+/*
+ * heartbeats a publisher may miss before its segment can be taken
+ * over, if its pid does not answer either.
+ */
+#define COLLECTOR_SHM_BEATS 3
+
+/*
+ * one writer, any number of readers.  seq is 2n while sample n is in
+ * the slot and 2n-1 while it is being written, a reader that sees it
+ * change across its copy has raced the writer and tries again.
+ */
+typedef struct {
+    sigar_uint64_t seq;
+    sigar_collector_sample_t sample;
+} collector_slot_t;
+
+/*
+ * the published segment: this header, the sets as they were added
+ * and one slot per set holding its latest sample.  version is stored
+ * last, readers that find 0 caught the publisher setting it up.
+ * heartbeat is the time of the last sample written, at least every
+ * interval (the shortest of the sets) while the collector runs.
+ */
+typedef struct {
+    char magic[8];
+    sigar_uint32_t version;
+    sigar_uint32_t sample_size;
+    sigar_uint64_t number;
+    sigar_uint64_t pid;
+    sigar_uint64_t started;
+    sigar_uint64_t closed;
+    sigar_uint64_t interval;
+    sigar_uint64_t heartbeat;
+} collector_shm_t;
+
+#define COLLECTOR_SHM_SETS(shm) \
+    ((sigar_collector_set_t *)((shm) + 1))
+
+#define COLLECTOR_SHM_SLOTS(shm) \
+    ((collector_slot_t *)(COLLECTOR_SHM_SETS(shm) + (shm)->number))
+
+#define COLLECTOR_SHM_SIZE(number) \
+    (sizeof(collector_shm_t) + \
+     ((number) * (sizeof(sigar_collector_set_t) + sizeof(collector_slot_t))))
+
+typedef struct {
+    sigar_collector_set_t set;
+    /* the collector thread's alone */
+    sigar_uint64_t next;
+    sigar_uint64_t jitter_max;
+    sigar_uint64_t jitter_total;
+    sigar_uint64_t missed;
+    /* newest complete sample, 0 before the first */
+    sigar_uint64_t latest;
+    collector_slot_t *ring;
+} collector_set_t;
+
+struct sigar_collector_t {
+    sigar_t *sigar;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int running;
+    int stop;
+    unsigned long mask;
+    unsigned long number;
+    unsigned long size;
+    collector_set_t *sets;
+    char *shm_name;
+    collector_shm_t *shm;
+    /* of the segment we created, the name may be reused after */
+    dev_t shm_dev;
+    ino_t shm_ino;
+};
+
+struct sigar_collector_shm_t {
+    collector_shm_t *shm;
+    size_t size;
+};
+
+static sigar_uint64_t collector_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(COLLECTOR_CLOCK, &ts);
+
+    return ((sigar_uint64_t)ts.tv_sec * SIGAR_MSEC) +
+        (ts.tv_nsec / (SIGAR_NSEC / SIGAR_MSEC));
+}
+
+SIGAR_DECLARE(int) sigar_collector_create(sigar_collector_t **collector,
+                                          unsigned long ring_size)
+{
+    sigar_collector_t *c;
+    pthread_condattr_t attr;
+    unsigned long size = 1;
+    int status;
+
+    while (size < ring_size) {
+        size <<= 1;
+    }
+
+    c = calloc(1, sizeof(*c));
+    if (!c) {
+        return ENOMEM;
+    }
+
+    if ((status = sigar_open(&c->sigar)) != SIGAR_OK) {
+        free(c);
+        return status;
+    }
+
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_condattr_init(&attr);
+#ifdef COLLECTOR_MONOTONIC
+    pthread_condattr_setclock(&attr, COLLECTOR_CLOCK);
+#endif
+    pthread_cond_init(&c->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    c->mask = size - 1;
+
+    *collector = c;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_collector_add(sigar_collector_t *collector,
+                                       sigar_collector_set_t *set,
+                                       int *id)
+{
+    collector_set_t *cset;
+
+    /* readers index sets without a lock, they must not move */
+    if (collector->running || collector->shm) {
+        return EBUSY;
+    }
+
+    if ((set->type < SIGAR_COLLECT_CPU) ||
+        (set->type > SIGAR_COLLECT_PROC) ||
+        (set->interval == 0))
+    {
+        return EINVAL;
+    }
+
+    if (collector->number >= collector->size) {
+        collector->size += COLLECTOR_SETS_GROW;
+        collector->sets =
+            realloc(collector->sets,
+                    sizeof(*(collector->sets)) * collector->size);
+    }
+
+    cset = &collector->sets[collector->number];
+    SIGAR_ZERO(cset);
+    memcpy(&cset->set, set, sizeof(*set));
+    cset->set.name[sizeof(cset->set.name)-1] = '\0';
+
+    cset->ring = calloc(collector->mask + 1, sizeof(*cset->ring));
+    if (!cset->ring) {
+        return ENOMEM;
+    }
+
+    *id = (int)collector->number++;
+
+    return SIGAR_OK;
+}
+
+static int collector_sample(sigar_t *sigar, sigar_collector_set_t *set,
+                            sigar_collector_sample_t *sample)
+{
+    sigar_collector_proc_t *proc = &sample->data.proc;
+    int status;
+
+    switch (set->type) {
+      case SIGAR_COLLECT_CPU:
+        return sigar_cpu_get(sigar, &sample->data.cpu);
+      case SIGAR_COLLECT_MEM:
+        return sigar_mem_get(sigar, &sample->data.mem);
+      case SIGAR_COLLECT_NETIF:
+        return sigar_net_interface_stat_get(sigar, set->name,
+                                            &sample->data.netif);
+      case SIGAR_COLLECT_DISK:
+        return sigar_disk_usage_get(sigar, set->name, &sample->data.disk);
+      case SIGAR_COLLECT_PROC_STAT:
+        return sigar_proc_stat_get(sigar, &sample->data.proc_stat);
+      case SIGAR_COLLECT_PROC:
+        if ((status = sigar_proc_state_get(sigar, set->pid,
+                                           &proc->state)) != SIGAR_OK)
+        {
+            return status;
+        }
+        if ((status = sigar_proc_mem_get(sigar, set->pid,
+                                         &proc->mem)) != SIGAR_OK)
+        {
+            return status;
+        }
+        return sigar_proc_cpu_get(sigar, set->pid, &proc->cpu);
+      default:
+        return EINVAL;
+    }
+}
+
+static void collector_slot_write(collector_slot_t *slot,
+                                 sigar_collector_sample_t *sample)
+{
+    SIGAR_ATOMIC_STORE(&slot->seq, (sample->seq * 2) - 1);
+    SIGAR_ATOMIC_FENCE();
+    memcpy(&slot->sample, sample, sizeof(*sample));
+    SIGAR_ATOMIC_STORE(&slot->seq, sample->seq * 2);
+}
+
+static int collector_slot_read(collector_slot_t *slot,
+                               sigar_uint64_t seq,
+                               sigar_collector_sample_t *sample)
+{
+    sigar_uint64_t before, after;
+
+    before = SIGAR_ATOMIC_LOAD(&slot->seq);
+    if (before != (seq * 2)) {
+        return ENOENT;
+    }
+
+    memcpy(sample, &slot->sample, sizeof(*sample));
+
+    SIGAR_ATOMIC_FENCE();
+    after = SIGAR_ATOMIC_LOAD(&slot->seq);
+
+    return (after == before) ? SIGAR_OK : ENOENT;
+}
+
+static void collector_set_run(sigar_collector_t *collector,
+                              collector_set_t *cset,
+                              sigar_uint64_t now)
+{
+    sigar_uint64_t seq = cset->latest + 1;
+    collector_slot_t *slot = &cset->ring[(seq - 1) & collector->mask];
+    sigar_collector_sample_t sample;
+    sigar_uint64_t interval = cset->set.interval;
+
+    SIGAR_ZERO(&sample);
+
+    sample.seq = seq;
+    sample.type = cset->set.type;
+    sample.scheduled = cset->next;
+    sample.time = now;
+    sample.timestamp = sigar_time_now_millis();
+    sample.jitter = now - cset->next;
+
+    sample.status = collector_sample(collector->sigar, &cset->set, &sample);
+    if (sample.status != SIGAR_OK) {
+        SIGAR_ZERO(&sample.data);
+    }
+
+    if (sample.jitter > cset->jitter_max) {
+        cset->jitter_max = sample.jitter;
+    }
+    cset->jitter_total += sample.jitter;
+
+    /* keep to the original schedule, dropping the intervals we overran */
+    cset->next += interval;
+    now = collector_now();
+    if (cset->next <= now) {
+        sigar_uint64_t behind = (now - cset->next) / interval + 1;
+        cset->missed += behind;
+        cset->next += behind * interval;
+    }
+
+    sample.jitter_max = cset->jitter_max;
+    sample.jitter_total = cset->jitter_total;
+    sample.missed = cset->missed;
+
+    collector_slot_write(slot, &sample);
+    SIGAR_ATOMIC_STORE(&cset->latest, seq);
+
+    if (collector->shm) {
+        slot = COLLECTOR_SHM_SLOTS(collector->shm);
+        collector_slot_write(&slot[cset - collector->sets], &sample);
+        SIGAR_ATOMIC_STORE(&collector->shm->heartbeat, sample.timestamp);
+    }
+}
+
+static void *collector_thread(void *data)
+{
+    sigar_collector_t *collector = data;
+    sigar_uint64_t now = collector_now();
+    unsigned long i;
+
+    for (i=0; i<collector->number; i++) {
+        collector->sets[i].next = now;
+    }
+
+    pthread_mutex_lock(&collector->lock);
+
+    while (!collector->stop) {
+        sigar_uint64_t next = 0;
+        struct timespec ts;
+
+        pthread_mutex_unlock(&collector->lock);
+
+        now = collector_now();
+
+        for (i=0; i<collector->number; i++) {
+            collector_set_t *cset = &collector->sets[i];
+
+            if (cset->next <= now) {
+                collector_set_run(collector, cset, now);
+                now = collector_now();
+            }
+            if (!next || (cset->next < next)) {
+                next = cset->next;
+            }
+        }
+
+        pthread_mutex_lock(&collector->lock);
+
+        if (collector->stop) {
+            break;
+        }
+        if (next <= collector_now()) {
+            continue;
+        }
+
+        /* the condvar waits on COLLECTOR_CLOCK as well */
+        ts.tv_sec = next / SIGAR_MSEC;
+        ts.tv_nsec = (next % SIGAR_MSEC) * (SIGAR_NSEC / SIGAR_MSEC);
+        pthread_cond_timedwait(&collector->cond, &collector->lock, &ts);
+    }
+
+    pthread_mutex_unlock(&collector->lock);
+
+    return NULL;
+}
+
+SIGAR_DECLARE(int) sigar_collector_start(sigar_collector_t *collector)
+{
+    int status;
+
+    if (collector->running) {
+        return EBUSY;
+    }
+
+    collector->stop = 0;
+
+    status = pthread_create(&collector->thread, NULL,
+                            collector_thread, collector);
+    if (status != 0) {
+        return status;
+    }
+
+    collector->running = 1;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_collector_stop(sigar_collector_t *collector)
+{
+    if (!collector->running) {
+        return SIGAR_OK;
+    }
+
+    pthread_mutex_lock(&collector->lock);
+    collector->stop = 1;
+    pthread_cond_signal(&collector->cond);
+    pthread_mutex_unlock(&collector->lock);
+
+    pthread_join(collector->thread, NULL);
+
+    collector->running = 0;
+
+    return SIGAR_OK;
+}
+
+/* name still maps to the segment dev/ino */
+static int collector_shm_is(const char *name, dev_t dev, ino_t ino)
+{
+    struct stat sb;
+    int fd, is;
+
+    if ((fd = shm_open(name, O_RDONLY, 0)) < 0) {
+        return 0;
+    }
+
+    is = (fstat(fd, &sb) == 0) && (sb.st_dev == dev) && (sb.st_ino == ino);
+    close(fd);
+
+    return is;
+}
+
+/*
+ * the segment at name was left by a publisher that has closed it or
+ * died without, dev/ino say which one was looked at.  one being set
+ * up, or that is not ours at all, is left alone.
+ *
+ * kill() is only a hint: a publisher in another pid namespace is
+ * ESRCH here while alive, and its pid may be someone else's.  so a
+ * segment that is not closed is only stale once its pid does not
+ * answer and it has missed COLLECTOR_SHM_BEATS heartbeats too.
+ */
+static int collector_shm_stale(const char *name, dev_t *dev, ino_t *ino)
+{
+    collector_shm_t *shm;
+    struct stat sb;
+    int fd, stale = 0;
+
+    *dev = 0;
+    *ino = 0;
+
+    /* gone meanwhile */
+    if ((fd = shm_open(name, O_RDONLY, 0)) < 0) {
+        return errno == ENOENT;
+    }
+
+    if ((fstat(fd, &sb) < 0) || ((size_t)sb.st_size < sizeof(*shm))) {
+        close(fd);
+        return 0;
+    }
+
+    shm = mmap(NULL, sizeof(*shm), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (shm == MAP_FAILED) {
+        return 0;
+    }
+
+    if ((memcmp(shm->magic, COLLECTOR_SHM_MAGIC, sizeof(shm->magic)) == 0) &&
+        (SIGAR_ATOMIC_LOAD(&shm->version) != 0))
+    {
+        sigar_uint64_t now = sigar_time_now_millis();
+        sigar_uint64_t heartbeat = SIGAR_ATOMIC_LOAD(&shm->heartbeat);
+
+        if (SIGAR_ATOMIC_LOAD(&shm->closed)) {
+            stale = 1;
+        }
+        else if ((kill((pid_t)shm->pid, 0) < 0) && (errno == ESRCH) &&
+                 (now > heartbeat) &&
+                 ((now - heartbeat) > COLLECTOR_SHM_BEATS * shm->interval))
+        {
+            stale = 1;
+        }
+    }
+
+    munmap(shm, sizeof(*shm));
+
+    *dev = sb.st_dev;
+    *ino = sb.st_ino;
+
+    return stale;
+}
+
+SIGAR_DECLARE(int) sigar_collector_destroy(sigar_collector_t *collector)
+{
+    unsigned long i;
+
+    sigar_collector_stop(collector);
+
+    for (i=0; i<collector->number; i++) {
+        free(collector->sets[i].ring);
+    }
+    if (collector->sets) {
+        free(collector->sets);
+    }
+
+    if (collector->shm) {
+        SIGAR_ATOMIC_STORE(&collector->shm->closed, 1);
+        munmap(collector->shm,
+               COLLECTOR_SHM_SIZE(collector->shm->number));
+        /* not a newer publisher's that took over a name we left stale */
+        if (collector_shm_is(collector->shm_name,
+                             collector->shm_dev, collector->shm_ino))
+        {
+            shm_unlink(collector->shm_name);
+        }
+        free(collector->shm_name);
+    }
+
+    pthread_cond_destroy(&collector->cond);
+    pthread_mutex_destroy(&collector->lock);
+
+    sigar_close(collector->sigar);
+    free(collector);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_collector_latest_get(sigar_collector_t *collector, int id,
+                           sigar_collector_sample_t *sample)
+{
+    collector_set_t *cset;
+    collector_slot_t *slot;
+    int tries;
+
+    if ((id < 0) || ((unsigned long)id >= collector->number)) {
+        return EINVAL;
+    }
+
+    cset = &collector->sets[id];
+
+    /* a whole ring's worth of samples has to be written meanwhile to fail */
+    for (tries=0; tries<3; tries++) {
+        sigar_uint64_t latest = SIGAR_ATOMIC_LOAD(&cset->latest);
+
+        if (latest == 0) {
+            return ENOENT;
+        }
+        slot = &cset->ring[(latest - 1) & collector->mask];
+        if (collector_slot_read(slot, latest, sample) == SIGAR_OK) {
+            return SIGAR_OK;
+        }
+    }
+
+    return EAGAIN;
+}
+
+SIGAR_DECLARE(int)
+sigar_collector_sample_get(sigar_collector_t *collector, int id,
+                           sigar_uint64_t seq,
+                           sigar_collector_sample_t *sample)
+{
+    collector_set_t *cset;
+
+    if ((id < 0) || ((unsigned long)id >= collector->number)) {
+        return EINVAL;
+    }
+
+    cset = &collector->sets[id];
+
+    if ((seq == 0) || (seq > SIGAR_ATOMIC_LOAD(&cset->latest))) {
+        return ENOENT;
+    }
+
+    return collector_slot_read(&cset->ring[(seq - 1) & collector->mask],
+                               seq, sample);
+}
+
+SIGAR_DECLARE(int) sigar_collector_publish(sigar_collector_t *collector,
+                                           const char *name)
+{
+    collector_shm_t *shm;
+    size_t size = COLLECTOR_SHM_SIZE(collector->number);
+    struct stat sb;
+    unsigned long i;
+    int fd, status;
+
+    if (collector->running || collector->shm) {
+        return EBUSY;
+    }
+
+    /*
+     * a new segment rather than the old one truncated, readers that
+     * still map a previous publisher's see it closed, not zeroed.
+     * that one is only unlinked once it is stale, a live publisher
+     * of the same name gets EEXIST.
+     */
+    if ((fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0644)) < 0) {
+        dev_t dev;
+        ino_t ino;
+
+        if (errno != EEXIST) {
+            return errno;
+        }
+        if (!collector_shm_stale(name, &dev, &ino)) {
+            return EEXIST;
+        }
+        if (collector_shm_is(name, dev, ino)) {
+            shm_unlink(name);
+        }
+        if ((fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0644)) < 0) {
+            return errno;
+        }
+    }
+
+    if ((fstat(fd, &sb) < 0) || (ftruncate(fd, size) < 0)) {
+        status = errno;
+        close(fd);
+        shm_unlink(name);
+        return status;
+    }
+
+    shm = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    status = errno;
+    close(fd);
+
+    if (shm == MAP_FAILED) {
+        shm_unlink(name);
+        return status;
+    }
+
+    memcpy(shm->magic, COLLECTOR_SHM_MAGIC, sizeof(shm->magic));
+    shm->sample_size = sizeof(sigar_collector_sample_t);
+    shm->number = collector->number;
+    shm->pid = getpid();
+    shm->started = sigar_time_now_millis();
+    shm->heartbeat = shm->started;
+
+    for (i=0; i<collector->number; i++) {
+        sigar_uint64_t interval = collector->sets[i].set.interval;
+
+        memcpy(&COLLECTOR_SHM_SETS(shm)[i], &collector->sets[i].set,
+               sizeof(sigar_collector_set_t));
+        if (!shm->interval || (interval < shm->interval)) {
+            shm->interval = interval;
+        }
+    }
+
+    SIGAR_ATOMIC_STORE(&shm->version, COLLECTOR_SHM_VERSION);
+
+    collector->shm = shm;
+    collector->shm_name = sigar_strdup(name);
+    collector->shm_dev = sb.st_dev;
+    collector->shm_ino = sb.st_ino;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_collector_shm_open(sigar_collector_shm_t **reader,
+                                            const char *name)
+{
+    collector_shm_t *shm;
+    struct stat sb;
+    int fd, status;
+
+    if ((fd = shm_open(name, O_RDONLY, 0)) < 0) {
+        return errno;
+    }
+
+    if (fstat(fd, &sb) < 0) {
+        status = errno;
+        close(fd);
+        return status;
+    }
+
+    if ((size_t)sb.st_size < sizeof(*shm)) {
+        close(fd);
+        return EAGAIN; /* not truncated to size yet */
+    }
+
+    shm = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    status = errno;
+    close(fd);
+
+    if (shm == MAP_FAILED) {
+        return status;
+    }
+
+    status = SIGAR_OK;
+
+    if (SIGAR_ATOMIC_LOAD(&shm->version) == 0) {
+        status = EAGAIN;
+    }
+    /* another layout, or a build where the sample differs (32 vs 64 bit) */
+    else if ((memcmp(shm->magic, COLLECTOR_SHM_MAGIC,
+                     sizeof(shm->magic)) != 0) ||
+             (shm->version != COLLECTOR_SHM_VERSION) ||
+             (shm->sample_size != sizeof(sigar_collector_sample_t)) ||
+             ((size_t)sb.st_size < COLLECTOR_SHM_SIZE(shm->number)))
+    {
+        status = EINVAL;
+    }
+
+    if (status != SIGAR_OK) {
+        munmap(shm, sb.st_size);
+        return status;
+    }
+
+    *reader = malloc(sizeof(**reader));
+    (*reader)->shm = shm;
+    (*reader)->size = sb.st_size;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_collector_shm_close(sigar_collector_shm_t *reader)
+{
+    munmap(reader->shm, reader->size);
+    free(reader);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_collector_shm_info_get(sigar_collector_shm_t *reader,
+                             sigar_collector_shm_info_t *info)
+{
+    collector_shm_t *shm = reader->shm;
+
+    info->number = shm->number;
+    info->pid = shm->pid;
+    info->started = shm->started;
+    info->heartbeat = SIGAR_ATOMIC_LOAD(&shm->heartbeat);
+    info->closed = SIGAR_ATOMIC_LOAD(&shm->closed);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_collector_shm_set_get(sigar_collector_shm_t *reader, int id,
+                            sigar_collector_set_t *set)
+{
+    collector_shm_t *shm = reader->shm;
+
+    if ((id < 0) || ((sigar_uint64_t)id >= shm->number)) {
+        return EINVAL;
+    }
+
+    memcpy(set, &COLLECTOR_SHM_SETS(shm)[id], sizeof(*set));
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int)
+sigar_collector_shm_latest_get(sigar_collector_shm_t *reader, int id,
+                               sigar_collector_sample_t *sample)
+{
+    collector_shm_t *shm = reader->shm;
+    collector_slot_t *slot;
+    int tries;
+
+    if ((id < 0) || ((sigar_uint64_t)id >= shm->number)) {
+        return EINVAL;
+    }
+
+    if (SIGAR_ATOMIC_LOAD(&shm->closed)) {
+        return ESRCH; /* the publisher is gone, open the name again */
+    }
+
+    slot = &COLLECTOR_SHM_SLOTS(shm)[id];
+
+    for (tries=0; tries<3; tries++) {
+        sigar_uint64_t seq = SIGAR_ATOMIC_LOAD(&slot->seq);
+
+        if (seq == 0) {
+            return ENOENT;
+        }
+        if (seq & 1) {
+            continue; /* mid write */
+        }
+        if (collector_slot_read(slot, seq / 2, sample) == SIGAR_OK) {
+            return SIGAR_OK;
+        }
+    }
+
+    return EAGAIN;
+}
+
+#else /* WIN32 */
+
+SIGAR_DECLARE(int) sigar_collector_create(sigar_collector_t **collector,
+                                          unsigned long ring_size)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_collector_add(sigar_collector_t *collector,
+                                       sigar_collector_set_t *set,
+                                       int *id)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_collector_start(sigar_collector_t *collector)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_collector_stop(sigar_collector_t *collector)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_collector_destroy(sigar_collector_t *collector)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int)
+sigar_collector_latest_get(sigar_collector_t *collector, int id,
+                           sigar_collector_sample_t *sample)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int)
+sigar_collector_sample_get(sigar_collector_t *collector, int id,
+                           sigar_uint64_t seq,
+                           sigar_collector_sample_t *sample)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_collector_publish(sigar_collector_t *collector,
+                                           const char *name)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_collector_shm_open(sigar_collector_shm_t **reader,
+                                            const char *name)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_collector_shm_close(sigar_collector_shm_t *reader)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int)
+sigar_collector_shm_info_get(sigar_collector_shm_t *reader,
+                             sigar_collector_shm_info_t *info)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int)
+sigar_collector_shm_set_get(sigar_collector_shm_t *reader, int id,
+                            sigar_collector_set_t *set)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int)
+sigar_collector_shm_latest_get(sigar_collector_shm_t *reader, int id,
+                               sigar_collector_sample_t *sample)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+#endif /* WIN32 */
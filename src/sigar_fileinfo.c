@@ -577,6 +577,8 @@ static int dir_stat_get(sigar_t *sigar,
 
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -750,6 +752,7 @@ static int dir_stat_get(sigar_t *sigar,
         }
 
         dirstats->disk_usage += info.st_size;
+        dirstats->disk_allocated += (sigar_uint64_t)info.st_blocks * 512;
 
         switch (filetype_from_mode(info.st_mode)) {
           case SIGAR_FILETYPE_REG:
@@ -796,20 +799,528 @@ static int dir_stat_get(sigar_t *sigar,
     return SIGAR_OK;
 }
 
+#ifdef AT_FDCWD
+/*
+ * fd relative scanner used by sigar_dir_usage_scan.
+ * entries are fstatat()-ed relative to their directory fd instead of
+ * building and resolving a full path for every file.  each thread
+ * walks depth first; when another thread is idle, subdirectories are
+ * handed off to it instead of being descended locally.
+ */
+#define SIGAR_DIR_SCAN
+
+#include <stdlib.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+#ifndef O_NOFOLLOW
+#define O_NOFOLLOW 0
+#endif
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+#define DIR_SCAN_OPEN_FLAGS \
+    (O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)
+
+#define DIR_SCAN_THREADS_MAX 8
+
+/* getdents64 batch size */
+#define DIR_SCAN_BUFSIZ (64 * 1024)
+
+typedef struct dir_scan_task_t dir_scan_task_t;
+
+struct dir_scan_task_t {
+    dir_scan_task_t *next;
+    int fd;
+    int depth;
+    char path[SIGAR_PATH_MAX+1];
+};
+
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+} dir_scan_link_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    dir_scan_task_t *tasks;
+    int queued;
+    int idle;
+    int active;
+    int done;
+    int max_depth;
+    int flags;
+    dev_t dev;
+    /* open addressed set of (dev, ino) for files with st_nlink > 1 */
+    pthread_mutex_t links_lock;
+    dir_scan_link_t *links;
+    unsigned long links_size;
+    unsigned long links_number;
+} dir_scan_t;
+
+typedef struct {
+    dir_scan_t *scan;
+    sigar_dir_stat_t stats;
+    /* one getdents buffer per level of local recursion */
+    char **bufs;
+    int nbufs;
+    /* of the dir being walked, left alone below one too long for it */
+    char path[SIGAR_PATH_MAX+1];
+    /* the first directory that could not be read */
+    int status;
+} dir_scan_worker_t;
+
+#define DIR_SCAN_LINK_HASH(dev, ino) \
+    ((unsigned long)(((sigar_uint64_t)(ino) * 31) ^ (sigar_uint64_t)(dev)))
+
+static int dir_scan_link_add(dir_scan_link_t *links, unsigned long size,
+                             dev_t dev, ino_t ino)
+{
+    unsigned long i = DIR_SCAN_LINK_HASH(dev, ino) & (size - 1);
+
+    while (links[i].ino || links[i].dev) {
+        if ((links[i].ino == ino) && (links[i].dev == dev)) {
+            return 0;
+        }
+        i = (i + 1) & (size - 1);
+    }
+
+    links[i].dev = dev;
+    links[i].ino = ino;
+
+    return 1;
+}
+
+/* returns 1 the first time an inode is seen */
+static int dir_scan_link_first(dir_scan_t *scan, struct stat *info)
+{
+    int first;
+
+    pthread_mutex_lock(&scan->links_lock);
+
+    if ((scan->links_number + 1) * 2 > scan->links_size) {
+        unsigned long i, size = scan->links_size ? scan->links_size * 2 : 1024;
+        dir_scan_link_t *links = calloc(size, sizeof(*links));
+
+        for (i=0; i<scan->links_size; i++) {
+            if (scan->links[i].ino || scan->links[i].dev) {
+                dir_scan_link_add(links, size,
+                                  scan->links[i].dev, scan->links[i].ino);
+            }
+        }
+        if (scan->links) {
+            free(scan->links);
+        }
+        scan->links = links;
+        scan->links_size = size;
+    }
+
+    if ((first = dir_scan_link_add(scan->links, scan->links_size,
+                                   info->st_dev, info->st_ino)))
+    {
+        scan->links_number++;
+    }
+
+    pthread_mutex_unlock(&scan->links_lock);
+
+    return first;
+}
+
+/* hand dir off to an idle thread, returns 0 if nobody is waiting */
+static int dir_scan_share(dir_scan_t *scan, const char *path, int depth)
+{
+    dir_scan_task_t *task;
+
+    pthread_mutex_lock(&scan->lock);
+    if (scan->idle <= scan->queued) {
+        pthread_mutex_unlock(&scan->lock);
+        return 0;
+    }
+    task = malloc(sizeof(*task));
+    task->fd = -1;
+    task->depth = depth;
+    strcpy(task->path, path); /* caller checked the length */
+    task->next = scan->tasks;
+    scan->tasks = task;
+    scan->queued++;
+    pthread_cond_signal(&scan->cond);
+    pthread_mutex_unlock(&scan->lock);
+
+    return 1;
+}
+
+static void dir_scan_entry(dir_scan_worker_t *worker, int dirfd,
+                           const char *name, int len,
+                           int pathlen, int depth, int level);
+
+static void dir_scan_dir(dir_scan_worker_t *worker, int fd,
+                         int pathlen, int depth, int level)
+{
+#ifdef __linux__
+    char *buf;
+    long nread;
+
+    if (level >= worker->nbufs) {
+        worker->bufs = realloc(worker->bufs,
+                               sizeof(*worker->bufs) * (level + 1));
+        while (worker->nbufs <= level) {
+            worker->bufs[worker->nbufs++] = NULL;
+        }
+    }
+    if (!(buf = worker->bufs[level])) {
+        buf = worker->bufs[level] = malloc(DIR_SCAN_BUFSIZ);
+    }
+
+    while ((nread = syscall(SYS_getdents64, fd, buf, DIR_SCAN_BUFSIZ)) != 0) {
+        long pos = 0;
+
+        if (nread < 0) {
+            if (worker->status == SIGAR_OK) {
+                worker->status = errno;
+            }
+            break;
+        }
+
+        while (pos < nread) {
+            /* struct linux_dirent64 */
+            unsigned short reclen = *(unsigned short *)(buf + pos + 16);
+            char *name = buf + pos + 19;
+
+            if (!IS_DOTDIR(name)) {
+                dir_scan_entry(worker, fd, name, strlen(name),
+                               pathlen, depth, level);
+            }
+            pos += reclen;
+        }
+    }
+
+    close(fd);
+#else
+    DIR *dirp = fdopendir(fd);
+    struct dirent *ent;
+
+    if (!dirp) {
+        close(fd);
+        return;
+    }
+
+    for (;;) {
+        errno = 0;
+        if (!(ent = readdir(dirp))) {
+            if (errno && (worker->status == SIGAR_OK)) {
+                worker->status = errno;
+            }
+            break;
+        }
+        if (!IS_DOTDIR(ent->d_name)) {
+            dir_scan_entry(worker, fd, ent->d_name, strlen(ent->d_name),
+                           pathlen, depth, level);
+        }
+    }
+
+    closedir(dirp);
+#endif
+}
+
+static void dir_scan_entry(dir_scan_worker_t *worker, int dirfd,
+                           const char *name, int len,
+                           int pathlen, int depth, int level)
+{
+    dir_scan_t *scan = worker->scan;
+    sigar_dir_stat_t *dirstats = &worker->stats;
+    struct stat info;
+    int fd, sublen;
+
+    if (fstatat(dirfd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+        return;
+    }
+
+    if (S_ISDIR(info.st_mode) || (info.st_nlink <= 1) ||
+        dir_scan_link_first(scan, &info))
+    {
+        dirstats->disk_usage += info.st_size;
+        dirstats->disk_allocated += (sigar_uint64_t)info.st_blocks * 512;
+    }
+    else {
+        ++dirstats->hardlinks;
+    }
+
+    switch (filetype_from_mode(info.st_mode)) {
+      case SIGAR_FILETYPE_REG:
+        ++dirstats->files;
+        return;
+      case SIGAR_FILETYPE_DIR:
+        ++dirstats->subdirs;
+        break;
+      case SIGAR_FILETYPE_LNK:
+        ++dirstats->symlinks;
+        return;
+      case SIGAR_FILETYPE_CHR:
+        ++dirstats->chrdevs;
+        return;
+      case SIGAR_FILETYPE_BLK:
+        ++dirstats->blkdevs;
+        return;
+      case SIGAR_FILETYPE_SOCK:
+        ++dirstats->sockets;
+        return;
+      default:
+        return;
+    }
+
+    if ((scan->max_depth >= 0) && (depth >= scan->max_depth)) {
+        return;
+    }
+    if ((scan->flags & SIGAR_DIR_USAGE_ONE_FS) &&
+        (info.st_dev != scan->dev))
+    {
+        return;
+    }
+
+    /*
+     * path is only needed to hand the dir to another thread.  one too
+     * long to share, and all below it, is walked here by fd alone.
+     */
+    sublen = -1;
+    if ((pathlen >= 0) && (pathlen + 1 + len < (int)sizeof(worker->path))) {
+        sublen = pathlen + 1 + len;
+        worker->path[pathlen] = '/';
+        memcpy(worker->path + pathlen + 1, name, len + 1);
+
+        if (dir_scan_share(scan, worker->path, depth + 1)) {
+            worker->path[pathlen] = '\0';
+            return;
+        }
+    }
+
+    if ((fd = openat(dirfd, name, DIR_SCAN_OPEN_FLAGS)) >= 0) {
+        dir_scan_dir(worker, fd, sublen, depth + 1, level + 1);
+    }
+
+    if (pathlen >= 0) {
+        worker->path[pathlen] = '\0';
+    }
+}
+
+static void *dir_scan_worker(void *arg)
+{
+    dir_scan_worker_t *worker = arg;
+    dir_scan_t *scan = worker->scan;
+
+    pthread_mutex_lock(&scan->lock);
+
+    while (!scan->done) {
+        dir_scan_task_t *task = scan->tasks;
+
+        if (task) {
+            int fd = task->fd, pathlen;
+
+            scan->tasks = task->next;
+            scan->queued--;
+            scan->active++;
+            pthread_mutex_unlock(&scan->lock);
+
+            if (fd < 0) {
+                fd = open(task->path, DIR_SCAN_OPEN_FLAGS);
+            }
+            if (fd >= 0) {
+                pathlen = strlen(task->path);
+                memcpy(worker->path, task->path, pathlen + 1);
+                dir_scan_dir(worker, fd, pathlen, task->depth, 0);
+            }
+            free(task);
+
+            pthread_mutex_lock(&scan->lock);
+            scan->active--;
+        }
+        else if (scan->active == 0) {
+            /* nothing queued and nobody left to queue more */
+            scan->done = 1;
+            pthread_cond_broadcast(&scan->cond);
+        }
+        else {
+            scan->idle++;
+            pthread_cond_wait(&scan->cond, &scan->lock);
+            scan->idle--;
+        }
+    }
+
+    pthread_mutex_unlock(&scan->lock);
+
+    return NULL;
+}
+
+static int dir_scan(sigar_t *sigar,
+                    const char *dir,
+                    sigar_dir_usage_opts_t *opts,
+                    sigar_dir_stat_t *dirstats)
+{
+    dir_scan_t scan;
+    dir_scan_worker_t *workers;
+    dir_scan_task_t *task;
+    pthread_t *threads;
+    struct stat info;
+    int i, fd, status = SIGAR_OK, nthreads = opts->threads;
+
+    if ((fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0) {
+        return errno;
+    }
+    if (fstat(fd, &info) != 0) {
+        int status = errno;
+        close(fd);
+        return status;
+    }
+
+    if (nthreads <= 0) {
+        nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+        if (nthreads > DIR_SCAN_THREADS_MAX) {
+            nthreads = DIR_SCAN_THREADS_MAX;
+        }
+    }
+    if ((nthreads <= 0) || (opts->max_depth == 0)) {
+        nthreads = 1;
+    }
+
+    memset(&scan, 0, sizeof(scan));
+    pthread_mutex_init(&scan.lock, NULL);
+    pthread_cond_init(&scan.cond, NULL);
+    pthread_mutex_init(&scan.links_lock, NULL);
+    scan.max_depth = opts->max_depth;
+    scan.flags = opts->flags;
+    scan.dev = info.st_dev;
+
+    task = malloc(sizeof(*task));
+    task->next = NULL;
+    task->fd = fd;
+    task->depth = 0;
+    strncpy(task->path, dir, sizeof(task->path));
+    task->path[sizeof(task->path)-1] = '\0';
+    scan.tasks = task;
+    scan.queued = 1;
+
+    workers = calloc(nthreads, sizeof(*workers));
+    threads = calloc(nthreads, sizeof(*threads));
+
+    for (i=0; i<nthreads; i++) {
+        workers[i].scan = &scan;
+    }
+
+    /* the calling thread is worker 0 */
+    for (i=1; i<nthreads; i++) {
+        if (pthread_create(&threads[i], NULL,
+                           dir_scan_worker, &workers[i]) != 0)
+        {
+            break;
+        }
+    }
+    nthreads = i;
+
+    dir_scan_worker(&workers[0]);
+
+    for (i=0; i<nthreads; i++) {
+        dir_scan_worker_t *worker = &workers[i];
+        int j;
+
+        if (i > 0) {
+            pthread_join(threads[i], NULL);
+        }
+        if (status == SIGAR_OK) {
+            status = worker->status;
+        }
+
+        dirstats->disk_usage     += worker->stats.disk_usage;
+        dirstats->disk_allocated += worker->stats.disk_allocated;
+        dirstats->hardlinks      += worker->stats.hardlinks;
+        dirstats->files          += worker->stats.files;
+        dirstats->subdirs        += worker->stats.subdirs;
+        dirstats->symlinks       += worker->stats.symlinks;
+        dirstats->chrdevs        += worker->stats.chrdevs;
+        dirstats->blkdevs        += worker->stats.blkdevs;
+        dirstats->sockets        += worker->stats.sockets;
+
+        for (j=0; j<worker->nbufs; j++) {
+            if (worker->bufs[j]) {
+                free(worker->bufs[j]);
+            }
+        }
+        if (worker->bufs) {
+            free(worker->bufs);
+        }
+    }
+
+    dirstats->total =
+        dirstats->files +
+        dirstats->subdirs +
+        dirstats->symlinks +
+        dirstats->chrdevs +
+        dirstats->blkdevs +
+        dirstats->sockets;
+
+    free(workers);
+    free(threads);
+    if (scan.links) {
+        free(scan.links);
+    }
+    pthread_mutex_destroy(&scan.lock);
+    pthread_cond_destroy(&scan.cond);
+    pthread_mutex_destroy(&scan.links_lock);
+
+    return status;
+}
+#endif /* AT_FDCWD */
+
 #endif
 
 SIGAR_DECLARE(int) sigar_dir_stat_get(sigar_t *sigar,
                                       const char *dir,
                                       sigar_dir_stat_t *dirstats)
 {
-    SIGAR_ZERO(dirstats);
-    return dir_stat_get(sigar, dir, dirstats, 0);
+    sigar_dir_usage_opts_t opts;
+
+    opts.max_depth = 0;
+    opts.flags = 0;
+    opts.threads = 1;
+
+    return sigar_dir_usage_scan(sigar, dir, &opts, dirstats);
 }
 
 SIGAR_DECLARE(int) sigar_dir_usage_get(sigar_t *sigar,
                                        const char *dir,
                                        sigar_dir_usage_t *dirusage)
+{
+    sigar_dir_usage_opts_t opts;
+
+    opts.max_depth = -1;
+    opts.flags = 0;
+    opts.threads = 0;
+
+    return sigar_dir_usage_scan(sigar, dir, &opts, dirusage);
+}
+
+SIGAR_DECLARE(int) sigar_dir_usage_scan(sigar_t *sigar,
+                                        const char *dir,
+                                        sigar_dir_usage_opts_t *opts,
+                                        sigar_dir_usage_t *dirusage)
 {
     SIGAR_ZERO(dirusage);
-    return dir_stat_get(sigar, dir, dirusage, 1);
+#ifdef SIGAR_DIR_SCAN
+    return dir_scan(sigar, dir, opts, dirusage);
+#else
+    {
+        /* depth limits other than none/unlimited are not supported here */
+        int status = dir_stat_get(sigar, dir, dirusage,
+                                  opts->max_depth != 0);
+# ifdef WIN32
+        dirusage->disk_allocated = SIGAR_FIELD_NOTIMPL;
+# endif
+        return status;
+    }
+#endif
 }
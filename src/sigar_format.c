@@ -134,12 +134,29 @@ static char *sigar_error_string(int err)
     }
 }
 
+/* the last error message is per thread on a threadsafe handle */
+static char *sigar_errbuf_get(sigar_t *sigar, int *len)
+{
+    sigar_thread_scratch_t *scratch = sigar_thread_scratch_get(sigar);
+
+    if (scratch) {
+        *len = sizeof(scratch->errbuf);
+        return scratch->errbuf;
+    }
+
+    *len = sizeof(sigar->errbuf);
+    return sigar->errbuf;
+}
+
 SIGAR_DECLARE(char *) sigar_strerror(sigar_t *sigar, int err)
 {
-    char *buf;
+    char *buf, *errbuf;
+    int len;
+
+    errbuf = sigar_errbuf_get(sigar, &len);
 
     if (err < 0) {
-        return sigar->errbuf;
+        return errbuf;
     }
 
     if (err > SIGAR_OS_START_ERROR) {
@@ -153,7 +170,7 @@ SIGAR_DECLARE(char *) sigar_strerror(sigar_t *sigar, int err)
         return sigar_error_string(err);
     }
 
-    return sigar_strerror_get(err, sigar->errbuf, sizeof(sigar->errbuf));
+    return sigar_strerror_get(err, errbuf, len);
 }
 
 char *sigar_strerror_get(int err, char *errbuf, int buflen)
@@ -197,7 +214,10 @@ char *sigar_strerror_get(int err, char *errbuf, int buflen)
 
 void sigar_strerror_set(sigar_t *sigar, char *msg)
 {
-    SIGAR_SSTRCPY(sigar->errbuf, msg);
+    int len;
+    char *errbuf = sigar_errbuf_get(sigar, &len);
+
+    SIGAR_STRNCPY(errbuf, msg, len);
 }
 
 #ifdef WIN32
@@ -207,9 +227,11 @@ void sigar_strerror_set(sigar_t *sigar, char *msg)
 void sigar_strerror_printf(sigar_t *sigar, const char *format, ...)
 {
     va_list args;
+    int len;
+    char *errbuf = sigar_errbuf_get(sigar, &len);
 
     va_start(args, format);
-    vsnprintf(sigar->errbuf, sizeof(sigar->errbuf), format, args);
+    vsnprintf(errbuf, len, format, args);
     va_end(args);
 }
 
@@ -621,7 +643,7 @@ SIGAR_DECLARE(char *)sigar_net_services_name_get(sigar_t *sigar,
 {
     sigar_cache_entry_t *entry;
     sigar_cache_t **names;
-    char *pname;
+    char *pname, *name = NULL;
 
     switch (protocol) {
       case SIGAR_NETCONN_TCP:
@@ -636,17 +658,21 @@ SIGAR_DECLARE(char *)sigar_net_services_name_get(sigar_t *sigar,
         return NULL;
     }
 
+    sigar_lock(sigar);
+
     if (*names == NULL) {
         *names = sigar_cache_new(1024);
         net_services_parse(*names, pname);
     }
 
+    /* entries are never freed before sigar_close */
     if ((entry = sigar_cache_find(*names, port))) {
-        return (char *)entry->value;
-    }
-    else {
-        return NULL;
+        name = (char *)entry->value;
     }
+
+    sigar_unlock(sigar);
+
+    return name;
 }
 
 SIGAR_DECLARE(int) sigar_cpu_perc_calculate(sigar_cpu_t *prev,
@@ -0,0 +1,477 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * batched file system usage.
+ * statvfs on a hung network mount blocks in the kernel and cannot be
+ * interrupted, so each mount is handed to a small pool of worker
+ * threads and the caller only waits until the deadline.  a worker
+ * stuck on a mount is left behind and replaced; the mount is
+ * quarantined with exponential backoff so later calls skip it
+ * until it is worth probing again.
+ */
+
+#include <errno.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_util.h"
+#include "sigar_os.h"
+
+SIGAR_DECLARE(int)
+sigar_file_system_usage_list_destroy(sigar_t *sigar,
+                                     sigar_file_system_usage_list_t *usagelist)
+{
+    if (usagelist->size) {
+        free(usagelist->data);
+        usagelist->number = usagelist->size = 0;
+    }
+
+    return SIGAR_OK;
+}
+
+static void fs_usage_list_create(sigar_file_system_usage_list_t *usagelist,
+                                 sigar_file_system_list_t *fslist)
+{
+    unsigned long i;
+
+    usagelist->number = fslist->number;
+    /* always allocate, so destroy has something to free */
+    usagelist->size = fslist->number ? fslist->number : 1;
+    usagelist->data =
+        malloc(sizeof(*(usagelist->data)) * usagelist->size);
+
+    for (i=0; i<fslist->number; i++) {
+        sigar_file_system_usage_entry_t *entry = &usagelist->data[i];
+
+        SIGAR_ZERO(entry);
+        SIGAR_SSTRCPY(entry->dir_name, fslist->data[i].dir_name);
+        SIGAR_DISK_STATS_INIT(&entry->usage.disk);
+        entry->status = ETIMEDOUT;
+    }
+}
+
+#ifdef WIN32
+
+/* no worker pool here, fall back to one mount at a time */
+static int fs_usage_list_get(sigar_t *sigar,
+                             sigar_file_system_list_t *fslist,
+                             unsigned long timeout,
+                             sigar_file_system_usage_list_t *usagelist)
+{
+    unsigned long i;
+
+    fs_usage_list_create(usagelist, fslist);
+
+    for (i=0; i<fslist->number; i++) {
+        sigar_file_system_usage_entry_t *entry = &usagelist->data[i];
+
+        entry->status =
+            sigar_file_system_usage_get(sigar, entry->dir_name,
+                                        &entry->usage);
+    }
+
+    return SIGAR_OK;
+}
+
+void sigar_fs_pool_destroy(sigar_fs_pool_t *pool)
+{
+}
+
+#else
+
+#include <pthread.h>
+#include <sys/time.h>
+
+/* workers kept for healthy mounts */
+#define SIGAR_FS_POOL_THREADS 4
+/* hard limit including workers stuck on hung mounts */
+#define SIGAR_FS_POOL_MAX 32
+
+#define SIGAR_FS_QUARANTINE_MIN (30 * SIGAR_MSEC)
+#define SIGAR_FS_QUARANTINE_MAX (15 * 60 * SIGAR_MSEC)
+
+typedef struct sigar_fs_job_t sigar_fs_job_t;
+
+struct sigar_fs_job_t {
+    sigar_fs_job_t *next;
+    unsigned long *pending;
+    int started;
+    int done;
+    int abandoned;
+    int status;
+    sigar_file_system_usage_t usage;
+    char dir_name[SIGAR_FS_NAME_LEN];
+};
+
+typedef struct {
+    char dir_name[SIGAR_FS_NAME_LEN];
+    sigar_int64_t until;
+    sigar_int64_t backoff;
+    int busy; /* an abandoned statvfs is still in flight */
+} sigar_fs_quarantine_t;
+
+struct sigar_fs_pool_t {
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    sigar_fs_job_t *head;
+    sigar_fs_job_t *tail;
+    int threads;
+    int stuck;
+    int shutdown;
+    unsigned long qnumber;
+    unsigned long qsize;
+    sigar_fs_quarantine_t *quarantine;
+};
+
+static sigar_fs_quarantine_t *fs_quarantine_find(sigar_fs_pool_t *pool,
+                                                 const char *dir_name)
+{
+    unsigned long i;
+
+    for (i=0; i<pool->qnumber; i++) {
+        if (strEQ(pool->quarantine[i].dir_name, dir_name)) {
+            return &pool->quarantine[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void fs_quarantine_add(sigar_fs_pool_t *pool,
+                              const char *dir_name,
+                              sigar_int64_t now)
+{
+    sigar_fs_quarantine_t *q = fs_quarantine_find(pool, dir_name);
+
+    if (q) {
+        q->backoff *= 2;
+        if (q->backoff > SIGAR_FS_QUARANTINE_MAX) {
+            q->backoff = SIGAR_FS_QUARANTINE_MAX;
+        }
+    }
+    else {
+        if (pool->qnumber >= pool->qsize) {
+            pool->qsize += SIGAR_FS_MAX;
+            pool->quarantine =
+                realloc(pool->quarantine,
+                        sizeof(*pool->quarantine) * pool->qsize);
+        }
+        q = &pool->quarantine[pool->qnumber++];
+        SIGAR_SSTRCPY(q->dir_name, dir_name);
+        q->backoff = SIGAR_FS_QUARANTINE_MIN;
+    }
+
+    q->until = now + q->backoff;
+    q->busy = 1;
+}
+
+static void fs_quarantine_remove(sigar_fs_pool_t *pool,
+                                 const char *dir_name)
+{
+    sigar_fs_quarantine_t *q = fs_quarantine_find(pool, dir_name);
+
+    if (q) {
+        *q = pool->quarantine[--pool->qnumber];
+    }
+}
+
+static void fs_pool_free(sigar_fs_pool_t *pool)
+{
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+    if (pool->quarantine) {
+        free(pool->quarantine);
+    }
+    free(pool);
+}
+
+static void *fs_pool_worker(void *arg)
+{
+    sigar_fs_pool_t *pool = arg;
+    int last;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (1) {
+        sigar_fs_job_t *job;
+
+        while (!pool->head && !pool->shutdown) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+
+        job = pool->head;
+        if (!(pool->head = job->next)) {
+            pool->tail = NULL;
+        }
+        job->started = 1;
+
+        pthread_mutex_unlock(&pool->lock);
+        /* sigar_t is not touched; this thread may outlive it */
+        job->status = sigar_statvfs(NULL, job->dir_name, &job->usage);
+        pthread_mutex_lock(&pool->lock);
+
+        job->done = 1;
+
+        if (job->abandoned) {
+            sigar_fs_quarantine_t *q =
+                fs_quarantine_find(pool, job->dir_name);
+            if (q) {
+                q->busy = 0;
+            }
+            free(job);
+            pool->stuck--;
+
+            /* a replacement was started while we were stuck */
+            if ((pool->threads - pool->stuck) > SIGAR_FS_POOL_THREADS) {
+                break;
+            }
+        }
+        else if (--*job->pending == 0) {
+            pthread_cond_broadcast(&pool->done);
+        }
+    }
+
+    pool->threads--;
+    last = pool->shutdown && (pool->threads == 0);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (last) {
+        fs_pool_free(pool);
+    }
+
+    return NULL;
+}
+
+static void fs_pool_spawn(sigar_fs_pool_t *pool)
+{
+    while (((pool->threads - pool->stuck) < SIGAR_FS_POOL_THREADS) &&
+           (pool->threads < SIGAR_FS_POOL_MAX))
+    {
+        pthread_t thread;
+        pthread_attr_t attr;
+        int status;
+
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        status = pthread_create(&thread, &attr, fs_pool_worker, pool);
+        pthread_attr_destroy(&attr);
+
+        if (status != 0) {
+            break;
+        }
+        pool->threads++;
+    }
+}
+
+static sigar_fs_pool_t *fs_pool_get(sigar_t *sigar)
+{
+    sigar_fs_pool_t *pool;
+
+    sigar_lock(sigar);
+
+    if (!(pool = sigar->fs_pool)) {
+        pool = sigar->fs_pool = malloc(sizeof(*pool));
+        SIGAR_ZERO(pool);
+        pthread_mutex_init(&pool->lock, NULL);
+        pthread_cond_init(&pool->work, NULL);
+        pthread_cond_init(&pool->done, NULL);
+    }
+
+    sigar_unlock(sigar);
+
+    return pool;
+}
+
+void sigar_fs_pool_destroy(sigar_fs_pool_t *pool)
+{
+    int last;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work);
+    /* workers stuck in statvfs free the pool on their way out */
+    last = (pool->threads == 0);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (last) {
+        fs_pool_free(pool);
+    }
+}
+
+static void fs_pool_dequeue(sigar_fs_pool_t *pool, sigar_fs_job_t *job)
+{
+    sigar_fs_job_t *prev = NULL, *ptr;
+
+    for (ptr = pool->head; ptr; prev = ptr, ptr = ptr->next) {
+        if (ptr == job) {
+            if (prev) {
+                prev->next = job->next;
+            }
+            else {
+                pool->head = job->next;
+            }
+            if (pool->tail == job) {
+                pool->tail = prev;
+            }
+            return;
+        }
+    }
+}
+
+static int fs_usage_list_get(sigar_t *sigar,
+                             sigar_file_system_list_t *fslist,
+                             unsigned long timeout,
+                             sigar_file_system_usage_list_t *usagelist)
+{
+    sigar_fs_pool_t *pool = fs_pool_get(sigar);
+    sigar_fs_job_t **jobs;
+    sigar_int64_t now = sigar_time_now_millis();
+    sigar_int64_t deadline = now + timeout;
+    unsigned long i, pending = 0;
+    struct timespec abstime;
+
+    fs_usage_list_create(usagelist, fslist);
+
+    if (fslist->number == 0) {
+        return SIGAR_OK;
+    }
+
+    jobs = calloc(fslist->number, sizeof(*jobs));
+
+    abstime.tv_sec = deadline / SIGAR_MSEC;
+    abstime.tv_nsec = (deadline % SIGAR_MSEC) * 1000000;
+
+    pthread_mutex_lock(&pool->lock);
+
+    fs_pool_spawn(pool);
+
+    for (i=0; i<fslist->number; i++) {
+        sigar_file_system_usage_entry_t *entry = &usagelist->data[i];
+        sigar_fs_quarantine_t *q =
+            fs_quarantine_find(pool, entry->dir_name);
+        sigar_fs_job_t *job;
+
+        if (q && (q->busy || (now < q->until))) {
+            continue; /* status stays ETIMEDOUT */
+        }
+
+        job = jobs[i] = calloc(1, sizeof(*job));
+        SIGAR_SSTRCPY(job->dir_name, entry->dir_name);
+        job->pending = &pending;
+
+        if (pool->tail) {
+            pool->tail->next = job;
+        }
+        else {
+            pool->head = job;
+        }
+        pool->tail = job;
+        pending++;
+    }
+
+    if (pending) {
+        pthread_cond_broadcast(&pool->work);
+    }
+
+    while (pending) {
+        if (pthread_cond_timedwait(&pool->done, &pool->lock,
+                                   &abstime) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+
+    for (i=0; i<fslist->number; i++) {
+        sigar_file_system_usage_entry_t *entry = &usagelist->data[i];
+        sigar_fs_job_t *job = jobs[i];
+
+        if (!job) {
+            continue;
+        }
+
+        if (job->done) {
+            entry->status = job->status;
+            if (entry->status == SIGAR_OK) {
+                sigar_disk_usage_t disk = entry->usage.disk;
+                memcpy(&entry->usage, &job->usage, sizeof(entry->usage));
+                entry->usage.disk = disk;
+            }
+            /* answered in time, an error is the mount's answer not a hang */
+            fs_quarantine_remove(pool, entry->dir_name);
+            free(job);
+        }
+        else if (!job->started) {
+            /* starved by stuck workers, not the mount's fault */
+            fs_pool_dequeue(pool, job);
+            free(job);
+        }
+        else {
+            job->abandoned = 1;
+            pool->stuck++;
+            fs_quarantine_add(pool, entry->dir_name, now);
+
+            if (SIGAR_LOG_IS_DEBUG(sigar)) {
+                sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                                 "[fs_usage] %s timed out after %lums",
+                                 entry->dir_name, timeout);
+            }
+        }
+    }
+
+    fs_pool_spawn(pool); /* replace stuck workers */
+
+    pthread_mutex_unlock(&pool->lock);
+
+    free(jobs);
+
+    for (i=0; i<fslist->number; i++) {
+        sigar_file_system_usage_entry_t *entry = &usagelist->data[i];
+
+        if (entry->status != SIGAR_OK) {
+            continue;
+        }
+
+        entry->usage.use_percent =
+            sigar_file_system_usage_calc_used(sigar, &entry->usage);
+
+        /* only local disks, a stat() on a network mount can hang too */
+        if (fslist->data[i].type == SIGAR_FSTYPE_LOCAL_DISK) {
+            (void)sigar_disk_usage_get(sigar, entry->dir_name,
+                                       &entry->usage.disk);
+        }
+    }
+
+    return SIGAR_OK;
+}
+
+#endif /* WIN32 */
+
+SIGAR_DECLARE(int)
+sigar_file_system_usage_list_get(sigar_t *sigar,
+                                 sigar_file_system_list_t *fslist,
+                                 unsigned long timeout,
+                                 sigar_file_system_usage_list_t *usagelist)
+{
+    SIGAR_STATS_BEGIN(sigar);
+    int status = fs_usage_list_get(sigar, fslist, timeout, usagelist);
+
+    return SIGAR_STATS_END(sigar, SIGAR_STATS_FILE_SYSTEM_USAGE_LIST,
+                           status);
+}
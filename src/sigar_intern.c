@@ -0,0 +1,346 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_util.h"
+#include "sigar_os.h"
+
+/*
+ * strings by id and ids by hash of the string, in a table of its own
+ * as sigar_cache_t has no remove for the last release of a string.
+ * the ids of released strings are handed out again.
+ */
+
+#define INTERN_BUCKETS_MIN 64
+
+typedef struct {
+    char *str;          /* NULL while the id is free */
+    sigar_uint32_t hash;
+    sigar_uint32_t refs;
+    sigar_uint32_t next; /* in its bucket, or the free list, 0 ends */
+} intern_entry_t;
+
+struct sigar_intern_t {
+    intern_entry_t *entries; /* entries[id-1] */
+    sigar_uint32_t number;   /* ids handed out so far */
+    sigar_uint32_t size;
+    sigar_uint32_t *buckets; /* first id of each */
+    sigar_uint32_t nbuckets; /* a power of 2 */
+    sigar_uint32_t count;    /* strings held */
+    sigar_uint32_t free;     /* first free id */
+};
+
+#define INTERN_ENTRY(intern, id) \
+    (&(intern)->entries[(id)-1])
+
+#define INTERN_BUCKET(intern, hash) \
+    (&(intern)->buckets[(hash) & ((intern)->nbuckets - 1)])
+
+/* FNV-1a */
+static sigar_uint32_t intern_hash(const char *str)
+{
+    sigar_uint32_t hash = 2166136261U;
+
+    while (*str) {
+        hash ^= (unsigned char)*str++;
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+static sigar_intern_t *intern_new(void)
+{
+    sigar_intern_t *intern = malloc(sizeof(*intern));
+
+    SIGAR_ZERO(intern);
+    intern->nbuckets = INTERN_BUCKETS_MIN;
+    intern->buckets = calloc(intern->nbuckets, sizeof(*intern->buckets));
+
+    return intern;
+}
+
+void sigar_intern_destroy(sigar_intern_t *intern)
+{
+    sigar_uint32_t id;
+
+    for (id=1; id<=intern->number; id++) {
+        if (INTERN_ENTRY(intern, id)->str) {
+            free(INTERN_ENTRY(intern, id)->str);
+        }
+    }
+
+    free(intern->entries);
+    free(intern->buckets);
+    free(intern);
+}
+
+static void intern_rehash(sigar_intern_t *intern)
+{
+    sigar_uint32_t id;
+
+    free(intern->buckets);
+    intern->nbuckets *= 2;
+    intern->buckets = calloc(intern->nbuckets, sizeof(*intern->buckets));
+
+    for (id=1; id<=intern->number; id++) {
+        intern_entry_t *entry = INTERN_ENTRY(intern, id);
+        sigar_uint32_t *bucket;
+
+        if (!entry->str) {
+            continue;
+        }
+        bucket = INTERN_BUCKET(intern, entry->hash);
+        entry->next = *bucket;
+        *bucket = id;
+    }
+}
+
+static sigar_uint32_t intern_add(sigar_intern_t *intern,
+                                 const char *str,
+                                 sigar_uint32_t hash)
+{
+    sigar_uint32_t id, *bucket;
+    intern_entry_t *entry;
+
+    if (intern->free) {
+        id = intern->free;
+        intern->free = INTERN_ENTRY(intern, id)->next;
+    }
+    else {
+        if (intern->number >= intern->size) {
+            intern->size =
+                SIGAR_LIST_GROW_SIZE(intern->size, INTERN_BUCKETS_MIN);
+            intern->entries =
+                realloc(intern->entries,
+                        sizeof(*intern->entries) * intern->size);
+        }
+        id = ++intern->number;
+    }
+
+    entry = INTERN_ENTRY(intern, id);
+    entry->str = sigar_strdup(str);
+    entry->hash = hash;
+    entry->refs = 1;
+
+    if (++intern->count > intern->nbuckets) {
+        /* links entry in along with the rest */
+        intern_rehash(intern);
+    }
+    else {
+        bucket = INTERN_BUCKET(intern, hash);
+        entry->next = *bucket;
+        *bucket = id;
+    }
+
+    return id;
+}
+
+SIGAR_DECLARE(int) sigar_intern(sigar_t *sigar, const char *str,
+                                sigar_uint32_t *id)
+{
+    sigar_uint32_t hash = intern_hash(str);
+    sigar_intern_t *intern;
+
+    sigar_lock(sigar);
+
+    if (!(intern = sigar->intern)) {
+        intern = sigar->intern = intern_new();
+    }
+
+    for (*id = *INTERN_BUCKET(intern, hash); *id;
+         *id = INTERN_ENTRY(intern, *id)->next)
+    {
+        intern_entry_t *entry = INTERN_ENTRY(intern, *id);
+
+        if ((entry->hash == hash) && strEQ(entry->str, str)) {
+            entry->refs++;
+            break;
+        }
+    }
+
+    if (*id == SIGAR_INTERN_NONE) {
+        *id = intern_add(intern, str, hash);
+    }
+
+    sigar_unlock(sigar);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(const char *) sigar_intern_str(sigar_t *sigar,
+                                             sigar_uint32_t id)
+{
+    sigar_intern_t *intern;
+    const char *str = NULL;
+
+    sigar_lock(sigar);
+    if ((intern = sigar->intern) && id && (id <= intern->number)) {
+        str = INTERN_ENTRY(intern, id)->str;
+    }
+    sigar_unlock(sigar);
+
+    return str;
+}
+
+SIGAR_DECLARE(int) sigar_intern_release(sigar_t *sigar, sigar_uint32_t id)
+{
+    sigar_intern_t *intern;
+    intern_entry_t *entry;
+    sigar_uint32_t *ptr;
+    int status = SIGAR_OK;
+
+    if (id == SIGAR_INTERN_NONE) {
+        return SIGAR_OK;
+    }
+
+    sigar_lock(sigar);
+
+    intern = sigar->intern;
+    if (!intern || (id > intern->number) ||
+        !(entry = INTERN_ENTRY(intern, id))->str)
+    {
+        status = SIGAR_ENOENT;
+    }
+    else if (--entry->refs == 0) {
+        for (ptr = INTERN_BUCKET(intern, entry->hash); *ptr != id;
+             ptr = &INTERN_ENTRY(intern, *ptr)->next)
+            ;
+        *ptr = entry->next;
+
+        free(entry->str);
+        entry->str = NULL;
+        entry->next = intern->free;
+        intern->free = id;
+        intern->count--;
+    }
+
+    sigar_unlock(sigar);
+
+    return status;
+}
+
+SIGAR_DECLARE(sigar_uint32_t) sigar_intern_count(sigar_t *sigar)
+{
+    sigar_uint32_t count;
+
+    sigar_lock(sigar);
+    count = sigar->intern ? sigar->intern->count : 0;
+    sigar_unlock(sigar);
+
+    return count;
+}
+
+/*
+ * the args joined by ' ', as ps shows them.  none, as for a kernel
+ * thread, is SIGAR_INTERN_NONE rather than an interned "".
+ */
+static int proc_args_intern(sigar_t *sigar, sigar_pid_t pid,
+                            sigar_uint32_t *id)
+{
+    sigar_proc_args_t procargs;
+    unsigned long i;
+    size_t len = 0;
+    char *line, *ptr;
+    int status;
+
+    if ((status = sigar_proc_args_get(sigar, pid, &procargs)) != SIGAR_OK) {
+        return status;
+    }
+
+    if (procargs.number == 0) {
+        *id = SIGAR_INTERN_NONE;
+        sigar_proc_args_destroy(sigar, &procargs);
+        return SIGAR_OK;
+    }
+
+    for (i=0; i<procargs.number; i++) {
+        len += strlen(procargs.data[i]) + 1;
+    }
+
+    ptr = line = malloc(len + 1);
+    for (i=0; i<procargs.number; i++) {
+        size_t arglen = strlen(procargs.data[i]);
+
+        if (i) {
+            *ptr++ = ' ';
+        }
+        memcpy(ptr, procargs.data[i], arglen);
+        ptr += arglen;
+    }
+    *ptr = '\0';
+
+    status = sigar_intern(sigar, line, id);
+
+    free(line);
+    sigar_proc_args_destroy(sigar, &procargs);
+
+    return status;
+}
+
+SIGAR_DECLARE(int) sigar_proc_interned_get(sigar_t *sigar, sigar_pid_t pid,
+                                           sigar_proc_interned_t *proc)
+{
+    sigar_proc_state_t procstate;
+    sigar_proc_cred_name_t credname;
+    sigar_proc_exe_t procexe;
+    int status;
+
+    SIGAR_ZERO(proc);
+
+    if ((status = sigar_proc_state_get(sigar, pid, &procstate)) != SIGAR_OK) {
+        return status;
+    }
+
+    proc->pid = pid;
+    proc->ppid = procstate.ppid;
+    proc->state = procstate.state;
+    sigar_intern(sigar, procstate.name, &proc->name);
+
+    /* what another user's process keeps from us stays SIGAR_INTERN_NONE */
+    if (sigar_proc_cred_name_get(sigar, pid, &credname) == SIGAR_OK) {
+        sigar_intern(sigar, credname.user, &proc->user);
+        sigar_intern(sigar, credname.group, &proc->group);
+    }
+
+    if (sigar_proc_exe_get(sigar, pid, &procexe) == SIGAR_OK) {
+        sigar_intern(sigar, procexe.name, &proc->exe);
+        sigar_intern(sigar, procexe.cwd, &proc->cwd);
+    }
+
+    (void)proc_args_intern(sigar, pid, &proc->args);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_proc_interned_release(sigar_t *sigar,
+                                               sigar_proc_interned_t *proc)
+{
+    sigar_intern_release(sigar, proc->name);
+    sigar_intern_release(sigar, proc->user);
+    sigar_intern_release(sigar, proc->group);
+    sigar_intern_release(sigar, proc->exe);
+    sigar_intern_release(sigar, proc->cwd);
+    sigar_intern_release(sigar, proc->args);
+
+    proc->name = proc->user = proc->group =
+        proc->exe = proc->cwd = proc->args = SIGAR_INTERN_NONE;
+
+    return SIGAR_OK;
+}
@@ -1070,8 +1070,11 @@ static int ptql_pid_list_get(sigar_t *sigar,
         return SIGAR_OK;
     }
 
+    sigar_lock(sigar);
+
     status = sigar_proc_list_get(sigar, NULL);
     if (status != SIGAR_OK) {
+        sigar_unlock(sigar);
         return status;
     }
     for (i=0; i<sigar->pids->number; i++) {
@@ -1082,6 +1085,8 @@ static int ptql_pid_list_get(sigar_t *sigar,
         }
     }
 
+    sigar_unlock(sigar);
+
     return SIGAR_OK;
 }
 
@@ -1851,7 +1856,7 @@ static int ptql_proc_list_get(sigar_t *sigar,
             if (*proclist == NULL) {
                 *proclist = malloc(sizeof(**proclist));
                 SIGAR_ZERO(*proclist);
-                sigar_proc_list_create(*proclist);
+                sigar_proc_list_create(sigar, *proclist);
             }
             status = ptql_pid_list_get(sigar, branch, *proclist);
             if (status != SIGAR_OK) {
@@ -1866,6 +1871,16 @@ static int ptql_proc_list_get(sigar_t *sigar,
         return SIGAR_OK;
     }
 
+    if (sigar->threads) {
+        /* sigar->pids is shared, so is not ours to iterate */
+        *proclist = malloc(sizeof(**proclist));
+        status = sigar_proc_list_get(sigar, *proclist);
+        if (status != SIGAR_OK) {
+            free(*proclist);
+        }
+        return status;
+    }
+
     status = sigar_proc_list_get(sigar, NULL);
     if (status != SIGAR_OK) {
         return status;
@@ -1948,7 +1963,7 @@ SIGAR_DECLARE(int) sigar_ptql_query_find(sigar_t *sigar,
         return status;
     }
 
-    sigar_proc_list_create(proclist);
+    sigar_proc_list_create(sigar, proclist);
 
     for (i=0; i<pids->number; i++) {
         int query_status =
@@ -0,0 +1,189 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_util.h"
+#include "sigar_os.h"
+
+#define RATE_HALF32 ((sigar_uint64_t)1 << 31)
+#define RATE_HALF64 ((sigar_uint64_t)1 << 63)
+
+/* time constants of the weighted rates, msec */
+#define RATE_EWMA_1S  (1  * SIGAR_MSEC)
+#define RATE_EWMA_10S (10 * SIGAR_MSEC)
+#define RATE_EWMA_60S (60 * SIGAR_MSEC)
+
+/*
+ * weight of the newest rate for samples interval msec apart, so
+ * irregular sampling still decays over the same wall time.
+ * interval / (tau + interval) rather than 1 - exp(-interval / tau)
+ * keeps libm out, the two agree closely while interval << tau.
+ */
+#define RATE_EWMA(ewma, rate, interval, tau) \
+    ewma += ((rate) - (ewma)) * ((double)(interval) / ((tau) + (interval)))
+
+/*
+ * a counter that went back is taken for a wrap only if it was in the
+ * top half of its range and is now in the bottom half, anything else
+ * (a process or device that restarted counting) is a reset.
+ */
+static int rate_delta(sigar_uint64_t prev, sigar_uint64_t value,
+                      int flags, sigar_uint64_t *delta)
+{
+    if (value >= prev) {
+        *delta = value - prev;
+        return 1;
+    }
+
+    if (flags & SIGAR_RATE_COUNTER32) {
+        if ((prev >= RATE_HALF32) && (prev < (RATE_HALF32 << 1)) &&
+            (value < RATE_HALF32))
+        {
+            *delta = ((RATE_HALF32 << 1) - prev) + value;
+            return 1;
+        }
+    }
+    else if ((prev >= RATE_HALF64) && (value < RATE_HALF64)) {
+        *delta = (0 - prev) + value; /* modulo 2^64 */
+        return 1;
+    }
+
+    *delta = 0;
+    return 0;
+}
+
+void sigar_rate_update(sigar_rate_state_t *state,
+                       sigar_uint64_t value,
+                       sigar_uint64_t now,
+                       int flags,
+                       sigar_rate_t *rate)
+{
+    sigar_rate_t *last = &state->last;
+    sigar_uint64_t interval, delta;
+
+    if ((state->time == 0) || (now < state->time)) {
+        /* first value, nothing to compare with yet */
+        SIGAR_ZERO(last);
+        state->value = value;
+        state->time = now;
+        memcpy(rate, last, sizeof(*rate));
+        return;
+    }
+
+    if (now == state->time) {
+        /* same msec, leave value to count towards the next interval */
+        memcpy(rate, last, sizeof(*rate));
+        return;
+    }
+
+    interval = now - state->time;
+
+    if (rate_delta(state->value, value, flags, &delta)) {
+        double per_sec = delta * (double)SIGAR_MSEC / interval;
+
+        if (last->interval == 0) {
+            /* first rate, nothing to weigh it against */
+            last->rate_1s = last->rate_10s = last->rate_60s = per_sec;
+        }
+        else {
+            RATE_EWMA(last->rate_1s, per_sec, interval, RATE_EWMA_1S);
+            RATE_EWMA(last->rate_10s, per_sec, interval, RATE_EWMA_10S);
+            RATE_EWMA(last->rate_60s, per_sec, interval, RATE_EWMA_60S);
+        }
+
+        last->rate = per_sec;
+        last->reset = 0;
+    }
+    else {
+        /* the weighted rates carry on from before the reset */
+        last->rate = 0.0;
+        last->reset = 1;
+    }
+
+    last->delta = delta;
+    last->interval = interval;
+
+    state->value = value;
+    state->time = now;
+
+    memcpy(rate, last, sizeof(*rate));
+}
+
+typedef struct sigar_rate_entry_t sigar_rate_entry_t;
+
+/* the metrics of one entity */
+struct sigar_rate_entry_t {
+    sigar_rate_entry_t *next;
+    sigar_uint64_t metric;
+    sigar_rate_state_t state;
+};
+
+static void rate_entry_free(void *ptr)
+{
+    sigar_rate_entry_t *entry = ptr;
+
+    while (entry) {
+        sigar_rate_entry_t *next = entry->next;
+        free(entry);
+        entry = next;
+    }
+}
+
+SIGAR_DECLARE(int) sigar_rate_get(sigar_t *sigar,
+                                  sigar_uint64_t metric,
+                                  sigar_uint64_t entity,
+                                  sigar_uint64_t value,
+                                  int flags,
+                                  sigar_rate_t *rate)
+{
+    sigar_cache_t **cache;
+    sigar_cache_entry_t *ent;
+    sigar_rate_entry_t *entry;
+
+    cache = sigar_shard_cache_lock(sigar, entity, SIGAR_SHARD_RATES);
+
+    if (!*cache) {
+        *cache =
+            sigar_expired_cache_new(128, PID_CACHE_CLEANUP_PERIOD,
+                                    PID_CACHE_ENTRY_EXPIRE_PERIOD);
+        (*cache)->free_value = rate_entry_free;
+    }
+
+    ent = sigar_cache_get(*cache, entity);
+
+    for (entry = ent->value; entry; entry = entry->next) {
+        if (entry->metric == metric) {
+            break;
+        }
+    }
+
+    if (!entry) {
+        entry = malloc(sizeof(*entry));
+        SIGAR_ZERO(entry);
+        entry->metric = metric;
+        entry->next = ent->value;
+        ent->value = entry;
+    }
+
+    sigar_rate_update(&entry->state, value,
+                      sigar_time_monotonic_millis(), flags, rate);
+
+    sigar_shard_cache_unlock(sigar, entity);
+
+    return SIGAR_OK;
+}
@@ -0,0 +1,779 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_util.h"
+#include "sigar_os.h"
+
+/* set while sigar_record_start is capturing */
+volatile int sigar_recording = 0;
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define RECORD_MAGIC "SIGARREC"
+#define RECORD_VERSION 1
+
+#define RECORD_FILE 'F'
+#define RECORD_LINK 'L'
+#define RECORD_DIR  'D'
+#define RECORD_MARK 'M'
+
+/*
+ * the archive is RECORD_MAGIC and a 32 bit version, then records of
+ *
+ *   type       1 byte, one of the above
+ *   time       64 bit, msec since the epoch
+ *   path_len   32 bit
+ *   data_len   32 bit
+ *   path, data
+ *
+ * integers little endian.  data is the bytes a file read returned,
+ * a link's target or a directory's entry names each with its NUL.
+ * a mark ends the frame a replay steps to.
+ */
+#define RECORD_HEADER_SIZE (1 + 8 + 4 + 4)
+
+struct sigar_replay_t {
+    FILE *fp;
+    char *dir;
+    int fd; /* of dir, records are put back relative to it */
+    char *proc;
+    char *sys;
+    /* of the last record applied */
+    sigar_uint64_t time;
+};
+
+static pthread_mutex_t record_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *record_fp = NULL;
+
+static void record_put(unsigned char *buf, sigar_uint64_t value, int size)
+{
+    int i;
+
+    for (i=0; i<size; i++) {
+        buf[i] = (unsigned char)(value >> (i * 8));
+    }
+}
+
+static sigar_uint64_t record_value(const unsigned char *buf, int size)
+{
+    sigar_uint64_t value = 0;
+    int i;
+
+    for (i=size-1; i>=0; i--) {
+        value = (value << 8) | buf[i];
+    }
+
+    return value;
+}
+
+/* only the live procfs and sysfs, what a replay puts back */
+static int record_path(const char *path, size_t *len)
+{
+    if (!((strnEQ(path, "/proc", 5) && ((path[5] == '/') || !path[5])) ||
+          (strnEQ(path, "/sys", 4) && ((path[4] == '/') || !path[4]))))
+    {
+        return 0;
+    }
+
+    *len = strlen(path);
+    while ((*len > 1) && (path[*len-1] == '/')) {
+        (*len)--;
+    }
+
+    return 1;
+}
+
+static void record_write(int type,
+                         const char *path, size_t path_len,
+                         const char *data, size_t len)
+{
+    unsigned char header[RECORD_HEADER_SIZE];
+
+    header[0] = type;
+    record_put(&header[1], sigar_time_now_millis(), 8);
+    record_put(&header[9], path_len, 4);
+    record_put(&header[13], len, 4);
+
+    pthread_mutex_lock(&record_lock);
+
+    if (record_fp) {
+        fwrite(header, sizeof(header), 1, record_fp);
+        if (path_len) {
+            fwrite(path, path_len, 1, record_fp);
+        }
+        if (len) {
+            fwrite(data, len, 1, record_fp);
+        }
+    }
+
+    pthread_mutex_unlock(&record_lock);
+}
+
+void sigar_record_file(const char *path, const char *data, size_t len)
+{
+    size_t path_len;
+
+    if (record_path(path, &path_len)) {
+        record_write(RECORD_FILE, path, path_len, data, len);
+    }
+}
+
+void sigar_record_link(const char *path, const char *target, size_t len)
+{
+    size_t path_len;
+
+    if (record_path(path, &path_len)) {
+        record_write(RECORD_LINK, path, path_len, target, len);
+    }
+}
+
+/*
+ * a second readdir of path rather than one hooked into every walk,
+ * a replay only has to get the same pids and fds back.  the links
+ * of numbered entries (fds) go first so the replay finds them.
+ */
+void sigar_record_dir(const char *path)
+{
+    DIR *dirp;
+    struct dirent *ent;
+    char *names = NULL;
+    size_t len = 0, size = 0, path_len;
+
+    if (!record_path(path, &path_len) || !(dirp = opendir(path))) {
+        return;
+    }
+
+    while ((ent = readdir(dirp))) {
+        size_t name_len;
+
+        if (strEQ(ent->d_name, ".") || strEQ(ent->d_name, "..")) {
+            continue;
+        }
+
+        name_len = strlen(ent->d_name) + 1;
+        if (len + name_len > size) {
+            size = (size + name_len) * 2;
+            names = realloc(names, size);
+        }
+        memcpy(names + len, ent->d_name, name_len);
+        len += name_len;
+
+        if ((ent->d_type == DT_LNK) && sigar_isdigit(*ent->d_name)) {
+            char link[SIGAR_PATH_MAX+1], name[SIGAR_PATH_MAX+1];
+            ssize_t link_len =
+                readlinkat(dirfd(dirp), ent->d_name, link, sizeof(link));
+            int n = snprintf(name, sizeof(name), "%.*s/%s",
+                             (int)path_len, path, ent->d_name);
+
+            if ((link_len >= 0) && (n < (int)sizeof(name))) {
+                record_write(RECORD_LINK, name, n, link, link_len);
+            }
+        }
+    }
+
+    closedir(dirp);
+
+    record_write(RECORD_DIR, path, path_len, names, len);
+
+    free(names);
+}
+
+SIGAR_DECLARE(int) sigar_record_start(const char *archive)
+{
+    unsigned char version[4];
+    FILE *fp;
+    int status = SIGAR_OK;
+
+    if (!(fp = fopen(archive, "wb"))) {
+        return errno;
+    }
+
+    record_put(version, RECORD_VERSION, sizeof(version));
+    if ((fwrite(RECORD_MAGIC, SSTRLEN(RECORD_MAGIC), 1, fp) != 1) ||
+        (fwrite(version, sizeof(version), 1, fp) != 1))
+    {
+        status = errno;
+        fclose(fp);
+        return status;
+    }
+
+    pthread_mutex_lock(&record_lock);
+
+    if (record_fp) {
+        fclose(record_fp);
+    }
+    record_fp = fp;
+    sigar_recording = 1;
+
+    pthread_mutex_unlock(&record_lock);
+
+    /*
+     * what sigar_open reads the boot time from, a replay needs it.
+     * sigar_fopen reads the whole file into the recording.
+     */
+    if ((fp = sigar_fopen(PROC_FS_ROOT "stat"))) {
+        sigar_fclose(fp);
+    }
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_record_mark(void)
+{
+    if (!sigar_recording) {
+        return SIGAR_ENOENT;
+    }
+
+    record_write(RECORD_MARK, NULL, 0, NULL, 0);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_record_stop(void)
+{
+    int status = SIGAR_OK;
+
+    pthread_mutex_lock(&record_lock);
+
+    sigar_recording = 0;
+    if (record_fp) {
+        if (fclose(record_fp) != 0) {
+            status = errno;
+        }
+        record_fp = NULL;
+    }
+
+    pthread_mutex_unlock(&record_lock);
+
+    return status;
+}
+
+/* rm -r of name in the dir at fd, never following a link */
+static int replay_remove_at(int fd, const char *name)
+{
+    struct stat sb;
+    int status = SIGAR_OK;
+
+    if (fstatat(fd, name, &sb, AT_SYMLINK_NOFOLLOW) < 0) {
+        return errno;
+    }
+
+    if (S_ISDIR(sb.st_mode)) {
+        struct dirent *ent;
+        DIR *dirp;
+        int dfd;
+
+        if ((dfd = openat(fd, name, O_RDONLY|O_DIRECTORY|O_NOFOLLOW)) < 0) {
+            return errno;
+        }
+        if (!(dirp = fdopendir(dfd))) {
+            status = errno;
+            close(dfd);
+            return status;
+        }
+        while ((ent = readdir(dirp))) {
+            if (strEQ(ent->d_name, ".") || strEQ(ent->d_name, "..")) {
+                continue;
+            }
+            if ((status = replay_remove_at(dfd, ent->d_name)) != SIGAR_OK) {
+                break;
+            }
+        }
+        closedir(dirp);
+
+        if ((status == SIGAR_OK) && (unlinkat(fd, name, AT_REMOVEDIR) < 0)) {
+            status = errno;
+        }
+    }
+    else if (unlinkat(fd, name, 0) < 0) {
+        status = errno;
+    }
+
+    return status;
+}
+
+static int replay_remove(const char *path)
+{
+    return replay_remove_at(AT_FDCWD, path);
+}
+
+/*
+ * what a record may put back: the path it was read from, under the
+ * recorded proc or sys, and nothing that climbs out of it.
+ */
+static int replay_path_valid(const char *path)
+{
+    const char *ptr;
+
+    if (!((strnEQ(path, "/proc", 5) && ((path[5] == '/') || !path[5])) ||
+          (strnEQ(path, "/sys", 4) && ((path[4] == '/') || !path[4]))))
+    {
+        return 0;
+    }
+
+    for (ptr = path + 1; ptr; ptr = strchr(ptr, '/')) {
+        size_t len;
+
+        if (*ptr == '/') {
+            ptr++;
+        }
+        len = strcspn(ptr, "/");
+
+        if ((len == 0) ||
+            ((len == 1) && (ptr[0] == '.')) ||
+            ((len == 2) && (ptr[0] == '.') && (ptr[1] == '.')))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * mkdir -p of everything above path, relative to replay->dir.  *fd is
+ * the dir that *name, the last component, goes in, for the caller to
+ * close unless it is replay->fd.  a link an earlier record left is
+ * never gone through.
+ */
+static int replay_parent(sigar_replay_t *replay, char *path,
+                         int *fd, char **name)
+{
+    char *ptr;
+
+    *fd = replay->fd;
+    *name = path;
+
+    while ((ptr = strchr(*name, '/'))) {
+        int dfd, status = SIGAR_OK;
+
+        *ptr = '\0';
+        if ((mkdirat(*fd, *name, 0755) < 0) && (errno != EEXIST)) {
+            status = errno;
+        }
+        else if ((dfd = openat(*fd, *name,
+                               O_RDONLY|O_DIRECTORY|O_NOFOLLOW)) < 0)
+        {
+            status = errno;
+        }
+        *ptr = '/';
+
+        if (*fd != replay->fd) {
+            close(*fd);
+        }
+        if (status != SIGAR_OK) {
+            *fd = replay->fd;
+            return status;
+        }
+
+        *fd = dfd;
+        *name = ptr + 1;
+    }
+
+    return SIGAR_OK;
+}
+
+/* whatever an earlier record left at name, so the new one can take it */
+static int replay_clear(int fd, const char *name)
+{
+    struct stat sb;
+
+    if (fstatat(fd, name, &sb, AT_SYMLINK_NOFOLLOW) == 0) {
+        return replay_remove_at(fd, name);
+    }
+
+    return SIGAR_OK;
+}
+
+static int replay_file(sigar_replay_t *replay, char *path, size_t len)
+{
+    char buffer[BUFSIZ], *name;
+    FILE *fp;
+    int fd, dfd, status;
+
+    if ((status = replay_parent(replay, path, &dfd, &name)) != SIGAR_OK) {
+        return status;
+    }
+
+    if ((status = replay_clear(dfd, name)) != SIGAR_OK) {
+        fd = -1;
+    }
+    else if ((fd = openat(dfd, name, O_WRONLY|O_CREAT|O_TRUNC|O_NOFOLLOW,
+                          0644)) < 0)
+    {
+        status = errno;
+    }
+    if (dfd != replay->fd) {
+        close(dfd);
+    }
+    if (status != SIGAR_OK) {
+        return status;
+    }
+
+    if (!(fp = fdopen(fd, "w"))) {
+        status = errno;
+        close(fd);
+        return status;
+    }
+
+    while (len > 0) {
+        size_t n = len < sizeof(buffer) ? len : sizeof(buffer);
+
+        if (fread(buffer, n, 1, replay->fp) != 1) {
+            fclose(fp);
+            return EINVAL;
+        }
+        fwrite(buffer, n, 1, fp);
+        len -= n;
+    }
+
+    return fclose(fp) == 0 ? SIGAR_OK : errno;
+}
+
+static int replay_link(sigar_replay_t *replay, char *path, size_t len)
+{
+    char target[SIGAR_PATH_MAX+1], *name;
+    int dfd, status;
+
+    if ((len > SIGAR_PATH_MAX) ||
+        ((len > 0) && (fread(target, len, 1, replay->fp) != 1)))
+    {
+        return EINVAL;
+    }
+    target[len] = '\0';
+
+    if ((status = replay_parent(replay, path, &dfd, &name)) != SIGAR_OK) {
+        return status;
+    }
+
+    if (((status = replay_clear(dfd, name)) == SIGAR_OK) &&
+        (symlinkat(target, dfd, name) < 0))
+    {
+        status = errno;
+    }
+    if (dfd != replay->fd) {
+        close(dfd);
+    }
+
+    return status;
+}
+
+static int replay_name_cmp(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/*
+ * the entries not listed are gone, numbered ones (pids and fds) that
+ * are listed get at least an empty dir so a readdir finds them.
+ */
+static int replay_dir(sigar_replay_t *replay, char *path, size_t len)
+{
+    char *names, **sorted = NULL, *ptr, *name;
+    unsigned long number = 0, i;
+    struct dirent *ent;
+    DIR *dirp;
+    int fd, dfd, status;
+
+    names = malloc(len + 1);
+    if ((len > 0) && (fread(names, len, 1, replay->fp) != 1)) {
+        free(names);
+        return EINVAL;
+    }
+    names[len] = '\0';
+
+    for (ptr = names; ptr < names + len; ptr += strlen(ptr) + 1) {
+        number++;
+    }
+    sorted = malloc(sizeof(*sorted) * (number + 1));
+    for (ptr = names, i = 0; i < number; ptr += strlen(ptr) + 1) {
+        sorted[i++] = ptr;
+    }
+    qsort(sorted, number, sizeof(*sorted), replay_name_cmp);
+
+    fd = -1;
+    if ((status = replay_parent(replay, path, &dfd, &name)) == SIGAR_OK) {
+        if ((mkdirat(dfd, name, 0755) < 0) && (errno != EEXIST)) {
+            status = errno;
+        }
+        else if ((fd = openat(dfd, name,
+                              O_RDONLY|O_DIRECTORY|O_NOFOLLOW)) < 0)
+        {
+            status = errno;
+        }
+        if (dfd != replay->fd) {
+            close(dfd);
+        }
+    }
+    if ((status == SIGAR_OK) && !(dirp = fdopendir(fd))) {
+        status = errno;
+        close(fd);
+    }
+    if (status != SIGAR_OK) {
+        free(sorted);
+        free(names);
+        return status;
+    }
+
+    while ((ent = readdir(dirp))) {
+        char *key = ent->d_name;
+
+        if (strEQ(key, ".") || strEQ(key, "..") ||
+            bsearch(&key, sorted, number, sizeof(*sorted),
+                    replay_name_cmp))
+        {
+            continue;
+        }
+        replay_remove_at(fd, key);
+    }
+
+    for (i=0; i<number; i++) {
+        struct stat sb;
+
+        /* a name, never a path */
+        if (!sigar_isdigit(*sorted[i]) || strchr(sorted[i], '/')) {
+            continue;
+        }
+        if (fstatat(fd, sorted[i], &sb, AT_SYMLINK_NOFOLLOW) < 0) {
+            mkdirat(fd, sorted[i], 0755);
+        }
+    }
+
+    closedir(dirp);
+    free(sorted);
+    free(names);
+
+    return SIGAR_OK;
+}
+
+/* apply the records up to the next mark */
+static int replay_frame(sigar_replay_t *replay)
+{
+    unsigned char header[RECORD_HEADER_SIZE];
+    char path[SIGAR_PATH_MAX+1];
+    int records = 0;
+
+    while (fread(header, sizeof(header), 1, replay->fp) == 1) {
+        size_t path_len = record_value(&header[9], 4);
+        size_t len = record_value(&header[13], 4);
+        int status;
+
+        records++;
+        replay->time = record_value(&header[1], 8);
+
+        if (header[0] == RECORD_MARK) {
+            return SIGAR_OK;
+        }
+
+        if ((path_len == 0) || (path_len > SIGAR_PATH_MAX) ||
+            (fread(path, path_len, 1, replay->fp) != 1))
+        {
+            return EINVAL;
+        }
+        path[path_len] = '\0';
+
+        /* an archive from elsewhere writes nowhere but under dir */
+        if ((strlen(path) != path_len) || !replay_path_valid(path)) {
+            return EINVAL;
+        }
+
+        switch (header[0]) {
+          case RECORD_FILE:
+            status = replay_file(replay, path + 1, len);
+            break;
+          case RECORD_LINK:
+            status = replay_link(replay, path + 1, len);
+            break;
+          case RECORD_DIR:
+            status = replay_dir(replay, path + 1, len);
+            break;
+          default:
+            status = EINVAL;
+            break;
+        }
+
+        if (status != SIGAR_OK) {
+            return status;
+        }
+    }
+
+    return records ? SIGAR_OK : SIGAR_ENOENT;
+}
+
+static void replay_free(sigar_replay_t *replay)
+{
+    if (replay->fp) {
+        fclose(replay->fp);
+    }
+    if (replay->fd >= 0) {
+        close(replay->fd);
+    }
+    if (replay->dir) {
+        replay_remove(replay->dir);
+        free(replay->dir);
+    }
+    free(replay->proc);
+    free(replay->sys);
+    free(replay);
+}
+
+SIGAR_DECLARE(int) sigar_replay_open(sigar_t *sigar,
+                                     const char *archive,
+                                     const char *dir)
+{
+    char magic[SSTRLEN(RECORD_MAGIC)], path[SIGAR_PATH_MAX+1];
+    unsigned char version[4];
+    sigar_replay_t *replay;
+    int status;
+
+    sigar_replay_close(sigar);
+
+    replay = malloc(sizeof(*replay));
+    SIGAR_ZERO(replay);
+    replay->fd = -1;
+
+    if (!(replay->fp = fopen(archive, "rb"))) {
+        status = errno;
+        replay_free(replay);
+        return status;
+    }
+
+    if ((fread(magic, sizeof(magic), 1, replay->fp) != 1) ||
+        (fread(version, sizeof(version), 1, replay->fp) != 1) ||
+        !strnEQ(magic, RECORD_MAGIC, sizeof(magic)) ||
+        (record_value(version, sizeof(version)) != RECORD_VERSION))
+    {
+        replay_free(replay);
+        return EINVAL;
+    }
+
+    if (mkdir(dir, 0755) < 0) {
+        status = errno;
+        replay_free(replay);
+        return status;
+    }
+    replay->dir = sigar_strdup(dir);
+
+    snprintf(path, sizeof(path), "%s/proc", dir);
+    replay->proc = sigar_strdup(path);
+    snprintf(path, sizeof(path), "%s/sys", dir);
+    replay->sys = sigar_strdup(path);
+
+    if (((replay->fd = open(dir, O_RDONLY|O_DIRECTORY|O_NOFOLLOW)) < 0) ||
+        (mkdirat(replay->fd, "proc", 0755) < 0) ||
+        (mkdirat(replay->fd, "sys", 0755) < 0))
+    {
+        status = errno;
+        replay_free(replay);
+        return status;
+    }
+
+    sigar->replay = replay;
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_replay_next(sigar_t *sigar, sigar_uint64_t *time)
+{
+    sigar_replay_t *replay = sigar->replay;
+    int status;
+
+    if (!replay) {
+        return SIGAR_ENOENT;
+    }
+
+    if ((status = replay_frame(replay)) != SIGAR_OK) {
+        return status;
+    }
+
+    if (time) {
+        *time = replay->time;
+    }
+
+    /* drops what was cached from the last frame, the mount table too */
+    return sigar_proc_root_set(sigar, replay->proc, replay->sys);
+}
+
+SIGAR_DECLARE(int) sigar_replay_close(sigar_t *sigar)
+{
+    if (!sigar->replay) {
+        return SIGAR_OK;
+    }
+
+    sigar_proc_root_set(sigar, NULL, NULL);
+    replay_free(sigar->replay);
+    sigar->replay = NULL;
+
+    return SIGAR_OK;
+}
+
+#else /* !__linux__ */
+
+void sigar_record_file(const char *path, const char *data, size_t len)
+{
+}
+
+void sigar_record_link(const char *path, const char *target, size_t len)
+{
+}
+
+void sigar_record_dir(const char *path)
+{
+}
+
+SIGAR_DECLARE(int) sigar_record_start(const char *archive)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_record_mark(void)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_record_stop(void)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_replay_open(sigar_t *sigar,
+                                     const char *archive,
+                                     const char *dir)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_replay_next(sigar_t *sigar, sigar_uint64_t *time)
+{
+    return SIGAR_ENOTIMPL;
+}
+
+SIGAR_DECLARE(int) sigar_replay_close(sigar_t *sigar)
+{
+    return SIGAR_OK;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,311 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_util.h"
+#include "sigar_os.h"
+
+#ifndef WIN32
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+struct sigar_stats_state_t {
+    /* the process wide counters as of the last reset */
+    sigar_uint64_t files_opened;
+    sigar_uint64_t bytes_read;
+    sigar_stats_call_t calls[SIGAR_STATS_API_MAX];
+};
+
+/* indexed with sigar_stats_api_e */
+static const char *stats_api_names[] = {
+    "cpu", "cpu_list", "mem", "swap",
+    "proc_list", "proc_stat", "proc_args",
+    "proc_state", "proc_mem", "proc_time", "proc_cpu", "proc_disk_io",
+    "file_system_list", "disk_usage", "net_interface_stat",
+    "net_interface_stat_list", "net_interface_config_list",
+    "net_interface_address_list", "net_connection_walk",
+    "net_connection_list", "net_unix_connection_list",
+    "net_connection_info_list", "net_port_tcp_info_list",
+    "net_connection_proc_list", "net_listener_list",
+    "net_proto_counter_list", "netns_list", "netns_interface_stat_list",
+    "netns_connection_list", "netns_proto_counter_list",
+    "disk_io_list", "file_system_usage_list", "netlink_dump"
+};
+
+/*
+ * handles with stats enabled.  file reads are counted while there
+ * are any, a stale read of it only miscounts around an enable.
+ */
+volatile sigar_int64_t sigar_stats_users = 0;
+
+static sigar_uint64_t stats_files_opened = 0;
+static sigar_uint64_t stats_bytes_read = 0;
+
+void sigar_stats_file_read(int opened, sigar_uint64_t bytes)
+{
+    if (!sigar_stats_users) {
+        return;
+    }
+    if (opened) {
+        SIGAR_ATOMIC_ADD(&stats_files_opened, 1);
+    }
+    if (bytes) {
+        SIGAR_ATOMIC_ADD(&stats_bytes_read, bytes);
+    }
+}
+
+/* usec, monotonic */
+sigar_uint64_t sigar_stats_now(void)
+{
+#ifdef WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    if (!freq.QuadPart) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&count);
+
+    return ((count.QuadPart / freq.QuadPart) * SIGAR_USEC) +
+        ((count.QuadPart % freq.QuadPart) * SIGAR_USEC / freq.QuadPart);
+#else
+    struct timeval tv;
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return ((sigar_uint64_t)ts.tv_sec * SIGAR_USEC) +
+            (ts.tv_nsec / (SIGAR_NSEC / SIGAR_USEC));
+    }
+#endif
+    gettimeofday(&tv, NULL);
+    return ((sigar_uint64_t)tv.tv_sec * SIGAR_USEC) + tv.tv_usec;
+#endif
+}
+
+/*
+ * the power of 2 below usec picks a group of 4 buckets, the next
+ * 2 bits down pick one within it.
+ */
+static int stats_bucket(sigar_uint64_t usec)
+{
+    sigar_uint64_t v = usec;
+    int msb = 0, bucket;
+
+    if (usec < 4) {
+        return (int)usec;
+    }
+
+    while (v >>= 1) {
+        msb++;
+    }
+
+    bucket = ((msb - 1) * 4) + (int)((usec >> (msb - 2)) & 3);
+
+    return bucket < SIGAR_STATS_BUCKETS ? bucket : SIGAR_STATS_BUCKETS - 1;
+}
+
+SIGAR_DECLARE(sigar_uint64_t) sigar_stats_bucket_usec(int bucket)
+{
+    if (bucket < 4) {
+        return bucket < 0 ? 0 : bucket;
+    }
+
+    return (sigar_uint64_t)(4 + (bucket & 3)) << ((bucket / 4) - 1);
+}
+
+int sigar_stats_end(sigar_t *sigar, int api,
+                    sigar_uint64_t start, int status)
+{
+    sigar_uint64_t usec, max;
+    sigar_stats_call_t *call;
+
+    if (!start) {
+        /* enabled while the call was running */
+        return status;
+    }
+
+    usec = sigar_stats_now() - start;
+
+    /*
+     * each slot on its own, no handle lock on the way out of every
+     * call.  a sigar_stats_get racing this may see a call counted
+     * before its usec is.
+     */
+    call = &sigar->stats->calls[api];
+    SIGAR_ATOMIC_ADD(&call->calls, 1);
+    if (status != SIGAR_OK) {
+        SIGAR_ATOMIC_ADD(&call->errors, 1);
+    }
+    SIGAR_ATOMIC_ADD(&call->usec_total, usec);
+    SIGAR_ATOMIC_ADD(&call->buckets[stats_bucket(usec)], 1);
+
+    max = SIGAR_ATOMIC_LOAD(&call->usec_max);
+    while (usec > max) {
+        if (SIGAR_ATOMIC_CAS(&call->usec_max, max, usec)) {
+            break;
+        }
+        max = SIGAR_ATOMIC_LOAD(&call->usec_max);
+    }
+
+    return status;
+}
+
+void sigar_stats_cache(sigar_stats_t *stats, const char *name,
+                       sigar_cache_t *cache)
+{
+    sigar_stats_cache_t *entry = NULL;
+    unsigned long i;
+
+    if (!cache) {
+        return;
+    }
+
+    if (!stats) {
+        cache->hits = cache->misses = 0;
+        return;
+    }
+
+    /* the shards of one cache add up under its name */
+    for (i=0; i<stats->cache_number; i++) {
+        if (strEQ(stats->caches[i].name, name)) {
+            entry = &stats->caches[i];
+            break;
+        }
+    }
+
+    if (!entry) {
+        if (stats->cache_number == SIGAR_STATS_CACHE_MAX) {
+            return;
+        }
+        entry = &stats->caches[stats->cache_number++];
+        SIGAR_SSTRCPY(entry->name, name);
+    }
+
+    entry->count  += cache->count;
+    entry->hits   += cache->hits;
+    entry->misses += cache->misses;
+}
+
+static void stats_caches(sigar_t *sigar, sigar_stats_t *stats)
+{
+    sigar_stats_cache(stats, "fsdev", sigar->fsdev);
+    sigar_stats_cache(stats, "proc_cpu", sigar->proc_cpu);
+    sigar_stats_cache(stats, "proc_io", sigar->proc_io);
+    sigar_stats_cache(stats, "net_listen", sigar->net_listen);
+    sigar_stats_cache(stats, "net_services_tcp", sigar->net_services_tcp);
+    sigar_stats_cache(stats, "net_services_udp", sigar->net_services_udp);
+    sigar_stats_cache(stats, "rates", sigar->rates);
+#ifdef __linux__
+    sigar_stats_cache(stats, "diskstats", sigar->diskstats);
+    sigar_stats_cache(stats, "sock_owners", sigar->sock_owners);
+    sigar_stats_cache(stats, "netns_counters", sigar->netns_counters);
+#endif
+    sigar_stats_shards(sigar, stats);
+}
+
+static void stats_reset(sigar_t *sigar)
+{
+    sigar_stats_state_t *state = sigar->stats;
+    int i;
+
+    SIGAR_ZERO(state);
+    for (i=0; i<SIGAR_STATS_API_MAX; i++) {
+        state->calls[i].name = stats_api_names[i];
+    }
+
+    state->files_opened = SIGAR_ATOMIC_ADD(&stats_files_opened, 0);
+    state->bytes_read = SIGAR_ATOMIC_ADD(&stats_bytes_read, 0);
+
+    stats_caches(sigar, NULL);
+}
+
+SIGAR_DECLARE(int) sigar_stats_enable(sigar_t *sigar, int enable)
+{
+    enable = enable ? 1 : 0;
+
+    sigar_lock(sigar);
+
+    if (!sigar->stats) {
+        if (!enable) {
+            sigar_unlock(sigar);
+            return SIGAR_OK;
+        }
+        /* kept until sigar_close, calls in flight may still count */
+        sigar->stats = malloc(sizeof(*sigar->stats));
+        stats_reset(sigar);
+    }
+
+    if (enable != sigar->stats_enabled) {
+        SIGAR_ATOMIC_ADD(&sigar_stats_users, enable ? 1 : -1);
+        sigar->stats_enabled = enable;
+    }
+
+    sigar_unlock(sigar);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_stats_get(sigar_t *sigar, sigar_stats_t *stats)
+{
+    int i;
+
+    SIGAR_ZERO(stats);
+
+    sigar_lock(sigar);
+
+    stats->enabled = sigar->stats_enabled;
+
+    if (sigar->stats) {
+        sigar_stats_state_t *state = sigar->stats;
+
+        memcpy(stats->calls, state->calls, sizeof(stats->calls));
+        stats->files_opened =
+            SIGAR_ATOMIC_ADD(&stats_files_opened, 0) - state->files_opened;
+        stats->bytes_read =
+            SIGAR_ATOMIC_ADD(&stats_bytes_read, 0) - state->bytes_read;
+    }
+    else {
+        for (i=0; i<SIGAR_STATS_API_MAX; i++) {
+            stats->calls[i].name = stats_api_names[i];
+        }
+    }
+
+    stats_caches(sigar, stats);
+
+    sigar_unlock(sigar);
+
+    return SIGAR_OK;
+}
+
+SIGAR_DECLARE(int) sigar_stats_reset(sigar_t *sigar)
+{
+    sigar_lock(sigar);
+
+    if (sigar->stats) {
+        stats_reset(sigar);
+    }
+    else {
+        stats_caches(sigar, NULL);
+    }
+
+    sigar_unlock(sigar);
+
+    return SIGAR_OK;
+}
@@ -29,6 +29,7 @@
 #ifndef WIN32
 
 #include <dirent.h>
+#include <time.h>
 #include <sys/stat.h>
 
 SIGAR_INLINE char *sigar_uitoa(char *buf, unsigned int n, int *len)
@@ -100,7 +101,35 @@ char *sigar_getword(char **line, char stop)
 
 /* avoiding sprintf */
 
-char *sigar_proc_filename(char *buffer, int buflen,
+const char *sigar_root_path(sigar_t *sigar, const char *path,
+                            char *buffer, int buflen)
+{
+    const char *root;
+    int skip;
+
+    /* the roots replace the leading dir, "/proc" of "/proc/stat" */
+    if (sigar->proc_root &&
+        strnEQ(path, PROC_FS_ROOT, SSTRLEN(PROC_FS_ROOT)))
+    {
+        root = sigar->proc_root;
+        skip = SSTRLEN(PROC_FS_ROOT) - 1;
+    }
+    else if (sigar->sys_root &&
+             strnEQ(path, SYS_FS_ROOT, SSTRLEN(SYS_FS_ROOT)))
+    {
+        root = sigar->sys_root;
+        skip = SSTRLEN(SYS_FS_ROOT) - 1;
+    }
+    else {
+        return path;
+    }
+
+    snprintf(buffer, buflen, "%s%s", root, path + skip);
+
+    return buffer;
+}
+
+char *sigar_proc_filename(sigar_t *sigar, char *buffer, int buflen,
                           sigar_pid_t bigpid,
                           const char *fname, int fname_len)
 {
@@ -108,7 +137,15 @@ char *sigar_proc_filename(char *buffer, int buflen,
     char *ptr = buffer;
     unsigned int pid = (unsigned int)bigpid; /* XXX -- This isn't correct */
     char pid_buf[UITOA_BUFFER_SIZE];
-    char *pid_str = sigar_uitoa(pid_buf, pid, &len);
+    char *pid_str;
+
+    if (sigar->proc_root) {
+        snprintf(buffer, buflen, "%s/%u%.*s",
+                 sigar->proc_root, pid, fname_len, fname);
+        return buffer;
+    }
+
+    pid_str = sigar_uitoa(pid_buf, pid, &len);
 
     assert((unsigned int)buflen >=
            (SSTRLEN(PROCP_FS_ROOT) + UITOA_BUFFER_SIZE + fname_len + 1));
@@ -126,14 +163,14 @@ char *sigar_proc_filename(char *buffer, int buflen,
     return buffer;
 }
 
-int sigar_proc_file2str(char *buffer, int buflen,
+int sigar_proc_file2str(sigar_t *sigar, char *buffer, int buflen,
                         sigar_pid_t pid,
                         const char *fname,
                         int fname_len)
 {
     int retval;
 
-    buffer = sigar_proc_filename(buffer, buflen, pid,
+    buffer = sigar_proc_filename(sigar, buffer, buflen, pid,
                                  fname, fname_len);
 
     retval = sigar_file2str(buffer, buffer, buflen);
@@ -153,7 +190,8 @@ int sigar_proc_file2str(char *buffer, int buflen,
 int sigar_proc_list_procfs_get(sigar_t *sigar,
                                sigar_proc_list_t *proclist)
 {
-    DIR *dirp = opendir("/proc");
+    char root[SIGAR_PATH_MAX+1];
+    DIR *dirp = opendir(SIGAR_ROOT_PATH(sigar, PROCP_FS_ROOT, root));
     struct dirent *ent;
 #ifdef HAVE_READDIR_R
     struct dirent dbuf;
@@ -163,6 +201,10 @@ int sigar_proc_list_procfs_get(sigar_t *sigar,
         return errno;
     }
 
+    if (sigar_recording && !sigar->proc_root) {
+        sigar_record_dir(PROCP_FS_ROOT);
+    }
+
 #ifdef HAVE_READDIR_R
     while (readdir_r(dirp, &dbuf, &ent) == 0) {
         if (ent == NULL) {
@@ -198,7 +240,7 @@ int sigar_proc_fd_count(sigar_t *sigar, sigar_pid_t pid,
 #endif
     char name[BUFSIZ];
 
-    (void)SIGAR_PROC_FILENAME(name, pid, "/fd");
+    (void)SIGAR_PROC_FILENAME(sigar, name, pid, "/fd");
 
     *total = 0;
 
@@ -223,6 +265,11 @@ int sigar_proc_fd_count(sigar_t *sigar, sigar_pid_t pid,
 
     closedir(dirp);
 
+    /* after closedir, so that of a process's own fds it holds as many */
+    if (sigar_recording) {
+        sigar_record_dir(name);
+    }
+
     return SIGAR_OK;
 }
 
@@ -232,7 +279,7 @@ int sigar_procfs_args_get(sigar_t *sigar, sigar_pid_t pid,
     char buffer[9086], *buf=NULL, *ptr;
     int fd, len, total=0;
 
-    (void)SIGAR_PROC_FILENAME(buffer, pid, "/cmdline");
+    (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/cmdline");
 
     if ((fd = open(buffer, O_RDONLY)) < 0) {
         if (errno == ENOENT) {
@@ -258,6 +305,11 @@ int sigar_procfs_args_get(sigar_t *sigar, sigar_pid_t pid,
 
     close(fd);
 
+    if (sigar_recording) {
+        (void)SIGAR_PROC_FILENAME(sigar, buffer, pid, "/cmdline");
+        sigar_record_file(buffer, buf, total);
+    }
+
     /* e.g. /proc/2/cmdline */
     if (total == 0) {
         procargs->number = 0;
@@ -347,8 +399,8 @@ int sigar_mem_calc_ram(sigar_t *sigar, sigar_mem_t *mem)
 
 #ifndef WIN32
 
-sigar_iodev_t *sigar_iodev_get(sigar_t *sigar,
-                               const char *dirname)
+static sigar_iodev_t *iodev_get(sigar_t *sigar,
+                                const char *dirname)
 {
     sigar_cache_entry_t *entry;
     struct stat sb;
@@ -401,6 +453,25 @@ sigar_iodev_t *sigar_iodev_get(sigar_t *sigar,
         return iodev;
     }
 
+#ifdef __linux__
+    /* mountinfo has the st_dev of every mount, no need to stat them all */
+    if (sigar_mount_dev_name_get(sigar, sb.st_dev,
+                                 dev_name, sizeof(dev_name)) == SIGAR_OK)
+    {
+        sigar_iodev_t *iodev;
+        entry->value = iodev = malloc(sizeof(*iodev));
+        SIGAR_ZERO(iodev);
+        iodev->is_partition = 1;
+        SIGAR_SSTRCPY(iodev->name, dev_name);
+        if (debug) {
+            sigar_log_printf(sigar, SIGAR_LOG_DEBUG,
+                             "[iodev] map %s -> %s",
+                             dirname, iodev->name);
+        }
+        return iodev;
+    }
+#endif
+
     status = sigar_file_system_list_get(sigar, &fslist);
 
     if (status != SIGAR_OK) {
@@ -458,6 +529,19 @@ sigar_iodev_t *sigar_iodev_get(sigar_t *sigar,
         return NULL;
     }
 }
+
+/* entries stay put until sigar_close, the pointer is safe to keep */
+sigar_iodev_t *sigar_iodev_get(sigar_t *sigar,
+                               const char *dirname)
+{
+    sigar_iodev_t *iodev;
+
+    sigar_lock(sigar);
+    iodev = iodev_get(sigar, dirname);
+    sigar_unlock(sigar);
+
+    return iodev;
+}
 #endif
 
 double sigar_file_system_usage_calc_used(sigar_t *sigar,
@@ -831,6 +915,7 @@ SIGAR_DECLARE(int) sigar_rpc_ping(char *host,
 
 int sigar_file2str(const char *fname, char *buffer, int buflen)
 {
+    char path[SIGAR_PATH_MAX+1];
     int len, status;
     int fd = open(fname, O_RDONLY);
 
@@ -838,18 +923,92 @@ int sigar_file2str(const char *fname, char *buffer, int buflen)
         return ENOENT;
     }
 
+    if (sigar_recording) {
+        /* fname may be buffer itself, see sigar_proc_file2str */
+        SIGAR_SSTRCPY(path, fname);
+        fname = path;
+    }
+
     if ((len = read(fd, buffer, buflen)) < 0) {
         status = errno;
+        sigar_stats_file_read(1, 0);
     }
     else {
         status = SIGAR_OK;
         buffer[len] = '\0';
+        sigar_stats_file_read(1, len);
+        if (sigar_recording) {
+            sigar_record_file(fname, buffer, len);
+        }
     }
     close(fd);
 
     return status;
 }
 
+#ifdef __linux__
+/*
+ * fp read whole for the recording and handed back as a copy in
+ * memory, a second read of a /proc file need not match the first.
+ */
+static FILE *record_fopen(const char *fname, FILE *fp)
+{
+    size_t len = 0, size = BUFSIZ, n;
+    char *data = malloc(size);
+    FILE *mem;
+
+    while ((n = fread(data + len, 1, size - len, fp)) > 0) {
+        len += n;
+        if (len == size) {
+            size *= 2;
+            data = realloc(data, size);
+        }
+    }
+    fclose(fp);
+
+    sigar_record_file(fname, data, len);
+
+    /* fmemopen's own buffer when NULL, freed by fclose */
+    if ((mem = fmemopen(NULL, len + 1, "w+"))) {
+        fwrite(data, 1, len, mem);
+        rewind(mem);
+    }
+    free(data);
+
+    return mem;
+}
+#endif
+
+FILE *sigar_fopen(const char *fname)
+{
+    FILE *fp = fopen(fname, "r");
+
+    if (fp) {
+        sigar_stats_file_read(1, 0);
+#ifdef __linux__
+        if (sigar_recording) {
+            fp = record_fopen(fname, fp);
+        }
+#endif
+    }
+
+    return fp;
+}
+
+int sigar_fclose(FILE *fp)
+{
+    if (sigar_stats_users) {
+        /* ftell is a syscall of its own, only while counting */
+        long pos = ftell(fp);
+
+        if (pos > 0) {
+            sigar_stats_file_read(0, pos);
+        }
+    }
+
+    return fclose(fp);
+}
+
 #ifdef WIN32
 #define vsnprintf _vsnprintf
 #endif
@@ -887,12 +1046,15 @@ static int proc_module_get_self(void *data, char *name, int len)
 
 char *sigar_get_self_path(sigar_t *sigar)
 {
+    sigar_lock(sigar);
+
     if (!sigar->self_path) {
         sigar_proc_modules_t procmods;
         char *self_path = getenv("SIGAR_PATH");
 
         if (self_path) {
             sigar->self_path = sigar_strdup(self_path);
+            sigar_unlock(sigar);
             return sigar->self_path;
         }
 
@@ -909,6 +1071,8 @@ char *sigar_get_self_path(sigar_t *sigar)
         }
     }
 
+    sigar_unlock(sigar);
+
     return sigar->self_path;
 }
 
@@ -1057,4 +1221,17 @@ sigar_int64_t sigar_time_now_millis(void)
     gettimeofday(&tv, NULL);
     return ((tv.tv_sec * SIGAR_USEC) + tv.tv_usec) / SIGAR_MSEC;
 }
+
+sigar_uint64_t sigar_time_monotonic_millis(void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return ((sigar_uint64_t)ts.tv_sec * SIGAR_MSEC) +
+            (ts.tv_nsec / (SIGAR_NSEC / SIGAR_MSEC));
+    }
+#endif
+    return sigar_time_now_millis();
+}
 #endif
@@ -0,0 +1,540 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * times the list, snapshot, ptql and net walks against fixture trees
+ * of growing size:
+ *
+ *   sigar_bench [-r rounds] [procs[:sockets[:interfaces[:disks]]] ...]
+ *
+ * sockets default to procs, interfaces and disks to procs / 100.
+ * the lines of /proc text are first parsed by libc and by sigar_parse.h
+ * on their own.
+ */
+#include <sys/types.h>
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_parse.h"
+#include "sigar_ptql.h"
+#include "sigar_fixture.h"
+
+typedef int (*bench_func_t)(sigar_t *sigar, sigar_fixture_t *fixture);
+
+static double bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static int bench_proc_list(sigar_t *sigar, sigar_fixture_t *fixture)
+{
+    sigar_proc_list_t proclist;
+    int status;
+
+    if ((status = sigar_proc_list_get(sigar, &proclist)) != SIGAR_OK) {
+        return status;
+    }
+    if (proclist.number != fixture->procs) {
+        status = SIGAR_ENOTIMPL;
+    }
+    sigar_proc_list_destroy(sigar, &proclist);
+
+    return status;
+}
+
+/* what a top-like poll does per process */
+static int bench_proc_snapshot(sigar_t *sigar, sigar_fixture_t *fixture)
+{
+    sigar_proc_list_t proclist;
+    sigar_proc_state_t procstate;
+    sigar_proc_mem_t procmem;
+    sigar_proc_cpu_t proccpu;
+    unsigned long i;
+    int status;
+
+    if ((status = sigar_proc_list_get(sigar, &proclist)) != SIGAR_OK) {
+        return status;
+    }
+
+    for (i=0; i<proclist.number; i++) {
+        sigar_pid_t pid = proclist.data[i];
+
+        if (((status = sigar_proc_state_get(sigar, pid, &procstate)) != SIGAR_OK) ||
+            ((status = sigar_proc_mem_get(sigar, pid, &procmem)) != SIGAR_OK) ||
+            ((status = sigar_proc_cpu_get(sigar, pid, &proccpu)) != SIGAR_OK))
+        {
+            break;
+        }
+    }
+
+    sigar_proc_list_destroy(sigar, &proclist);
+
+    return status;
+}
+
+/*
+ * each process's strings (name, user, group, exe, cwd and args)
+ * read and interned, all held until the last as history would keep
+ * them.  other reads than proc_snapshot's, not the same poll stored.
+ */
+static int bench_proc_strings(sigar_t *sigar, sigar_fixture_t *fixture)
+{
+    sigar_proc_list_t proclist;
+    sigar_proc_interned_t *procs;
+    unsigned long i, number = 0;
+    int status;
+
+    if ((status = sigar_proc_list_get(sigar, &proclist)) != SIGAR_OK) {
+        return status;
+    }
+
+    procs = malloc(sizeof(*procs) * proclist.number);
+
+    for (i=0; i<proclist.number; i++) {
+        status = sigar_proc_interned_get(sigar, proclist.data[i],
+                                         &procs[number]);
+        if (status != SIGAR_OK) {
+            break;
+        }
+        number++;
+    }
+
+    for (i=0; i<number; i++) {
+        sigar_proc_interned_release(sigar, &procs[i]);
+    }
+
+    free(procs);
+    sigar_proc_list_destroy(sigar, &proclist);
+
+    return status;
+}
+
+static int bench_proc_stat(sigar_t *sigar, sigar_fixture_t *fixture)
+{
+    sigar_proc_stat_t procstat;
+
+    return sigar_proc_stat_get(sigar, &procstat);
+}
+
+static int bench_ptql(sigar_t *sigar, sigar_fixture_t *fixture)
+{
+    sigar_ptql_query_t *query;
+    sigar_ptql_error_t error;
+    sigar_proc_list_t proclist;
+    char ptql[64];
+    int status;
+
+    snprintf(ptql, sizeof(ptql), "State.Name.eq=fixture%lu",
+             fixture->procs / 2);
+
+    if ((status = sigar_ptql_query_create(&query, ptql, &error)) != SIGAR_OK) {
+        return status;
+    }
+    if ((status = sigar_ptql_query_find(sigar, query, &proclist)) == SIGAR_OK) {
+        sigar_proc_list_destroy(sigar, &proclist);
+    }
+    sigar_ptql_query_destroy(query);
+
+    return status;
+}
+
+static int bench_net_connections(sigar_t *sigar, sigar_fixture_t *fixture)
+{
+    sigar_net_connection_list_t connlist;
+    int status;
+
+    status = sigar_net_connection_list_get(sigar, &connlist,
+                                           SIGAR_NETCONN_SERVER |
+                                           SIGAR_NETCONN_TCP);
+    if (status == SIGAR_OK) {
+        sigar_net_connection_list_destroy(sigar, &connlist);
+    }
+
+    return status;
+}
+
+/* the fd walk behind port to pid */
+static int bench_proc_port(sigar_t *sigar, sigar_fixture_t *fixture)
+{
+    sigar_pid_t pid;
+
+    if (fixture->sockets == 0) {
+        return SIGAR_OK;
+    }
+
+    return sigar_proc_port_get(sigar, SIGAR_NETCONN_TCP,
+                               FIXTURE_PORT_BASE + fixture->sockets - 1,
+                               &pid);
+}
+
+static int bench_net_interfaces(sigar_t *sigar, sigar_fixture_t *fixture)
+{
+    sigar_net_interface_stat_t ifstat;
+    char name[32];
+    unsigned long i;
+    int status = SIGAR_OK;
+
+    for (i=0; i<fixture->interfaces; i++) {
+        snprintf(name, sizeof(name), "fx%lu", i);
+        if ((status = sigar_net_interface_stat_get(sigar, name, &ifstat)) != SIGAR_OK) {
+            break;
+        }
+    }
+
+    return status;
+}
+
+static int bench_disk_io(sigar_t *sigar, sigar_fixture_t *fixture)
+{
+    sigar_disk_io_list_t disklist;
+    int status;
+
+    if ((status = sigar_disk_io_list_get(sigar, &disklist)) == SIGAR_OK) {
+        sigar_disk_io_list_destroy(sigar, &disklist);
+    }
+
+    return status;
+}
+
+#define PARSE_LINES 200000
+
+/* /proc/PID/stat past the state, /proc/diskstats past the name */
+static const char parse_stat_line[] =
+    "1 12345 12345 0 -1 4194560 1234567 98765432 12 345 123456789 "
+    "98765 1234 567 20 0 24 0 1234567890 2147483648 262144 "
+    "18446744073709551615 94371840 94375936 140736912345678 0 0 0 0 0 "
+    "0 0 0 17 3 0 0 42 0 0\n";
+
+static const char parse_diskstats_line[] =
+    "1234567 12345 987654321 1234567 7654321 54321 123456789 7654321 "
+    "0 12345678 23456789 0 0 0 0 123456 7890\n";
+
+/* /proc/net/tcp6, the addresses and queues */
+static const char parse_tcp_line[] =
+    "0000000000000000FFFF00000100007F 00000000000000000000000001000000 "
+    "0A 00000000:0000ABCD\n";
+
+typedef sigar_uint64_t (*parse_func_t)(char *line, char *end);
+
+static sigar_uint64_t parse_libc_u64(char *ptr, char *end)
+{
+    sigar_uint64_t sum = 0;
+
+    for (;;) {
+        char *next;
+        sigar_uint64_t value = strtoull(ptr, &next, 10);
+
+        if (next == ptr) {
+            break;
+        }
+        sum += value;
+        ptr = next;
+    }
+
+    return sum;
+}
+
+static sigar_uint64_t parse_sigar_u64(char *ptr, char *end)
+{
+    sigar_uint64_t sum = 0;
+
+    for (;;) {
+        char *start = ptr;
+        sigar_uint64_t value = sigar_parse_u64(&ptr, end);
+
+        if (ptr == start) {
+            break;
+        }
+        sum += value;
+    }
+
+    return sum;
+}
+
+/* what the tcp parser did before sigar_parse_hex32 */
+static unsigned int parse_ctype_hex(const char *x, int len)
+{
+    unsigned int j = 0;
+    int i;
+
+    for (i=0; i<len; i++) {
+        int ch = x[i];
+        j <<= 4;
+        if (isdigit(ch)) {
+            j |= ch - '0';
+        }
+        else if (isupper(ch)) {
+            j |= ch - ('A' - 10);
+        }
+        else {
+            j |= ch - ('a' - 10);
+        }
+    }
+
+    return j;
+}
+
+static sigar_uint64_t parse_libc_tcp(char *ptr, char *end)
+{
+    sigar_uint64_t sum = 0;
+    int i;
+
+    for (i=0; i<8; i++) {
+        sum += parse_ctype_hex(ptr + (i * 8) + (i >= 4), 8);
+    }
+    ptr += 66;
+    sum += parse_ctype_hex(ptr, 2);
+    sum += parse_ctype_hex(ptr + 3, 8);
+    sum += parse_ctype_hex(ptr + 12, 8);
+
+    return sum;
+}
+
+static sigar_uint64_t parse_sigar_tcp(char *ptr, char *end)
+{
+    sigar_uint64_t sum = 0;
+    int i;
+
+    for (i=0; i<8; i++) {
+        sum += sigar_parse_hex32(ptr + (i * 8) + (i >= 4));
+    }
+    ptr += 66;
+    sum += sigar_parse_hex(ptr, 2);
+    sum += sigar_parse_hex32(ptr + 3);
+    sum += sigar_parse_hex32(ptr + 12);
+
+    return sum;
+}
+
+static const struct {
+    const char *name;
+    const char *line;
+    parse_func_t libc, sigar;
+} parsers[] = {
+    { "parse_pid_stat",   parse_stat_line, parse_libc_u64, parse_sigar_u64 },
+    { "parse_diskstats",  parse_diskstats_line, parse_libc_u64, parse_sigar_u64 },
+    { "parse_tcp_hex",    parse_tcp_line, parse_libc_tcp, parse_sigar_tcp },
+    { NULL, NULL, NULL, NULL }
+};
+
+static double parse_time(parse_func_t func, char *line, int rounds,
+                         sigar_uint64_t *sum)
+{
+    char *end = line + strlen(line);
+    double best = 0;
+    int i, r;
+
+    for (r=0; r<rounds; r++) {
+        double start = bench_now(), elapsed;
+
+        *sum = 0;
+        for (i=0; i<PARSE_LINES; i++) {
+            *sum += func(line, end);
+        }
+        elapsed = bench_now() - start;
+
+        if ((r == 0) || (elapsed < best)) {
+            best = elapsed;
+        }
+    }
+
+    return best;
+}
+
+/* ns a line, and a check that both read the same numbers */
+static int bench_parsers(int rounds)
+{
+    char line[1024];
+    int i, status = 0;
+
+    printf("%-16s %10s  %12s %12s\n", "# parse", "lines", "libc", "sigar");
+
+    for (i=0; parsers[i].name; i++) {
+        sigar_uint64_t libc_sum, sigar_sum;
+        double libc, sigar;
+
+        strcpy(line, parsers[i].line);
+        libc = parse_time(parsers[i].libc, line, rounds, &libc_sum);
+        sigar = parse_time(parsers[i].sigar, line, rounds, &sigar_sum);
+
+        if (libc_sum != sigar_sum) {
+            printf("%-16s %10d  mismatch\n", parsers[i].name, PARSE_LINES);
+            status = 1;
+            continue;
+        }
+
+        printf("%-16s %10d  %9.1f ns %9.1f ns\n", parsers[i].name,
+               PARSE_LINES,
+               libc * 1e9 / PARSE_LINES, sigar * 1e9 / PARSE_LINES);
+    }
+
+    return status;
+}
+
+static const struct {
+    const char *name;
+    bench_func_t func;
+} benches[] = {
+    { "proc_list",      bench_proc_list },
+    { "proc_snapshot",  bench_proc_snapshot },
+    { "proc_strings",   bench_proc_strings },
+    { "proc_stat",      bench_proc_stat },
+    { "ptql_find",      bench_ptql },
+    { "net_connections", bench_net_connections },
+    { "proc_port",      bench_proc_port },
+    { "net_interfaces", bench_net_interfaces },
+    { "disk_io_list",   bench_disk_io },
+    { NULL, NULL }
+};
+
+static int bench_scale(const char *tmpdir, sigar_fixture_t *fixture,
+                       int rounds)
+{
+    char root[1024], proc[1024], sys[1024];
+    sigar_t *sigar;
+    double start, best;
+    int i, r, status;
+
+    snprintf(root, sizeof(root), "%s/%lu", tmpdir, fixture->procs);
+    snprintf(proc, sizeof(proc), "%s/proc", root);
+    snprintf(sys, sizeof(sys), "%s/sys", root);
+
+    start = bench_now();
+    if ((status = sigar_fixture_create(root, fixture)) != 0) {
+        fprintf(stderr, "fixture %s: %s\n", root, strerror(status));
+        sigar_fixture_destroy(root);
+        return status;
+    }
+
+    printf("# procs=%lu sockets=%lu interfaces=%lu disks=%lu "
+           "(generated in %.2fs)\n",
+           fixture->procs, fixture->sockets,
+           fixture->interfaces, fixture->disks,
+           bench_now() - start);
+
+    if ((status = sigar_open(&sigar)) != SIGAR_OK) {
+        sigar_fixture_destroy(root);
+        return status;
+    }
+
+    if ((status = sigar_proc_root_set(sigar, proc, sys)) != SIGAR_OK) {
+        fprintf(stderr, "proc_root_set: %s\n", sigar_strerror(sigar, status));
+        sigar_close(sigar);
+        sigar_fixture_destroy(root);
+        return status;
+    }
+
+    for (i=0; benches[i].name; i++) {
+        best = 0;
+        for (r=0; r<rounds; r++) {
+            double elapsed;
+
+            start = bench_now();
+            status = benches[i].func(sigar, fixture);
+            elapsed = bench_now() - start;
+
+            if (status != SIGAR_OK) {
+                break;
+            }
+            if ((r == 0) || (elapsed < best)) {
+                best = elapsed;
+            }
+        }
+
+        if (status != SIGAR_OK) {
+            printf("%-16s %10lu  %s\n", benches[i].name, fixture->procs,
+                   sigar_strerror(sigar, status));
+        }
+        else {
+            printf("%-16s %10lu  %12.3f ms\n", benches[i].name,
+                   fixture->procs, best * 1000);
+        }
+    }
+
+    sigar_close(sigar);
+    sigar_fixture_destroy(root);
+
+    return SIGAR_OK;
+}
+
+static void bench_parse(const char *arg, sigar_fixture_t *fixture)
+{
+    char *ptr;
+
+    memset(fixture, 0, sizeof(*fixture));
+
+    fixture->procs = strtoul(arg, &ptr, 10);
+    fixture->sockets = fixture->procs;
+    fixture->interfaces = fixture->disks = fixture->procs / 100;
+    fixture->cpus = 4;
+
+    if (*ptr == ':') {
+        fixture->sockets = strtoul(ptr+1, &ptr, 10);
+    }
+    if (*ptr == ':') {
+        fixture->interfaces = strtoul(ptr+1, &ptr, 10);
+    }
+    if (*ptr == ':') {
+        fixture->disks = strtoul(ptr+1, &ptr, 10);
+    }
+}
+
+int main(int argc, char **argv) {
+    static const char *scales[] = { "1000", "10000", "50000", NULL };
+    char tmpdir[] = "/tmp/sigar_bench.XXXXXX";
+    sigar_fixture_t fixture;
+    int rounds = 5, i, status = 0;
+
+    if ((argc > 2) && (strcmp(argv[1], "-r") == 0)) {
+        rounds = atoi(argv[2]);
+        argc -= 2;
+        argv += 2;
+    }
+    if (rounds < 1) {
+        rounds = 1;
+    }
+
+    if (!mkdtemp(tmpdir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    if (bench_parsers(rounds) != 0) {
+        rmdir(tmpdir);
+        return 1;
+    }
+
+    printf("%-16s %10s  %15s\n", "# bench", "procs", "best of rounds");
+
+    for (i=0; (argc > 1) ? (i < argc-1) : (scales[i] != NULL); i++) {
+        bench_parse((argc > 1) ? argv[i+1] : scales[i], &fixture);
+        if ((status = bench_scale(tmpdir, &fixture, rounds)) != 0) {
+            break;
+        }
+    }
+
+    rmdir(tmpdir);
+
+    return status ? 1 : 0;
+}
@@ -0,0 +1,421 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "sigar_fixture.h"
+
+#define FIXTURE_PATH_MAX 4096
+
+static int fixture_mkdir(const char *fmt, ...)
+{
+    char path[FIXTURE_PATH_MAX];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(path, sizeof(path), fmt, ap);
+    va_end(ap);
+
+    if ((mkdir(path, 0755) < 0) && (errno != EEXIST)) {
+        return errno;
+    }
+
+    return 0;
+}
+
+/* path, then the printf format and arguments of the contents */
+static int fixture_write(const char *path, const char *fmt, ...)
+{
+    FILE *fp;
+    va_list ap;
+
+    if (!(fp = fopen(path, "w"))) {
+        return errno;
+    }
+
+    va_start(ap, fmt);
+    vfprintf(fp, fmt, ap);
+    va_end(ap);
+
+    return fclose(fp) == 0 ? 0 : errno;
+}
+
+#define FIXTURE_PATH(buffer, fmt, ...) \
+    snprintf(buffer, sizeof(buffer), fmt, __VA_ARGS__)
+
+static int fixture_proc_global(const char *proc, sigar_fixture_t *fixture)
+{
+    char path[FIXTURE_PATH_MAX];
+    FILE *fp;
+    unsigned long i;
+    int status;
+
+    FIXTURE_PATH(path, "%s/stat", proc);
+    if (!(fp = fopen(path, "w"))) {
+        return errno;
+    }
+    fprintf(fp, "cpu  %lu %lu %lu %lu 200 0 50 0 0 0\n",
+            10000 * fixture->cpus, 100 * fixture->cpus,
+            5000 * fixture->cpus, 900000 * fixture->cpus);
+    for (i=0; i<fixture->cpus; i++) {
+        fprintf(fp, "cpu%lu 10000 100 5000 900000 200 0 50 0 0 0\n", i);
+    }
+    fprintf(fp,
+            "intr 1000\n"
+            "ctxt 100000\n"
+            "btime 1700000000\n"
+            "processes %lu\n"
+            "procs_running 1\n"
+            "procs_blocked 0\n",
+            fixture->procs);
+    fclose(fp);
+
+    FIXTURE_PATH(path, "%s/cpuinfo", proc);
+    if (!(fp = fopen(path, "w"))) {
+        return errno;
+    }
+    for (i=0; i<fixture->cpus; i++) {
+        fprintf(fp,
+                "processor\t: %lu\n"
+                "vendor_id\t: GenuineIntel\n"
+                "model name\t: Fixture CPU @ 2.00GHz\n"
+                "cpu MHz\t\t: 2000.000\n"
+                "cache size\t: 8192 KB\n"
+                "physical id\t: 0\n"
+                "core id\t\t: %lu\n"
+                "cpu cores\t: %lu\n\n",
+                i, i, fixture->cpus);
+    }
+    fclose(fp);
+
+    FIXTURE_PATH(path, "%s/meminfo", proc);
+    status = fixture_write(path,
+                           "MemTotal:       16384000 kB\n"
+                           "MemFree:         8192000 kB\n"
+                           "Buffers:          512000 kB\n"
+                           "Cached:          2048000 kB\n"
+                           "SwapTotal:       4096000 kB\n"
+                           "SwapFree:        4000000 kB\n");
+    if (status) {
+        return status;
+    }
+
+    FIXTURE_PATH(path, "%s/vmstat", proc);
+    if ((status = fixture_write(path, "pswpin 10\npswpout 20\n"))) {
+        return status;
+    }
+
+    FIXTURE_PATH(path, "%s/uptime", proc);
+    if ((status = fixture_write(path, "12345.67 98765.43\n"))) {
+        return status;
+    }
+
+    FIXTURE_PATH(path, "%s/loadavg", proc);
+    return fixture_write(path, "0.50 0.40 0.30 1/%lu %lu\n",
+                         fixture->procs,
+                         FIXTURE_PID_BASE + fixture->procs);
+}
+
+static int fixture_proc_pid(const char *proc, sigar_fixture_t *fixture,
+                            unsigned long i)
+{
+    char path[FIXTURE_PATH_MAX], link[64];
+    unsigned long pid = FIXTURE_PID_BASE + i, sock, fd;
+    int status;
+
+    if ((status = fixture_mkdir("%s/%lu", proc, pid)) ||
+        (status = fixture_mkdir("%s/%lu/fd", proc, pid)))
+    {
+        return status;
+    }
+
+    /* fields as proc(5), 44 of them */
+    FIXTURE_PATH(path, "%s/%lu/stat", proc, pid);
+    status = fixture_write(path,
+                           "%lu (fixture%lu) S 1 %lu %lu 0 -1 4194560 "
+                           "%lu 0 %lu 0 %lu %lu 0 0 20 0 1 0 %lu "
+                           "10485760 256 18446744073709551615 1 1 "
+                           "0 0 0 0 0 0 0 0 0 0 17 %lu 0 0 0 0 0\n",
+                           pid, i, pid, pid,
+                           100 + i, i % 10, 10 * (i + 1), 5 * (i + 1),
+                           1000 + i, i % fixture->cpus);
+    if (status) {
+        return status;
+    }
+
+    FIXTURE_PATH(path, "%s/%lu/statm", proc, pid);
+    if ((status = fixture_write(path, "2560 256 128 10 0 200 0\n"))) {
+        return status;
+    }
+
+    FIXTURE_PATH(path, "%s/%lu/status", proc, pid);
+    status = fixture_write(path,
+                           "Name:\tfixture%lu\n"
+                           "State:\tS (sleeping)\n"
+                           "Tgid:\t%lu\n"
+                           "Pid:\t%lu\n"
+                           "PPid:\t1\n"
+                           "Uid:\t1000\t1000\t1000\t1000\n"
+                           "Gid:\t1000\t1000\t1000\t1000\n"
+                           "Threads:\t1\n",
+                           i, pid, pid);
+    if (status) {
+        return status;
+    }
+
+    FIXTURE_PATH(path, "%s/%lu/io", proc, pid);
+    status = fixture_write(path,
+                           "rchar: %lu\n"
+                           "wchar: %lu\n"
+                           "syscr: 10\n"
+                           "syscw: 10\n"
+                           "read_bytes: %lu\n"
+                           "write_bytes: %lu\n"
+                           "cancelled_write_bytes: 0\n",
+                           4096 * (i + 1), 4096 * (i + 1),
+                           4096 * (i + 1), 8192 * (i + 1));
+    if (status) {
+        return status;
+    }
+
+    FIXTURE_PATH(path, "%s/%lu/cmdline", proc, pid);
+    if ((status = fixture_write(path, "fixture%lu%c--id%c%lu%c",
+                                i, '\0', '\0', i, '\0')))
+    {
+        return status;
+    }
+
+    FIXTURE_PATH(path, "%s/%lu/fd/0", proc, pid);
+    if (symlink("/dev/null", path) < 0) {
+        return errno;
+    }
+
+    for (sock = i, fd = 3; sock < fixture->sockets;
+         sock += fixture->procs, fd++)
+    {
+        FIXTURE_PATH(path, "%s/%lu/fd/%lu", proc, pid, fd);
+        snprintf(link, sizeof(link), "socket:[%lu]",
+                 FIXTURE_INODE_BASE + sock);
+        if (symlink(link, path) < 0) {
+            return errno;
+        }
+    }
+
+    return 0;
+}
+
+static const char *fixture_net_empty[] = {
+    "tcp6", "udp", "udp6", "raw", "raw6", NULL
+};
+
+#define FIXTURE_NET_HEADER \
+    "  sl  local_address rem_address   st tx_queue rx_queue tr " \
+    "tm->when retrnsmt   uid  timeout inode\n"
+
+static int fixture_proc_net(const char *proc, sigar_fixture_t *fixture)
+{
+    char path[FIXTURE_PATH_MAX];
+    FILE *fp;
+    unsigned long i;
+    int status;
+
+    FIXTURE_PATH(path, "%s/net/tcp", proc);
+    if (!(fp = fopen(path, "w"))) {
+        return errno;
+    }
+    fputs(FIXTURE_NET_HEADER, fp);
+    for (i=0; i<fixture->sockets; i++) {
+        fprintf(fp,
+                "%4lu: 0100007F:%04lX 00000000:0000 0A "
+                "00000000:00000000 00:00000000 00000000  1000        0 "
+                "%lu 1 0000000000000000 100 0 0 10 0\n",
+                i, (FIXTURE_PORT_BASE + i) & 0xffff,
+                FIXTURE_INODE_BASE + i);
+    }
+    fclose(fp);
+
+    for (i=0; fixture_net_empty[i]; i++) {
+        FIXTURE_PATH(path, "%s/net/%s", proc, fixture_net_empty[i]);
+        if ((status = fixture_write(path, FIXTURE_NET_HEADER))) {
+            return status;
+        }
+    }
+
+    FIXTURE_PATH(path, "%s/net/unix", proc);
+    status = fixture_write(path,
+                           "Num       RefCount Protocol Flags    Type "
+                           "St Inode Path\n");
+    if (status) {
+        return status;
+    }
+
+    FIXTURE_PATH(path, "%s/net/dev", proc);
+    if (!(fp = fopen(path, "w"))) {
+        return errno;
+    }
+    fputs("Inter-|   Receive                            "
+          "                    |  Transmit\n"
+          " face |bytes    packets errs drop fifo frame compressed "
+          "multicast|bytes    packets errs drop fifo colls carrier "
+          "compressed\n", fp);
+    for (i=0; i<fixture->interfaces; i++) {
+        fprintf(fp, "%6s%lu: %lu %lu 0 0 0 0 0 0 %lu %lu 0 0 0 0 0 0\n",
+                "fx", i, 1000 * (i + 1), 10 * (i + 1),
+                2000 * (i + 1), 20 * (i + 1));
+    }
+    fclose(fp);
+
+    return 0;
+}
+
+static int fixture_disks(const char *proc, const char *sys,
+                         sigar_fixture_t *fixture)
+{
+    char path[FIXTURE_PATH_MAX];
+    FILE *fp;
+    unsigned long i;
+    int status;
+
+    FIXTURE_PATH(path, "%s/diskstats", proc);
+    if (!(fp = fopen(path, "w"))) {
+        return errno;
+    }
+    for (i=0; i<fixture->disks; i++) {
+        fprintf(fp, "%4d %7lu fxd%lu %lu 0 %lu %lu %lu 0 %lu %lu 0 %lu %lu\n",
+                8, 16 * i, i,
+                100 * (i + 1), 800 * (i + 1), 10 * (i + 1),
+                200 * (i + 1), 1600 * (i + 1), 20 * (i + 1),
+                30 * (i + 1), 30 * (i + 1));
+    }
+    fclose(fp);
+
+    for (i=0; i<fixture->disks; i++) {
+        if ((status = fixture_mkdir("%s/block/fxd%lu", sys, i))) {
+            return status;
+        }
+        FIXTURE_PATH(path, "%s/block/fxd%lu/stat", sys, i);
+        status = fixture_write(path,
+                               "%lu 0 %lu %lu %lu 0 %lu %lu 0 %lu %lu\n",
+                               100 * (i + 1), 800 * (i + 1), 10 * (i + 1),
+                               200 * (i + 1), 1600 * (i + 1), 20 * (i + 1),
+                               30 * (i + 1), 30 * (i + 1));
+        if (status) {
+            return status;
+        }
+    }
+
+    for (i=0; i<fixture->interfaces; i++) {
+        if ((status = fixture_mkdir("%s/class/net/fx%lu", sys, i))) {
+            return status;
+        }
+        FIXTURE_PATH(path, "%s/class/net/fx%lu/type", sys, i);
+        if ((status = fixture_write(path, "1\n"))) {
+            return status;
+        }
+    }
+
+    return 0;
+}
+
+int sigar_fixture_create(const char *root, sigar_fixture_t *fixture)
+{
+    char proc[FIXTURE_PATH_MAX], sys[FIXTURE_PATH_MAX];
+    unsigned long i;
+    int status;
+
+    if (fixture->cpus == 0) {
+        fixture->cpus = 1;
+    }
+
+    FIXTURE_PATH(proc, "%s/proc", root);
+    FIXTURE_PATH(sys, "%s/sys", root);
+
+    if ((mkdir(root, 0755) < 0) ||
+        (mkdir(proc, 0755) < 0) ||
+        (mkdir(sys, 0755) < 0))
+    {
+        return errno;
+    }
+
+    if ((status = fixture_mkdir("%s/net", proc)) ||
+        (status = fixture_mkdir("%s/block", sys)) ||
+        (status = fixture_mkdir("%s/class", sys)) ||
+        (status = fixture_mkdir("%s/class/net", sys)))
+    {
+        return status;
+    }
+
+    if ((status = fixture_proc_global(proc, fixture)) ||
+        (status = fixture_proc_net(proc, fixture)) ||
+        (status = fixture_disks(proc, sys, fixture)))
+    {
+        return status;
+    }
+
+    for (i=0; i<fixture->procs; i++) {
+        if ((status = fixture_proc_pid(proc, fixture, i))) {
+            return status;
+        }
+    }
+
+    return 0;
+}
+
+int sigar_fixture_destroy(const char *root)
+{
+    char path[FIXTURE_PATH_MAX];
+    struct dirent *ent;
+    struct stat sb;
+    DIR *dirp;
+    int status = 0;
+
+    if (lstat(root, &sb) < 0) {
+        return errno;
+    }
+
+    if (S_ISDIR(sb.st_mode)) {
+        if (!(dirp = opendir(root))) {
+            return errno;
+        }
+        while ((ent = readdir(dirp))) {
+            if ((strcmp(ent->d_name, ".") == 0) ||
+                (strcmp(ent->d_name, "..") == 0))
+            {
+                continue;
+            }
+            FIXTURE_PATH(path, "%s/%s", root, ent->d_name);
+            if ((status = sigar_fixture_destroy(path))) {
+                break;
+            }
+        }
+        closedir(dirp);
+
+        if (status == 0 && rmdir(root) < 0) {
+            status = errno;
+        }
+    }
+    else if (unlink(root) < 0) {
+        status = errno;
+    }
+
+    return status;
+}
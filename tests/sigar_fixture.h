@@ -0,0 +1,48 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SIGAR_FIXTURE_H__
+#define __SIGAR_FIXTURE_H__
+
+/*
+ * fabricated linux /proc and /sys trees, in the formats the linux
+ * parsers read, for sigar_proc_root_set.  everything is derived from
+ * the counts so a test knows what to expect back:
+ *
+ *   pid          FIXTURE_PID_BASE + i, named "fixture<i>", ppid 1
+ *   socket       tcp listener on 127.0.0.1:(FIXTURE_PORT_BASE + i),
+ *                inode FIXTURE_INODE_BASE + i, owned by proc i % procs
+ *   interface    "fx<i>", rx_bytes 1000 * (i + 1)
+ *   disk         "fxd<i>", major 8, minor 16 * i
+ */
+
+#define FIXTURE_PID_BASE   1000
+#define FIXTURE_PORT_BASE  10000
+#define FIXTURE_INODE_BASE 100000
+
+typedef struct {
+    unsigned long procs;
+    unsigned long sockets;
+    unsigned long interfaces;
+    unsigned long disks;
+    unsigned long cpus;
+} sigar_fixture_t;
+
+/* root/proc and root/sys, root must not exist yet */
+int sigar_fixture_create(const char *root, sigar_fixture_t *fixture);
+
+/* rm -r root */
+int sigar_fixture_destroy(const char *root);
+
+#endif
@@ -0,0 +1,260 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/types.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#if !defined(SIGAR_TEST_OS_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_collector.h"
+#include "sigar_tests.h"
+
+#if !defined(SIGAR_TEST_OS_WIN32)
+TEST(test_sigar_collector) {
+	sigar_collector_t *collector;
+	sigar_collector_set_t set;
+	sigar_collector_sample_t sample, older;
+	int cpu_id, mem_id, proc_id;
+
+	assert(SIGAR_OK == sigar_collector_create(&collector, 6));
+
+	memset(&set, 0, sizeof(set));
+	set.type = SIGAR_COLLECT_CPU;
+	set.interval = 10;
+	assert(SIGAR_OK == sigar_collector_add(collector, &set, &cpu_id));
+
+	set.type = SIGAR_COLLECT_MEM;
+	set.interval = 20;
+	assert(SIGAR_OK == sigar_collector_add(collector, &set, &mem_id));
+
+	set.type = SIGAR_COLLECT_PROC;
+	set.interval = 10;
+	set.pid = getpid();
+	assert(SIGAR_OK == sigar_collector_add(collector, &set, &proc_id));
+
+	set.interval = 0;
+	assert(EINVAL == sigar_collector_add(collector, &set, &proc_id));
+
+	assert(ENOENT == sigar_collector_latest_get(collector, cpu_id, &sample));
+	assert(EINVAL == sigar_collector_latest_get(collector, 3, &sample));
+
+	assert(SIGAR_OK == sigar_collector_start(collector));
+	assert(EBUSY == sigar_collector_add(collector, &set, &proc_id));
+
+	usleep(250 * 1000);
+
+	assert(SIGAR_OK == sigar_collector_latest_get(collector, cpu_id, &sample));
+	assert(sample.status == SIGAR_OK);
+	assert(sample.type == SIGAR_COLLECT_CPU);
+	assert(sample.seq > 8); /* more than the ring holds */
+	assert(sample.time >= sample.scheduled);
+	assert(sample.jitter == sample.time - sample.scheduled);
+	assert(sample.jitter_max >= sample.jitter);
+	assert(sample.data.cpu.total > 0);
+
+	/* rounded up to 8 slots, the first sample is gone */
+	assert(ENOENT == sigar_collector_sample_get(collector, cpu_id, 1, &older));
+	assert(ENOENT == sigar_collector_sample_get(collector, cpu_id,
+						    sample.seq + 100, &older));
+
+	assert(SIGAR_OK == sigar_collector_latest_get(collector, mem_id, &sample));
+	assert(sample.status == SIGAR_OK);
+	assert(sample.data.mem.total > 0);
+
+	assert(SIGAR_OK == sigar_collector_latest_get(collector, proc_id, &sample));
+	assert(sample.status == SIGAR_OK);
+	assert(sample.data.proc.state.ppid == getppid());
+
+	assert(SIGAR_OK == sigar_collector_stop(collector));
+
+	/* stopped, history stays readable */
+	assert(SIGAR_OK == sigar_collector_latest_get(collector, cpu_id, &sample));
+	assert(SIGAR_OK == sigar_collector_sample_get(collector, cpu_id,
+						      sample.seq - 1, &older));
+	assert(older.seq == sample.seq - 1);
+	assert(older.scheduled < sample.scheduled);
+
+	assert(SIGAR_OK == sigar_collector_destroy(collector));
+
+	return 0;
+}
+
+TEST(test_sigar_collector_publish) {
+	sigar_collector_t *collector;
+	sigar_collector_shm_t *reader;
+	sigar_collector_shm_info_t info;
+	sigar_collector_set_t set;
+	sigar_collector_sample_t sample;
+	char name[64];
+	int cpu_id, mem_id;
+
+	snprintf(name, sizeof(name), "/sigar-test-%d", (int)getpid());
+
+	assert(SIGAR_OK == sigar_collector_create(&collector, 4));
+
+	memset(&set, 0, sizeof(set));
+	set.type = SIGAR_COLLECT_CPU;
+	set.interval = 10;
+	assert(SIGAR_OK == sigar_collector_add(collector, &set, &cpu_id));
+
+	set.type = SIGAR_COLLECT_MEM;
+	set.interval = 50;
+	assert(SIGAR_OK == sigar_collector_add(collector, &set, &mem_id));
+
+	assert(SIGAR_OK == sigar_collector_publish(collector, name));
+	assert(EBUSY == sigar_collector_add(collector, &set, &mem_id));
+
+	assert(SIGAR_OK == sigar_collector_shm_open(&reader, name));
+	assert(SIGAR_OK == sigar_collector_shm_info_get(reader, &info));
+	assert(info.number == 2);
+	assert(info.pid == getpid());
+	assert(!info.closed);
+
+	assert(ENOENT == sigar_collector_shm_latest_get(reader, cpu_id, &sample));
+	assert(EINVAL == sigar_collector_shm_latest_get(reader, 2, &sample));
+
+	assert(SIGAR_OK == sigar_collector_shm_set_get(reader, mem_id, &set));
+	assert(set.type == SIGAR_COLLECT_MEM);
+	assert(set.interval == 50);
+
+	assert(SIGAR_OK == sigar_collector_start(collector));
+
+	usleep(100 * 1000);
+
+	assert(SIGAR_OK == sigar_collector_shm_latest_get(reader, cpu_id, &sample));
+	assert(sample.type == SIGAR_COLLECT_CPU);
+	assert(sample.status == SIGAR_OK);
+	assert(sample.seq > 1);
+	assert(sample.data.cpu.total > 0);
+
+	assert(SIGAR_OK == sigar_collector_shm_latest_get(reader, mem_id, &sample));
+	assert(sample.type == SIGAR_COLLECT_MEM);
+	assert(sample.data.mem.total > 0);
+
+	/* kept beating by the samples */
+	assert(SIGAR_OK == sigar_collector_shm_info_get(reader, &info));
+	assert(info.heartbeat > info.started);
+	assert(info.heartbeat >= sample.timestamp);
+
+	assert(SIGAR_OK == sigar_collector_destroy(collector));
+
+	/* still mapped, marked closed */
+	assert(ESRCH == sigar_collector_shm_latest_get(reader, cpu_id, &sample));
+	assert(SIGAR_OK == sigar_collector_shm_info_get(reader, &info));
+	assert(info.closed);
+	assert(SIGAR_OK == sigar_collector_shm_close(reader));
+
+	assert(ENOENT == sigar_collector_shm_open(&reader, name));
+
+	return 0;
+}
+
+TEST(test_sigar_collector_publish_owner) {
+	sigar_collector_t *first, *second;
+	sigar_collector_shm_t *reader;
+	sigar_collector_shm_info_t info;
+	sigar_collector_set_t set;
+	char name[64];
+	pid_t pid;
+	int fd, id, status;
+
+	snprintf(name, sizeof(name), "/sigar-test-owner-%d", (int)getpid());
+
+	memset(&set, 0, sizeof(set));
+	set.type = SIGAR_COLLECT_MEM;
+	set.interval = 50;
+
+	assert(SIGAR_OK == sigar_collector_create(&first, 4));
+	assert(SIGAR_OK == sigar_collector_add(first, &set, &id));
+	assert(SIGAR_OK == sigar_collector_create(&second, 4));
+	assert(SIGAR_OK == sigar_collector_add(second, &set, &id));
+
+	/* live, not taken over, however old its heartbeat */
+	assert(SIGAR_OK == sigar_collector_publish(first, name));
+	assert(EEXIST == sigar_collector_publish(second, name));
+	usleep(4 * set.interval * 1000);
+	assert(EEXIST == sigar_collector_publish(second, name));
+
+	/* closed, replaced; the first no longer unlinks the second's */
+	assert(SIGAR_OK == sigar_collector_shm_open(&reader, name));
+	assert(SIGAR_OK == sigar_collector_destroy(first));
+	assert(SIGAR_OK == sigar_collector_publish(second, name));
+	assert(SIGAR_OK == sigar_collector_shm_close(reader));
+
+	assert(SIGAR_OK == sigar_collector_create(&first, 4));
+	assert(SIGAR_OK == sigar_collector_add(first, &set, &id));
+	assert(EEXIST == sigar_collector_publish(first, name));
+
+	assert(SIGAR_OK == sigar_collector_shm_open(&reader, name));
+	assert(SIGAR_OK == sigar_collector_shm_info_get(reader, &info));
+	assert(!info.closed);
+	assert(info.heartbeat == info.started);
+	assert(SIGAR_OK == sigar_collector_shm_close(reader));
+
+	assert(SIGAR_OK == sigar_collector_destroy(second));
+	assert(ENOENT == sigar_collector_shm_open(&reader, name));
+
+	/* a publisher that died without destroy */
+	if ((pid = fork()) == 0) {
+		_exit(sigar_collector_publish(first, name));
+	}
+	assert(pid > 0);
+	assert(pid == waitpid(pid, &status, 0));
+	assert(WIFEXITED(status) && (WEXITSTATUS(status) == SIGAR_OK));
+	/* its pid is gone, but it may be one we cannot see: wait it out */
+	assert(EEXIST == sigar_collector_publish(first, name));
+	usleep(4 * set.interval * 1000);
+	assert(SIGAR_OK == sigar_collector_publish(first, name));
+	assert(SIGAR_OK == sigar_collector_destroy(first));
+	assert(ENOENT == sigar_collector_shm_open(&reader, name));
+
+	/* not a collector's at all, left alone */
+	assert((fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600)) >= 0);
+	close(fd);
+	assert(SIGAR_OK == sigar_collector_create(&first, 4));
+	assert(SIGAR_OK == sigar_collector_add(first, &set, &id));
+	assert(EEXIST == sigar_collector_publish(first, name));
+	assert(SIGAR_OK == sigar_collector_destroy(first));
+	assert(0 == shm_unlink(name));
+
+	return 0;
+}
+#endif
+
+int main() {
+	sigar_t *t;
+	int err = 0;
+
+	assert(SIGAR_OK == sigar_open(&t));
+
+#if !defined(SIGAR_TEST_OS_WIN32)
+	test_sigar_collector(t);
+	test_sigar_collector_publish(t);
+	test_sigar_collector_publish_owner(t);
+#endif
+
+	sigar_close(t);
+
+	return err ? -1 : 0;
+}
@@ -0,0 +1,297 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/types.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "sigar.h"
+#include "sigar_ptql.h"
+#include "sigar_tests.h"
+#include "sigar_fixture.h"
+
+#if defined(SIGAR_TEST_OS_LINUX)
+static char tmpdir[] = "/tmp/sigar_fixture.XXXXXX";
+static char root[sizeof(tmpdir) + 8];
+
+static sigar_fixture_t fixture = {
+	20, /* procs */
+	30, /* sockets */
+	3,  /* interfaces */
+	2,  /* disks */
+	2   /* cpus */
+};
+
+TEST(test_sigar_fixture_proc) {
+	sigar_proc_list_t proclist;
+	sigar_proc_state_t procstate;
+	sigar_proc_mem_t procmem;
+	sigar_proc_args_t procargs;
+	sigar_proc_stat_t procstat;
+
+	assert(SIGAR_OK == sigar_proc_list_get(t, &proclist));
+	assert(proclist.number == fixture.procs);
+	assert(SIGAR_OK == sigar_proc_list_destroy(t, &proclist));
+
+	assert(SIGAR_OK == sigar_proc_state_get(t, FIXTURE_PID_BASE + 7, &procstate));
+	assert(strcmp(procstate.name, "fixture7") == 0);
+	assert(procstate.ppid == 1);
+	assert(procstate.state == SIGAR_PROC_STATE_SLEEP);
+
+	assert(SIGAR_OK == sigar_proc_mem_get(t, FIXTURE_PID_BASE, &procmem));
+	assert(procmem.size > 0);
+
+	assert(SIGAR_OK == sigar_proc_args_get(t, FIXTURE_PID_BASE + 3, &procargs));
+	assert(procargs.number == 3);
+	assert(strcmp(procargs.data[0], "fixture3") == 0);
+	assert(SIGAR_OK == sigar_proc_args_destroy(t, &procargs));
+
+	assert(SIGAR_OK != sigar_proc_state_get(t, FIXTURE_PID_BASE + fixture.procs,
+	                                        &procstate));
+
+	assert(SIGAR_OK == sigar_proc_stat_get(t, &procstat));
+	assert(procstat.total == fixture.procs);
+	assert(procstat.sleeping == fixture.procs);
+
+	return 0;
+}
+
+TEST(test_sigar_fixture_interned) {
+	sigar_proc_interned_t proc;
+	char path[sizeof(root) + 32];
+	FILE *fp;
+
+	assert(SIGAR_OK == sigar_proc_interned_get(t, FIXTURE_PID_BASE + 2, &proc));
+	assert(strcmp(sigar_intern_str(t, proc.args), "fixture2 --id 2") == 0);
+	assert(SIGAR_OK == sigar_proc_interned_release(t, &proc));
+
+	/* a kernel thread has no args, not an interned "" */
+	snprintf(path, sizeof(path), "%s/proc/%lu/cmdline", root,
+	         (unsigned long)FIXTURE_PID_BASE + 1);
+	assert((fp = fopen(path, "w")) != NULL);
+	fclose(fp);
+
+	assert(SIGAR_OK == sigar_proc_interned_get(t, FIXTURE_PID_BASE + 1, &proc));
+	assert(strcmp(sigar_intern_str(t, proc.name), "fixture1") == 0);
+	assert(proc.args == SIGAR_INTERN_NONE);
+	assert(SIGAR_OK == sigar_proc_interned_release(t, &proc));
+	assert(sigar_intern_count(t) == 0);
+
+	return 0;
+}
+
+TEST(test_sigar_fixture_ptql) {
+	sigar_ptql_query_t *query;
+	sigar_ptql_error_t error;
+	sigar_proc_list_t proclist;
+
+	assert(SIGAR_OK == sigar_ptql_query_create(&query, "State.Name.eq=fixture11",
+	                                           &error));
+	assert(SIGAR_OK == sigar_ptql_query_find(t, query, &proclist));
+	assert(proclist.number == 1);
+	assert(proclist.data[0] == FIXTURE_PID_BASE + 11);
+	assert(SIGAR_OK == sigar_proc_list_destroy(t, &proclist));
+	assert(SIGAR_OK == sigar_ptql_query_destroy(query));
+
+	return 0;
+}
+
+TEST(test_sigar_fixture_system) {
+	sigar_cpu_t cpu;
+	sigar_cpu_list_t cpulist;
+	sigar_mem_t mem;
+	sigar_uptime_t uptime;
+
+	assert(SIGAR_OK == sigar_cpu_get(t, &cpu));
+	assert(cpu.total > 0);
+
+	assert(SIGAR_OK == sigar_cpu_list_get(t, &cpulist));
+	assert(cpulist.number == fixture.cpus);
+	assert(SIGAR_OK == sigar_cpu_list_destroy(t, &cpulist));
+
+	assert(SIGAR_OK == sigar_mem_get(t, &mem));
+	assert(mem.total == (sigar_uint64_t)16384000 * 1024);
+
+	assert(SIGAR_OK == sigar_uptime_get(t, &uptime));
+	assert(uptime.uptime > 12345 && uptime.uptime < 12346);
+
+	return 0;
+}
+
+static sigar_stats_cache_t fixture_cache(sigar_t *t, const char *name) {
+	sigar_stats_t stats;
+	sigar_stats_cache_t cache;
+	unsigned long i;
+
+	memset(&cache, 0, sizeof(cache));
+	assert(SIGAR_OK == sigar_stats_get(t, &stats));
+	for (i = 0; i < stats.cache_number; i++) {
+		if (strcmp(stats.caches[i].name, name) == 0) {
+			cache = stats.caches[i];
+		}
+	}
+
+	return cache;
+}
+
+TEST(test_sigar_fixture_net) {
+	sigar_net_interface_stat_t ifstat;
+	sigar_net_connection_list_t connlist;
+	sigar_pid_t pid;
+
+	assert(SIGAR_OK == sigar_net_interface_stat_get(t, "fx2", &ifstat));
+	assert(ifstat.rx_bytes == 3000);
+	assert(SIGAR_OK != sigar_net_interface_stat_get(t, "fx3", &ifstat));
+
+	assert(SIGAR_OK == sigar_net_connection_list_get(t, &connlist,
+	                                                 SIGAR_NETCONN_SERVER |
+	                                                 SIGAR_NETCONN_TCP));
+	assert(connlist.number == fixture.sockets);
+	assert(connlist.data[5].local_port == FIXTURE_PORT_BASE + 5);
+	assert(connlist.data[5].inode == FIXTURE_INODE_BASE + 5);
+	assert(SIGAR_OK == sigar_net_connection_list_destroy(t, &connlist));
+
+	/* the socket of port 25 is owned by proc 25 % 20 */
+	assert(SIGAR_OK == sigar_proc_port_get(t, SIGAR_NETCONN_TCP,
+	                                       FIXTURE_PORT_BASE + 25, &pid));
+	assert(pid == FIXTURE_PID_BASE + 5);
+
+	return 0;
+}
+
+TEST(test_sigar_fixture_port_unowned) {
+	sigar_stats_cache_t before, after;
+	unsigned long port = FIXTURE_PORT_BASE + fixture.sockets;
+	char path[sizeof(root) + 32];
+	sigar_pid_t pid;
+	FILE *fp;
+
+	/* a listener no process we can read holds */
+	snprintf(path, sizeof(path), "%s/proc/net/tcp", root);
+	assert((fp = fopen(path, "a")) != NULL);
+	fprintf(fp, "%4lu: 0100007F:%04lX 00000000:0000 0A "
+	        "00000000:00000000 00:00000000 00000000     0        0 "
+	        "%lu 1 0000000000000000 100 0 0 10 0\n",
+	        fixture.sockets, port, (unsigned long)FIXTURE_INODE_BASE + 999);
+	fclose(fp);
+
+	assert(SIGAR_OK == sigar_proc_port_get(t, SIGAR_NETCONN_TCP, port, &pid));
+	assert(pid == 0);
+
+	/* the miss is remembered, no rescan of every fd for it again */
+	before = fixture_cache(t, "sock_owners");
+	assert(SIGAR_OK == sigar_proc_port_get(t, SIGAR_NETCONN_TCP, port, &pid));
+	assert(pid == 0);
+	after = fixture_cache(t, "sock_owners");
+	assert((after.hits + after.misses) - (before.hits + before.misses) <
+	       fixture.sockets);
+
+	/* the owned ones still resolve */
+	assert(SIGAR_OK == sigar_proc_port_get(t, SIGAR_NETCONN_TCP,
+	                                       FIXTURE_PORT_BASE + 25, &pid));
+	assert(pid == FIXTURE_PID_BASE + 5);
+
+	return 0;
+}
+
+TEST(test_sigar_fixture_disk) {
+	sigar_disk_io_list_t disklist;
+	unsigned long i;
+
+	assert(SIGAR_OK == sigar_disk_io_list_get(t, &disklist));
+	assert(disklist.number == fixture.disks);
+	for (i = 0; i < disklist.number; i++) {
+		if (strcmp(disklist.data[i].name, "fxd1") == 0) {
+			assert(disklist.data[i].disk.reads == 200);
+			break;
+		}
+	}
+	assert(i < disklist.number);
+	assert(SIGAR_OK == sigar_disk_io_list_destroy(t, &disklist));
+
+	return 0;
+}
+
+TEST(test_sigar_fixture_disk_gone) {
+	sigar_disk_io_list_t disklist;
+	char path[sizeof(root) + 32];
+	FILE *fp;
+
+	assert(fixture_cache(t, "diskstats").count == fixture.disks);
+
+	/* fxd0 goes away, its entry must not stay cached */
+	snprintf(path, sizeof(path), "%s/proc/diskstats", root);
+	assert((fp = fopen(path, "w")) != NULL);
+	fprintf(fp, "   8      16 fxd1 200 0 1600 20 400 0 3200 40 0 60 60\n");
+	fclose(fp);
+
+	assert(SIGAR_OK == sigar_disk_io_list_get(t, &disklist));
+	assert(disklist.number == 1);
+	assert(strcmp(disklist.data[0].name, "fxd1") == 0);
+	assert(SIGAR_OK == sigar_disk_io_list_destroy(t, &disklist));
+
+	assert(fixture_cache(t, "diskstats").count == 1);
+
+	return 0;
+}
+#endif
+
+int main() {
+	sigar_t *t;
+	int err = 0;
+
+	assert(SIGAR_OK == sigar_open(&t));
+
+#if defined(SIGAR_TEST_OS_LINUX)
+	assert(mkdtemp(tmpdir) != NULL);
+	snprintf(root, sizeof(root), "%s/root", tmpdir);
+	assert(0 == sigar_fixture_create(root, &fixture));
+
+	{
+		char proc[sizeof(root) + 8], sys[sizeof(root) + 8];
+
+		snprintf(proc, sizeof(proc), "%s/proc", root);
+		snprintf(sys, sizeof(sys), "%s/sys", root);
+		assert(SIGAR_OK == sigar_proc_root_set(t, proc, sys));
+	}
+
+	test_sigar_fixture_proc(t);
+	test_sigar_fixture_interned(t);
+	test_sigar_fixture_ptql(t);
+	test_sigar_fixture_system(t);
+	test_sigar_fixture_net(t);
+	test_sigar_fixture_port_unowned(t);
+	test_sigar_fixture_disk(t);
+	test_sigar_fixture_disk_gone(t);
+
+	/* back to the live tree */
+	assert(SIGAR_OK == sigar_proc_root_set(t, NULL, NULL));
+	{
+		sigar_pid_t pid = sigar_pid_get(t);
+		sigar_proc_state_t procstate;
+
+		assert(SIGAR_OK == sigar_proc_state_get(t, pid, &procstate));
+	}
+
+	assert(0 == sigar_fixture_destroy(tmpdir));
+#endif
+
+	sigar_close(t);
+
+	return err ? -1 : 0;
+}
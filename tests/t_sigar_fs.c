@@ -45,6 +45,7 @@
 
 #include "sigar.h"
 #include "sigar_private.h"
+#include "sigar_fileinfo.h"
 #include "sigar_format.h"
 #include "sigar_tests.h"
 
@@ -149,6 +150,253 @@ TEST(test_sigar_file_system_list_get) {
 	return 0;
 }
 
+TEST(test_sigar_file_system_list_cached) {
+	sigar_file_system_list_t first, second;
+	size_t i;
+
+	assert(SIGAR_OK == sigar_file_system_list_get(t, &first));
+	assert(SIGAR_OK == sigar_file_system_list_get(t, &second));
+
+	/* nothing got mounted in between, the table is served from cache */
+	assert(first.number == second.number);
+	for (i = 0; i < first.number; i++) {
+		assert(0 == strcmp(first.data[i].dir_name, second.data[i].dir_name));
+		assert(0 == strcmp(first.data[i].dev_name, second.data[i].dev_name));
+		assert(first.data[i].type == second.data[i].type);
+	}
+
+	sigar_file_system_list_destroy(t, &first);
+	sigar_file_system_list_destroy(t, &second);
+
+	return 0;
+}
+
+TEST(test_sigar_file_system_usage_list_get) {
+	sigar_file_system_list_t fslist;
+	sigar_file_system_usage_list_t usagelist;
+	size_t i;
+
+	assert(SIGAR_OK == sigar_file_system_list_get(t, &fslist));
+	assert(SIGAR_OK == sigar_file_system_usage_list_get(t, &fslist, 10000, &usagelist));
+
+	assert(usagelist.number == fslist.number);
+
+	for (i = 0; i < usagelist.number; i++) {
+		sigar_file_system_usage_entry_t *entry = &usagelist.data[i];
+
+		assert(0 == strcmp(entry->dir_name, fslist.data[i].dir_name));
+
+		if (entry->status == SIGAR_OK) {
+			assert(entry->usage.total >= entry->usage.free);
+			assert(entry->usage.use_percent >= 0);
+		} else {
+			fprintf(stderr, "sigar_file_system_usage_list_get(%s) ret = %d (%s)\n",
+					entry->dir_name,
+					entry->status, sigar_strerror(t, entry->status));
+		}
+	}
+
+	sigar_file_system_usage_list_destroy(t, &usagelist);
+	sigar_file_system_list_destroy(t, &fslist);
+
+	return 0;
+}
+
+TEST(test_sigar_disk_io_list_get) {
+	sigar_disk_io_list_t disklist;
+	size_t i;
+	int round;
+
+	/* the second round has a previous snapshot to compute rates against */
+	for (round = 0; round < 2; round++) {
+		int ret = sigar_disk_io_list_get(t, &disklist);
+
+		if (ret != SIGAR_OK) {
+			fprintf(stderr, "sigar_disk_io_list_get() ret = %d (%s)\n",
+					ret, sigar_strerror(t, ret));
+			assert(ret == ENOENT || ret == SIGAR_ENOTIMPL);
+			return 0;
+		}
+
+		for (i = 0; i < disklist.number; i++) {
+			sigar_disk_io_t *dio = &disklist.data[i];
+
+			assert(dio->name[0]);
+			assert(IS_IMPL_U64(dio->disk.reads));
+			assert(IS_IMPL_U64(dio->disk.writes));
+			if (dio->utilization != SIGAR_FIELD_NOTIMPL) {
+				assert(dio->utilization >= 0);
+			}
+			if (dio->reads_per_sec != SIGAR_FIELD_NOTIMPL) {
+				assert(dio->reads_per_sec >= 0);
+				assert(dio->read_bytes_per_sec >= 0);
+			}
+		}
+
+		sigar_disk_io_list_destroy(t, &disklist);
+	}
+
+	return 0;
+}
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void write_file(const char *path, size_t len) {
+	FILE *fp = fopen(path, "w");
+	char buf[1024];
+
+	assert(fp != NULL);
+	memset(buf, 'x', sizeof(buf));
+	while (len > 0) {
+		size_t n = len > sizeof(buf) ? sizeof(buf) : len;
+		assert(n == fwrite(buf, 1, n, fp));
+		len -= n;
+	}
+	fclose(fp);
+}
+
+TEST(test_sigar_dir_usage_scan) {
+	char root[] = "/tmp/sigar_dir_usage_XXXXXX";
+	char path[1024], lpath[1024];
+	sigar_dir_usage_opts_t opts;
+	sigar_dir_usage_t single, parallel, shallow;
+	int i, j;
+
+	assert(NULL != mkdtemp(root));
+
+	/* root/d0..d3/e0..e3/f, plus a second link to root/d0/e0/f */
+	for (i = 0; i < 4; i++) {
+		snprintf(path, sizeof(path), "%s/d%d", root, i);
+		assert(0 == mkdir(path, 0700));
+		for (j = 0; j < 4; j++) {
+			snprintf(path, sizeof(path), "%s/d%d/e%d", root, i, j);
+			assert(0 == mkdir(path, 0700));
+			snprintf(path, sizeof(path), "%s/d%d/e%d/f", root, i, j);
+			write_file(path, 4096);
+		}
+	}
+	snprintf(path, sizeof(path), "%s/d0/e0/f", root);
+	snprintf(lpath, sizeof(lpath), "%s/d3/e3/g", root);
+	assert(0 == link(path, lpath));
+
+	opts.max_depth = -1;
+	opts.flags = SIGAR_DIR_USAGE_ONE_FS;
+	opts.threads = 1;
+	assert(SIGAR_OK == sigar_dir_usage_scan(t, root, &opts, &single));
+
+	assert(single.subdirs == 4 + 16);
+	assert(single.files == 16 + 1);
+	assert(single.hardlinks == 1);
+	assert(single.disk_usage >= 16 * 4096);
+	assert(single.total == single.files + single.subdirs);
+
+	opts.threads = 4;
+	assert(SIGAR_OK == sigar_dir_usage_scan(t, root, &opts, &parallel));
+	assert(parallel.files == single.files);
+	assert(parallel.subdirs == single.subdirs);
+	assert(parallel.hardlinks == single.hardlinks);
+	assert(parallel.disk_usage == single.disk_usage);
+	assert(parallel.disk_allocated == single.disk_allocated);
+
+	opts.max_depth = 0;
+	assert(SIGAR_OK == sigar_dir_usage_scan(t, root, &opts, &shallow));
+	assert(shallow.subdirs == 4);
+	assert(shallow.files == 0);
+
+	assert(SIGAR_OK == sigar_dir_usage_get(t, root, &parallel));
+	assert(parallel.files == single.files);
+
+	unlink(lpath);
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < 4; j++) {
+			snprintf(path, sizeof(path), "%s/d%d/e%d/f", root, i, j);
+			unlink(path);
+			snprintf(path, sizeof(path), "%s/d%d/e%d", root, i, j);
+			rmdir(path);
+		}
+		snprintf(path, sizeof(path), "%s/d%d", root, i);
+		rmdir(path);
+	}
+	rmdir(root);
+
+	return 0;
+}
+
+#include <fcntl.h>
+
+#define DEEP_LEVELS 24 /* of DEEP_NAME, past SIGAR_PATH_MAX */
+#define DEEP_FAN 8
+#define DEEP_FILES 2000 /* beside the fan, for the other threads to go idle */
+
+TEST(test_sigar_dir_usage_scan_deep) {
+	char root[] = "/tmp/sigar_dir_usage_XXXXXX";
+	char name[201], file[16];
+	int fds[DEEP_LEVELS + 1];
+	sigar_dir_usage_opts_t opts;
+	sigar_dir_usage_t usage;
+	int i, j, fd;
+
+	assert(NULL != mkdtemp(root));
+	memset(name, 'd', sizeof(name) - 1);
+	name[sizeof(name) - 1] = '\0';
+
+	/* a chain of long names, then a fan of dirs with a file each */
+	assert((fds[0] = open(root, O_RDONLY | O_DIRECTORY)) >= 0);
+	for (i = 1; i <= DEEP_LEVELS; i++) {
+		assert(0 == mkdirat(fds[i-1], name, 0700));
+		assert((fds[i] = openat(fds[i-1], name, O_RDONLY | O_DIRECTORY)) >= 0);
+	}
+	for (j = 0; j < DEEP_FAN; j++) {
+		char sub[16];
+
+		snprintf(sub, sizeof(sub), "s%d", j);
+		assert(0 == mkdirat(fds[DEEP_LEVELS], sub, 0700));
+		assert((fd = openat(fds[DEEP_LEVELS], sub, O_RDONLY | O_DIRECTORY)) >= 0);
+		assert((i = openat(fd, "f", O_WRONLY | O_CREAT, 0600)) >= 0);
+		close(i);
+		close(fd);
+	}
+	for (j = 0; j < DEEP_FILES; j++) {
+		snprintf(file, sizeof(file), "f%d", j);
+		assert((fd = openat(fds[DEEP_LEVELS], file, O_WRONLY | O_CREAT, 0600)) >= 0);
+		close(fd);
+	}
+
+	/* nothing below the too long path is handed off and lost */
+	opts.max_depth = -1;
+	opts.flags = 0;
+	opts.threads = 4;
+	assert(SIGAR_OK == sigar_dir_usage_scan(t, root, &opts, &usage));
+	assert(usage.subdirs == DEEP_LEVELS + DEEP_FAN);
+	assert(usage.files == DEEP_FAN + DEEP_FILES);
+
+	for (j = 0; j < DEEP_FILES; j++) {
+		snprintf(file, sizeof(file), "f%d", j);
+		unlinkat(fds[DEEP_LEVELS], file, 0);
+	}
+
+	for (j = 0; j < DEEP_FAN; j++) {
+		char sub[16];
+
+		snprintf(sub, sizeof(sub), "s%d", j);
+		assert((fd = openat(fds[DEEP_LEVELS], sub, O_RDONLY | O_DIRECTORY)) >= 0);
+		unlinkat(fd, "f", 0);
+		close(fd);
+		unlinkat(fds[DEEP_LEVELS], sub, AT_REMOVEDIR);
+	}
+	for (i = DEEP_LEVELS; i > 0; i--) {
+		close(fds[i]);
+		unlinkat(fds[i-1], name, AT_REMOVEDIR);
+	}
+	close(fds[0]);
+	rmdir(root);
+
+	return 0;
+}
+#endif
+
 int main() {
 	sigar_t *t;
 	int err = 0;
@@ -156,6 +404,13 @@ int main() {
 	assert(SIGAR_OK == sigar_open(&t));
 
 	test_sigar_file_system_list_get(t);
+	test_sigar_file_system_list_cached(t);
+	test_sigar_file_system_usage_list_get(t);
+	test_sigar_disk_io_list_get(t);
+#ifndef _WIN32
+	test_sigar_dir_usage_scan(t);
+	test_sigar_dir_usage_scan_deep(t);
+#endif
 
 	sigar_close(t);
 
@@ -0,0 +1,145 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/types.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sigar.h"
+#include "sigar_tests.h"
+
+#define INTERN_MANY 10000
+
+TEST(test_sigar_intern_refs) {
+	sigar_uint32_t foo, foo2, bar, baz;
+
+	assert(SIGAR_OK == sigar_intern(t, "foo", &foo));
+	assert(SIGAR_OK == sigar_intern(t, "foo", &foo2));
+	assert(SIGAR_OK == sigar_intern(t, "bar", &bar));
+	assert(foo != SIGAR_INTERN_NONE);
+	assert(foo == foo2);
+	assert(foo != bar);
+	assert(sigar_intern_count(t) == 2);
+	assert(strcmp(sigar_intern_str(t, foo), "foo") == 0);
+	assert(strcmp(sigar_intern_str(t, bar), "bar") == 0);
+
+	/* held until the last reference goes */
+	assert(SIGAR_OK == sigar_intern_release(t, foo));
+	assert(strcmp(sigar_intern_str(t, foo), "foo") == 0);
+	assert(SIGAR_OK == sigar_intern_release(t, foo));
+	assert(sigar_intern_str(t, foo) == NULL);
+	assert(sigar_intern_count(t) == 1);
+	assert(SIGAR_OK != sigar_intern_release(t, foo));
+
+	/* the id is free for another */
+	assert(SIGAR_OK == sigar_intern(t, "baz", &baz));
+	assert(baz == foo);
+	assert(strcmp(sigar_intern_str(t, baz), "baz") == 0);
+
+	assert(SIGAR_OK == sigar_intern_release(t, bar));
+	assert(SIGAR_OK == sigar_intern_release(t, baz));
+	assert(sigar_intern_count(t) == 0);
+
+	assert(SIGAR_OK == sigar_intern_release(t, SIGAR_INTERN_NONE));
+	assert(sigar_intern_str(t, SIGAR_INTERN_NONE) == NULL);
+
+	return 0;
+}
+
+TEST(test_sigar_intern_many) {
+	static sigar_uint32_t ids[INTERN_MANY];
+	char str[32];
+	int i;
+
+	/* well past the first buckets, so the table rehashes */
+	for (i = 0; i < INTERN_MANY; i++) {
+		snprintf(str, sizeof(str), "string%d", i);
+		assert(SIGAR_OK == sigar_intern(t, str, &ids[i]));
+	}
+	assert(sigar_intern_count(t) == INTERN_MANY);
+
+	for (i = 0; i < INTERN_MANY; i++) {
+		sigar_uint32_t id;
+
+		snprintf(str, sizeof(str), "string%d", i);
+		assert(SIGAR_OK == sigar_intern(t, str, &id));
+		assert(id == ids[i]);
+		assert(strcmp(sigar_intern_str(t, id), str) == 0);
+		assert(SIGAR_OK == sigar_intern_release(t, id));
+	}
+
+	/* every other one, then the rest */
+	for (i = 0; i < INTERN_MANY; i += 2) {
+		assert(SIGAR_OK == sigar_intern_release(t, ids[i]));
+	}
+	assert(sigar_intern_count(t) == INTERN_MANY / 2);
+	assert(strcmp(sigar_intern_str(t, ids[1]), "string1") == 0);
+
+	for (i = 1; i < INTERN_MANY; i += 2) {
+		assert(SIGAR_OK == sigar_intern_release(t, ids[i]));
+	}
+	assert(sigar_intern_count(t) == 0);
+
+	return 0;
+}
+
+TEST(test_sigar_proc_interned_get) {
+	sigar_pid_t pid = sigar_pid_get(t);
+	sigar_proc_interned_t first, second;
+	sigar_proc_state_t procstate;
+	sigar_proc_exe_t procexe;
+
+	assert(SIGAR_OK == sigar_proc_interned_get(t, pid, &first));
+	assert(SIGAR_OK == sigar_proc_state_get(t, pid, &procstate));
+
+	assert(first.pid == pid);
+	assert(first.ppid == procstate.ppid);
+	assert(strcmp(sigar_intern_str(t, first.name), procstate.name) == 0);
+
+	if (SIGAR_OK == sigar_proc_exe_get(t, pid, &procexe)) {
+		assert(strcmp(sigar_intern_str(t, first.exe), procexe.name) == 0);
+	}
+
+	/* the same strings again are the same ids */
+	assert(SIGAR_OK == sigar_proc_interned_get(t, pid, &second));
+	assert(second.name == first.name);
+	assert(second.user == first.user);
+	assert(second.exe == first.exe);
+	assert(second.args == first.args);
+
+	assert(SIGAR_OK == sigar_proc_interned_release(t, &first));
+	assert(strcmp(sigar_intern_str(t, second.name), procstate.name) == 0);
+	assert(SIGAR_OK == sigar_proc_interned_release(t, &second));
+	assert(sigar_intern_count(t) == 0);
+
+	return 0;
+}
+
+int main() {
+	sigar_t *t;
+	int err = 0;
+
+	assert(SIGAR_OK == sigar_open(&t));
+
+	test_sigar_intern_refs(t);
+	test_sigar_intern_many(t);
+	test_sigar_proc_interned_get(t);
+
+	sigar_close(t);
+
+	return err ? -1 : 0;
+}
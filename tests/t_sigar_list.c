@@ -0,0 +1,130 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/types.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_tests.h"
+
+static int proc_list_has_self(sigar_t *t, sigar_proc_list_t *proclist) {
+	unsigned long i;
+
+	for (i = 0; i < proclist->number; i++) {
+		if (proclist->data[i] == sigar_pid_get(t)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+TEST(test_sigar_list_grow) {
+	sigar_proc_list_t proclist;
+	unsigned long i, size;
+
+	assert(SIGAR_OK == sigar_proc_list_create(t, &proclist));
+	assert(proclist.size == SIGAR_PROC_LIST_MAX);
+
+	/* doubles once past the first _MAX */
+	for (i = 0, size = proclist.size; i < 10000; i++) {
+		SIGAR_PROC_LIST_GROW((&proclist));
+		proclist.data[proclist.number++] = i;
+		if (proclist.size != size) {
+			assert(proclist.size == size * 2);
+			size = proclist.size;
+		}
+	}
+	assert(proclist.size == SIGAR_PROC_LIST_MAX * 64);
+	assert(proclist.data[9999] == 9999);
+
+	assert(SIGAR_OK == sigar_proc_list_destroy(t, &proclist));
+
+	return 0;
+}
+
+TEST(test_sigar_list_recycle) {
+	sigar_proc_list_t proclist, other;
+	sigar_cpu_list_t cpulist;
+	sigar_pid_t *data, *larger;
+	int i;
+
+	assert(SIGAR_OK == sigar_list_recycle_set(t, 1));
+
+	/* a poll of get then destroy keeps getting the same data */
+	assert(SIGAR_OK == sigar_proc_list_get(t, &proclist));
+	data = proclist.data;
+	assert(SIGAR_OK == sigar_proc_list_destroy(t, &proclist));
+
+	for (i = 0; i < 3; i++) {
+		assert(SIGAR_OK == sigar_proc_list_get(t, &proclist));
+		assert(proclist.data == data);
+		assert(proc_list_has_self(t, &proclist));
+		assert(SIGAR_OK == sigar_proc_list_destroy(t, &proclist));
+	}
+
+	/* two at once, the larger is kept */
+	assert(SIGAR_OK == sigar_proc_list_get(t, &proclist));
+	assert(SIGAR_OK == sigar_proc_list_create(t, &other));
+	while (other.number <= proclist.size) {
+		SIGAR_PROC_LIST_GROW((&other));
+		other.data[other.number++] = 0;
+	}
+	larger = other.data;
+	assert(SIGAR_OK == sigar_proc_list_destroy(t, &other));
+	assert(SIGAR_OK == sigar_proc_list_destroy(t, &proclist));
+
+	assert(SIGAR_OK == sigar_proc_list_get(t, &proclist));
+	assert(proclist.data == larger);
+	assert(proc_list_has_self(t, &proclist));
+	assert(SIGAR_OK == sigar_proc_list_destroy(t, &proclist));
+
+	/* kinds are kept apart */
+	assert(SIGAR_OK == sigar_cpu_list_get(t, &cpulist));
+	assert((void *)cpulist.data != (void *)larger);
+	assert(cpulist.number > 0);
+	assert(SIGAR_OK == sigar_cpu_list_destroy(t, &cpulist));
+
+	/* off again frees what was kept */
+	assert(SIGAR_OK == sigar_list_recycle_set(t, 0));
+	assert(SIGAR_OK == sigar_proc_list_get(t, &proclist));
+	assert(proc_list_has_self(t, &proclist));
+	assert(SIGAR_OK == sigar_proc_list_destroy(t, &proclist));
+
+	/* left on for sigar_close to free */
+	assert(SIGAR_OK == sigar_list_recycle_set(t, 1));
+	assert(SIGAR_OK == sigar_proc_list_get(t, &proclist));
+	assert(SIGAR_OK == sigar_proc_list_destroy(t, &proclist));
+
+	return 0;
+}
+
+int main() {
+	sigar_t *t;
+	int err = 0;
+
+	assert(SIGAR_OK == sigar_open(&t));
+
+	test_sigar_list_grow(t);
+	test_sigar_list_recycle(t);
+
+	sigar_close(t);
+
+	return err ? -1 : 0;
+}
@@ -45,6 +45,15 @@
 #include "sigar_format.h"
 #include "sigar_tests.h"
 
+#if defined(SIGAR_TEST_OS_LINUX)
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#endif
+
 TEST(test_sigar_net_connections_get) {
 	sigar_net_connection_list_t connlist;
 	size_t i;
@@ -84,6 +93,432 @@ TEST(test_sigar_net_connections_get) {
 	return 0;
 }
 
+#if defined(SIGAR_TEST_OS_LINUX)
+/* the sock_diag backend has to agree with the /proc/net parser */
+TEST(test_sigar_net_connections_backends) {
+	sigar_t *proc;
+	sigar_net_connection_list_t diaglist, proclist;
+	int flags = SIGAR_NETCONN_SERVER | SIGAR_NETCONN_TCP;
+	size_t i, j;
+
+	setenv("SIGAR_PROC_NET", "/proc", 1);
+	assert(SIGAR_OK == sigar_open(&proc));
+	unsetenv("SIGAR_PROC_NET");
+
+	assert(SIGAR_OK == sigar_net_connection_list_get(t, &diaglist, flags));
+	assert(SIGAR_OK == sigar_net_connection_list_get(proc, &proclist, flags));
+
+	/* listeners rarely come and go while the test runs */
+	assert(diaglist.number == proclist.number);
+
+	for (i = 0; i < diaglist.number; i++) {
+		sigar_net_connection_t *con = &diaglist.data[i];
+		int found = 0;
+
+		/* servers by remote port in both, not by LISTEN state */
+		assert(con->remote_port == 0);
+
+		for (j = 0; j < proclist.number; j++) {
+			if (proclist.data[j].inode == con->inode) {
+				assert(proclist.data[j].local_port == con->local_port);
+				assert(proclist.data[j].state == con->state);
+				assert(proclist.data[j].uid == con->uid);
+				assert(0 == sigar_net_address_equals(&proclist.data[j].local_address,
+						&con->local_address));
+				found = 1;
+			}
+		}
+		assert(found);
+	}
+
+	sigar_net_connection_list_destroy(t, &diaglist);
+	sigar_net_connection_list_destroy(proc, &proclist);
+	sigar_close(proc);
+
+	return 0;
+}
+
+TEST(test_sigar_net_connection_info_get) {
+	sigar_net_connection_info_list_t infolist;
+	sigar_net_port_tcp_info_list_t portlist;
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	int server, client, conn;
+	unsigned long port;
+	size_t i;
+	int found = 0;
+
+	/* a loopback connection we know is there */
+	assert((server = socket(AF_INET, SOCK_STREAM, 0)) >= 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	assert(0 == bind(server, (struct sockaddr *)&addr, sizeof(addr)));
+	assert(0 == listen(server, 4));
+	assert(0 == getsockname(server, (struct sockaddr *)&addr, &len));
+	port = ntohs(addr.sin_port);
+
+	assert((client = socket(AF_INET, SOCK_STREAM, 0)) >= 0);
+	assert(0 == connect(client, (struct sockaddr *)&addr, sizeof(addr)));
+	assert((conn = accept(server, NULL, NULL)) >= 0);
+
+	assert(SIGAR_OK == sigar_net_connection_info_list_get(t, &infolist,
+			SIGAR_NETCONN_SERVER | SIGAR_NETCONN_CLIENT | SIGAR_NETCONN_TCP));
+
+	for (i = 0; i < infolist.number; i++) {
+		sigar_net_connection_info_t *info = &infolist.data[i];
+
+		if (info->conn.local_port != port) {
+			continue;
+		}
+
+		if (info->conn.state == SIGAR_TCP_LISTEN) {
+			assert(info->accept_queue == 0);
+			assert(info->accept_queue_max == 4);
+		}
+		else {
+			assert(info->conn.state == SIGAR_TCP_ESTABLISHED);
+			assert(IS_IMPL_U64(info->rtt));
+			assert(IS_IMPL_U64(info->snd_cwnd));
+			assert(IS_IMPL_U64(info->sndbuf));
+			assert(info->total_retrans == 0);
+		}
+		found++;
+	}
+	assert(found == 2);
+
+	sigar_net_connection_info_list_destroy(t, &infolist);
+
+	assert(SIGAR_OK == sigar_net_port_tcp_info_list_get(t, &portlist));
+
+	for (i = 0, found = 0; i < portlist.number; i++) {
+		sigar_net_port_tcp_info_t *info = &portlist.data[i];
+		sigar_uint64_t total = 0;
+		int j;
+
+		for (j = 0; j < SIGAR_NET_HISTOGRAM_BUCKETS; j++) {
+			total += info->rtt_histogram[j];
+		}
+		assert(total == info->connections);
+
+		if (info->local_port == port) {
+			assert(info->connections == 1);
+			assert(info->retrans_histogram[0] == 1);
+			assert(info->rtt_min == info->rtt_max);
+			found++;
+		}
+	}
+	assert(found == 1);
+
+	sigar_net_port_tcp_info_list_destroy(t, &portlist);
+
+	close(conn);
+	close(client);
+	close(server);
+
+	return 0;
+}
+
+TEST(test_sigar_net_port_stat_map_get) {
+	sigar_net_port_stat_map_t portmap;
+	sigar_net_port_stat_t *entry;
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	int server, client, conn;
+	unsigned long port, client_port;
+	sigar_uint32_t states = 0;
+	size_t i;
+	int j;
+
+	/* a loopback connection we know is there */
+	assert((server = socket(AF_INET, SOCK_STREAM, 0)) >= 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	assert(0 == bind(server, (struct sockaddr *)&addr, sizeof(addr)));
+	assert(0 == listen(server, 4));
+	assert(0 == getsockname(server, (struct sockaddr *)&addr, &len));
+	port = ntohs(addr.sin_port);
+
+	assert((client = socket(AF_INET, SOCK_STREAM, 0)) >= 0);
+	assert(0 == connect(client, (struct sockaddr *)&addr, sizeof(addr)));
+	assert((conn = accept(server, NULL, NULL)) >= 0);
+	len = sizeof(addr);
+	assert(0 == getsockname(client, (struct sockaddr *)&addr, &len));
+	client_port = ntohs(addr.sin_port);
+
+	assert(SIGAR_OK == sigar_net_port_stat_map_get(t, &portmap,
+			SIGAR_NETCONN_SERVER | SIGAR_NETCONN_CLIENT | SIGAR_NETCONN_TCP));
+
+	/* inbound: the accepted side of the listener's port */
+	assert((entry = sigar_net_port_stat_map_find(&portmap, port)));
+	assert(entry->port == port);
+	assert(entry->local.tcp_states[SIGAR_TCP_LISTEN] == 1);
+	assert(entry->local.tcp_states[SIGAR_TCP_ESTABLISHED] == 1);
+	assert(entry->local.tcp_inbound_total == 1);
+	assert(entry->local.tcp_outbound_total == 0);
+	/* outbound: the client's connection to it */
+	assert(entry->remote.tcp_states[SIGAR_TCP_ESTABLISHED] == 1);
+	assert(entry->remote.tcp_outbound_total == 1);
+
+	/* the client's port is outbound on this end, and the accepted
+	 * connection back to it is not counted as an outbound one */
+	assert((entry = sigar_net_port_stat_map_find(&portmap, client_port)));
+	assert(entry->local.tcp_states[SIGAR_TCP_ESTABLISHED] == 1);
+	assert(entry->local.tcp_inbound_total == 0);
+	assert(entry->local.tcp_outbound_total == 1);
+	assert(entry->remote.tcp_states[SIGAR_TCP_ESTABLISHED] == 0);
+	assert(entry->remote.tcp_outbound_total == 0);
+
+	for (i = 0; i < portmap.number; i++) {
+		assert(sigar_net_port_stat_map_find(&portmap,
+				portmap.data[i].port) == &portmap.data[i]);
+		for (j = 0; j < SIGAR_TCP_UNKNOWN; j++) {
+			states += portmap.data[i].local.tcp_states[j];
+		}
+	}
+	for (j = 0; j < SIGAR_TCP_UNKNOWN; j++) {
+		states -= portmap.total.tcp_states[j];
+	}
+	/* every connection has exactly one local port */
+	assert(states == 0);
+
+	sigar_net_port_stat_map_destroy(t, &portmap);
+
+	close(conn);
+	close(client);
+	close(server);
+
+	return 0;
+}
+
+TEST(test_sigar_net_connection_proc_get) {
+	sigar_net_connection_proc_list_t connlist;
+	sigar_net_address_t address;
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	sigar_pid_t pid;
+	unsigned long port;
+	size_t i;
+	int server, found = 0;
+
+	assert((server = socket(AF_INET, SOCK_STREAM, 0)) >= 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	assert(0 == bind(server, (struct sockaddr *)&addr, sizeof(addr)));
+	assert(0 == listen(server, 4));
+	assert(0 == getsockname(server, (struct sockaddr *)&addr, &len));
+	port = ntohs(addr.sin_port);
+
+	/* the socket is newer than any index built by earlier tests */
+	assert(SIGAR_OK == sigar_proc_port_get(t, SIGAR_NETCONN_TCP, port, &pid));
+	assert(pid == getpid());
+
+	assert(SIGAR_OK == sigar_net_connection_proc_list_get(t, &connlist,
+			SIGAR_NETCONN_SERVER | SIGAR_NETCONN_TCP));
+
+	for (i = 0; i < connlist.number; i++) {
+		sigar_net_connection_proc_t *entry = &connlist.data[i];
+
+		if (entry->conn.local_port == port) {
+			assert(entry->pid == getpid());
+			assert(entry->fd == server);
+			found++;
+		}
+		else if (entry->pid == 0) {
+			assert(entry->fd == -1);
+		}
+	}
+	assert(found == 1);
+
+	sigar_net_connection_proc_list_destroy(t, &connlist);
+
+	/* listing the listeners refreshes the listen address cache too */
+	assert(SIGAR_OK == sigar_net_listener_list_get(t, &connlist));
+	for (i = 0, found = 0; i < connlist.number; i++) {
+		sigar_net_connection_proc_t *entry = &connlist.data[i];
+
+		assert((entry->conn.type == SIGAR_NETCONN_TCP) ||
+		       (entry->conn.type == SIGAR_NETCONN_UDP));
+		if ((entry->conn.type == SIGAR_NETCONN_TCP) &&
+		    (entry->conn.local_port == port)) {
+			assert(entry->pid == getpid());
+			found++;
+		}
+	}
+	assert(found == 1);
+	sigar_net_connection_proc_list_destroy(t, &connlist);
+
+	assert(SIGAR_OK == sigar_net_listen_address_get(t, port, &address));
+	assert(address.family == SIGAR_AF_INET);
+	assert(address.addr.in == htonl(INADDR_LOOPBACK));
+
+	close(server);
+
+	/* gone with the next walk */
+	assert(SIGAR_OK == sigar_net_listener_list_get(t, &connlist));
+	sigar_net_connection_proc_list_destroy(t, &connlist);
+	assert(ENOENT == sigar_net_listen_address_get(t, port, &address));
+
+	return 0;
+}
+
+static void unix_connections_check(sigar_t *sigar, const char *path,
+		unsigned long listen_ino, unsigned long ino[2], int with_peers) {
+	sigar_net_connection_list_t connlist;
+	sigar_net_unix_connection_list_t unixlist;
+	sigar_net_stat_t netstat;
+	size_t i;
+	int listener = 0, pair = 0;
+
+	/* the walk has the fields shared with inet sockets */
+	assert(SIGAR_OK == sigar_net_connection_list_get(sigar, &connlist,
+			SIGAR_NETCONN_SERVER | SIGAR_NETCONN_CLIENT | SIGAR_NETCONN_UNIX));
+
+	for (i = 0; i < connlist.number; i++) {
+		sigar_net_connection_t *con = &connlist.data[i];
+
+		assert(con->type == SIGAR_NETCONN_UNIX);
+
+		if (con->inode == listen_ino) {
+			assert(con->state == SIGAR_TCP_LISTEN);
+			listener++;
+		}
+		else if ((con->inode == ino[0]) || (con->inode == ino[1])) {
+			assert(con->state == SIGAR_TCP_ESTABLISHED);
+			pair++;
+		}
+	}
+	assert(listener == 1);
+	assert(pair == 2);
+
+	sigar_net_connection_list_destroy(sigar, &connlist);
+
+	/* and the unix list the rest */
+	assert(SIGAR_OK == sigar_net_unix_connection_list_get(sigar, &unixlist,
+			SIGAR_NETCONN_SERVER | SIGAR_NETCONN_CLIENT));
+
+	for (i = 0, listener = pair = 0; i < unixlist.number; i++) {
+		sigar_net_unix_connection_t *con = &unixlist.data[i];
+
+		if (con->inode == listen_ino) {
+			assert(con->state == SIGAR_TCP_LISTEN);
+			assert(con->socket_type == SOCK_STREAM);
+			assert(strEQ(con->path, path));
+			listener++;
+		}
+		else if ((con->inode == ino[0]) || (con->inode == ino[1])) {
+			assert(con->state == SIGAR_TCP_ESTABLISHED);
+			if (with_peers) {
+				assert(con->peer_inode == ((con->inode == ino[0]) ? ino[1] : ino[0]));
+			}
+			pair++;
+		}
+	}
+	assert(listener == 1);
+	assert(pair == 2);
+
+	sigar_net_unix_connection_list_destroy(sigar, &unixlist);
+
+	/* servers only */
+	assert(SIGAR_OK == sigar_net_unix_connection_list_get(sigar, &unixlist,
+			SIGAR_NETCONN_SERVER));
+	for (i = 0, listener = pair = 0; i < unixlist.number; i++) {
+		if (unixlist.data[i].inode == listen_ino) {
+			listener++;
+		}
+		assert(unixlist.data[i].inode != ino[0]);
+	}
+	assert(listener == 1);
+	sigar_net_unix_connection_list_destroy(sigar, &unixlist);
+
+	assert(SIGAR_OK == sigar_net_stat_get(sigar, &netstat,
+			SIGAR_NETCONN_SERVER | SIGAR_NETCONN_CLIENT | SIGAR_NETCONN_UNIX));
+	assert(netstat.unix_states[SIGAR_TCP_LISTEN] >= 1);
+	assert(netstat.unix_states[SIGAR_TCP_ESTABLISHED] >= 2);
+}
+
+TEST(test_sigar_net_connections_unix) {
+	sigar_t *proc;
+	struct sockaddr_un addr;
+	struct stat sb;
+	char dir[] = "/tmp/sigar-unix-XXXXXX";
+	unsigned long listen_ino, ino[2];
+	int server, pair[2];
+
+	assert(mkdtemp(dir));
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/sock", dir);
+
+	assert((server = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0);
+	assert(0 == bind(server, (struct sockaddr *)&addr, sizeof(addr)));
+	assert(0 == listen(server, 4));
+	assert(0 == fstat(server, &sb));
+	listen_ino = sb.st_ino;
+
+	assert(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, pair));
+	assert(0 == fstat(pair[0], &sb));
+	ino[0] = sb.st_ino;
+	assert(0 == fstat(pair[1], &sb));
+	ino[1] = sb.st_ino;
+
+	unix_connections_check(t, addr.sun_path, listen_ino, ino, 1);
+
+	setenv("SIGAR_PROC_NET", "/proc", 1);
+	assert(SIGAR_OK == sigar_open(&proc));
+	unsetenv("SIGAR_PROC_NET");
+	unix_connections_check(proc, addr.sun_path, listen_ino, ino, 0);
+	sigar_close(proc);
+
+	close(pair[0]);
+	close(pair[1]);
+	close(server);
+	unlink(addr.sun_path);
+	rmdir(dir);
+
+	return 0;
+}
+#endif
+
+TEST(test_sigar_net_proto_counters_get) {
+	sigar_net_proto_counter_list_t counters;
+	sigar_net_proto_counter_t *counter;
+	sigar_tcp_t tcp;
+	size_t i;
+	int ret;
+
+	ret = sigar_net_proto_counter_list_get(t, &counters);
+	if (ret == SIGAR_ENOTIMPL) {
+		return 0;
+	}
+	assert(ret == SIGAR_OK);
+	assert(counters.number > 0);
+
+	for (i = 0; i < counters.number; i++) {
+		assert(counters.data[i].group[0]);
+		assert(counters.data[i].name[0]);
+		assert(counters.data[i].delta == 0);
+	}
+
+	assert(SIGAR_OK == sigar_tcp_get(t, &tcp));
+	assert((counter = sigar_net_proto_counter_find(&counters, "Tcp", "ActiveOpens")));
+	assert(counter->value <= tcp.active_opens);
+	sigar_net_proto_counter_list_destroy(t, &counters);
+
+	/* the second snapshot is relative to the first */
+	assert(SIGAR_OK == sigar_net_proto_counter_list_get(t, &counters));
+	assert((counter = sigar_net_proto_counter_find(&counters, "Tcp", "InSegs")));
+	assert(counter->delta <= counter->value);
+#if defined(SIGAR_TEST_OS_LINUX)
+	assert(sigar_net_proto_counter_find(&counters, "TcpExt", "ListenOverflows"));
+#endif
+	sigar_net_proto_counter_list_destroy(t, &counters);
+
+	return 0;
+}
+
 int main() {
 	sigar_t *t;
 	int err = 0;
@@ -91,6 +526,14 @@ int main() {
 	assert(SIGAR_OK == sigar_open(&t));
 
 	test_sigar_net_connections_get(t);
+	test_sigar_net_proto_counters_get(t);
+#if defined(SIGAR_TEST_OS_LINUX)
+	test_sigar_net_connections_backends(t);
+	test_sigar_net_connection_info_get(t);
+	test_sigar_net_port_stat_map_get(t);
+	test_sigar_net_connection_proc_get(t);
+	test_sigar_net_connections_unix(t);
+#endif
 
 	sigar_close(t);
 
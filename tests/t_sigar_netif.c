@@ -26,6 +26,9 @@
  * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* unshare */
+#endif
 #include <sys/types.h>
 #ifdef HAVE_SYS_TIME_H
 #include <sys/time.h>
@@ -45,6 +48,15 @@
 #include "sigar_format.h"
 #include "sigar_tests.h"
 
+#if defined(SIGAR_TEST_OS_LINUX)
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#endif
+
 TEST(test_sigar_net_iflist_get) {
 	sigar_net_interface_list_t net_iflist;
 	size_t i;
@@ -122,6 +134,317 @@ TEST(test_sigar_net_iflist_get) {
 	return 0;
 }
 
+TEST(test_sigar_net_ifstat_list_get) {
+	sigar_net_interface_stat_list_t iflist;
+	size_t i;
+
+	assert(SIGAR_OK == sigar_net_interface_stat_list_get(t, &iflist));
+	assert(iflist.number > 0);
+
+	for (i = 0; i < iflist.number; i++) {
+		sigar_net_interface_stat_entry_t *entry = &iflist.data[i];
+		sigar_net_interface_stat_t ifstat;
+
+		assert(entry->name[0]);
+		assert(IS_IMPL_U64(entry->stat.rx_packets));
+		assert(IS_IMPL_U64(entry->stat.rx_bytes));
+		assert(IS_IMPL_U64(entry->stat.tx_packets));
+		assert(IS_IMPL_U64(entry->stat.tx_bytes));
+
+		/* the single interface lookup reads the counters later on */
+		if (SIGAR_OK == sigar_net_interface_stat_get(t, entry->name, &ifstat)) {
+			assert(ifstat.rx_packets >= entry->stat.rx_packets);
+			assert(ifstat.tx_packets >= entry->stat.tx_packets);
+		}
+	}
+
+	assert(SIGAR_OK == sigar_net_interface_stat_list_destroy(t, &iflist));
+
+	return 0;
+}
+
+#if defined(SIGAR_TEST_OS_LINUX)
+static int route_family_count(sigar_net_route_walker_t *walker,
+		sigar_net_route_t *route) {
+	unsigned long *counts = walker->data;
+
+	counts[route->destination.family]++;
+
+	return SIGAR_OK;
+}
+
+TEST(test_sigar_net_route_backends) {
+	sigar_t *proc;
+	sigar_net_route_list_t nllist, proclist;
+	sigar_net_route_walker_t walker;
+	unsigned long counts[SIGAR_AF_LINK+1];
+	size_t i, j;
+
+	setenv("SIGAR_PROC_NET", "/proc", 1);
+	assert(SIGAR_OK == sigar_open(&proc));
+	unsetenv("SIGAR_PROC_NET");
+
+	assert(SIGAR_OK == sigar_net_route_list_get(t, &nllist));
+	assert(SIGAR_OK == sigar_net_route_list_get(proc, &proclist));
+
+	/* the main table does not change while the test runs */
+	assert(nllist.number == proclist.number);
+
+	for (i = 0; i < nllist.number; i++) {
+		sigar_net_route_t *route = &nllist.data[i];
+		int found = 0;
+
+		assert(route->destination.family == SIGAR_AF_INET);
+
+		for (j = 0; j < proclist.number; j++) {
+			sigar_net_route_t *other = &proclist.data[j];
+
+			if ((route->destination.addr.in == other->destination.addr.in) &&
+			    (route->mask.addr.in == other->mask.addr.in) &&
+			    (route->metric == other->metric) &&
+			    strEQ(route->ifname, other->ifname))
+			{
+				assert(route->gateway.addr.in == other->gateway.addr.in);
+				assert(route->flags == other->flags);
+				found = 1;
+			}
+		}
+		assert(found);
+	}
+
+	sigar_net_route_list_destroy(t, &nllist);
+	sigar_net_route_list_destroy(proc, &proclist);
+	sigar_close(proc);
+
+	/* the unfiltered walk adds ipv6 and nothing else */
+	memset(counts, 0, sizeof(counts));
+	walker.sigar = t;
+	walker.family = SIGAR_AF_UNSPEC;
+	walker.data = counts;
+	walker.add_route = route_family_count;
+	assert(SIGAR_OK == sigar_net_route_walk(&walker));
+	assert(counts[SIGAR_AF_INET] == i);
+	assert(counts[SIGAR_AF_UNSPEC] == 0);
+	assert(counts[SIGAR_AF_LINK] == 0);
+
+	return 0;
+}
+
+TEST(test_sigar_net_address_list_get) {
+	sigar_net_interface_address_list_t addrlist;
+	sigar_arp_list_t arplist;
+	size_t i;
+	int loopback = 0;
+
+	assert(SIGAR_OK == sigar_net_interface_address_list_get(t, &addrlist));
+
+	for (i = 0; i < addrlist.number; i++) {
+		sigar_net_interface_address_t *address = &addrlist.data[i];
+
+		assert(address->ifname[0]);
+		assert(address->ifindex > 0);
+		assert((address->address.family == SIGAR_AF_INET) ||
+		       (address->address.family == SIGAR_AF_INET6));
+
+		if ((address->address.family == SIGAR_AF_INET) &&
+		    (address->address.addr.in == htonl(INADDR_LOOPBACK)))
+		{
+			assert(strEQ(address->ifname, "lo"));
+			assert(address->prefix_length == 8);
+			loopback++;
+		}
+	}
+	assert(loopback == 1);
+
+	assert(SIGAR_OK == sigar_net_interface_address_list_destroy(t, &addrlist));
+
+	assert(SIGAR_OK == sigar_arp_list_get(t, &arplist));
+	for (i = 0; i < arplist.number; i++) {
+		assert(arplist.data[i].address.family == SIGAR_AF_INET);
+		assert(arplist.data[i].hwaddr.family == SIGAR_AF_LINK);
+		assert(arplist.data[i].ifname[0]);
+	}
+	assert(SIGAR_OK == sigar_arp_list_destroy(t, &arplist));
+
+	return 0;
+}
+#endif
+
+TEST(test_sigar_net_ifconfig_list_get) {
+	sigar_net_interface_config_list_t iflist;
+	size_t i, j;
+	int ret;
+
+	ret = sigar_net_interface_config_list_get(t, &iflist);
+	if (ret != SIGAR_OK) {
+		fprintf(stderr, "ret = %d (%s)\n", ret, sigar_strerror(t, ret));
+		assert(ret == SIGAR_OK);
+	}
+	assert(iflist.number > 0);
+
+	for (i = 0; i < iflist.number; i++) {
+		sigar_net_interface_config_entry_t *entry = &iflist.data[i];
+		sigar_net_interface_config_t ifconfig;
+		int found = 0;
+
+		assert(entry->config.name[0]);
+
+		for (j = 0; j < entry->addresses_number; j++) {
+			sigar_net_interface_address_t *address = &entry->addresses[j];
+
+			if (sigar_net_address_equals(&address->address,
+					&entry->config.address) == SIGAR_OK) {
+				found = 1;
+			}
+		}
+		assert(found || !entry->config.address.addr.in);
+
+		/* the per interface ioctls agree, unless it went away meanwhile */
+		if (SIGAR_OK != sigar_net_interface_config_get(t, entry->config.name, &ifconfig)) {
+			continue;
+		}
+		assert(strEQ(ifconfig.type, entry->config.type));
+		assert(ifconfig.flags == entry->config.flags);
+		assert(ifconfig.mtu == entry->config.mtu);
+		assert(0 == sigar_net_address_equals(&ifconfig.hwaddr, &entry->config.hwaddr));
+		assert(ifconfig.address.addr.in == entry->config.address.addr.in);
+		assert(ifconfig.netmask.addr.in == entry->config.netmask.addr.in);
+	}
+
+	assert(SIGAR_OK == sigar_net_interface_config_list_destroy(t, &iflist));
+
+	return 0;
+}
+
+#if defined(SIGAR_TEST_OS_LINUX)
+TEST(test_sigar_netns_get) {
+	sigar_netns_list_t netnslist;
+	sigar_netns_t self, bypath;
+	sigar_net_interface_stat_list_t host, iflist;
+	sigar_net_proto_counter_list_t counters;
+	sigar_net_connection_list_t connlist;
+	size_t i;
+	int found = 0, status;
+
+	if (SIGAR_OK != sigar_netns_pid_get(t, getpid(), &self)) {
+		return 0; /* no /proc/PID/ns */
+	}
+
+	/* ours is listed exactly once, with us counted in it */
+	assert(SIGAR_OK == sigar_netns_list_get(t, &netnslist));
+	for (i = 0; i < netnslist.number; i++) {
+		sigar_netns_t *netns = &netnslist.data[i];
+
+		assert(netns->pid || netns->path[0]);
+		if (netns->id == self.id) {
+			assert(!found);
+			found = 1;
+			assert(netns->processes >= 1);
+			assert(netns->pid <= getpid());
+		}
+	}
+	assert(found);
+	assert(SIGAR_OK == sigar_netns_list_destroy(t, &netnslist));
+
+	/* through /proc/PID/net, the same interfaces we see directly */
+	assert(SIGAR_OK == sigar_net_interface_stat_list_get(t, &host));
+	assert(SIGAR_OK == sigar_netns_interface_stat_list_get(t, &self, &iflist));
+	assert(iflist.number == host.number);
+	assert(SIGAR_OK == sigar_net_interface_stat_list_destroy(t, &iflist));
+
+	assert(SIGAR_OK == sigar_netns_connection_list_get(t, &self, &connlist,
+			SIGAR_NETCONN_SERVER|SIGAR_NETCONN_TCP));
+	assert(SIGAR_OK == sigar_net_connection_list_destroy(t, &connlist));
+
+	assert(SIGAR_OK == sigar_netns_proto_counter_list_get(t, &self, &counters));
+	assert(counters.number > 0);
+	assert(SIGAR_OK == sigar_net_proto_counter_list_destroy(t, &counters));
+
+	/* by path it takes setns(), which needs CAP_SYS_ADMIN */
+	assert(SIGAR_OK == sigar_netns_path_get(t, "/proc/self/ns/net", &bypath));
+	assert(bypath.id == self.id);
+	assert(!bypath.pid);
+
+	status = sigar_netns_interface_stat_list_get(t, &bypath, &iflist);
+	if (status == SIGAR_OK) {
+		assert(iflist.number == host.number);
+		assert(SIGAR_OK == sigar_net_interface_stat_list_destroy(t, &iflist));
+	}
+	else {
+		assert(status == EPERM);
+	}
+
+	assert(SIGAR_OK == sigar_net_interface_stat_list_destroy(t, &host));
+
+	return 0;
+}
+
+static unsigned long netns_counters_count(sigar_t *t) {
+	sigar_stats_t stats;
+	unsigned long i;
+
+	assert(SIGAR_OK == sigar_stats_get(t, &stats));
+	for (i = 0; i < stats.cache_number; i++) {
+		if (strcmp(stats.caches[i].name, "netns_counters") == 0) {
+			return stats.caches[i].count;
+		}
+	}
+
+	return 0;
+}
+
+TEST(test_sigar_netns_counters_gone) {
+	sigar_netns_list_t netnslist;
+	sigar_netns_t self, child;
+	sigar_net_proto_counter_list_t counters;
+	int fds[2], status;
+	pid_t pid;
+	char ok;
+
+	if (SIGAR_OK != sigar_netns_pid_get(t, getpid(), &self)) {
+		return 0;
+	}
+
+	assert(0 == pipe(fds));
+	if ((pid = fork()) == 0) {
+		/* a namespace of its own, needs CAP_SYS_ADMIN */
+		ok = unshare(CLONE_NEWNET) == 0;
+		if (write(fds[1], &ok, 1) != 1) {
+			_exit(1);
+		}
+		pause();
+		_exit(0);
+	}
+	assert(pid > 0);
+	assert(1 == read(fds[0], &ok, 1));
+	close(fds[0]);
+	close(fds[1]);
+
+	if (ok) {
+		assert(SIGAR_OK == sigar_netns_proto_counter_list_get(t, &self, &counters));
+		assert(SIGAR_OK == sigar_net_proto_counter_list_destroy(t, &counters));
+
+		assert(SIGAR_OK == sigar_netns_pid_get(t, pid, &child));
+		assert(child.id != self.id);
+		assert(SIGAR_OK == sigar_netns_proto_counter_list_get(t, &child, &counters));
+		assert(SIGAR_OK == sigar_net_proto_counter_list_destroy(t, &counters));
+		assert(netns_counters_count(t) == 2);
+	}
+
+	kill(pid, SIGKILL);
+	assert(pid == waitpid(pid, &status, 0));
+
+	/* the next sweep forgets the namespace that went with it */
+	if (ok) {
+		assert(SIGAR_OK == sigar_netns_list_get(t, &netnslist));
+		assert(SIGAR_OK == sigar_netns_list_destroy(t, &netnslist));
+		assert(netns_counters_count(t) == 1);
+	}
+
+	return 0;
+}
+#endif
+
 int main() {
 	sigar_t *t;
 	int err = 0;
@@ -129,6 +452,14 @@ int main() {
 	assert(SIGAR_OK == sigar_open(&t));
 
 	test_sigar_net_iflist_get(t);
+	test_sigar_net_ifstat_list_get(t);
+	test_sigar_net_ifconfig_list_get(t);
+#if defined(SIGAR_TEST_OS_LINUX)
+	test_sigar_net_route_backends(t);
+	test_sigar_net_address_list_get(t);
+	test_sigar_netns_get(t);
+	test_sigar_netns_counters_gone(t);
+#endif
 
 	sigar_close(t);
 
@@ -0,0 +1,146 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/types.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_parse.h"
+#include "sigar_tests.h"
+
+/* sigar_parse_u64 must agree with strtoull, end and all */
+static void check_u64(const char *text) {
+	char buffer[64], *ptr = buffer, *end;
+	char *libc_end;
+	sigar_uint64_t value, expect;
+
+	strcpy(buffer, text);
+	end = buffer + strlen(buffer);
+
+	expect = strtoull(buffer, &libc_end, 10);
+	value = sigar_parse_u64(&ptr, end);
+
+	assert(value == expect);
+	assert(ptr == libc_end);
+}
+
+TEST(test_sigar_parse_u64) {
+	static const char *texts[] = {
+		"0", "7", "42", "1234567", "12345678", "123456789",
+		"9999999999999999", "12345678901234567", "18446744073709551615",
+		"  123", "\t\n 12345678 tail", "00000000000000001", "-1", "-20",
+		"+5", "", "   ", "x12", "-", "12345678x", "1234567890123 456",
+		NULL
+	};
+	char buffer[32], *ptr;
+	int i;
+
+	for (i = 0; texts[i]; i++) {
+		check_u64(texts[i]);
+	}
+
+	/* every digit count, so both the 8 at a time and the tail run */
+	for (i = 1; i <= 19; i++) {
+		memset(buffer, '0' + (i % 10), i);
+		buffer[i] = ' ';
+		buffer[i+1] = '\0';
+		check_u64(buffer);
+	}
+
+	/* never past end, even in the middle of a run of digits */
+	strcpy(buffer, "1234567890123456");
+	ptr = buffer;
+	assert(sigar_parse_u64(&ptr, buffer + 10) == 1234567890ULL);
+	assert(ptr == buffer + 10);
+
+	ptr = buffer;
+	assert(sigar_parse_u64(&ptr, buffer) == 0);
+	assert(ptr == buffer);
+
+	return 0;
+}
+
+TEST(test_sigar_parse_hex) {
+	static const char *texts[] = {
+		"00000000", "0100007F", "ffffffff", "FFFFFFFF", "DeadBeef",
+		"0A0B0C0D", "89abcdef", "12345678", NULL
+	};
+	char buffer[16], *ptr;
+	int i;
+
+	for (i = 0; texts[i]; i++) {
+		unsigned int expect = (unsigned int)strtoul(texts[i], NULL, 16);
+
+		assert(sigar_parse_hex32(texts[i]) == expect);
+		assert(sigar_parse_hex(texts[i], 8) == expect);
+	}
+
+	assert(sigar_parse_hex("0A", 2) == 10);
+	assert(sigar_parse_hex("fF", 2) == 255);
+
+	strcpy(buffer, " 1F90 rest");
+	ptr = buffer;
+	assert(sigar_parse_x64(&ptr, buffer + strlen(buffer)) == 0x1f90);
+	assert(*ptr == ' ');
+
+	return 0;
+}
+
+TEST(test_sigar_parse_fields) {
+	char buffer[] = "  eth0\t0000FEA9 00000000  0001 0 0 1000\n";
+	char *end = buffer + strlen(buffer);
+	char *fields[8], *ptr;
+	int num;
+
+	num = sigar_parse_fields(buffer, end, fields, 8);
+	assert(num == 7);
+	assert(strncmp(fields[0], "eth0", 4) == 0);
+	assert(strncmp(fields[2], "00000000", 8) == 0);
+	assert(sigar_parse_u64(&fields[6], end) == 1000);
+
+	/* no more than asked for */
+	assert(sigar_parse_fields(buffer, end, fields, 2) == 2);
+
+	ptr = sigar_parse_skip(buffer, end);
+	assert(ptr == buffer + 6);
+	ptr = sigar_parse_space(ptr, end);
+	assert(*ptr == '0');
+
+	/* the 8 at a time space skip stops at end */
+	strcpy(buffer, "                x");
+	assert(sigar_parse_space(buffer, buffer + 12) == buffer + 12);
+	assert(sigar_parse_space(buffer, buffer + 17) == buffer + 16);
+
+	return 0;
+}
+
+int main() {
+	sigar_t *t;
+	int err = 0;
+
+	assert(SIGAR_OK == sigar_open(&t));
+
+	test_sigar_parse_u64(t);
+	test_sigar_parse_hex(t);
+	test_sigar_parse_fields(t);
+
+	sigar_close(t);
+
+	return err ? -1 : 0;
+}
@@ -48,6 +48,11 @@
 #include "sigar_format.h"
 #include "sigar_tests.h"
 
+#if !defined(SIGAR_TEST_OS_WIN32)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 #ifdef HAVE_VALGRIND_VALGRIND_H
 #include <valgrind/valgrind.h>
 #else
@@ -184,6 +189,124 @@ TEST(test_sigar_proc_list_get) {
 	return 0;
 }
 
+#if !defined(SIGAR_TEST_OS_WIN32)
+#define THREADSAFE_THREADS 8
+
+typedef struct {
+	sigar_t *sigar;
+	char *errbuf;
+	char errmsg[256];
+	int failed;
+} threadsafe_worker_t;
+
+static pthread_mutex_t threadsafe_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t threadsafe_cond = PTHREAD_COND_INITIALIZER;
+static threadsafe_worker_t *threadsafe_workers;
+static int threadsafe_ready;
+
+/* each thread has an error buffer of its own, compared by the last
+ * worker to get there while the others wait, alive */
+static void threadsafe_errbuf_check(threadsafe_worker_t *worker) {
+	int i, j;
+
+	pthread_mutex_lock(&threadsafe_lock);
+	if (++threadsafe_ready == THREADSAFE_THREADS) {
+		for (i = 0; i < THREADSAFE_THREADS; i++) {
+			for (j = i + 1; j < THREADSAFE_THREADS; j++) {
+				if (threadsafe_workers[i].errbuf ==
+				    threadsafe_workers[j].errbuf) {
+					worker->failed++;
+				}
+			}
+		}
+		pthread_cond_broadcast(&threadsafe_cond);
+	}
+	while (threadsafe_ready < THREADSAFE_THREADS) {
+		pthread_cond_wait(&threadsafe_cond, &threadsafe_lock);
+	}
+	pthread_mutex_unlock(&threadsafe_lock);
+}
+
+static void *threadsafe_worker(void *data) {
+	threadsafe_worker_t *worker = data;
+	sigar_t *t = worker->sigar;
+	sigar_pid_t pid = getpid();
+	int i;
+
+	for (i = 0; i < 50; i++) {
+		sigar_proc_cpu_t proc_cpu;
+		sigar_proc_state_t proc_state;
+		sigar_proc_stat_t proc_stat;
+		sigar_file_system_list_t fslist;
+		sigar_rate_t rate;
+
+		/* an entity per thread, its counter only ever goes up */
+		if ((SIGAR_OK != sigar_rate_get(t, 1, worker - threadsafe_workers,
+		                                i, 0, &rate)) ||
+		    rate.reset || (rate.delta > i)) {
+			worker->failed++;
+		}
+		if ((SIGAR_OK != sigar_proc_cpu_get(t, pid, &proc_cpu)) ||
+		    (SIGAR_OK != sigar_proc_state_get(t, pid, &proc_state)) ||
+		    (proc_state.ppid != getppid())) {
+			worker->failed++;
+		}
+		if ((i % 10) == 0) {
+			if ((SIGAR_OK != sigar_proc_stat_get(t, &proc_stat)) ||
+			    (proc_stat.total == 0)) {
+				worker->failed++;
+			}
+			if (SIGAR_OK != sigar_file_system_list_get(t, &fslist)) {
+				worker->failed++;
+			}
+			else {
+				sigar_file_system_list_destroy(t, &fslist);
+			}
+		}
+	}
+
+	/* freed when this thread exits, keep a copy */
+	worker->errbuf = sigar_strerror(t, ENOENT);
+	strncpy(worker->errmsg, worker->errbuf, sizeof(worker->errmsg) - 1);
+
+	threadsafe_errbuf_check(worker);
+
+	return NULL;
+}
+
+TEST(test_sigar_open_threadsafe) {
+	sigar_t *shared;
+	pthread_t threads[THREADSAFE_THREADS];
+	threadsafe_worker_t workers[THREADSAFE_THREADS];
+	int i;
+
+	assert(SIGAR_OK == sigar_open_threadsafe(&shared));
+
+	threadsafe_workers = workers;
+	threadsafe_ready = 0;
+
+	for (i = 0; i < THREADSAFE_THREADS; i++) {
+		workers[i].sigar = shared;
+		workers[i].errbuf = NULL;
+		memset(workers[i].errmsg, 0, sizeof(workers[i].errmsg));
+		workers[i].failed = 0;
+		assert(0 == pthread_create(&threads[i], NULL,
+					threadsafe_worker, &workers[i]));
+	}
+
+	for (i = 0; i < THREADSAFE_THREADS; i++) {
+		assert(0 == pthread_join(threads[i], NULL));
+		assert(workers[i].failed == 0);
+		assert(workers[i].errmsg[0]);
+		assert(strcmp(workers[i].errmsg, workers[0].errmsg) == 0);
+	}
+
+	sigar_close(shared);
+
+	return 0;
+}
+#endif
+
 int main() {
 	sigar_t *t;
 	int err = 0;
@@ -192,6 +315,9 @@ int main() {
 
 	test_sigar_proc_stat_get(t);
 	test_sigar_proc_list_get(t);
+#if !defined(SIGAR_TEST_OS_WIN32)
+	test_sigar_open_threadsafe(t);
+#endif
 
 	sigar_close(t);
 
@@ -0,0 +1,99 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/types.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#if !defined(SIGAR_TEST_OS_WIN32)
+#include <unistd.h>
+#define msleep(ms) usleep((ms) * 1000)
+#else
+#include <windows.h>
+#define msleep(ms) Sleep(ms)
+#endif
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_tests.h"
+
+#define METRIC_BYTES 1
+#define METRIC_PACKETS 2
+
+TEST(test_sigar_rate_get) {
+	sigar_rate_t rate;
+	sigar_uint64_t entity = 42;
+
+	assert(SIGAR_OK == sigar_rate_get(t, METRIC_BYTES, entity, 1000, 0, &rate));
+	assert(rate.interval == 0);
+	assert(rate.delta == 0);
+	assert(rate.rate == 0.0);
+
+	/* same entity, another metric, kept apart */
+	assert(SIGAR_OK == sigar_rate_get(t, METRIC_PACKETS, entity,
+					  0xFFFFFF00, SIGAR_RATE_COUNTER32, &rate));
+	assert(rate.interval == 0);
+
+	msleep(20);
+
+	assert(SIGAR_OK == sigar_rate_get(t, METRIC_BYTES, entity, 3000, 0, &rate));
+	assert(rate.interval > 0);
+	assert(rate.delta == 2000);
+	assert(!rate.reset);
+	assert(rate.rate > 0.0);
+	/* the first rate seeds the weighted ones */
+	assert(rate.rate_1s == rate.rate);
+	assert(rate.rate_60s == rate.rate);
+
+	/* 32 bit counter wrapped */
+	assert(SIGAR_OK == sigar_rate_get(t, METRIC_PACKETS, entity,
+					  0x10, SIGAR_RATE_COUNTER32, &rate));
+	assert(rate.delta == 0x110);
+	assert(!rate.reset);
+
+	msleep(20);
+
+	/* a 64 bit counter going back is a reset, not a wrap */
+	assert(SIGAR_OK == sigar_rate_get(t, METRIC_BYTES, entity, 10, 0, &rate));
+	assert(rate.reset);
+	assert(rate.delta == 0);
+	assert(rate.rate == 0.0);
+	assert(rate.rate_60s > 0.0);
+
+	msleep(20);
+
+	/* counting on from the reset, the slow average moves least */
+	assert(SIGAR_OK == sigar_rate_get(t, METRIC_BYTES, entity, 10, 0, &rate));
+	assert(!rate.reset);
+	assert(rate.rate == 0.0);
+	assert(rate.rate_1s < rate.rate_10s);
+	assert(rate.rate_10s < rate.rate_60s);
+
+	return 0;
+}
+
+int main() {
+	sigar_t *t;
+	int err = 0;
+
+	assert(SIGAR_OK == sigar_open(&t));
+
+	test_sigar_rate_get(t);
+
+	sigar_close(t);
+
+	return err ? -1 : 0;
+}
@@ -0,0 +1,252 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "sigar.h"
+#include "sigar_tests.h"
+
+#if defined(SIGAR_TEST_OS_LINUX)
+static char tmpdir[] = "/tmp/sigar_record.XXXXXX";
+static char archive[sizeof(tmpdir) + 16];
+static char replay[sizeof(tmpdir) + 16];
+
+/* what the recorded passes saw, for the replay to give back */
+typedef struct {
+	sigar_mem_t mem;
+	sigar_cpu_t cpu;
+	sigar_proc_state_t procstate;
+	sigar_proc_fd_t procfd;
+	unsigned long tcp_number;
+} pass_t;
+
+static pass_t passes[2];
+
+static void pass_get(sigar_t *t, pass_t *pass) {
+	sigar_proc_list_t proclist;
+	sigar_net_connection_list_t connlist;
+	unsigned long i;
+	int found = 0;
+
+	assert(SIGAR_OK == sigar_mem_get(t, &pass->mem));
+	assert(SIGAR_OK == sigar_cpu_get(t, &pass->cpu));
+
+	assert(SIGAR_OK == sigar_proc_list_get(t, &proclist));
+	for (i = 0; i < proclist.number; i++) {
+		if (proclist.data[i] == sigar_pid_get(t)) {
+			found = 1;
+		}
+	}
+	assert(found);
+	assert(SIGAR_OK == sigar_proc_list_destroy(t, &proclist));
+
+	assert(SIGAR_OK == sigar_proc_state_get(t, sigar_pid_get(t), &pass->procstate));
+	assert(SIGAR_OK == sigar_proc_fd_get(t, sigar_pid_get(t), &pass->procfd));
+
+	assert(SIGAR_OK == sigar_net_connection_list_get(t, &connlist,
+	                                                 SIGAR_NETCONN_SERVER |
+	                                                 SIGAR_NETCONN_TCP));
+	pass->tcp_number = connlist.number;
+	assert(SIGAR_OK == sigar_net_connection_list_destroy(t, &connlist));
+}
+
+TEST(test_sigar_record) {
+	assert(SIGAR_OK == sigar_record_start(archive));
+
+	pass_get(t, &passes[0]);
+	assert(SIGAR_OK == sigar_record_mark());
+	pass_get(t, &passes[1]);
+	assert(SIGAR_OK == sigar_record_mark());
+
+	assert(SIGAR_OK == sigar_record_stop());
+	assert(SIGAR_OK != sigar_record_mark());
+
+	return 0;
+}
+
+TEST(test_sigar_replay) {
+	sigar_uint64_t time, first;
+	pass_t pass;
+	struct stat sb;
+	int i;
+
+	/* an existing dir is not taken over */
+	assert(SIGAR_OK != sigar_replay_open(t, archive, tmpdir));
+	assert(SIGAR_OK == sigar_replay_open(t, archive, replay));
+
+	for (i = 0; i < 2; i++) {
+		assert(SIGAR_OK == sigar_replay_next(t, &time));
+		if (i == 0) {
+			first = time;
+		}
+		assert(time >= first);
+
+		pass_get(t, &pass);
+		assert(pass.mem.total == passes[i].mem.total);
+		assert(pass.mem.free == passes[i].mem.free);
+		assert(pass.cpu.total == passes[i].cpu.total);
+		assert(pass.cpu.idle == passes[i].cpu.idle);
+		assert(strcmp(pass.procstate.name, passes[i].procstate.name) == 0);
+		assert(pass.procstate.ppid == passes[i].procstate.ppid);
+		assert(pass.procfd.total == passes[i].procfd.total);
+		assert(pass.tcp_number == passes[i].tcp_number);
+	}
+
+	assert(SIGAR_ENOENT == sigar_replay_next(t, &time));
+
+	assert(SIGAR_OK == sigar_replay_close(t));
+	assert(stat(replay, &sb) < 0);
+
+	/* back to the live tree */
+	assert(SIGAR_OK == sigar_proc_state_get(t, sigar_pid_get(t), &pass.procstate));
+
+	return 0;
+}
+
+/* one record of the archive format, integers little endian */
+static void record_put(FILE *fp, int type, const char *path, const char *data) {
+	unsigned char header[1 + 8 + 4 + 4];
+	size_t path_len = path ? strlen(path) : 0;
+	size_t len = data ? strlen(data) : 0;
+	int i;
+
+	memset(header, 0, sizeof(header));
+	header[0] = type;
+	for (i = 0; i < 4; i++) {
+		header[9 + i] = (unsigned char)(path_len >> (i * 8));
+		header[13 + i] = (unsigned char)(len >> (i * 8));
+	}
+	assert(fwrite(header, sizeof(header), 1, fp) == 1);
+	if (path_len) {
+		assert(fwrite(path, path_len, 1, fp) == 1);
+	}
+	if (len) {
+		assert(fwrite(data, len, 1, fp) == 1);
+	}
+}
+
+/* with the boot time a replay needs to start */
+static FILE *record_open(void) {
+	FILE *fp;
+
+	assert((fp = fopen(archive, "wb")) != NULL);
+	assert(fwrite("SIGARREC\1\0\0\0", 12, 1, fp) == 1);
+	record_put(fp, 'F', "/proc/stat", "cpu 1 2 3 4\nbtime 1000000000\n");
+
+	return fp;
+}
+
+/* the first frame applies, the second is refused */
+static void replay_refused(sigar_t *t) {
+	sigar_uint64_t time;
+
+	assert(SIGAR_OK == sigar_replay_open(t, archive, replay));
+	assert(SIGAR_OK == sigar_replay_next(t, &time));
+	assert(SIGAR_OK != sigar_replay_next(t, &time));
+	assert(SIGAR_OK == sigar_replay_close(t));
+}
+
+TEST(test_sigar_replay_paths) {
+	static const char *paths[] = {
+		"/proc/../../escape", "/proc/1/../../../escape", "/proc//escape",
+		"/proc/./escape", "/tmp/escape", "proc/escape", "/procfs/escape",
+		NULL
+	};
+	char outside[sizeof(tmpdir) + 16], escape[sizeof(tmpdir) + 16];
+	char target[sizeof(tmpdir) + 16];
+	struct stat sb;
+	FILE *fp;
+	int i;
+
+	snprintf(escape, sizeof(escape), "%s/escape", tmpdir);
+
+	/* nothing out of the recorded proc and sys */
+	for (i = 0; paths[i]; i++) {
+		fp = record_open();
+		record_put(fp, 'M', NULL, NULL);
+		record_put(fp, 'F', paths[i], "escaped\n");
+		record_put(fp, 'M', NULL, NULL);
+		assert(0 == fclose(fp));
+
+		replay_refused(t);
+		assert(stat(escape, &sb) < 0);
+	}
+
+	/* a link an earlier record made is not gone through */
+	snprintf(outside, sizeof(outside), "%s/outside", tmpdir);
+	assert(0 == mkdir(outside, 0755));
+	snprintf(target, sizeof(target), "%s/escape", outside);
+
+	fp = record_open();
+	record_put(fp, 'L', "/proc/1/cwd", outside);
+	record_put(fp, 'M', NULL, NULL);
+	record_put(fp, 'F', "/proc/1/cwd/escape", "escaped\n");
+	record_put(fp, 'M', NULL, NULL);
+	assert(0 == fclose(fp));
+
+	replay_refused(t);
+	assert(stat(target, &sb) < 0);
+
+	/* nor written through, the file takes the link's place */
+	fp = record_open();
+	record_put(fp, 'L', "/proc/1/cwd", target);
+	record_put(fp, 'F', "/proc/1/cwd", "replaced\n");
+	record_put(fp, 'M', NULL, NULL);
+	assert(0 == fclose(fp));
+
+	assert(0 == symlink("/nonexistent", target));
+	assert(SIGAR_OK == sigar_replay_open(t, archive, replay));
+	assert(SIGAR_OK == sigar_replay_next(t, NULL));
+	assert(SIGAR_OK == sigar_replay_close(t));
+	assert(lstat(target, &sb) == 0 && S_ISLNK(sb.st_mode));
+
+	assert(0 == unlink(target));
+	assert(0 == rmdir(outside));
+
+	return 0;
+}
+#endif
+
+int main() {
+	sigar_t *t;
+	int err = 0;
+
+	assert(SIGAR_OK == sigar_open(&t));
+
+#if defined(SIGAR_TEST_OS_LINUX)
+	assert(mkdtemp(tmpdir) != NULL);
+	snprintf(archive, sizeof(archive), "%s/archive", tmpdir);
+	snprintf(replay, sizeof(replay), "%s/replay", tmpdir);
+
+	test_sigar_record(t);
+	test_sigar_replay(t);
+	test_sigar_replay_paths(t);
+
+	assert(0 == unlink(archive));
+	assert(0 == rmdir(tmpdir));
+#else
+	assert(SIGAR_OK != sigar_record_start("archive"));
+#endif
+
+	sigar_close(t);
+
+	return err ? -1 : 0;
+}
@@ -0,0 +1,201 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/types.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sigar.h"
+#include "sigar_private.h"
+#include "sigar_tests.h"
+
+static sigar_stats_t stats;
+
+static sigar_stats_cache_t *stats_cache_find(const char *name) {
+	unsigned long i;
+
+	for (i = 0; i < stats.cache_number; i++) {
+		if (strcmp(stats.caches[i].name, name) == 0) {
+			return &stats.caches[i];
+		}
+	}
+
+	return NULL;
+}
+
+TEST(test_sigar_stats_bucket_usec) {
+	int i;
+
+	assert(sigar_stats_bucket_usec(0) == 0);
+	assert(sigar_stats_bucket_usec(3) == 3);
+	assert(sigar_stats_bucket_usec(4) == 4);
+	assert(sigar_stats_bucket_usec(8) == 8);
+	assert(sigar_stats_bucket_usec(9) == 10);
+	assert(sigar_stats_bucket_usec(12) == 16);
+
+	for (i = 1; i < SIGAR_STATS_BUCKETS; i++) {
+		assert(sigar_stats_bucket_usec(i) > sigar_stats_bucket_usec(i - 1));
+	}
+
+	return 0;
+}
+
+TEST(test_sigar_stats_get) {
+	sigar_cpu_t cpu;
+	sigar_mem_t mem;
+	sigar_proc_cpu_t proccpu;
+	sigar_proc_state_t procstate;
+	sigar_stats_call_t *call;
+	sigar_stats_cache_t *cache;
+	sigar_uint64_t total = 0;
+	int i;
+
+	/* off by default, nothing counted */
+	assert(SIGAR_OK == sigar_cpu_get(t, &cpu));
+	assert(SIGAR_OK == sigar_stats_get(t, &stats));
+	assert(!stats.enabled);
+	assert(stats.calls[SIGAR_STATS_CPU].calls == 0);
+	assert(strcmp(stats.calls[SIGAR_STATS_CPU].name, "cpu") == 0);
+
+	assert(SIGAR_OK == sigar_stats_enable(t, 1));
+
+	for (i = 0; i < 3; i++) {
+		assert(SIGAR_OK == sigar_cpu_get(t, &cpu));
+	}
+	assert(SIGAR_OK == sigar_mem_get(t, &mem));
+	assert(SIGAR_OK == sigar_proc_cpu_get(t, sigar_pid_get(t), &proccpu));
+	assert(SIGAR_OK == sigar_proc_cpu_get(t, sigar_pid_get(t), &proccpu));
+	assert(SIGAR_OK != sigar_proc_state_get(t, -1, &procstate));
+
+	assert(SIGAR_OK == sigar_stats_get(t, &stats));
+	assert(stats.enabled);
+
+	call = &stats.calls[SIGAR_STATS_CPU];
+	assert(call->calls == 3);
+	assert(call->errors == 0);
+	assert(call->usec_max <= call->usec_total);
+	for (i = 0; i < SIGAR_STATS_BUCKETS; i++) {
+		total += call->buckets[i];
+	}
+	assert(total == call->calls);
+
+	assert(stats.calls[SIGAR_STATS_MEM].calls == 1);
+	assert(stats.calls[SIGAR_STATS_PROC_CPU].calls == 2);
+	/* sigar_proc_cpu_get goes through sigar_proc_time_get */
+	assert(stats.calls[SIGAR_STATS_PROC_TIME].calls >= 1);
+	assert(stats.calls[SIGAR_STATS_PROC_STATE].errors == 1);
+
+	cache = stats_cache_find("proc_cpu");
+	assert(cache != NULL);
+	assert(cache->count == 1);
+	assert(cache->misses == 1);
+	assert(cache->hits == 1);
+
+#if defined(SIGAR_TEST_OS_LINUX)
+	assert(stats.files_opened > 0);
+	assert(stats.bytes_read > 0);
+#endif
+
+	assert(SIGAR_OK == sigar_stats_reset(t));
+	assert(SIGAR_OK == sigar_stats_get(t, &stats));
+	assert(stats.enabled);
+	assert(stats.calls[SIGAR_STATS_CPU].calls == 0);
+	assert(stats.calls[SIGAR_STATS_CPU].usec_total == 0);
+	assert(stats_cache_find("proc_cpu")->hits == 0);
+	assert(stats.files_opened == 0);
+
+	/* disabled again, counts stay where they were */
+	assert(SIGAR_OK == sigar_stats_enable(t, 0));
+	assert(SIGAR_OK == sigar_cpu_get(t, &cpu));
+	assert(SIGAR_OK == sigar_stats_get(t, &stats));
+	assert(!stats.enabled);
+	assert(stats.calls[SIGAR_STATS_CPU].calls == 0);
+
+	return 0;
+}
+
+TEST(test_sigar_stats_lists) {
+	sigar_net_interface_stat_list_t iflist;
+	sigar_net_connection_list_t connlist;
+	sigar_file_system_list_t fslist;
+	sigar_file_system_usage_list_t usagelist;
+	sigar_stats_call_t *call;
+	int i, j, status;
+
+	assert(SIGAR_OK == sigar_stats_enable(t, 1));
+	assert(SIGAR_OK == sigar_stats_reset(t));
+
+	assert(SIGAR_OK == sigar_net_interface_stat_list_get(t, &iflist));
+	sigar_net_interface_stat_list_destroy(t, &iflist);
+
+	status = sigar_net_connection_list_get(t, &connlist,
+	                                       SIGAR_NETCONN_SERVER|SIGAR_NETCONN_TCP);
+	if (status == SIGAR_OK) {
+		sigar_net_connection_list_destroy(t, &connlist);
+	}
+
+	assert(SIGAR_OK == sigar_file_system_list_get(t, &fslist));
+	assert(SIGAR_OK == sigar_file_system_usage_list_get(t, &fslist, 10000, &usagelist));
+	sigar_file_system_usage_list_destroy(t, &usagelist);
+	sigar_file_system_list_destroy(t, &fslist);
+
+	assert(SIGAR_OK == sigar_stats_get(t, &stats));
+
+	call = &stats.calls[SIGAR_STATS_NET_INTERFACE_STAT_LIST];
+	assert(strcmp(call->name, "net_interface_stat_list") == 0);
+	assert(call->calls == 1);
+	assert(call->errors == 0);
+
+	call = &stats.calls[SIGAR_STATS_NET_CONNECTION_LIST];
+	assert(call->calls == 1);
+	assert(call->errors == (status == SIGAR_OK ? 0 : 1));
+	/* the list is built from a walk */
+	assert(stats.calls[SIGAR_STATS_NET_CONNECTION_WALK].calls >= 1);
+
+	assert(stats.calls[SIGAR_STATS_FILE_SYSTEM_USAGE_LIST].calls == 1);
+
+#if defined(SIGAR_TEST_OS_LINUX)
+	/* one dump for the interfaces, at least one for the connections */
+	assert(stats.calls[SIGAR_STATS_NETLINK_DUMP].calls >= 2);
+#endif
+
+	for (i = 0; i < SIGAR_STATS_API_MAX; i++) {
+		assert(stats.calls[i].name != NULL);
+		for (j = 0; j < i; j++) {
+			assert(strcmp(stats.calls[i].name, stats.calls[j].name) != 0);
+		}
+	}
+
+	assert(SIGAR_OK == sigar_stats_enable(t, 0));
+
+	return 0;
+}
+
+int main() {
+	sigar_t *t;
+	int err = 0;
+
+	assert(SIGAR_OK == sigar_open(&t));
+
+	test_sigar_stats_bucket_usec(t);
+	test_sigar_stats_get(t);
+	test_sigar_stats_lists(t);
+
+	sigar_close(t);
+
+	return err ? -1 : 0;
+}